@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_http_parse.cpp
+//!
+//! @brief      HTTP head parsing speed, with the header lookups a static file
+//!             request makes
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // strlen
+#include    <string>                    // Requests
+#include    "bench_timer.h"             // Measure
+#include    "../Source/Mongoose/mongoose.h" // Mongoose
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using Essentials::Benchmarks::Measure;
+using Essentials::Benchmarks::gSink;
+
+static const char* BROWSER_REQUEST =
+    "GET /pages/graphs.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"120\", \"Not?A_Brand\";v=\"8\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Upgrade-Insecure-Requests: 1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: navigate\r\n"
+    "Sec-Fetch-User: ?1\r\n"
+    "Sec-Fetch-Dest: document\r\n"
+    "Referer: http://127.0.0.1/index.html\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef; theme=dark; layout=wide; last=graphs\r\n"
+    "If-None-Match: \"1a2b3c4d.1234\"\r\n"
+    "If-Modified-Since: Mon, 19 Oct 2026 10:00:00 GMT\r\n"
+    "\r\n";
+
+static const char* CURL_REQUEST =
+    "GET /api/history?name=count&points=500 HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "User-Agent: curl/7.88.1\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static void Run(const char* name, const char* request)
+{
+    size_t length = strlen(request);
+    Measure(name, length, [&]()
+        {
+            struct mg_http_message message;
+            int head = mg_http_get_request_len(reinterpret_cast<const unsigned char*>(request), length);
+            mg_http_parse(request, length, &message);
+
+            // The lookups mg_http_serve_file makes for a static file
+            const char* names[4] = { "Content-Length", "If-None-Match", "Range", "Accept-Encoding" };
+            for (const char* header : names)
+            {
+                struct mg_str* value = mg_http_get_header(&message, header);
+                gSink = gSink + (value == NULL ? 0 : value->len);
+            }
+            gSink = gSink + head;
+        });
+}
+
+int main()
+{
+    Run("browser page request", BROWSER_REQUEST);
+    Run("curl api request", CURL_REQUEST);
+    return 0;
+}
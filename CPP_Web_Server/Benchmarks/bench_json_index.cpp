@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_json_index.cpp
+//!
+//! @brief      JSON tape parsing speed on websocket commands and batched edits
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // strlen
+#include    <string>                    // Documents
+#include    "bench_timer.h"             // Measure
+#include    "../Source/CPP_Web_Server/json_index.h"     // JSON Index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+using Essentials::Benchmarks::Measure;
+using Essentials::Benchmarks::gSink;
+
+int main()
+{
+    // The index is kept and parsed into again, as the server does per connection
+    JsonIndex index;
+
+    const char* command = "{\"type\":\"subscribe\",\"names\":[\"count\",\"speed\",\"heading\"],\"period\":100}";
+    size_t commandLength = strlen(command);
+    Measure("subscribe command, parse and lookups", commandLength, [&]()
+        {
+            index.Parse(command, commandLength);
+            int root = index.Root();
+            long period = 0;
+            index.GetLong(index.Find(root, "period"), period);
+            gSink = gSink + period + index.GetCount(index.Find(root, "names")) + index.Equals(index.Find(root, "type"), "subscribe");
+        });
+
+    std::string batch = "{\"type\":\"set\",\"items\":[";
+    for (int i = 0; i < 100; i++)
+    {
+        batch += "{\"name\":\"item_" + std::to_string(i) + "\",\"value\":" + std::to_string(i * 1.25) + "},";
+    }
+    batch.back() = ']';
+    batch += "}";
+    Measure("batched edit of 100 items, parse and walk", batch.size(), [&]()
+        {
+            index.Parse(batch.data(), batch.size());
+            int items = index.Find(index.Root(), "items");
+            for (int item = index.First(items); item >= 0; item = index.Next(item, items))
+            {
+                double value = 0.0;
+                index.GetNumber(index.Find(item, "value"), value);
+                gSink = gSink + static_cast<uint64_t>(value) + index.GetText(index.Find(item, "name")).len;
+            }
+        });
+    return 0;
+}
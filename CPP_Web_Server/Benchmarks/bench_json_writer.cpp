@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_json_writer.cpp
+//!
+//! @brief      JSON writing speed of data pushes, graph series and strings
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string>                    // Names
+#include    <vector>                    // Series
+#include    "bench_timer.h"             // Measure
+#include    "../Source/CPP_Web_Server/json_writer.h"    // JSON Writer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+using Essentials::Benchmarks::Measure;
+using Essentials::Benchmarks::gSink;
+
+int main()
+{
+    // The writer is kept and cleared, as the server does
+    JsonWriter writer;
+
+    std::vector<std::string> names;
+    std::vector<double> values;
+    for (int i = 0; i < 100; i++)
+    {
+        names.push_back("item_" + std::to_string(i));
+        values.push_back(i * 1.25 + 0.1);
+    }
+    Measure("data push of 100 items", 0, [&]()
+        {
+            writer.Clear();
+            writer.BeginObject();
+            writer.Key("type");
+            writer.String("data");
+            writer.Key("items");
+            writer.BeginArray();
+            for (size_t i = 0; i < names.size(); i++)
+            {
+                writer.BeginObject();
+                writer.Key("name");
+                writer.String(names[i]);
+                writer.Key("value");
+                writer.Value(Data::Type::DOUBLE, &values[i]);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+            gSink = gSink + writer.Text().size();
+        });
+
+    std::vector<float> series(1000);
+    for (size_t i = 0; i < series.size(); i++)
+    {
+        series[i] = static_cast<float>(i) * 0.37f;
+    }
+    Measure("graph series of 1000 floats", 0, [&]()
+        {
+            writer.Clear();
+            writer.Numbers(series.data(), series.size());
+            gSink = gSink + writer.Text().size();
+        });
+
+    std::string log(4000, 'l');
+    for (size_t i = 0; i < log.size(); i += 80)
+    {
+        log[i] = '\n';
+    }
+    Measure("console log line of 4000 bytes", log.size(), [&]()
+        {
+            writer.Clear();
+            writer.String(log);
+            gSink = gSink + writer.Text().size();
+        });
+    return 0;
+}
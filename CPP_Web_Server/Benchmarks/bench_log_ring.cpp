@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_log_ring.cpp
+//!
+//! @brief      Logging throughput from 1, 4 and 16 threads under each full
+//!             queue policy
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <filesystem>                // Log directory
+#include    <string>                    // Names
+#include    <thread>                    // Logging threads
+#include    <vector>                    // Threads
+#include    "bench_timer.h"             // Results
+#include    "../Source/CPP_Logger/cpp_logger.h"     // Log
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Utilities;
+
+const static int ENTRIES = 200000;              // Entries per thread per measurement
+
+static void Run(Log* log, const char* name, LOG_FULL_POLICY policy, int threads)
+{
+    log->SetQueueFullPolicy(policy);
+    uint64_t dropped = log->GetDroppedCount();
+
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int thread = 0; thread < threads; thread++)
+    {
+        workers.emplace_back([=]()
+            {
+                for (int i = 0; i < ENTRIES; i++)
+                {
+                    log->AddEntry(LOG_LEVEL::LOG_INFO, "Bench", "thread %d entry %d value %f", thread, i, i * 0.5);
+                }
+            });
+    }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string label = std::string(name) + ", " + std::to_string(threads) + " thread(s)";
+    printf("%-40s %12.2f M calls/s %10llu dropped\n", label.c_str(), threads * ENTRIES / seconds / 1e6,
+        static_cast<unsigned long long>(log->GetDroppedCount() - dropped));
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cpp_log_ring_bench";
+    std::filesystem::create_directories(directory);
+
+    Log* log = Log::GetInstance();
+    log->Initialize(false, true, (directory / "bench").generic_string());
+
+    const int threadCounts[3] = { 1, 4, 16 };
+    for (int threads : threadCounts)
+    {
+        Run(log, "block", LOG_FULL_POLICY::LOG_BLOCK, threads);
+        Run(log, "drop newest", LOG_FULL_POLICY::LOG_DROP_NEWEST, threads);
+        Run(log, "drop oldest", LOG_FULL_POLICY::LOG_DROP_OLDEST, threads);
+    }
+
+    Log::ReleaseInstance();
+    std::filesystem::remove_all(directory);
+    return 0;
+}
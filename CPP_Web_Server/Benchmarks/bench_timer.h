@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_timer.h
+//!
+//! @brief      Timing shared by the microbenchmarks. Each benchmark is its own
+//!             program and prints one line per measurement.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdio.h>                          // Results
+#include <stdint.h>                         // Standard integer types
+#include <chrono>                           // Steady clock
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_BENCH_TIMER                 // Define the bench timer header.
+#define     CPP_BENCH_TIMER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Benchmarks
+    {
+        /// @brief Keeps a result alive so the compiler cannot drop the work producing it.
+        inline volatile uint64_t gSink = 0;
+
+        /// @brief Time a body, repeating it until at least half a second has passed.
+        /// @param name - [in] - Printed name of the measurement.
+        /// @param bytes - [in] - Bytes handled by one call of the body, 0 to print calls only.
+        /// @param body - [in] - Work to time.
+        template <typename Body>
+        void Measure(const char* name, size_t bytes, Body body)
+        {
+            using Clock = std::chrono::steady_clock;
+
+            // One call outside the timing warms the caches and any lazy set up
+            body();
+
+            uint64_t calls = 0;
+            Clock::time_point start = Clock::now();
+            Clock::duration elapsed;
+            do
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    body();
+                }
+                calls += 16;
+                elapsed = Clock::now() - start;
+            } while (elapsed < std::chrono::milliseconds(500));
+
+            double seconds = std::chrono::duration<double>(elapsed).count();
+            if (bytes > 0)
+            {
+                printf("%-40s %12.1f ns/call %10.1f MB/s\n", name, seconds * 1e9 / calls, calls * bytes / seconds / 1e6);
+            }
+            else
+            {
+                printf("%-40s %12.1f ns/call\n", name, seconds * 1e9 / calls);
+            }
+        }
+    } // End Benchmarks
+} // End Essentials
+
+#endif // CPP_BENCH_TIMER
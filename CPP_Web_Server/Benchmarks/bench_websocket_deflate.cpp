@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_websocket_deflate.cpp
+//!
+//! @brief      Compression and decompression speed of websocket data pushes
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string>                    // Messages
+#include    "bench_timer.h"             // Measure
+#include    "../Source/CPP_Web_Server/websocket_deflate.h"  // Websocket Deflate
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+using Essentials::Benchmarks::Measure;
+using Essentials::Benchmarks::gSink;
+
+#ifdef CPP_WEBSOCKET_DEFLATE
+/// @brief A data push of a hundred items, as the server sends every tick.
+static std::string Push(int tick)
+{
+    std::string message = "{\"type\":\"data\",\"items\":[";
+    for (int i = 0; i < 100; i++)
+    {
+        message += "{\"name\":\"item_" + std::to_string(i) + "\",\"value\":" + std::to_string((tick * 31 + i) % 977) + "},";
+    }
+    message.back() = ']';
+    message += "}";
+    return message;
+}
+
+static void Run(const char* name, bool takeover, int level)
+{
+    DeflateParameters parameters = { !takeover, !takeover, 15 };
+    WebsocketDeflate sender;
+    WebsocketDeflate receiver;
+    sender.Start(parameters, level);
+    receiver.Start(parameters, level);
+
+    std::string messages[64];
+    for (int i = 0; i < 64; i++)
+    {
+        messages[i] = Push(i);
+    }
+
+    std::vector<uint8_t> packed;
+    std::vector<uint8_t> unpacked;
+    size_t packedBytes = 0;
+    size_t tick = 0;
+    Measure(name, messages[0].size(), [&]()
+        {
+            const std::string& message = messages[tick++ % 64];
+            sender.Compress(message.data(), message.size(), packed);
+            receiver.Decompress(packed.data(), packed.size(), unpacked);
+            packedBytes = packed.size();
+            gSink = gSink + unpacked.size();
+        });
+    printf("%-40s %12zu -> %zu bytes\n", "", messages[0].size(), packedBytes);
+}
+#endif
+
+int main()
+{
+#ifdef CPP_WEBSOCKET_DEFLATE
+    Run("push round trip, takeover, level 1", true, 1);
+    Run("push round trip, takeover, level 6", true, 6);
+    Run("push round trip, no takeover, level 1", false, 1);
+    Run("push round trip, no takeover, level 6", false, 6);
+#else
+    printf("Built without zlib, nothing to measure\n");
+#endif
+    return 0;
+}
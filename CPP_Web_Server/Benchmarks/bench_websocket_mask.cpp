@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       bench_websocket_mask.cpp
+//!
+//! @brief      Websocket masking speed of the picked kernel against the word
+//!             at a time fallback
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string>                    // Names
+#include    <vector>                    // Buffers
+#include    "bench_timer.h"             // Measure
+#include    "../Source/Mongoose/mongoose.h" // Mongoose
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using Essentials::Benchmarks::Measure;
+using Essentials::Benchmarks::gSink;
+
+int main()
+{
+    struct mg_mgr mgr;
+    mg_mgr_init(&mgr);
+
+    const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+    const size_t sizes[4] = { 16, 125, 4096, 1 << 20 };
+    for (size_t size : sizes)
+    {
+        // One byte in, as the payload follows a header of odd length
+        std::vector<uint8_t> buffer(size + 1, 0x5A);
+        std::string picked = "picked kernel, " + std::to_string(size) + " bytes";
+        std::string fallback = "fallback, " + std::to_string(size) + " bytes";
+        Measure(picked.c_str(), size, [&]()
+            {
+                mg_ws_mask_buf(&mgr, buffer.data() + 1, size, mask);
+                gSink = gSink + buffer[size];
+            });
+        Measure(fallback.c_str(), size, [&]()
+            {
+                mg_ws_mask_buf(NULL, buffer.data() + 1, size, mask);
+                gSink = gSink + buffer[size];
+            });
+    }
+
+    mg_mgr_free(&mgr);
+    return 0;
+}
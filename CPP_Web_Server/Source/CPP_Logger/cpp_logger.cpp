@@ -130,6 +130,17 @@ namespace Essentials
                     milliseconds.insert(0, 3 - milliseconds.length(), '0');
                 }
 
+                // Set up the ring of pending entries, every slot free for its first write.
+                mSlots.reset(new LogSlot[mSlotCount]);
+                for (size_t i = 0; i < mSlotCount; i++)
+                {
+                    mSlots[i].sequence.store(i, std::memory_order_relaxed);
+                    mSlots[i].length = 0;
+                }
+                mEnqueuePosition.store(0, std::memory_order_relaxed);
+                mDequeuePosition.store(0, std::memory_order_relaxed);
+                mDropped.store(0, std::memory_order_relaxed);
+
                 // Create the file and verify its open - if successful start the writing thread.
                 mFile.open(filename + "_" + std::string(time_str) + "." + milliseconds + ".txt");
                 if (!mFile.is_open())
@@ -138,12 +149,12 @@ namespace Essentials
                 }
             }
 
+            // Successful initialization, running before the thread starts so it does not exit at once.
+            mRunning = true;
+
             // Set up the logging thread.
             mThread = new std::thread(&Log::WriteOut, this);
 
-            // Successful initialization
-            mRunning = true;
-
 #ifdef NO_TIMER
             AddEntry(LOG_LEVEL::LOG_INFO, mUser, "Initialize Complete - Using NO_TIMER.");
 #elif defined CPP_TIMER
@@ -160,8 +171,17 @@ namespace Essentials
             return 1;
         }
 
-        bool Log::AddEntry(LOG_LEVEL level, std::string user, std::string format, ...)
+        bool Log::AddEntry(LOG_LEVEL level, const std::string& user, const char* format, ...)
         {
+            bool toConsole = mConsoleOutputEnabled && level <= mMaxConsoleLogLevel;
+            bool toFile = mFileOutputEnabled && level <= mMaxFileLogLevel && mFile.is_open();
+
+            // Nothing to format when neither output takes the level.
+            if (!toConsole && !toFile)
+            {
+                return true;
+            }
+
             va_list args{};
             char msg[MAX_LOG_MESSAGE_LENGTH + 1];
             char ts[20];
@@ -206,15 +226,15 @@ namespace Essentials
             // Format the message with args
             va_start(args, format);
 #ifdef WIN32
-            vsnprintf_s(msg, sizeof(msg), MAX_LOG_MESSAGE_LENGTH, format.c_str(), args);
+            vsnprintf_s(msg, sizeof(msg), MAX_LOG_MESSAGE_LENGTH, format, args);
 #else
-            vsnprintf(msg, MAX_LOG_MESSAGE_LENGTH, format.c_str(), args);
+            vsnprintf(msg, MAX_LOG_MESSAGE_LENGTH, format, args);
 #endif
             msg[sizeof(msg) - 1] = '\0';
             va_end(args);
 
             // Log to console if enabled and within the max
-            if (mConsoleOutputEnabled && level <= mMaxConsoleLogLevel)
+            if (toConsole)
             {
 #ifdef WIN32
                 char buf[400];
@@ -226,42 +246,163 @@ namespace Essentials
 #endif
             }
 
-            // Log to file if enabled, within the max, and file is open. 
-            if (    mFileOutputEnabled 
-                && level <= mMaxFileLogLevel
-                && mFile.is_open())
+            // Log to file if enabled, within the max, and file is open. The entry is formatted
+            // straight into its slot, no lock or allocation on the way.
+            if (toFile)
             {
-                mMutex.lock();
-                char buffer[400];
-                snprintf(buffer, sizeof(buffer), "%s - %s - %s", ts, user.c_str(), msg);
-                std::string tmp = buffer;
-                mQueue.push(tmp);
-                mMutex.unlock();
+                size_t position = 0;
+                if (!ClaimSlot(position))
+                {
+                    return false;
+                }
+
+                LogSlot& slot = mSlots[position & (mSlotCount - 1)];
+                int length = snprintf(slot.text, sizeof(slot.text), "%s - %s - %s", ts, user.c_str(), msg);
+                if (length < 0)
+                {
+                    length = 0;
+                }
+                slot.length = (size_t)length < sizeof(slot.text) ? (size_t)length : sizeof(slot.text) - 1;
+                CommitSlot(position);
             }
 
             return true;
         }
 
+        bool Log::ClaimSlot(size_t& position)
+        {
+            size_t mask = mSlotCount - 1;
+            LOG_FULL_POLICY policy = mFullPolicy.load(std::memory_order_relaxed);
+            size_t pos = mEnqueuePosition.load(std::memory_order_relaxed);
+            while (true)
+            {
+                LogSlot& slot = mSlots[pos & mask];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t turn = (intptr_t)sequence - (intptr_t)pos;
+
+                if (turn == 0)
+                {
+                    // Free for this position, race the other logging threads for it.
+                    if (mEnqueuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        position = pos;
+                        return true;
+                    }
+                }
+                else if (turn < 0)
+                {
+                    // Still holding the entry from a lap ago, the queue is full.
+                    switch (policy)
+                    {
+                    case LOG_FULL_POLICY::LOG_DROP_NEWEST:
+                        mDropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    case LOG_FULL_POLICY::LOG_DROP_OLDEST:
+                    {
+                        // Take the entry in the way if it is ready and nobody took it yet, otherwise
+                        // it is being formatted or written and the wait is short.
+                        size_t oldest = pos - mSlotCount;
+                        if (sequence == oldest + 1
+                            && mDequeuePosition.compare_exchange_strong(oldest, oldest + 1, std::memory_order_relaxed))
+                        {
+                            ReleaseSlot(pos - mSlotCount);
+                            mDropped.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        else
+                        {
+                            std::this_thread::yield();
+                        }
+                        break;
+                    }
+                    default:
+                        std::this_thread::yield();
+                        break;
+                    }
+                    pos = mEnqueuePosition.load(std::memory_order_relaxed);
+                }
+                else
+                {
+                    // Another thread claimed it first.
+                    pos = mEnqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void Log::CommitSlot(size_t position)
+        {
+            mSlots[position & (mSlotCount - 1)].sequence.store(position + 1, std::memory_order_release);
+        }
+
+        bool Log::TakeSlot(size_t& position)
+        {
+            size_t mask = mSlotCount - 1;
+            size_t pos = mDequeuePosition.load(std::memory_order_relaxed);
+            while (true)
+            {
+                LogSlot& slot = mSlots[pos & mask];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t turn = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+                if (turn == 0)
+                {
+                    // Ready, race dropping threads for it.
+                    if (mDequeuePosition.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        position = pos;
+                        return true;
+                    }
+                }
+                else if (turn < 0)
+                {
+                    // Empty, or the oldest entry is still being formatted.
+                    return false;
+                }
+                else
+                {
+                    pos = mDequeuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void Log::ReleaseSlot(size_t position)
+        {
+            mSlots[position & (mSlotCount - 1)].sequence.store(position + mSlotCount, std::memory_order_release);
+        }
+
         void Log::WriteOut()
         {
-            while (mRunning)
+            uint64_t droppedReported = 0;
+            bool running = true;
+
+            while (running)
             {
-                std::string entry;
+                // Read the flag before draining, so entries logged before a stop are still written.
+                running = mRunning;
 
-                mMutex.lock();
-                if (mFile.is_open() && !mQueue.empty())
+                // Write every entry ready, then flush once for the batch.
+                size_t written = 0;
+                size_t position = 0;
+                while (mSlots != nullptr && TakeSlot(position))
                 {
-                    entry = mQueue.front();
-                    mQueue.pop();
+                    LogSlot& slot = mSlots[position & (mSlotCount - 1)];
+                    mFile.write(slot.text, slot.length);
+                    mFile.put('\n');
+                    ReleaseSlot(position);
+                    written++;
                 }
-                mMutex.unlock();
 
-                if (entry.length() > 0)
+                uint64_t dropped = mDropped.load(std::memory_order_relaxed);
+                if (dropped != droppedReported && mFile.is_open())
                 {
-                    mFile << entry << "\n";
-                    mFile.flush();
+                    mFile << " - " << mUser << " - Queue full, dropped " << (dropped - droppedReported) << " entries.\n";
+                    droppedReported = dropped;
+                    written++;
+                }
 
-                    entry.clear();
+                if (written > 0)
+                {
+                    mFile.flush();
+                    continue;
                 }
 
 #if defined NO_TIMER
@@ -309,6 +450,34 @@ namespace Essentials
             return (enable == mFileOutputEnabled);
         }
 
+        bool Log::SetQueueSize(size_t slots)
+        {
+            // The ring is set up in Initialize and cannot change under the logging threads.
+            if (mRunning)
+            {
+                return false;
+            }
+
+            size_t count = 2;
+            while (count < slots)
+            {
+                count <<= 1;
+            }
+            mSlotCount = count;
+            return true;
+        }
+
+        bool Log::SetQueueFullPolicy(LOG_FULL_POLICY policy)
+        {
+            mFullPolicy.store(policy, std::memory_order_relaxed);
+            return true;
+        }
+
+        uint64_t Log::GetDroppedCount()
+        {
+            return mDropped.load(std::memory_order_relaxed);
+        }
+
 #ifdef WIN32
         int8_t Log::SetLoggerThreadPriority(LogThreadPriority priority)
         {
@@ -361,13 +530,15 @@ namespace Essentials
 
         Log::~Log()
         {
-            // Notify close and wait for queue to finish writing to file
+            // Notify close, the thread writes what is queued before it stops.
             AddEntry(LOG_LEVEL::LOG_INFO, mUser, "Closing.");
-            while (!mQueue.empty()) {}
 
             mRunning = false;
-            mThread->join();
-            delete mThread;
+            if (mThread != nullptr)
+            {
+                mThread->join();
+                delete mThread;
+            }
             mFile.close();
         }
 
@@ -382,6 +553,11 @@ namespace Essentials
             mOutputFile = "";
             mRunning = false;
             mUser = "";
+            mSlotCount = LOG_QUEUE_SLOTS;
+            mEnqueuePosition = 0;
+            mDequeuePosition = 0;
+            mDropped = 0;
+            mFullPolicy = LOG_FULL_POLICY::LOG_BLOCK;
         }
     } // Utilities
 } // Essentials
\ No newline at end of file
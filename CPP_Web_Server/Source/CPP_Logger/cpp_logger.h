@@ -30,8 +30,9 @@
 #include    <fstream>                    // File Stream
 #include    <iostream>                    // Input Output
 #include    <thread>                    // Multithreading
-#include    <queue>                        // Queue object to store pending log entries
-#include    <mutex>                        // Mutex object to enable thread safe usage of the queue
+#include    <atomic>                    // Lock free ring of pending log entries
+#include    <memory>                    // Ring storage
+#include    <mutex>                        // Mutex object to enable thread safe creation of the instance
 #include    <chrono>                    // Timing for filename date/time
 #include    <cstring>                    // C-Strings
 #include    <stdarg.h>                    // Inbound Arguments
@@ -53,6 +54,8 @@
 //
 // 
 constexpr int MAX_LOG_MESSAGE_LENGTH = 250;    //! Maximum Loggable Message Length
+constexpr int LOG_SLOT_SIZE = 400;            //! Bytes per pending log entry, timestamp and user included
+constexpr size_t LOG_QUEUE_SLOTS = 4096;    //! Default pending log entries, a power of two
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -78,6 +81,14 @@ namespace Essentials
             LOG_USEC,
         };
 
+        // What to do with a log entry when the queue is full
+        enum class LOG_FULL_POLICY : const int
+        {
+            LOG_BLOCK,
+            LOG_DROP_NEWEST,
+            LOG_DROP_OLDEST,
+        };
+
         enum class LogThreadPriority
         {
 #ifdef WIN32
@@ -144,8 +155,8 @@ namespace Essentials
             //! @param level - LOG Level of the string.
             //! @param user - User the message is coming from
             //! @param format - formatted string to be logged. 
-            //! @return false if failed, true if message was logged
-            bool AddEntry(LOG_LEVEL level, std::string user, std::string format, ...);
+            //! @return false if failed or dropped, true if message was logged
+            bool AddEntry(LOG_LEVEL level, const std::string& user, const char* format, ...);
 
             //! @brief Writes out the log entries. 
             void WriteOut();
@@ -175,6 +186,20 @@ namespace Essentials
             //! @return false if failed, true if set
             bool LogToFile(bool enable);
 
+            //! @brief Sets the number of entries waiting for the file at once.
+            //! @param slots - entries, rounded up to a power of two.
+            //! @return false if already initialized, true if set
+            bool SetQueueSize(size_t slots);
+
+            //! @brief Sets what happens to an entry logged while the queue is full.
+            //! @param policy - wait for room, drop the new entry or drop the oldest one.
+            //! @return false if failed, true if set
+            bool SetQueueFullPolicy(LOG_FULL_POLICY policy);
+
+            //! @brief Gets the number of entries dropped for a full queue.
+            //! @return entries dropped since initialization.
+            uint64_t GetDroppedCount();
+
 #ifdef WIN32
             int8_t SetLoggerThreadPriority(LogThreadPriority priority);
 #else
@@ -191,9 +216,41 @@ namespace Essentials
             //! @brief Hidden Deconstructor
             ~Log();
 
+            //! @brief One pending entry. Its sequence says whose turn it is: equal to a write
+            //!        position the slot is free for that write, one past it the entry is ready.
+            struct alignas(64) LogSlot
+            {
+                std::atomic<size_t> sequence;                   // Turn of the slot
+                size_t              length;                     // Length of the entry text
+                char                text[LOG_SLOT_SIZE];        // Formatted entry
+            };
+
+            //! @brief Claims the next free slot, applying the full policy when there is none.
+            //! @param position - write position of the slot claimed.
+            //! @return false if the entry is dropped, true if claimed
+            bool ClaimSlot(size_t& position);
+
+            //! @brief Hands a claimed slot to the writer.
+            //! @param position - write position of the slot.
+            void CommitSlot(size_t position);
+
+            //! @brief Takes the oldest ready slot.
+            //! @param position - write position of the slot taken.
+            //! @return false if none is ready, true if taken
+            bool TakeSlot(size_t& position);
+
+            //! @brief Frees a taken slot for a later write.
+            //! @param position - write position of the slot.
+            void ReleaseSlot(size_t position);
+
             static Log* mInstance;                              // Instance of Logger
             std::thread* mThread;                               // Pointer to a thread object
-            std::queue<std::string> mQueue;                     // Queue to store pending log entries
+            std::unique_ptr<LogSlot[]> mSlots;                  // Ring of pending log entries
+            size_t                  mSlotCount;                 // Slots in the ring, a power of two
+            alignas(64) std::atomic<size_t> mEnqueuePosition;   // Next write position, shared by the logging threads
+            alignas(64) std::atomic<size_t> mDequeuePosition;   // Next read position
+            std::atomic<uint64_t>   mDropped;                   // Entries dropped for a full queue
+            std::atomic<LOG_FULL_POLICY> mFullPolicy;           // What to do when the queue is full, may change while logging
             static std::mutex       mMutex;                     // Mutex for thread protection
             LOG_LEVEL               mMaxConsoleLogLevel;        // Allowed Maximum Logging Level
             LOG_LEVEL               mMaxFileLogLevel;           // Allowed Maximum Logging Level
@@ -201,7 +258,7 @@ namespace Essentials
             bool                    mConsoleOutputEnabled;      // Output to console enabled ? 
             bool                    mFileOutputEnabled;         // Output to file enabled ?
             std::string             mOutputFile;                // Holds output file location.
-            bool                    mRunning;                   // Track if Logger is running
+            std::atomic<bool>       mRunning;                   // Track if Logger is running
             std::ofstream           mFile;                      // File Stream To Write To
             std::string             mUser;                      // System User for Log information location
         };
@@ -14,6 +14,18 @@
 //          name                        reason included
 //          --------------------        ---------------------------------------
 #include    "cpp_terminal.h"                // Terminal Class
+#ifndef WIN32
+#include    <spawn.h>                       // posix_spawn
+#include    <signal.h>                      // Process group signals
+#include    <fcntl.h>                       // Non-blocking descriptors
+#include    <unistd.h>                      // close
+#include    <sys/socket.h>                  // Stream socket pairs
+#include    <sys/wait.h>                    // waitpid
+#include    <stdlib.h>                      // Pseudo terminals
+#include    <termios.h>                     // Terminal modes
+
+extern char** environ;
+#endif
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -77,5 +89,214 @@ namespace Essentials
         {
             return TerminalErrorMap[mLastError];
         }
+
+#ifndef WIN32
+        /// @brief Create a socket pair for one stream, the parent end non-blocking and neither
+        ///        end inherited by other children.
+        static bool OpenStream(int ends[2])
+        {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0)
+            {
+                return false;
+            }
+
+            fcntl(ends[0], F_SETFD, FD_CLOEXEC);
+            fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+            fcntl(ends[0], F_SETFL, fcntl(ends[0], F_GETFL) | O_NONBLOCK);
+
+            // The parent only reads
+            shutdown(ends[0], SHUT_WR);
+            return true;
+        }
+
+        int8_t Terminal::SpawnCommand(const std::string& command, CommandProcess& process)
+        {
+            // Sockets rather than pipes so the reader can treat them as any other connection
+            int output[2] = { -1, -1 };
+            int error[2] = { -1, -1 };
+            if (!OpenStream(output))
+            {
+                mLastError = TerminalError::SPAWN_FAILED;
+                return -1;
+            }
+            if (!OpenStream(error))
+            {
+                close(output[0]);
+                close(output[1]);
+                mLastError = TerminalError::SPAWN_FAILED;
+                return -1;
+            }
+
+            // dup2 clears close on exec on the child's copies
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+            posix_spawn_file_actions_adddup2(&actions, output[1], 1);
+            posix_spawn_file_actions_adddup2(&actions, error[1], 2);
+
+            // Its own process group so a kill reaches whatever it starts, with the signal
+            // handling of a fresh process rather than the server's
+            posix_spawnattr_t attributes;
+            posix_spawnattr_init(&attributes);
+            sigset_t signals;
+            sigemptyset(&signals);
+            posix_spawnattr_setsigmask(&attributes, &signals);
+            sigaddset(&signals, SIGPIPE);
+            sigaddset(&signals, SIGINT);
+            sigaddset(&signals, SIGQUIT);
+            posix_spawnattr_setsigdefault(&attributes, &signals);
+            posix_spawnattr_setpgroup(&attributes, 0);
+            posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+            pid_t pid = 0;
+            char* argv[] = { const_cast<char*>("/bin/sh"), const_cast<char*>("-c"), const_cast<char*>(command.c_str()), nullptr };
+            int result = posix_spawn(&pid, "/bin/sh", &actions, &attributes, argv, environ);
+
+            posix_spawn_file_actions_destroy(&actions);
+            posix_spawnattr_destroy(&attributes);
+            close(output[1]);
+            close(error[1]);
+
+            if (result != 0)
+            {
+                close(output[0]);
+                close(error[0]);
+                mLastError = TerminalError::SPAWN_FAILED;
+                return -1;
+            }
+
+            process = { static_cast<int>(pid), output[0], error[0] };
+            return 0;
+        }
+
+        int8_t Terminal::OpenShell(CommandProcess& process)
+        {
+            int master = posix_openpt(O_RDWR | O_NOCTTY);
+            const char* slave = master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ? nullptr : ptsname(master);
+            if (slave == nullptr)
+            {
+                if (master >= 0)
+                {
+                    close(master);
+                }
+                mLastError = TerminalError::PTY_FAILED;
+                return -1;
+            }
+
+            // The client shows what it sends, so the terminal does not echo it back, and lines
+            // end in a bare newline as they do from a pipe
+            int terminal = open(slave, O_RDWR | O_NOCTTY | O_CLOEXEC);
+            termios modes;
+            if (terminal < 0 || tcgetattr(terminal, &modes) != 0)
+            {
+                if (terminal >= 0)
+                {
+                    close(terminal);
+                }
+                close(master);
+                mLastError = TerminalError::PTY_FAILED;
+                return -1;
+            }
+            modes.c_lflag &= ~(ECHO | ECHONL);
+            modes.c_oflag &= ~ONLCR;
+            tcsetattr(terminal, TCSANOW, &modes);
+
+            fcntl(master, F_SETFD, FD_CLOEXEC);
+            fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+            // A new session opening the terminal makes it the controlling terminal, so
+            // interrupts written to the master reach the foreground command
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addopen(&actions, 0, slave, O_RDWR, 0);
+            posix_spawn_file_actions_adddup2(&actions, 0, 1);
+            posix_spawn_file_actions_adddup2(&actions, 0, 2);
+
+            posix_spawnattr_t attributes;
+            posix_spawnattr_init(&attributes);
+            sigset_t signals;
+            sigemptyset(&signals);
+            posix_spawnattr_setsigmask(&attributes, &signals);
+            sigaddset(&signals, SIGPIPE);
+            sigaddset(&signals, SIGINT);
+            sigaddset(&signals, SIGQUIT);
+            posix_spawnattr_setsigdefault(&attributes, &signals);
+            posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+            pid_t pid = 0;
+            // Without job control, background jobs stay in the shell's process group and die with it
+            char* argv[] = { const_cast<char*>("/bin/sh"), const_cast<char*>("-i"), const_cast<char*>("+m"), nullptr };
+            int result = posix_spawn(&pid, "/bin/sh", &actions, &attributes, argv, environ);
+
+            posix_spawn_file_actions_destroy(&actions);
+            posix_spawnattr_destroy(&attributes);
+            close(terminal);
+
+            if (result != 0)
+            {
+                close(master);
+                mLastError = TerminalError::SPAWN_FAILED;
+                return -1;
+            }
+
+            process = { static_cast<int>(pid), master, -1 };
+            return 0;
+        }
+
+        int8_t Terminal::CheckCommand(const CommandProcess& process, int& exitstatus)
+        {
+            int status = 0;
+            pid_t result = waitpid(process.pid, &status, WNOHANG);
+            if (result == 0)
+            {
+                return 0;
+            }
+            if (result < 0)
+            {
+                return -1;
+            }
+
+            exitstatus = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+            return 1;
+        }
+
+        void Terminal::KillCommand(const CommandProcess& process, bool wait)
+        {
+            kill(-process.pid, SIGKILL);
+            if (wait)
+            {
+                waitpid(process.pid, nullptr, 0);
+            }
+        }
+#else
+        int8_t Terminal::SpawnCommand(const std::string& command, CommandProcess& process)
+        {
+            // Windows runs commands through ExecuteCommand only
+            (void)command;
+            process = { -1, -1, -1 };
+            mLastError = TerminalError::SPAWN_FAILED;
+            return -1;
+        }
+
+        int8_t Terminal::OpenShell(CommandProcess& process)
+        {
+            process = { -1, -1, -1 };
+            mLastError = TerminalError::PTY_FAILED;
+            return -1;
+        }
+
+        int8_t Terminal::CheckCommand(const CommandProcess& process, int& exitstatus)
+        {
+            (void)process;
+            exitstatus = -1;
+            return -1;
+        }
+
+        void Terminal::KillCommand(const CommandProcess& process, bool wait)
+        {
+            (void)process;
+            (void)wait;
+        }
+#endif
     }
 }
\ No newline at end of file
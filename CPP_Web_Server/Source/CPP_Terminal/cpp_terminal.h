@@ -55,6 +55,8 @@ namespace Essentials
             NONE,
             POPEN_FAILED,
             EXCEPTION,
+            SPAWN_FAILED,
+            PTY_FAILED,
         };
 
         /// @brief Error enum to readable string conversion map
@@ -66,6 +68,10 @@ namespace Essentials
             std::string("Error Code " + std::to_string((uint8_t)TerminalError::POPEN_FAILED) + ": pOpen failed.")},
             {TerminalError::EXCEPTION,
             std::string("Error Code " + std::to_string((uint8_t)TerminalError::EXCEPTION) + ": caught exception.")},
+            {TerminalError::SPAWN_FAILED,
+            std::string("Error Code " + std::to_string((uint8_t)TerminalError::SPAWN_FAILED) + ": spawn failed.")},
+            {TerminalError::PTY_FAILED,
+            std::string("Error Code " + std::to_string((uint8_t)TerminalError::PTY_FAILED) + ": pseudo terminal failed.")},
         };
 
         struct CommandResult 
@@ -90,6 +96,15 @@ namespace Essentials
             }
         };
 
+        /// @brief A command running in the background. Its output and error streams are
+        ///        non-blocking sockets, read as data arrives instead of after the command exits.
+        struct CommandProcess
+        {
+            int     pid;        // Process id, also the id of its process group
+            int     output;     // Parent end of standard output, the terminal master for a shell
+            int     error;      // Parent end of standard error, -1 for a shell
+        };
+
         class Terminal
         {
         public:
@@ -98,6 +113,31 @@ namespace Essentials
             int8_t      ExecuteCommand(std::string& command, std::string& result);
             std::string ExecuteCommand(std::string& command);
             std::string GetLastError();
+
+            /// @brief Start a command through the shell without waiting for it. The caller owns
+            ///        the stream descriptors and closes them once read to the end.
+            /// @param command - [in] - Command line to run.
+            /// @param process - [out] - Started process and its streams.
+            /// @return -1 on error, 0 on success
+            int8_t SpawnCommand(const std::string& command, CommandProcess& process);
+
+            /// @brief Start an interactive shell on a pseudo terminal, which keeps its working
+            ///        directory and environment from one command to the next. Input written to
+            ///        the master is not echoed back. The caller owns the master descriptor.
+            /// @param process - [out] - Started shell, output holding the non-blocking master.
+            /// @return -1 on error, 0 on success
+            int8_t OpenShell(CommandProcess& process);
+
+            /// @brief Check whether a spawned command has exited, reaping it if so.
+            /// @param process - [in] - Spawned process.
+            /// @param exitstatus - [out] - Exit status, 128 plus the signal number when killed.
+            /// @return -1 on error, 0 while running, 1 once exited
+            static int8_t CheckCommand(const CommandProcess& process, int& exitstatus);
+
+            /// @brief Kill a spawned command and everything it started.
+            /// @param process - [in] - Spawned process.
+            /// @param wait - [in] - true to reap it before returning, false to leave it to CheckCommand.
+            static void KillCommand(const CommandProcess& process, bool wait);
         protected:
         private:
             TerminalError   mLastError;
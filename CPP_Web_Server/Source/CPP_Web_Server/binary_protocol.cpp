@@ -0,0 +1,363 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       binary_protocol.cpp
+//!
+//! @brief      Implementation of the binary websocket frame writer and reader
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "binary_protocol.h"         // Binary Protocol
+#include    <cstring>                   // memcpy
+//
+//  Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#define     COUNT_SLOT_SIZE     5       // Padded varint slot for the frame count
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        namespace Binary
+        {
+            size_t FixedSize(Data::Type type)
+            {
+                switch (type)
+                {
+                case Data::Type::CHAR:
+                case Data::Type::UCHAR:
+                case Data::Type::BOOL:
+                    return 1;
+                case Data::Type::SHORT:
+                case Data::Type::USHORT:
+                    return 2;
+                case Data::Type::INT:
+                case Data::Type::UINT:
+                case Data::Type::FLOAT:
+                    return 4;
+                case Data::Type::DOUBLE:
+                    return 8;
+                default:
+                    return 0;
+                }
+            }
+
+            size_t EncodeValue(Data::Type type, const void* address, uint8_t* out, size_t capacity)
+            {
+                if (type == Data::Type::STRING)
+                {
+                    const std::string* str = static_cast<const std::string*>(address);
+
+                    uint8_t length[10];
+                    size_t used = 0;
+                    uint64_t value = str->size();
+                    while (value >= 0x80)
+                    {
+                        length[used++] = static_cast<uint8_t>(value | 0x80);
+                        value >>= 7;
+                    }
+                    length[used++] = static_cast<uint8_t>(value);
+
+                    if (used + str->size() > capacity)
+                    {
+                        return 0;
+                    }
+                    memcpy(out, length, used);
+                    memcpy(out + used, str->data(), str->size());
+                    return used + str->size();
+                }
+
+                size_t size = FixedSize(type);
+                if (size == 0 || size > capacity)
+                {
+                    return 0;
+                }
+
+                uint64_t raw = 0;
+                switch (size)
+                {
+                case 1: { uint8_t  v; memcpy(&v, address, 1); raw = v; break; }
+                case 2: { uint16_t v; memcpy(&v, address, 2); raw = v; break; }
+                case 4: { uint32_t v; memcpy(&v, address, 4); raw = v; break; }
+                default:{ memcpy(&raw, address, 8); break; }
+                }
+
+                if (type == Data::Type::BOOL)
+                {
+                    raw = raw != 0 ? 1 : 0;
+                }
+
+                for (size_t i = 0; i < size; i++)
+                {
+                    out[i] = static_cast<uint8_t>(raw >> (i * 8));
+                }
+                return size;
+            }
+
+            Reader::Reader(const uint8_t* data, size_t size)
+            {
+                mData = data;
+                mSize = size;
+                mPosition = 0;
+            }
+
+            bool Reader::GetVarint(uint64_t& value)
+            {
+                value = 0;
+                for (uint32_t shift = 0; shift < 64; shift += 7)
+                {
+                    if (mPosition >= mSize)
+                    {
+                        return false;
+                    }
+
+                    uint8_t byte = mData[mPosition++];
+                    if (shift == 63 && byte > 1)
+                    {
+                        // The tenth byte holds only the top bit of the value
+                        return false;
+                    }
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool Reader::GetU8(uint8_t& value)
+            {
+                if (mPosition >= mSize)
+                {
+                    return false;
+                }
+
+                value = mData[mPosition++];
+                return true;
+            }
+
+            bool Reader::GetBytes(size_t size, const uint8_t*& bytes)
+            {
+                if (size > mSize - mPosition)
+                {
+                    return false;
+                }
+
+                bytes = mData + mPosition;
+                mPosition += size;
+                return true;
+            }
+
+            bool Reader::GetValue(Data::Type type, void* address)
+            {
+                const uint8_t* bytes = nullptr;
+
+                if (type == Data::Type::STRING)
+                {
+                    uint64_t length = 0;
+                    if (!GetVarint(length) || !GetBytes(static_cast<size_t>(length), bytes))
+                    {
+                        return false;
+                    }
+                    static_cast<std::string*>(address)->assign(reinterpret_cast<const char*>(bytes), static_cast<size_t>(length));
+                    return true;
+                }
+
+                size_t size = FixedSize(type);
+                if (size == 0 || !GetBytes(size, bytes))
+                {
+                    return false;
+                }
+
+                // Assemble the little-endian bytes and store them at the native width
+                uint64_t raw = 0;
+                for (size_t i = 0; i < size; i++)
+                {
+                    raw |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+                }
+
+                switch (size)
+                {
+                case 1:
+                    if (type == Data::Type::BOOL)
+                    {
+                        bool v = raw != 0;
+                        memcpy(address, &v, sizeof(v));
+                    }
+                    else
+                    {
+                        uint8_t v = static_cast<uint8_t>(raw);
+                        memcpy(address, &v, 1);
+                    }
+                    break;
+                case 2: { uint16_t v = static_cast<uint16_t>(raw); memcpy(address, &v, 2); break; }
+                case 4: { uint32_t v = static_cast<uint32_t>(raw); memcpy(address, &v, 4); break; }
+                default:{ memcpy(address, &raw, 8); break; }
+                }
+                return true;
+            }
+
+            void Writer::Begin(FrameType type, size_t reserve)
+            {
+                mBuffer.clear();
+                mBuffer.reserve(reserve);
+                mBuffer.push_back(PROTOCOL_VERSION);
+                mBuffer.push_back(static_cast<uint8_t>(type));
+
+                // Leave room for the count, patched in Finish()
+                mBuffer.insert(mBuffer.end(), COUNT_SLOT_SIZE, 0);
+            }
+
+            void Writer::PutVarint(uint64_t value)
+            {
+                while (value >= 0x80)
+                {
+                    mBuffer.push_back(static_cast<uint8_t>(value | 0x80));
+                    value >>= 7;
+                }
+                mBuffer.push_back(static_cast<uint8_t>(value));
+            }
+
+            void Writer::PutU8(uint8_t value)
+            {
+                mBuffer.push_back(value);
+            }
+
+            void Writer::PutU64(uint64_t value)
+            {
+                for (int i = 0; i < 8; i++)
+                {
+                    mBuffer.push_back(static_cast<uint8_t>(value >> (i * 8)));
+                }
+            }
+
+            void Writer::PutBytes(const uint8_t* data, size_t size)
+            {
+                mBuffer.insert(mBuffer.end(), data, data + size);
+            }
+
+            void Writer::PutValue(Data::Type type, const void* address)
+            {
+                if (type == Data::Type::STRING)
+                {
+                    const std::string* str = static_cast<const std::string*>(address);
+                    PutVarint(str->size());
+                    mBuffer.insert(mBuffer.end(), str->begin(), str->end());
+                    return;
+                }
+
+                size_t size = FixedSize(type);
+                if (size == 0)
+                {
+                    return;
+                }
+
+                // Read the native value into a 64 bit integer and emit it
+                // byte by byte so the output is little-endian on any host.
+                uint64_t raw = 0;
+                switch (size)
+                {
+                case 1: { uint8_t  v; memcpy(&v, address, 1); raw = v; break; }
+                case 2: { uint16_t v; memcpy(&v, address, 2); raw = v; break; }
+                case 4: { uint32_t v; memcpy(&v, address, 4); raw = v; break; }
+                default:{ memcpy(&raw, address, 8); break; }
+                }
+
+                if (type == Data::Type::BOOL)
+                {
+                    raw = raw != 0 ? 1 : 0;
+                }
+
+                for (size_t i = 0; i < size; i++)
+                {
+                    mBuffer.push_back(static_cast<uint8_t>(raw >> (i * 8)));
+                }
+            }
+
+            void Writer::PutNumber(Data::Type type, double value)
+            {
+                switch (type)
+                {
+                case Data::Type::CHAR:   { char v           = static_cast<char>(value);             PutValue(type, &v); break; }
+                case Data::Type::UCHAR:  { unsigned char v  = static_cast<unsigned char>(value);    PutValue(type, &v); break; }
+                case Data::Type::SHORT:  { short v          = static_cast<short>(value);            PutValue(type, &v); break; }
+                case Data::Type::USHORT: { unsigned short v = static_cast<unsigned short>(value);   PutValue(type, &v); break; }
+                case Data::Type::INT:    { int v            = static_cast<int>(value);              PutValue(type, &v); break; }
+                case Data::Type::UINT:   { unsigned int v   = static_cast<unsigned int>(value);     PutValue(type, &v); break; }
+                case Data::Type::FLOAT:  { float v          = static_cast<float>(value);            PutValue(type, &v); break; }
+                case Data::Type::DOUBLE: {                                                          PutValue(type, &value); break; }
+                case Data::Type::BOOL:   { bool v           = value != 0.0;                         PutValue(type, &v); break; }
+                default:
+                    break;
+                }
+            }
+
+            void Writer::AddValue(uint32_t id, Data::Type type, const void* address)
+            {
+                PutVarint(id);
+                PutU8(static_cast<uint8_t>(type));
+                PutValue(type, address);
+            }
+
+            void Writer::AddSeries(uint32_t id, Data::Type type, const uint64_t* timestamps, const double* values, size_t count)
+            {
+                PutVarint(id);
+                PutU8(static_cast<uint8_t>(type));
+                PutVarint(count);
+
+                uint64_t previous = count > 0 ? timestamps[0] : 0;
+                PutU64(previous);
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    PutVarint(timestamps[i] - previous);
+                    PutNumber(type, values[i]);
+                    previous = timestamps[i];
+                }
+            }
+
+            void Writer::BeginBlocks(uint32_t id, Data::Type type, size_t blocks)
+            {
+                PutVarint(id);
+                PutU8(static_cast<uint8_t>(type));
+                PutVarint(blocks);
+            }
+
+            void Writer::AddBlock(uint32_t count, const uint8_t* data, size_t size)
+            {
+                PutVarint(count);
+                PutVarint(size);
+                mBuffer.insert(mBuffer.end(), data, data + size);
+            }
+
+            const std::vector<uint8_t>& Writer::Finish(uint32_t count)
+            {
+                // Write the count as a fixed width varint, padding with
+                // continuation bits so the slot size never changes.
+                uint64_t value = count;
+                for (int i = 0; i < COUNT_SLOT_SIZE; i++)
+                {
+                    uint8_t byte = static_cast<uint8_t>(value & 0x7F);
+                    value >>= 7;
+                    if (i < COUNT_SLOT_SIZE - 1)
+                    {
+                        byte |= 0x80;
+                    }
+                    mBuffer[2 + i] = byte;
+                }
+
+                return mBuffer;
+            }
+        }
+    } // End Communications
+} // End Essentials
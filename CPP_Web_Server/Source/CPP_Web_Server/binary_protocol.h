@@ -0,0 +1,210 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       binary_protocol.h
+//!
+//! @brief      Compact binary websocket frame format for published data and
+//!             graph samples.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Strings
+#include <vector>                           // Frame buffer
+#include <map>                              // Type maps
+#include "publishable_types.h"              // Data::Type
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_BINARY_PROTOCOL             // Define the binary protocol header.
+#define     CPP_BINARY_PROTOCOL
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        //  Every frame is sent as a WEBSOCKET_OP_BINARY message laid out as:
+        //
+        //      [u8 version][u8 frame type][payload]
+        //
+        //  VALUES payload:
+        //      varint count
+        //      count x { varint id, u8 Data::Type, value }
+        //
+        //  SAMPLES payload:
+        //      varint series count
+        //      series x { varint id, u8 Data::Type, varint n, u64 base ms,
+        //                 n x { varint delta ms, value } }
+        //
+        //  GORILLA payload:
+        //      varint series count
+        //      series x { varint id, u8 Data::Type, varint block count,
+        //                 blocks x { varint n, varint byte length, bytes } }
+        //
+        //  INVOKE payload, sent by clients to call a published function:
+        //      varint request id, varint name length, name bytes,
+        //      arguments back to back as values of the declared argument types
+        //
+        //  Block bytes are gorilla encoded as laid out in gorilla_codec.h, with
+        //  values as doubles whatever the Data::Type.
+        //
+        //  Values are little-endian and sized by their Data::Type. Strings are
+        //  a varint byte length followed by the raw bytes. Deltas are relative
+        //  to the previous sample of the series, the first to the base.
+        namespace Binary
+        {
+            const static uint8_t PROTOCOL_VERSION = 1;
+
+            /// @brief Frame types carried in the second header byte
+            enum class FrameType : uint8_t
+            {
+                NONE,
+                VALUES,
+                SAMPLES,
+                GORILLA,
+                INVOKE,
+            };
+
+            /// @brief Get the encoded size of a value type, 0 for variable length.
+            /// @param type - [in] - Data type to size.
+            /// @return size in bytes of the fixed width encoding.
+            size_t FixedSize(Data::Type type);
+
+            /// @brief Encode one value into a fixed buffer, as Writer::PutValue lays it out.
+            /// @param type - [in] - Data type located at address.
+            /// @param address - [in] - Memory to read the value from, a std::string for STRING.
+            /// @param out - [out] - Buffer to write to.
+            /// @param capacity - [in] - Bytes available at out.
+            /// @return bytes written, 0 if the type has no encoding or the value does not fit.
+            size_t EncodeValue(Data::Type type, const void* address, uint8_t* out, size_t capacity);
+
+            /// @brief Reads values from a received frame, failing rather than reading past its end.
+            class Reader
+            {
+            public:
+                /// @brief Read from a buffer.
+                /// @param data - [in] - Bytes to read, must outlive the reader.
+                /// @param size - [in] - Byte count.
+                Reader(const uint8_t* data, size_t size);
+
+                /// @brief Read a base 128 varint.
+                /// @param value - [out] - Value read.
+                /// @return false if the buffer ends first or the varint is too long, true on success.
+                bool GetVarint(uint64_t& value);
+
+                /// @brief Read a raw byte.
+                /// @param value - [out] - Byte read.
+                /// @return false at the end of the buffer, true on success.
+                bool GetU8(uint8_t& value);
+
+                /// @brief Read a run of bytes in place.
+                /// @param size - [in] - Byte count.
+                /// @param bytes - [out] - Pointer to the bytes within the buffer.
+                /// @return false if fewer bytes remain, true on success.
+                bool GetBytes(size_t size, const uint8_t*& bytes);
+
+                /// @brief Read a value of a data type into memory, the reverse of Writer::PutValue.
+                /// @param type - [in] - Data type located at address.
+                /// @param address - [out] - Memory to write, a std::string for STRING.
+                /// @return false if the buffer ends first or the type has no encoding, true on success.
+                bool GetValue(Data::Type type, void* address);
+
+                /// @brief Get the bytes not read yet.
+                size_t Remaining() const { return mSize - mPosition; }
+
+                /// @brief Get the next byte to be read.
+                const uint8_t* Position() const { return mData + mPosition; }
+
+            private:
+                const uint8_t*  mData;          // Buffer read
+                size_t          mSize;          // Buffer size
+                size_t          mPosition;      // Next byte to read
+            };
+
+            /// @brief Builds a single binary frame.
+            class Writer
+            {
+            public:
+                /// @brief Start a new frame of a type.
+                /// @param type - [in] - Frame type to start.
+                /// @param reserve - [in] - Byte count to reserve up front.
+                void Begin(FrameType type, size_t reserve = 256);
+
+                /// @brief Append a base 128 varint.
+                /// @param value - [in] - Value to append.
+                void PutVarint(uint64_t value);
+
+                /// @brief Append a raw byte.
+                /// @param value - [in] - Byte to append.
+                void PutU8(uint8_t value);
+
+                /// @brief Append a little-endian 64 bit value.
+                /// @param value - [in] - Value to append.
+                void PutU64(uint64_t value);
+
+                /// @brief Append raw bytes, such as items encoded ahead of time.
+                /// @param data - [in] - Bytes to append.
+                /// @param size - [in] - Byte count.
+                void PutBytes(const uint8_t* data, size_t size);
+
+                /// @brief Append a value read from memory of a data type.
+                /// @param type - [in] - Data type located at address.
+                /// @param address - [in] - Memory to read the value from.
+                void PutValue(Data::Type type, const void* address);
+
+                /// @brief Append a numeric value converted to a data type.
+                /// @param type - [in] - Data type to encode the value as.
+                /// @param value - [in] - Value to encode.
+                void PutNumber(Data::Type type, double value);
+
+                /// @brief Append one item to a VALUES frame.
+                /// @param id - [in] - Item id assigned at registration.
+                /// @param type - [in] - Data type of the item.
+                /// @param address - [in] - Memory of the item.
+                void AddValue(uint32_t id, Data::Type type, const void* address);
+
+                /// @brief Append one series to a SAMPLES frame.
+                /// @param id - [in] - Item id assigned at registration.
+                /// @param type - [in] - Data type of the item.
+                /// @param timestamps - [in] - Sample times in milliseconds, ascending.
+                /// @param values - [in] - Sample values.
+                /// @param count - [in] - Number of samples.
+                void AddSeries(uint32_t id, Data::Type type, const uint64_t* timestamps, const double* values, size_t count);
+
+                /// @brief Start one series of a GORILLA frame, its blocks are added after.
+                /// @param id - [in] - Item id assigned at registration.
+                /// @param type - [in] - Data type of the item.
+                /// @param blocks - [in] - Number of blocks that follow.
+                void BeginBlocks(uint32_t id, Data::Type type, size_t blocks);
+
+                /// @brief Append one encoded block to the current GORILLA series.
+                /// @param count - [in] - Number of samples in the block.
+                /// @param data - [in] - Encoded block bytes.
+                /// @param size - [in] - Encoded block size in bytes.
+                void AddBlock(uint32_t count, const uint8_t* data, size_t size);
+
+                /// @brief Patch the item count of the frame once all items are added.
+                /// @param count - [in] - Item or series count in the frame.
+                /// @return The finished frame buffer.
+                const std::vector<uint8_t>& Finish(uint32_t count);
+
+                /// @brief Get the current frame buffer.
+                const std::vector<uint8_t>& Buffer() const { return mBuffer; }
+
+            private:
+                std::vector<uint8_t>    mBuffer;        // Frame bytes
+            };
+        }
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_BINARY_PROTOCOL
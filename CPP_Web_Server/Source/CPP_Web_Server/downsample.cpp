@@ -0,0 +1,330 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       downsample.cpp
+//!
+//! @brief      Implementation of the graph series downsampling
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "downsample.h"              // Downsample
+#include    <cmath>                     // fabs
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include    <emmintrin.h>               // SSE2 intrinsics
+#define     DOWNSAMPLE_SSE2
+#endif
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        namespace Downsample
+        {
+            /// @brief Find the minimum and maximum of a contiguous range, two lanes at a time.
+            static void RangeMinMax(const double* values, size_t count, double& minimum, double& maximum)
+            {
+                size_t i = 0;
+                double mn = values[0];
+                double mx = values[0];
+
+#ifdef DOWNSAMPLE_SSE2
+                if (count >= 4)
+                {
+                    __m128d min0 = _mm_loadu_pd(values);
+                    __m128d max0 = min0;
+                    __m128d min1 = _mm_loadu_pd(values + 2);
+                    __m128d max1 = min1;
+
+                    for (i = 4; i + 4 <= count; i += 4)
+                    {
+                        __m128d a = _mm_loadu_pd(values + i);
+                        __m128d b = _mm_loadu_pd(values + i + 2);
+                        min0 = _mm_min_pd(min0, a);
+                        max0 = _mm_max_pd(max0, a);
+                        min1 = _mm_min_pd(min1, b);
+                        max1 = _mm_max_pd(max1, b);
+                    }
+
+                    double lanes[2];
+                    _mm_storeu_pd(lanes, _mm_min_pd(min0, min1));
+                    mn = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+                    _mm_storeu_pd(lanes, _mm_max_pd(max0, max1));
+                    mx = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+                }
+#endif
+                for (; i < count; i++)
+                {
+                    mn = values[i] < mn ? values[i] : mn;
+                    mx = values[i] > mx ? values[i] : mx;
+                }
+
+                minimum = mn;
+                maximum = mx;
+            }
+
+            /// @brief Sum a contiguous range, two lanes at a time.
+            static double RangeSum(const double* values, size_t count)
+            {
+                size_t i = 0;
+                double sum = 0.0;
+
+#ifdef DOWNSAMPLE_SSE2
+                __m128d acc0 = _mm_setzero_pd();
+                __m128d acc1 = _mm_setzero_pd();
+                for (; i + 4 <= count; i += 4)
+                {
+                    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(values + i));
+                    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(values + i + 2));
+                }
+
+                double lanes[2];
+                _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+                sum = lanes[0] + lanes[1];
+#endif
+                for (; i < count; i++)
+                {
+                    sum += values[i];
+                }
+
+                return sum;
+            }
+
+            /// @brief Find the first index in a range holding a value.
+            static size_t RangeFind(const double* values, size_t count, double value)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (values[i] == value)
+                    {
+                        return i;
+                    }
+                }
+
+                // Only reachable for NaN, which never compares equal
+                return 0;
+            }
+
+            Mode ModeFromName(const std::string& name)
+            {
+                if (name == "minmax")
+                {
+                    return Mode::MINMAX;
+                }
+
+                if (name == "lttb")
+                {
+                    return Mode::LTTB;
+                }
+
+                return Mode::NONE;
+            }
+
+            void MinMax(const uint64_t* times, const double* values, size_t count, size_t target,
+                        std::vector<uint64_t>& outTimes, std::vector<double>& outValues)
+            {
+                outTimes.clear();
+                outValues.clear();
+
+                if (target == 0 || count <= target)
+                {
+                    outTimes.assign(times, times + count);
+                    outValues.assign(values, values + count);
+                    return;
+                }
+
+                // One point has no room for a pair, keep the maximum
+                size_t buckets = target / 2;
+                if (buckets == 0)
+                {
+                    double mn = 0.0;
+                    double mx = 0.0;
+                    RangeMinMax(values, count, mn, mx);
+                    size_t index = RangeFind(values, count, mx);
+                    outTimes.push_back(times[index]);
+                    outValues.push_back(values[index]);
+                    return;
+                }
+
+                outTimes.reserve(buckets * 2);
+                outValues.reserve(buckets * 2);
+
+                for (size_t b = 0; b < buckets; b++)
+                {
+                    size_t first = b * count / buckets;
+                    size_t last = (b + 1) * count / buckets;
+                    size_t size = last - first;
+
+                    double mn = 0.0;
+                    double mx = 0.0;
+                    RangeMinMax(values + first, size, mn, mx);
+
+                    size_t minIndex = first + RangeFind(values + first, size, mn);
+                    size_t maxIndex = first + RangeFind(values + first, size, mx);
+
+                    // Emit the pair in time order, once if both are the same sample
+                    size_t a = minIndex < maxIndex ? minIndex : maxIndex;
+                    size_t c = minIndex < maxIndex ? maxIndex : minIndex;
+                    outTimes.push_back(times[a]);
+                    outValues.push_back(values[a]);
+                    if (c != a)
+                    {
+                        outTimes.push_back(times[c]);
+                        outValues.push_back(values[c]);
+                    }
+                }
+            }
+
+            void LTTB(const uint64_t* times, const double* values, size_t count, size_t target,
+                      std::vector<uint64_t>& outTimes, std::vector<double>& outValues)
+            {
+                outTimes.clear();
+                outValues.clear();
+
+                if (target == 0 || count <= target)
+                {
+                    outTimes.assign(times, times + count);
+                    outValues.assign(values, values + count);
+                    return;
+                }
+
+                // Too few points for a bucket between the ends, keep the ends
+                if (target < 3)
+                {
+                    outTimes.push_back(times[0]);
+                    outValues.push_back(values[0]);
+                    if (target == 2)
+                    {
+                        outTimes.push_back(times[count - 1]);
+                        outValues.push_back(values[count - 1]);
+                    }
+                    return;
+                }
+
+                outTimes.reserve(target);
+                outValues.reserve(target);
+
+                // Work in times relative to the first sample so areas stay precise
+                const uint64_t origin = times[0];
+                const double every = static_cast<double>(count - 2) / static_cast<double>(target - 2);
+
+                size_t picked = 0;
+                outTimes.push_back(times[0]);
+                outValues.push_back(values[0]);
+
+                for (size_t b = 0; b < target - 2; b++)
+                {
+                    // Current bucket
+                    size_t first = static_cast<size_t>(b * every) + 1;
+                    size_t last = static_cast<size_t>((b + 1) * every) + 1;
+
+                    // Average point of the next bucket, the last sample for the final bucket
+                    size_t nextFirst = last;
+                    size_t nextLast = static_cast<size_t>((b + 2) * every) + 1;
+                    nextLast = nextLast < count ? nextLast : count;
+                    if (nextFirst >= nextLast)
+                    {
+                        nextFirst = count - 1;
+                        nextLast = count;
+                    }
+
+                    size_t nextSize = nextLast - nextFirst;
+                    double cy = RangeSum(values + nextFirst, nextSize) / static_cast<double>(nextSize);
+                    double cx = (static_cast<double>(times[nextFirst] - origin) + static_cast<double>(times[nextLast - 1] - origin)) / 2.0;
+
+                    double ax = static_cast<double>(times[picked] - origin);
+                    double ay = values[picked];
+
+                    // Twice the triangle area is |k1 * y + k2 * x + k0|, so the terms
+                    // that only depend on the anchors are hoisted out of the scan.
+                    double k1 = ax - cx;
+                    double k2 = cy - ay;
+                    double k0 = -k1 * ay - k2 * ax;
+
+                    double bestArea = -1.0;
+                    size_t best = first;
+                    for (size_t i = first; i < last; i++)
+                    {
+                        double area = std::fabs(k1 * values[i] + k2 * static_cast<double>(times[i] - origin) + k0);
+                        if (area > bestArea)
+                        {
+                            bestArea = area;
+                            best = i;
+                        }
+                    }
+
+                    outTimes.push_back(times[best]);
+                    outValues.push_back(values[best]);
+                    picked = best;
+                }
+
+                outTimes.push_back(times[count - 1]);
+                outValues.push_back(values[count - 1]);
+            }
+
+            void MergeBuckets(size_t target, std::vector<uint64_t>& times, std::vector<double>& values,
+                              std::vector<double>& minimums, std::vector<double>& maximums)
+            {
+                size_t count = times.size();
+                if (target == 0 || count <= target)
+                {
+                    return;
+                }
+
+                // Merge in place, the write cursor never passes the read cursor
+                for (size_t b = 0; b < target; b++)
+                {
+                    size_t first = b * count / target;
+                    size_t last = (b + 1) * count / target;
+                    size_t size = last - first;
+
+                    double mn = 0.0;
+                    double mx = 0.0;
+                    double unused = 0.0;
+                    RangeMinMax(minimums.data() + first, size, mn, unused);
+                    RangeMinMax(maximums.data() + first, size, unused, mx);
+
+                    times[b] = times[first];
+                    values[b] = RangeSum(values.data() + first, size) / static_cast<double>(size);
+                    minimums[b] = mn;
+                    maximums[b] = mx;
+                }
+
+                times.resize(target);
+                values.resize(target);
+                minimums.resize(target);
+                maximums.resize(target);
+            }
+
+            void Apply(Mode mode, size_t target, std::vector<uint64_t>& times, std::vector<double>& values)
+            {
+                if (mode == Mode::NONE || times.size() <= target)
+                {
+                    return;
+                }
+
+                std::vector<uint64_t> outTimes;
+                std::vector<double> outValues;
+
+                if (mode == Mode::MINMAX)
+                {
+                    MinMax(times.data(), values.data(), times.size(), target, outTimes, outValues);
+                }
+                else
+                {
+                    LTTB(times.data(), values.data(), times.size(), target, outTimes, outValues);
+                }
+
+                times.swap(outTimes);
+                values.swap(outValues);
+            }
+        }
+    } // End Communications
+} // End Essentials
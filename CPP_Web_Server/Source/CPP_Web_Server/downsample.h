@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       downsample.h
+//!
+//! @brief      Server side reduction of graph series to a target point count.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <vector>                           // Output series
+#include <string>                           // Mode names
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_DOWNSAMPLE                  // Define the downsample header.
+#define     CPP_DOWNSAMPLE
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        namespace Downsample
+        {
+            /// @brief Downsampling algorithms
+            enum class Mode : uint8_t
+            {
+                NONE,
+                MINMAX,
+                LTTB,
+            };
+
+            /// @brief Convert a query string mode name to a mode.
+            /// @param name - [in] - "minmax" or "lttb".
+            /// @return matching mode, NONE if unknown.
+            Mode ModeFromName(const std::string& name);
+
+            /// @brief Keep the minimum and maximum of each of target / 2 equal count buckets,
+            ///        emitted in time order. Preserves spikes a chart would otherwise drop.
+            /// @param times - [in] - Sample times, ascending.
+            /// @param values - [in] - Sample values.
+            /// @param count - [in] - Number of samples.
+            /// @param target - [in] - Maximum number of points to produce, 0 keeps every sample.
+            ///                        A target of 1 keeps the maximum.
+            /// @param outTimes - [out] - Reduced sample times.
+            /// @param outValues - [out] - Reduced sample values.
+            void MinMax(const uint64_t* times, const double* values, size_t count, size_t target,
+                        std::vector<uint64_t>& outTimes, std::vector<double>& outValues);
+
+            /// @brief Largest-Triangle-Three-Buckets. Keeps the first and last samples and
+            ///        from each bucket between them the sample forming the largest triangle
+            ///        with the previous pick and the average of the next bucket.
+            /// @param times - [in] - Sample times, ascending.
+            /// @param values - [in] - Sample values.
+            /// @param count - [in] - Number of samples.
+            /// @param target - [in] - Number of points to produce, 0 keeps every sample.
+            ///                        Below 3 only the first, then the last, sample is kept.
+            /// @param outTimes - [out] - Reduced sample times.
+            /// @param outValues - [out] - Reduced sample values.
+            void LTTB(const uint64_t* times, const double* values, size_t count, size_t target,
+                      std::vector<uint64_t>& outTimes, std::vector<double>& outValues);
+
+            /// @brief Merge neighbouring rollup buckets until at most target remain. Each merged
+            ///        bucket keeps the first start time, the smallest minimum, the largest
+            ///        maximum and the mean of the averages.
+            /// @param target - [in] - Maximum number of buckets to produce.
+            /// @param times - [in/out] - Bucket start times, ascending.
+            /// @param values - [in/out] - Bucket averages.
+            /// @param minimums - [in/out] - Bucket minimums.
+            /// @param maximums - [in/out] - Bucket maximums.
+            void MergeBuckets(size_t target, std::vector<uint64_t>& times, std::vector<double>& values,
+                              std::vector<double>& minimums, std::vector<double>& maximums);
+
+            /// @brief Reduce a series in place with a mode.
+            /// @param mode - [in] - Algorithm to apply.
+            /// @param target - [in] - Number of points to produce.
+            /// @param times - [in/out] - Sample times, ascending.
+            /// @param values - [in/out] - Sample values.
+            void Apply(Mode mode, size_t target, std::vector<uint64_t>& times, std::vector<double>& values);
+        }
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_DOWNSAMPLE
@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       function_executor.cpp
+//!
+//! @brief      Implementation of the function executor
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "function_executor.h"       // Function Executor
+#include    <exception>                 // Failed calls
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        FunctionExecutor::FunctionExecutor()
+        {
+            mCapacity = 0;
+            mStatistics = {};
+            mRunning = false;
+        }
+
+        FunctionExecutor::~FunctionExecutor()
+        {
+            Stop();
+        }
+
+        int8_t FunctionExecutor::Start(NotifyCallback notify, size_t threads, size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mRunning || threads == 0 || capacity == 0)
+            {
+                return -1;
+            }
+
+            mNotify = notify;
+            mCapacity = capacity;
+            mRunning = true;
+            for (size_t i = 0; i < threads; i++)
+            {
+                mWorkers.emplace_back(&FunctionExecutor::Run, this);
+            }
+            return 0;
+        }
+
+        void FunctionExecutor::Stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRunning = false;
+                mQueue.clear();
+            }
+            mWake.notify_all();
+
+            for (std::thread& worker : mWorkers)
+            {
+                if (worker.joinable())
+                {
+                    worker.join();
+                }
+            }
+            mWorkers.clear();
+        }
+
+        int8_t FunctionExecutor::Submit(const FunctionCall& call)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (!mRunning || call.function == nullptr || mQueue.size() >= mCapacity)
+                {
+                    mStatistics.rejected++;
+                    return -1;
+                }
+
+                mQueue.push_back(call);
+                mStatistics.submitted++;
+            }
+            mWake.notify_one();
+            return 0;
+        }
+
+        void FunctionExecutor::TakeResults(std::vector<FunctionResult>& results)
+        {
+            results.clear();
+            std::lock_guard<std::mutex> lock(mMutex);
+            results.swap(mResults);
+        }
+
+        FunctionExecutorStatistics FunctionExecutor::GetStatistics()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mStatistics;
+        }
+
+        void FunctionExecutor::Run()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (true)
+            {
+                mWake.wait(lock, [this]() { return !mRunning || !mQueue.empty(); });
+                if (!mRunning)
+                {
+                    return;
+                }
+
+                FunctionCall call = mQueue.front();
+                mQueue.pop_front();
+                lock.unlock();
+
+                FunctionResult result = { call.id, call.function, call.connection, true, Data::Value(), std::string() };
+
+                // A throwing function must not take the worker down with it
+                try
+                {
+                    result.value = call.function->Invoke(call.arguments);
+                }
+                catch (const std::exception& exception)
+                {
+                    result.success = false;
+                    result.error = exception.what();
+                }
+                catch (...)
+                {
+                    result.success = false;
+                    result.error = "function failed";
+                }
+
+                lock.lock();
+                mResults.push_back(std::move(result));
+                mStatistics.completed++;
+                lock.unlock();
+
+                if (mNotify)
+                {
+                    mNotify();
+                }
+                lock.lock();
+            }
+        }
+    } // End Communications
+} // End Essentials
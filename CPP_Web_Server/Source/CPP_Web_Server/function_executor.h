@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       function_executor.h
+//!
+//! @brief      Bounded pool of worker threads running published function
+//!             calls away from the server thread.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Error text
+#include <vector>                           // Workers and results
+#include <deque>                            // Call queue
+#include <functional>                       // Handler callbacks
+#include <thread>                           // Worker threads
+#include <mutex>                            // Queue protection
+#include <condition_variable>               // Worker wake up
+#include "publishable_types.h"              // Published functions
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_FUNCTION_EXECUTOR           // Define the function executor header.
+#define     CPP_FUNCTION_EXECUTOR
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static size_t FUNCTION_EXECUTOR_THREADS   = 2;    // Default worker threads
+        const static size_t FUNCTION_EXECUTOR_QUEUE     = 64;   // Default calls waiting before submissions are refused
+
+        /// @brief One call waiting to run.
+        struct FunctionCall
+        {
+            uint64_t            id;             // Call id handed back to the caller
+            PublishedFunction*  function;       // Function to call, must outlive the call
+            unsigned long       connection;     // Websocket to deliver the result to, 0 for every websocket
+            Function::Arguments arguments;      // Arguments accepted by the function's parser
+        };
+
+        /// @brief Outcome of a finished call.
+        struct FunctionResult
+        {
+            uint64_t            id;             // Call id
+            PublishedFunction*  function;       // Function called
+            unsigned long       connection;     // Websocket to deliver the result to, 0 for every websocket
+            bool                success;        // false if the function threw
+            Data::Value         value;          // Returned value, NONE when nothing is returned
+            std::string         error;          // Reason when not successful
+        };
+
+        /// @brief Executor bookkeeping counters.
+        struct FunctionExecutorStatistics
+        {
+            uint64_t    submitted;          // Calls accepted
+            uint64_t    rejected;           // Calls refused with the queue full
+            uint64_t    completed;          // Calls finished, successful or not
+        };
+
+        /// @brief Runs calls on a fixed set of worker threads from a bounded queue. Finished
+        ///        calls collect in a result list the owner drains when notified.
+        class FunctionExecutor
+        {
+        public:
+            using NotifyCallback = std::function<void()>;
+
+            FunctionExecutor();
+            ~FunctionExecutor();
+
+            FunctionExecutor(const FunctionExecutor&) = delete;
+            FunctionExecutor& operator=(const FunctionExecutor&) = delete;
+
+            /// @brief Start the worker threads.
+            /// @param notify - [in] - Called on a worker thread after each result is added.
+            /// @param threads - [in] - Number of worker threads.
+            /// @param capacity - [in] - Calls that may wait before Submit refuses more.
+            /// @return -1 on error, 0 on success
+            int8_t Start(NotifyCallback notify, size_t threads = FUNCTION_EXECUTOR_THREADS,
+                size_t capacity = FUNCTION_EXECUTOR_QUEUE);
+
+            /// @brief Finish the calls running, drop the ones waiting and join the workers.
+            void Stop();
+
+            /// @brief Queue a call.
+            /// @param call - [in] - Call to run.
+            /// @return -1 if stopped or the queue is full, 0 on success
+            int8_t Submit(const FunctionCall& call);
+
+            /// @brief Move out every finished result.
+            /// @param results - [out] - Replaced with the results in completion order.
+            void TakeResults(std::vector<FunctionResult>& results);
+
+            /// @brief Get a copy of the executor counters.
+            FunctionExecutorStatistics GetStatistics();
+
+        private:
+            /// @brief Worker thread loop.
+            void Run();
+
+            std::vector<std::thread>    mWorkers;       // Worker threads
+            std::deque<FunctionCall>    mQueue;         // Calls waiting
+            std::vector<FunctionResult> mResults;       // Calls finished and not yet taken
+            size_t                      mCapacity;      // Most calls waiting
+            NotifyCallback              mNotify;        // Tells the owner about results
+            FunctionExecutorStatistics  mStatistics;    // Counters
+            std::mutex                  mMutex;         // Guards queue, results and counters
+            std::condition_variable     mWake;          // Wakes workers
+            bool                        mRunning;       // Worker run flag
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_FUNCTION_EXECUTOR
@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       function_marshal.h
+//!
+//! @brief      Publishes functions of any supported C++ signature, with the
+//!             argument parsers for each signature generated at compile time.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <cstring>                          // memcmp, memcpy
+#include <string>                           // Strings
+#include <tuple>                            // Argument tuples
+#include <utility>                          // Index sequences
+#include <functional>                       // std::function
+#include <stdexcept>                        // Rejected arguments
+#include <type_traits>                      // Signature inspection
+#include <charconv>                         // Number parsing
+#include <cmath>                            // isfinite
+#include "json_index.h"                     // JSON access
+#include "publishable_types.h"              // Published functions
+#include "binary_protocol.h"                // Argument encoding
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_FUNCTION_MARSHAL            // Define the function marshal header.
+#define     CPP_FUNCTION_MARSHAL
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        //  A call's arguments are checked where the request arrives, straight from the
+        //  request buffer, then carried to the executor in a Function::Arguments block
+        //  holding them in the binary protocol encoding. The worker decodes the block into
+        //  a tuple on its stack and applies the function to it.
+        //
+        //  Supported argument and return types are those of Data::Type: char, unsigned
+        //  char, short, unsigned short, int, unsigned int, float, double, bool and
+        //  std::string, by value or const reference. Only string arguments longer than
+        //  the small string buffer allocate.
+        namespace Marshal
+        {
+            /// @brief Data type of a C++ argument or return type, NONE if unsupported.
+            template <typename T>
+            constexpr Data::Type TypeOf()
+            {
+                using U = std::remove_cv_t<std::remove_reference_t<T>>;
+                if constexpr (std::is_same_v<U, bool>)                  return Data::Type::BOOL;
+                else if constexpr (std::is_same_v<U, char>)             return Data::Type::CHAR;
+                else if constexpr (std::is_same_v<U, unsigned char>)    return Data::Type::UCHAR;
+                else if constexpr (std::is_same_v<U, short>)            return Data::Type::SHORT;
+                else if constexpr (std::is_same_v<U, unsigned short>)   return Data::Type::USHORT;
+                else if constexpr (std::is_same_v<U, int>)              return Data::Type::INT;
+                else if constexpr (std::is_same_v<U, unsigned int>)     return Data::Type::UINT;
+                else if constexpr (std::is_same_v<U, float>)            return Data::Type::FLOAT;
+                else if constexpr (std::is_same_v<U, double>)           return Data::Type::DOUBLE;
+                else if constexpr (std::is_same_v<U, std::string>)      return Data::Type::STRING;
+                else                                                    return Data::Type::NONE;
+            }
+
+            /// @brief Parse a JSON token as a value of T, failing when it is another kind of
+            ///        value or out of the range of T.
+            /// @param token - [in] - Token text as located by the JSON index.
+            /// @param length - [in] - Token length.
+            /// @param value - [out] - Parsed value.
+            /// @return false if the token is not a valid T, true on success.
+            template <typename T>
+            bool ParseJson(const char* token, size_t length, T& value)
+            {
+                if constexpr (std::is_same_v<T, std::string>)
+                {
+                    if (length < 2 || token[0] != '"')
+                    {
+                        return false;
+                    }
+                    return Json::Unescape(token + 1, length - 2, value);
+                }
+                else if constexpr (std::is_same_v<T, bool>)
+                {
+                    if (length == 4 && memcmp(token, "true", 4) == 0)
+                    {
+                        value = true;
+                        return true;
+                    }
+                    if (length == 5 && memcmp(token, "false", 5) == 0)
+                    {
+                        value = false;
+                        return true;
+                    }
+                    return false;
+                }
+                else
+                {
+                    std::from_chars_result result = std::from_chars(token, token + length, value);
+                    if (result.ec != std::errc() || result.ptr != token + length)
+                    {
+                        return false;
+                    }
+
+                    if constexpr (std::is_floating_point_v<T>)
+                    {
+                        return std::isfinite(value);
+                    }
+                    return true;
+                }
+            }
+
+            /// @brief Parse one element of a JSON argument array and append it to the block.
+            /// @param json - [in] - Request document index.
+            /// @param array - [in] - Argument array.
+            /// @param element - [in/out] - Element to parse, advanced past it.
+            /// @param arguments - [in/out] - Block to append to.
+            /// @return false if the element is missing, invalid or does not fit, true on success.
+            template <typename T>
+            bool ParseJsonElement(const JsonIndex& json, int array, int& element, Function::Arguments& arguments)
+            {
+                mg_str token = json.GetText(element);
+                element = json.Next(element, array);
+
+                T value{};
+                if (token.len == 0 || !ParseJson(token.ptr, token.len, value))
+                {
+                    return false;
+                }
+
+                size_t written = Binary::EncodeValue(TypeOf<T>(), &value, arguments.bytes + arguments.size,
+                    Function::ARGUMENTS_MAX - arguments.size);
+                arguments.size += written;
+                return written > 0;
+            }
+
+            /// @brief Parse a JSON array of arguments into their encoded block. An absent
+            ///        array is accepted for functions taking no arguments.
+            template <typename... Args>
+            bool ParseJsonArguments(const JsonIndex& json, int array, Function::Arguments& arguments)
+            {
+                arguments.size = 0;
+                if (array < 0)
+                {
+                    return sizeof...(Args) == 0;
+                }
+
+                // Extra arguments are an error, not ignored
+                if (!json.Is(array, Json::Kind::ARRAY) || json.GetCount(array) != sizeof...(Args))
+                {
+                    return false;
+                }
+
+                // Parsed in order, each into a value on the stack
+                int element = json.First(array);
+                return (... && ParseJsonElement<Args>(json, array, element, arguments));
+            }
+
+            /// @brief Read one binary argument to check it.
+            template <typename T>
+            bool CheckBinaryElement(Binary::Reader& reader)
+            {
+                T value{};
+                return reader.GetValue(TypeOf<T>(), &value);
+            }
+
+            /// @brief Check arguments received in the binary encoding and copy them into their
+            ///        block. They must fill the data exactly.
+            template <typename... Args>
+            bool ParseBinaryArguments(const uint8_t* data, size_t size, Function::Arguments& arguments)
+            {
+                if (size > Function::ARGUMENTS_MAX)
+                {
+                    return false;
+                }
+
+                Binary::Reader reader(data, size);
+                if (!(... && CheckBinaryElement<Args>(reader)) || reader.Remaining() != 0)
+                {
+                    return false;
+                }
+
+                memcpy(arguments.bytes, data, size);
+                arguments.size = size;
+                return true;
+            }
+
+            /// @brief Decode an argument block into a tuple and call the function with it.
+            template <typename R, typename... Args, size_t... I>
+            Data::Value Apply(const std::function<R(Args...)>& function, const Function::Arguments& arguments, std::index_sequence<I...>)
+            {
+                std::tuple<std::decay_t<Args>...> values;
+                Binary::Reader reader(arguments.bytes, arguments.size);
+                if (!(... && reader.GetValue(TypeOf<Args>(), &std::get<I>(values))))
+                {
+                    throw std::invalid_argument("invalid arguments");
+                }
+
+                if constexpr (std::is_void_v<R>)
+                {
+                    std::apply(function, values);
+                    return Data::Value();
+                }
+                else if constexpr (std::is_same_v<std::decay_t<R>, std::string>)
+                {
+                    return Data::Value(std::apply(function, values));
+                }
+                else
+                {
+                    return Data::Value(TypeOf<R>(), static_cast<double>(std::apply(function, values)));
+                }
+            }
+        }
+
+        /// @brief Publish a function of any supported signature. Its argument types are listed
+        ///        in args and its calls take their arguments from the request.
+        /// @param function - [in] - Function to publish.
+        /// @param name - [in] - Unique name of the function.
+        /// @param description - [in] - Description shown with the function.
+        /// @return The function ready for Web_Server::AddPublishedFunction.
+        template <typename R, typename... Args>
+        PublishedFunction MakePublishedFunction(std::function<R(Args...)> function, std::string name, std::string description)
+        {
+            static_assert(((Marshal::TypeOf<Args>() != Data::Type::NONE) && ...), "Unsupported argument type");
+            static_assert(std::is_void_v<R> || Marshal::TypeOf<R>() != Data::Type::NONE, "Unsupported return type");
+
+            PublishedFunction published(name);
+            published.description   = description;
+            published.args          = { Marshal::TypeOf<Args>()... };
+            published.parse_json    = &Marshal::ParseJsonArguments<std::decay_t<Args>...>;
+            published.parse_binary  = &Marshal::ParseBinaryArguments<std::decay_t<Args>...>;
+            published.typed         = [function](const Function::Arguments& arguments)
+            {
+                return Marshal::Apply(function, arguments, std::index_sequence_for<Args...>());
+            };
+
+            if constexpr (!std::is_void_v<R>)
+            {
+                published.return_type = Marshal::TypeOf<R>();
+                published.access      = Function::Access::EXECUTE_READBACK;
+            }
+
+            return published;
+        }
+
+        /// @brief Publish a function pointer or lambda, deducing its signature.
+        template <typename F>
+        PublishedFunction MakePublishedFunction(F function, std::string name, std::string description)
+        {
+            return MakePublishedFunction(std::function(function), name, description);
+        }
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_FUNCTION_MARSHAL
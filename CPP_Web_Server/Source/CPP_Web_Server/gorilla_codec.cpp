@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       gorilla_codec.cpp
+//!
+//! @brief      Implementation of the gorilla block codec
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "gorilla_codec.h"           // Gorilla Codec
+#include    <cstring>                   // memcpy
+#ifdef _MSC_VER
+#include    <intrin.h>                  // Bit scan intrinsics
+#endif
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        namespace Gorilla
+        {
+            /// @brief Count leading zero bits of a non zero value.
+            static uint32_t LeadingZeros(uint64_t value)
+            {
+#ifdef _MSC_VER
+                unsigned long index = 0;
+                _BitScanReverse64(&index, value);
+                return 63 - static_cast<uint32_t>(index);
+#else
+                return static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+            }
+
+            /// @brief Count trailing zero bits of a non zero value.
+            static uint32_t TrailingZeros(uint64_t value)
+            {
+#ifdef _MSC_VER
+                unsigned long index = 0;
+                _BitScanForward64(&index, value);
+                return static_cast<uint32_t>(index);
+#else
+                return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+            }
+
+            /// @brief Sign extend the low bits of a value.
+            static int64_t SignExtend(uint64_t bits, uint32_t count)
+            {
+                uint64_t sign = 1ull << (count - 1);
+                return static_cast<int64_t>((bits ^ sign) - sign);
+            }
+
+            /// @brief Load eight bytes as a big-endian word, the bit order of a block.
+            static uint64_t LoadBigEndian(const uint8_t* data)
+            {
+                uint64_t word;
+                memcpy(&word, data, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                return word;
+#elif defined(_MSC_VER)
+                return _byteswap_uint64(word);
+#else
+                return __builtin_bswap64(word);
+#endif
+            }
+
+            static uint64_t DoubleBits(double value)
+            {
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                return bits;
+            }
+
+            static double BitsDouble(uint64_t bits)
+            {
+                double value;
+                memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+
+            BitWriter::BitWriter()
+            {
+                mUsed = 0;
+            }
+
+            void BitWriter::Write(uint64_t bits, uint32_t count)
+            {
+                while (count > 0)
+                {
+                    if (mUsed == 0)
+                    {
+                        mBytes.push_back(0);
+                    }
+
+                    uint32_t space = 8 - mUsed;
+                    uint32_t take = count < space ? count : space;
+                    uint8_t chunk = static_cast<uint8_t>((bits >> (count - take)) & ((1u << take) - 1));
+
+                    mBytes.back() |= static_cast<uint8_t>(chunk << (space - take));
+                    mUsed = (mUsed + take) & 7;
+                    count -= take;
+                }
+            }
+
+            std::vector<uint8_t> BitWriter::Take()
+            {
+                std::vector<uint8_t> bytes;
+                bytes.swap(mBytes);
+                mUsed = 0;
+                return bytes;
+            }
+
+            BitReader::BitReader(const uint8_t* data, size_t size)
+            {
+                mData = data;
+                mSize = size;
+                mPosition = 0;
+            }
+
+            bool BitReader::Read(uint32_t count, uint64_t& bits)
+            {
+                if (mPosition + count > mSize * 8)
+                {
+                    return false;
+                }
+
+                // Away from the end of the block one unaligned word load covers any
+                // read of up to 57 bits
+                size_t byte = mPosition >> 3;
+                uint32_t shift = static_cast<uint32_t>(mPosition & 7);
+                if (count > 0 && count + shift <= 64 && byte + 8 <= mSize)
+                {
+                    bits = (LoadBigEndian(mData + byte) << shift) >> (64 - count);
+                    mPosition += count;
+                    return true;
+                }
+
+                bits = 0;
+                while (count > 0)
+                {
+                    uint32_t used = static_cast<uint32_t>(mPosition & 7);
+                    uint32_t space = 8 - used;
+                    uint32_t take = count < space ? count : space;
+                    uint8_t byte = mData[mPosition >> 3];
+                    uint64_t chunk = (byte >> (space - take)) & ((1u << take) - 1);
+
+                    bits = (bits << take) | chunk;
+                    mPosition += take;
+                    count -= take;
+                }
+
+                return true;
+            }
+
+            uint64_t BitReader::Peek(uint32_t count) const
+            {
+                uint64_t bits = 0;
+                size_t byte = mPosition >> 3;
+                uint32_t shift = static_cast<uint32_t>(mPosition & 7);
+
+                if (byte + 8 <= mSize)
+                {
+                    return (LoadBigEndian(mData + byte) << shift) >> (64 - count);
+                }
+
+                // Near the end, bits past the block read as zero
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    size_t position = mPosition + i;
+                    uint64_t bit = position < mSize * 8 ? (mData[position >> 3] >> (7 - (position & 7))) & 1 : 0;
+                    bits = (bits << 1) | bit;
+                }
+
+                return bits;
+            }
+
+            Encoder::Encoder()
+            {
+                mCount = 0;
+                mTimestamp = 0;
+                mDelta = 0;
+                mValue = 0;
+                mLeading = 0;
+                mTrailing = 0;
+            }
+
+            void Encoder::Append(uint64_t timestamp, double value)
+            {
+                uint64_t bits = DoubleBits(value);
+
+                if (mCount == 0)
+                {
+                    mWriter.Write(timestamp, 64);
+                    mWriter.Write(bits, 64);
+                    mTimestamp = timestamp;
+                    mDelta = 0;
+                    mValue = bits;
+                    mLeading = UINT32_MAX;
+                    mCount++;
+                    return;
+                }
+
+                // Timestamp as the change in spacing, a regular rate costs one bit
+                int64_t delta = static_cast<int64_t>(timestamp - mTimestamp);
+                int64_t dod = delta - mDelta;
+
+                if (dod == 0)
+                {
+                    mWriter.Write(0, 1);
+                }
+                else if (dod >= -64 && dod <= 63)
+                {
+                    mWriter.Write(0x2, 2);
+                    mWriter.Write(static_cast<uint64_t>(dod), 7);
+                }
+                else if (dod >= -256 && dod <= 255)
+                {
+                    mWriter.Write(0x6, 3);
+                    mWriter.Write(static_cast<uint64_t>(dod), 9);
+                }
+                else if (dod >= -2048 && dod <= 2047)
+                {
+                    mWriter.Write(0xE, 4);
+                    mWriter.Write(static_cast<uint64_t>(dod), 12);
+                }
+                else
+                {
+                    mWriter.Write(0xF, 4);
+                    mWriter.Write(static_cast<uint64_t>(dod), 64);
+                }
+
+                mTimestamp = timestamp;
+                mDelta = delta;
+
+                // Value as the bits that changed, a steady value costs one bit
+                uint64_t xored = bits ^ mValue;
+                mValue = bits;
+
+                if (xored == 0)
+                {
+                    mWriter.Write(0, 1);
+                }
+                else
+                {
+                    uint32_t leading = LeadingZeros(xored);
+                    uint32_t trailing = TrailingZeros(xored);
+                    leading = leading > 31 ? 31 : leading;
+
+                    if (mLeading != UINT32_MAX && leading >= mLeading && trailing >= mTrailing)
+                    {
+                        // Reuse the previous window
+                        mWriter.Write(0x2, 2);
+                        mWriter.Write(xored >> mTrailing, 64 - mLeading - mTrailing);
+                    }
+                    else
+                    {
+                        uint32_t significant = 64 - leading - trailing;
+                        mWriter.Write(0x3, 2);
+                        mWriter.Write(leading, 5);
+                        mWriter.Write(significant & 63, 6);
+                        mWriter.Write(xored >> trailing, significant);
+                        mLeading = leading;
+                        mTrailing = trailing;
+                    }
+                }
+
+                mCount++;
+            }
+
+            std::vector<uint8_t> Encoder::Take()
+            {
+                mCount = 0;
+                return mWriter.Take();
+            }
+
+            Decoder::Decoder(const uint8_t* data, size_t size, uint32_t count) : mReader(data, size)
+            {
+                mRemaining = count;
+                mIndex = 0;
+                mTimestamp = 0;
+                mDelta = 0;
+                mValue = 0;
+                mLeading = 0;
+                mTrailing = 0;
+            }
+
+            bool Decoder::Next(uint64_t& timestamp, double& value)
+            {
+                if (mRemaining == 0)
+                {
+                    return false;
+                }
+
+                uint64_t bits = 0;
+
+                if (mIndex == 0)
+                {
+                    if (!mReader.Read(64, mTimestamp) || !mReader.Read(64, mValue))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    // The prefix is at most four bits, decode it from one peek
+                    uint64_t prefix = mReader.Peek(4);
+                    uint32_t ones = (prefix & 0x8) == 0 ? 0 : (prefix & 0x4) == 0 ? 1 : (prefix & 0x2) == 0 ? 2 : (prefix & 0x1) == 0 ? 3 : 4;
+
+                    static const uint32_t widths[] = { 0, 7, 9, 12, 64 };
+                    if (!mReader.Read(ones < 4 ? ones + 1 : 4, bits))
+                    {
+                        return false;
+                    }
+
+                    int64_t dod = 0;
+                    if (ones > 0)
+                    {
+                        if (!mReader.Read(widths[ones], bits))
+                        {
+                            return false;
+                        }
+                        dod = ones == 4 ? static_cast<int64_t>(bits) : SignExtend(bits, widths[ones]);
+                    }
+
+                    mDelta += dod;
+                    mTimestamp += static_cast<uint64_t>(mDelta);
+
+                    // Value control bits, '0' equal, '10' same window, '11' new window
+                    uint64_t control = mReader.Peek(2);
+                    if (!mReader.Read(control < 2 ? 1 : 2, bits))
+                    {
+                        return false;
+                    }
+
+                    if (control >= 2)
+                    {
+                        if (control == 3)
+                        {
+                            uint64_t leading = 0;
+                            uint64_t significant = 0;
+                            if (!mReader.Read(5, leading) || !mReader.Read(6, significant))
+                            {
+                                return false;
+                            }
+
+                            significant = significant == 0 ? 64 : significant;
+                            if (leading + significant > 64)
+                            {
+                                return false;
+                            }
+                            mLeading = static_cast<uint32_t>(leading);
+                            mTrailing = static_cast<uint32_t>(64 - leading - significant);
+                        }
+
+                        uint64_t xored = 0;
+                        if (!mReader.Read(64 - mLeading - mTrailing, xored))
+                        {
+                            return false;
+                        }
+                        mValue ^= xored << mTrailing;
+                    }
+                }
+
+                timestamp = mTimestamp;
+                value = BitsDouble(mValue);
+                mIndex++;
+                mRemaining--;
+                return true;
+            }
+        }
+    } // End Communications
+} // End Essentials
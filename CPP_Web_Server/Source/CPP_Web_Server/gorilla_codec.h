@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       gorilla_codec.h
+//!
+//! @brief      Delta-of-delta timestamp and XOR float compression of sample
+//!             blocks, as described for the Gorilla time-series database.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <stddef.h>                         // size_t
+#include <vector>                           // Block bytes
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_GORILLA_CODEC               // Define the gorilla codec header.
+#define     CPP_GORILLA_CODEC
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        //  Block layout, most significant bit first:
+        //
+        //      first sample:   64 bit timestamp, 64 bit value
+        //      timestamps:     delta-of-delta against the previous delta
+        //                          '0'                         dod == 0
+        //                          '10'   + 7 bits             dod in [-64, 63]
+        //                          '110'  + 9 bits             dod in [-256, 255]
+        //                          '1110' + 12 bits            dod in [-2048, 2047]
+        //                          '1111' + 64 bits            otherwise
+        //      values:         XOR against the previous value
+        //                          '0'                         equal
+        //                          '10' + meaningful bits      fits the previous window
+        //                          '11' + 5 bit leading zeros + 6 bit length (0 = 64)
+        //                               + meaningful bits      new window
+        //
+        //  A block does not store its sample count, it is kept next to the block.
+        namespace Gorilla
+        {
+            /// @brief Appends bits to a byte buffer.
+            class BitWriter
+            {
+            public:
+                BitWriter();
+
+                /// @brief Append the low bits of a value, most significant first.
+                /// @param bits - [in] - Value holding the bits.
+                /// @param count - [in] - Number of bits, 0 to 64.
+                void Write(uint64_t bits, uint32_t count);
+
+                /// @brief Get the written bytes, the last one possibly partial.
+                const std::vector<uint8_t>& Bytes() const { return mBytes; }
+
+                /// @brief Release the written bytes and reset the writer.
+                std::vector<uint8_t> Take();
+
+            private:
+                std::vector<uint8_t>    mBytes;     // Written bytes
+                uint32_t                mUsed;      // Bits used in the last byte, 0 for none
+            };
+
+            /// @brief Reads bits from a byte buffer.
+            class BitReader
+            {
+            public:
+                /// @brief Start reading a buffer.
+                /// @param data - [in] - Buffer to read.
+                /// @param size - [in] - Buffer size in bytes.
+                BitReader(const uint8_t* data, size_t size);
+
+                /// @brief Read bits, most significant first.
+                /// @param count - [in] - Number of bits, 0 to 64.
+                /// @param bits - [out] - Bits read into the low end.
+                /// @return false if the buffer ran out, true on success.
+                bool Read(uint32_t count, uint64_t& bits);
+
+                /// @brief Look at upcoming bits without consuming them, zeros past the end.
+                /// @param count - [in] - Number of bits, 1 to 57.
+                /// @return bits in the low end.
+                uint64_t Peek(uint32_t count) const;
+
+            private:
+                const uint8_t*  mData;      // Buffer
+                size_t          mSize;      // Buffer size in bytes
+                size_t          mPosition;  // Bit position
+            };
+
+            /// @brief Compresses samples into one block.
+            class Encoder
+            {
+            public:
+                Encoder();
+
+                /// @brief Append a sample. Timestamps must not go backwards.
+                /// @param timestamp - [in] - Sample time in milliseconds.
+                /// @param value - [in] - Sample value.
+                void Append(uint64_t timestamp, double value);
+
+                /// @brief Get the number of samples appended.
+                uint32_t Count() const { return mCount; }
+
+                /// @brief Get the encoded bytes so far.
+                const std::vector<uint8_t>& Bytes() const { return mWriter.Bytes(); }
+
+                /// @brief Release the encoded block and reset the encoder.
+                std::vector<uint8_t> Take();
+
+            private:
+                BitWriter   mWriter;            // Block bits
+                uint32_t    mCount;             // Samples appended
+                uint64_t    mTimestamp;         // Previous timestamp
+                int64_t     mDelta;             // Previous timestamp delta
+                uint64_t    mValue;             // Previous value bits
+                uint32_t    mLeading;           // Leading zeros of the current XOR window
+                uint32_t    mTrailing;          // Trailing zeros of the current XOR window
+            };
+
+            /// @brief Streams samples back out of one block.
+            class Decoder
+            {
+            public:
+                /// @brief Start decoding a block.
+                /// @param data - [in] - Block bytes.
+                /// @param size - [in] - Block size in bytes.
+                /// @param count - [in] - Number of samples in the block.
+                Decoder(const uint8_t* data, size_t size, uint32_t count);
+
+                /// @brief Decode the next sample.
+                /// @param timestamp - [out] - Sample time in milliseconds.
+                /// @param value - [out] - Sample value.
+                /// @return false at the end of the block or on corrupt data, true on success.
+                bool Next(uint64_t& timestamp, double& value);
+
+            private:
+                BitReader   mReader;            // Block bits
+                uint32_t    mRemaining;         // Samples left
+                uint32_t    mIndex;             // Samples decoded
+                uint64_t    mTimestamp;         // Previous timestamp
+                int64_t     mDelta;             // Previous timestamp delta
+                uint64_t    mValue;             // Previous value bits
+                uint32_t    mLeading;           // Leading zeros of the current XOR window
+                uint32_t    mTrailing;          // Trailing zeros of the current XOR window
+            };
+        }
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_GORILLA_CODEC
@@ -0,0 +1,653 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       graph_history.cpp
+//!
+//! @brief      Implementation of the graph history storage
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "graph_history.h"           // Graph History
+#include    <chrono>                    // Wall clock
+#include    <new>                       // Aligned allocation
+#include    <algorithm>                 // min, partition_point
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        GraphRingBuffer::GraphRingBuffer()
+        {
+            mTimes = nullptr;
+            mValues = nullptr;
+            mCapacity = 0;
+            mOwned = false;
+            mLocalWriteIndex = 0;
+            mWriteIndex = &mLocalWriteIndex;
+        }
+
+        GraphRingBuffer::~GraphRingBuffer()
+        {
+            Release();
+        }
+
+        void GraphRingBuffer::Release()
+        {
+            if (!mOwned)
+            {
+                return;
+            }
+
+            if (mTimes != nullptr)
+            {
+                ::operator delete[](mTimes, std::align_val_t(CACHE_LINE_SIZE));
+            }
+
+            if (mValues != nullptr)
+            {
+                ::operator delete[](mValues, std::align_val_t(CACHE_LINE_SIZE));
+            }
+
+            mTimes = nullptr;
+            mValues = nullptr;
+            mOwned = false;
+        }
+
+        int8_t GraphRingBuffer::Initialize(size_t capacity)
+        {
+            if (capacity == 0 || mCapacity != 0)
+            {
+                return -1;
+            }
+
+            mOwned = true;
+            mTimes = static_cast<uint64_t*>(::operator new[](capacity * sizeof(uint64_t), std::align_val_t(CACHE_LINE_SIZE), std::nothrow));
+            mValues = static_cast<double*>(::operator new[](capacity * sizeof(double), std::align_val_t(CACHE_LINE_SIZE), std::nothrow));
+
+            if (mTimes == nullptr || mValues == nullptr)
+            {
+                return -1;
+            }
+
+            mCapacity = capacity;
+            mWriteIndex->store(0, std::memory_order_release);
+            return 0;
+        }
+
+        int8_t GraphRingBuffer::Attach(uint64_t* times, double* values, std::atomic<uint64_t>* writeIndex, size_t capacity)
+        {
+            if (times == nullptr || values == nullptr || writeIndex == nullptr || capacity == 0)
+            {
+                return -1;
+            }
+
+            Release();
+            mTimes = times;
+            mValues = values;
+            mCapacity = capacity;
+            mWriteIndex = writeIndex;
+            return 0;
+        }
+
+        void GraphRingBuffer::Push(uint64_t timestamp, double value)
+        {
+            // A flag left by a crash mid overwrite means the same slot is written again
+            uint64_t index = mWriteIndex->load(std::memory_order_relaxed) & ~RING_WRITE_PENDING;
+            size_t slot = static_cast<size_t>(index % mCapacity);
+
+            // Retire the oldest sample before its slot changes
+            if (index >= mCapacity)
+            {
+                mWriteIndex->store(index | RING_WRITE_PENDING, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            mTimes[slot] = timestamp;
+            mValues[slot] = value;
+
+            // Publish the sample only once both columns are written
+            mWriteIndex->store(index + 1, std::memory_order_release);
+        }
+
+        size_t GraphRingBuffer::Size() const
+        {
+            uint64_t written = mWriteIndex->load(std::memory_order_acquire);
+            if ((written & RING_WRITE_PENDING) != 0)
+            {
+                // Only ever set once full, the slot being overwritten is not held
+                return mCapacity - 1;
+            }
+
+            return written < mCapacity ? static_cast<size_t>(written) : mCapacity;
+        }
+
+        size_t GraphRingBuffer::UpperBound(uint64_t timestamp) const
+        {
+            size_t low = 0;
+            size_t high = Size();
+
+            // Samples are appended in time order so the logical ring is sorted
+            while (low < high)
+            {
+                size_t mid = low + (high - low) / 2;
+                if (TimeAt(mid) <= timestamp)
+                {
+                    low = mid + 1;
+                }
+                else
+                {
+                    high = mid;
+                }
+            }
+
+            return low;
+        }
+
+        void GraphRingBuffer::Copy(size_t first, size_t count, std::vector<uint64_t>& times, std::vector<double>& values) const
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            times.reserve(times.size() + count);
+            values.reserve(values.size() + count);
+
+            // The range is at most two contiguous spans of storage
+            size_t start = Slot(first);
+            size_t firstSpan = std::min(count, mCapacity - start);
+
+            times.insert(times.end(), mTimes + start, mTimes + start + firstSpan);
+            values.insert(values.end(), mValues + start, mValues + start + firstSpan);
+            times.insert(times.end(), mTimes, mTimes + (count - firstSpan));
+            values.insert(values.end(), mValues, mValues + (count - firstSpan));
+        }
+
+        CompressedSeries::CompressedSeries()
+        {
+            mOpenFirst = 0;
+            mOpenLast = 0;
+            mCapacity = 0;
+            mSealedSamples = 0;
+            mSealedBytes = 0;
+        }
+
+        int8_t CompressedSeries::Initialize(size_t capacity)
+        {
+            if (capacity == 0 || mCapacity != 0)
+            {
+                return -1;
+            }
+
+            mCapacity = capacity;
+            return 0;
+        }
+
+        void CompressedSeries::Push(uint64_t timestamp, double value)
+        {
+            if (mOpen.Count() == 0)
+            {
+                mOpenFirst = timestamp;
+            }
+
+            mOpen.Append(timestamp, value);
+            mOpenLast = timestamp;
+
+            if (mOpen.Count() < GORILLA_BLOCK_SAMPLES)
+            {
+                return;
+            }
+
+            // Seal the full block
+            CompressedBlock block = { mOpenFirst, mOpenLast, mOpen.Count(), mOpen.Take() };
+            block.bytes.shrink_to_fit();
+            mSealedSamples += block.count;
+            mSealedBytes += block.bytes.size();
+            mBlocks.push_back(std::move(block));
+
+            // Drop whole blocks while the rest still covers the capacity
+            while (!mBlocks.empty() && Size() - mBlocks.front().count >= mCapacity)
+            {
+                mSealedSamples -= mBlocks.front().count;
+                mSealedBytes -= mBlocks.front().bytes.size();
+                mBlocks.pop_front();
+            }
+        }
+
+        uint64_t CompressedSeries::OldestTime() const
+        {
+            if (!mBlocks.empty())
+            {
+                return mBlocks.front().first;
+            }
+
+            return mOpen.Count() > 0 ? mOpenFirst : UINT64_MAX;
+        }
+
+        uint64_t CompressedSeries::NewestTime() const
+        {
+            if (mOpen.Count() > 0)
+            {
+                return mOpenLast;
+            }
+
+            return !mBlocks.empty() ? mBlocks.back().last : 0;
+        }
+
+        void CompressedSeries::Copy(uint64_t since, uint64_t until, std::vector<uint64_t>& times, std::vector<double>& values) const
+        {
+            auto decode = [&](const uint8_t* data, size_t size, uint32_t count)
+            {
+                Gorilla::Decoder decoder(data, size, count);
+                uint64_t timestamp = 0;
+                double value = 0.0;
+                while (decoder.Next(timestamp, value) && timestamp <= until)
+                {
+                    if (timestamp > since)
+                    {
+                        times.push_back(timestamp);
+                        values.push_back(value);
+                    }
+                }
+            };
+
+            // Blocks are in time order, binary search the first one ending after since
+            auto first = std::partition_point(mBlocks.begin(), mBlocks.end(),
+                [&](const CompressedBlock& block) { return block.last <= since; });
+
+            for (auto block = first; block != mBlocks.end() && block->first <= until; ++block)
+            {
+                decode(block->bytes.data(), block->bytes.size(), block->count);
+            }
+
+            if (mOpen.Count() > 0 && mOpenLast > since && mOpenFirst <= until)
+            {
+                decode(mOpen.Bytes().data(), mOpen.Bytes().size(), mOpen.Count());
+            }
+        }
+
+        int8_t CompressedSeries::Last(uint64_t until, uint64_t& timestamp, double& value) const
+        {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            uint32_t count = 0;
+
+            // The open block if it started by then, else the last sealed block that did
+            if (mOpen.Count() > 0 && mOpenFirst <= until)
+            {
+                data = mOpen.Bytes().data();
+                size = mOpen.Bytes().size();
+                count = mOpen.Count();
+            }
+            else
+            {
+                auto block = std::partition_point(mBlocks.begin(), mBlocks.end(),
+                    [&](const CompressedBlock& entry) { return entry.first <= until; });
+                if (block == mBlocks.begin())
+                {
+                    return -1;
+                }
+                --block;
+                data = block->bytes.data();
+                size = block->bytes.size();
+                count = block->count;
+            }
+
+            Gorilla::Decoder decoder(data, size, count);
+            uint64_t sampleTime = 0;
+            double sampleValue = 0.0;
+            int8_t status = -1;
+            while (decoder.Next(sampleTime, sampleValue) && sampleTime <= until)
+            {
+                timestamp = sampleTime;
+                value = sampleValue;
+                status = 0;
+            }
+
+            return status;
+        }
+
+        void CompressedSeries::CopyBlocks(uint64_t since, uint64_t until, std::vector<CompressedBlock>& blocks) const
+        {
+            auto first = std::partition_point(mBlocks.begin(), mBlocks.end(),
+                [&](const CompressedBlock& block) { return block.last <= since; });
+
+            for (auto block = first; block != mBlocks.end() && block->first <= until; ++block)
+            {
+                blocks.push_back(*block);
+            }
+
+            if (mOpen.Count() > 0 && mOpenLast > since && mOpenFirst <= until)
+            {
+                blocks.push_back({ mOpenFirst, mOpenLast, mOpen.Count(), mOpen.Bytes() });
+            }
+        }
+
+        RollupRing::RollupRing()
+        {
+            mTier = { 0, 0 };
+            mCapacity = 0;
+            mHead = 0;
+            mOpen = {};
+        }
+
+        int8_t RollupRing::Initialize(const RollupTier& tier)
+        {
+            if (tier.resolution == 0 || tier.retention < tier.resolution)
+            {
+                return -1;
+            }
+
+            mTier = tier;
+            mCapacity = static_cast<size_t>(tier.retention / tier.resolution);
+            mHead = 0;
+            mOpen = {};
+            mBuckets.clear();
+            return 0;
+        }
+
+        void RollupRing::Add(uint64_t timestamp, double value)
+        {
+            uint64_t start = timestamp - (timestamp % mTier.resolution);
+
+            if (mOpen.count > 0 && start != mOpen.start)
+            {
+                // Close the open bucket into the ring
+                if (mBuckets.size() < mCapacity)
+                {
+                    mBuckets.push_back(mOpen);
+                }
+                else
+                {
+                    mBuckets[mHead] = mOpen;
+                    mHead = (mHead + 1) % mCapacity;
+                }
+                mOpen.count = 0;
+            }
+
+            if (mOpen.count == 0)
+            {
+                mOpen = { start, value, value, value, 1 };
+                return;
+            }
+
+            mOpen.minimum = value < mOpen.minimum ? value : mOpen.minimum;
+            mOpen.maximum = value > mOpen.maximum ? value : mOpen.maximum;
+            mOpen.sum += value;
+            mOpen.count++;
+        }
+
+        const RollupBucket& RollupRing::At(size_t index) const
+        {
+            if (index == mBuckets.size())
+            {
+                return mOpen;
+            }
+
+            return mBuckets[(mHead + index) % mBuckets.size()];
+        }
+
+        GraphHistory::GraphHistory()
+        {
+            mCompressed = false;
+        }
+
+        int8_t GraphHistory::Initialize(size_t capacity, const std::vector<RollupTier>& tiers, bool compressed)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if ((compressed ? mSeries.Initialize(capacity) : mRing.Initialize(capacity)) < 0)
+            {
+                return -1;
+            }
+            mCompressed = compressed;
+
+            mTiers.resize(tiers.size());
+            for (size_t i = 0; i < tiers.size(); i++)
+            {
+                if (mTiers[i].Initialize(tiers[i]) < 0)
+                {
+                    return -1;
+                }
+            }
+
+            return 0;
+        }
+
+        void GraphHistory::Record(uint64_t timestamp, double value)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            uint64_t newest = RawNewestTime();
+            timestamp = timestamp < newest ? newest : timestamp;
+
+            if (mCompressed)
+            {
+                mSeries.Push(timestamp, value);
+            }
+            else
+            {
+                mRing.Push(timestamp, value);
+            }
+
+            for (RollupRing& tier : mTiers)
+            {
+                tier.Add(timestamp, value);
+            }
+        }
+
+        void GraphHistory::Query(uint64_t since, uint64_t until, uint64_t resolution, GraphQueryResult& result) const
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            result.resolution = 0;
+            result.times.clear();
+            result.values.clear();
+            result.minimums.clear();
+            result.maximums.clear();
+
+            // Start at the coarsest tier fine enough for the request, -1 being raw
+            int selected = -1;
+            for (int i = static_cast<int>(mTiers.size()) - 1; i >= 0; i--)
+            {
+                if (resolution > 0 && mTiers[i].Resolution() <= resolution)
+                {
+                    selected = i;
+                    break;
+                }
+            }
+
+            // Move coarser while the selected storage has already dropped the window start and
+            // the next one reaches further back. Raw samples resumed from a mapped file can be
+            // older than every tier, which only holds what arrived since the restart.
+            uint64_t oldest = selected < 0 ? RawOldestTime() : mTiers[selected].OldestTime();
+            while (oldest > since && selected + 1 < static_cast<int>(mTiers.size()) &&
+                   mTiers[selected + 1].OldestTime() < oldest)
+            {
+                selected++;
+                oldest = mTiers[selected].OldestTime();
+            }
+
+            if (selected < 0 && mCompressed)
+            {
+                mSeries.Copy(since, until, result.times, result.values);
+                return;
+            }
+
+            if (selected < 0)
+            {
+                size_t first = mRing.UpperBound(since);
+                size_t last = mRing.UpperBound(until);
+                if (last > first)
+                {
+                    mRing.Copy(first, last - first, result.times, result.values);
+                }
+                return;
+            }
+
+            const RollupRing& tier = mTiers[selected];
+            result.resolution = tier.Resolution();
+
+            // Buckets are in time order, binary search the first one ending after since
+            size_t low = 0;
+            size_t high = tier.Size();
+            while (low < high)
+            {
+                size_t mid = low + (high - low) / 2;
+                if (tier.At(mid).start + tier.Resolution() <= since)
+                {
+                    low = mid + 1;
+                }
+                else
+                {
+                    high = mid;
+                }
+            }
+
+            for (size_t i = low; i < tier.Size() && tier.At(i).start <= until; i++)
+            {
+                const RollupBucket& bucket = tier.At(i);
+                result.times.push_back(bucket.start);
+                result.values.push_back(bucket.sum / bucket.count);
+                result.minimums.push_back(bucket.minimum);
+                result.maximums.push_back(bucket.maximum);
+            }
+        }
+
+        int8_t GraphHistory::Last(uint64_t until, uint64_t& timestamp, double& value) const
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            // Raw storage holds every sample since its oldest, if it has one it is the answer
+            if (mCompressed && mSeries.Last(until, timestamp, value) == 0)
+            {
+                return 0;
+            }
+
+            size_t index = mCompressed ? 0 : mRing.UpperBound(until);
+            if (index > 0)
+            {
+                timestamp = mRing.TimeAt(index - 1);
+                value = mRing.ValueAt(index - 1);
+                return 0;
+            }
+
+            // Otherwise the bucket ending last by then, of whichever tier still holds one
+            int8_t status = -1;
+            uint64_t latestEnd = 0;
+            for (const RollupRing& tier : mTiers)
+            {
+                size_t low = 0;
+                size_t high = tier.Size();
+                while (low < high)
+                {
+                    size_t mid = low + (high - low) / 2;
+                    if (tier.At(mid).start + tier.Resolution() - 1 <= until)
+                    {
+                        low = mid + 1;
+                    }
+                    else
+                    {
+                        high = mid;
+                    }
+                }
+
+                if (low > 0 && tier.At(low - 1).start + tier.Resolution() > latestEnd)
+                {
+                    const RollupBucket& bucket = tier.At(low - 1);
+                    latestEnd = bucket.start + tier.Resolution();
+                    timestamp = bucket.start;
+                    value = bucket.sum / bucket.count;
+                    status = 0;
+                }
+            }
+
+            return status;
+        }
+
+        uint64_t GraphHistory::OldestTime() const
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            uint64_t oldest = RawOldestTime();
+            for (const RollupRing& tier : mTiers)
+            {
+                oldest = tier.OldestTime() < oldest ? tier.OldestTime() : oldest;
+            }
+
+            return oldest;
+        }
+
+        uint64_t GraphHistory::NewestTime() const
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            uint64_t newest = RawNewestTime();
+            for (const RollupRing& tier : mTiers)
+            {
+                newest = tier.NewestTime() > newest ? tier.NewestTime() : newest;
+            }
+
+            return newest;
+        }
+
+        int8_t GraphHistory::CopyBlocks(uint64_t since, uint64_t until, std::vector<CompressedBlock>& blocks) const
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (!mCompressed)
+            {
+                return -1;
+            }
+
+            mSeries.CopyBlocks(since, until, blocks);
+            return 0;
+        }
+
+        int8_t GraphHistory::AttachStorage(uint64_t* times, double* values, std::atomic<uint64_t>* writeIndex, size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (mCompressed || capacity != mRing.Capacity())
+            {
+                return -1;
+            }
+
+            return mRing.Attach(times, values, writeIndex, capacity);
+        }
+
+        uint64_t GraphHistory::RawOldestTime() const
+        {
+            if (mCompressed)
+            {
+                return mSeries.OldestTime();
+            }
+
+            return mRing.Size() > 0 ? mRing.TimeAt(0) : UINT64_MAX;
+        }
+
+        uint64_t GraphHistory::RawNewestTime() const
+        {
+            if (mCompressed)
+            {
+                return mSeries.NewestTime();
+            }
+
+            return mRing.Size() > 0 ? mRing.TimeAt(mRing.Size() - 1) : 0;
+        }
+
+        uint64_t GraphHistory::Now()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,338 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       graph_history.h
+//!
+//! @brief      Fixed capacity time-series storage for published graph data.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <vector>                           // Query output
+#include <mutex>                            // Reader / writer protection
+#include <atomic>                           // Write index
+#include <deque>                            // Compressed blocks
+#include "gorilla_codec.h"                  // Block compression
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_GRAPH_HISTORY               // Define the graph history header.
+#define     CPP_GRAPH_HISTORY
+//
+constexpr size_t CACHE_LINE_SIZE = 64;      //! Alignment of ring storage
+constexpr uint32_t GORILLA_BLOCK_SAMPLES = 1024; //! Samples per sealed compressed block
+constexpr uint64_t RING_WRITE_PENDING = 1ull << 63; //! Write index flag while the oldest slot is overwritten
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        /// @brief Single writer ring of timestamped samples. Timestamps and values
+        ///        are kept in separate cache line aligned arrays so scans over
+        ///        either column stay sequential. Storage is either owned or attached
+        ///        from outside, such as a mapped file.
+        class GraphRingBuffer
+        {
+        public:
+            GraphRingBuffer();
+            ~GraphRingBuffer();
+
+            GraphRingBuffer(const GraphRingBuffer&) = delete;
+            GraphRingBuffer& operator=(const GraphRingBuffer&) = delete;
+
+            /// @brief Allocate the ring storage.
+            /// @param capacity - [in] - Maximum number of samples held.
+            /// @return -1 on error, 0 on success
+            int8_t Initialize(size_t capacity);
+
+            /// @brief Switch to storage owned elsewhere, keeping whatever samples it holds.
+            ///        The owned storage is released. Must not race Push or readers.
+            /// @param times - [in] - Timestamp column of capacity entries.
+            /// @param values - [in] - Value column of capacity entries.
+            /// @param writeIndex - [in] - Total samples ever written into the columns.
+            /// @param capacity - [in] - Number of slots in the columns.
+            /// @return -1 on error, 0 on success
+            int8_t Attach(uint64_t* times, double* values, std::atomic<uint64_t>* writeIndex, size_t capacity);
+
+            /// @brief Append a sample, overwriting the oldest when full. The oldest sample
+            ///        leaves the ring before its slot is reused, so a crash mid write never
+            ///        leaves a torn sample in an attached file.
+            /// @param timestamp - [in] - Sample time in milliseconds.
+            /// @param value - [in] - Sample value.
+            void Push(uint64_t timestamp, double value);
+
+            /// @brief Get the number of samples the ring can hold.
+            size_t Capacity() const { return mCapacity; }
+
+            /// @brief Get the number of samples currently held.
+            size_t Size() const;
+
+            /// @brief Get the timestamp of a held sample, 0 being the oldest.
+            uint64_t TimeAt(size_t index) const { return mTimes[Slot(index)]; }
+
+            /// @brief Get the value of a held sample, 0 being the oldest.
+            double ValueAt(size_t index) const { return mValues[Slot(index)]; }
+
+            /// @brief Find the first held sample with a timestamp greater than a time.
+            /// @param timestamp - [in] - Time in milliseconds.
+            /// @return index of the sample, Size() if there is none.
+            size_t UpperBound(uint64_t timestamp) const;
+
+            /// @brief Copy a range of held samples in time order.
+            /// @param first - [in] - Index of the first sample, 0 being the oldest.
+            /// @param count - [in] - Number of samples to copy.
+            /// @param times - [out] - Timestamps appended here.
+            /// @param values - [out] - Values appended here.
+            void Copy(size_t first, size_t count, std::vector<uint64_t>& times, std::vector<double>& values) const;
+
+        private:
+            /// @brief Map a logical index to its slot in storage.
+            size_t Slot(size_t index) const
+            {
+                uint64_t written = mWriteIndex->load(std::memory_order_acquire) & ~RING_WRITE_PENDING;
+                size_t oldest = static_cast<size_t>(written - Size());
+                return (oldest + index) % mCapacity;
+            }
+
+            /// @brief Release owned storage.
+            void Release();
+
+            uint64_t*                           mTimes;         // Sample timestamps in milliseconds
+            double*                             mValues;        // Sample values
+            size_t                              mCapacity;      // Number of slots
+            bool                                mOwned;         // Columns were allocated here
+            std::atomic<uint64_t>*              mWriteIndex;    // Total samples ever written, local or attached, RING_WRITE_PENDING while overwriting
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mLocalWriteIndex; // Write index of owned storage
+        };
+
+        /// @brief One gorilla encoded block of samples.
+        struct CompressedBlock
+        {
+            uint64_t                first;      // Time of the first sample in milliseconds
+            uint64_t                last;       // Time of the last sample in milliseconds
+            uint32_t                count;      // Number of samples
+            std::vector<uint8_t>    bytes;      // Encoded samples
+        };
+
+        /// @brief Raw sample storage as gorilla compressed blocks. Samples go into an
+        ///        open block that is sealed every GORILLA_BLOCK_SAMPLES samples, and whole
+        ///        blocks are dropped oldest first once the capacity is exceeded.
+        class CompressedSeries
+        {
+        public:
+            CompressedSeries();
+
+            /// @brief Configure the series.
+            /// @param capacity - [in] - Number of samples always kept.
+            /// @return -1 on error, 0 on success
+            int8_t Initialize(size_t capacity);
+
+            /// @brief Append a sample. Timestamps must not go backwards.
+            /// @param timestamp - [in] - Sample time in milliseconds.
+            /// @param value - [in] - Sample value.
+            void Push(uint64_t timestamp, double value);
+
+            /// @brief Get the number of samples always kept.
+            size_t Capacity() const { return mCapacity; }
+
+            /// @brief Get the number of samples held.
+            size_t Size() const { return mSealedSamples + mOpen.Count(); }
+
+            /// @brief Get the number of encoded bytes held.
+            size_t Bytes() const { return mSealedBytes + mOpen.Bytes().size(); }
+
+            /// @brief Get the time of the oldest sample held, UINT64_MAX if empty.
+            uint64_t OldestTime() const;
+
+            /// @brief Get the time of the newest sample held, 0 if empty.
+            uint64_t NewestTime() const;
+
+            /// @brief Decode the samples in a time window, only touching overlapping blocks.
+            /// @param since - [in] - Exclusive lower time bound in milliseconds.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param times - [out] - Timestamps appended here.
+            /// @param values - [out] - Values appended here.
+            void Copy(uint64_t since, uint64_t until, std::vector<uint64_t>& times, std::vector<double>& values) const;
+
+            /// @brief Decode the newest sample at or before a time, from the one block holding it.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param timestamp - [out] - Time of the sample.
+            /// @param value - [out] - Value of the sample.
+            /// @return -1 if there is none, 0 on success
+            int8_t Last(uint64_t until, uint64_t& timestamp, double& value) const;
+
+            /// @brief Copy the encoded blocks overlapping a time window, the open block last.
+            /// @param since - [in] - Exclusive lower time bound in milliseconds.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param blocks - [out] - Blocks appended here.
+            void CopyBlocks(uint64_t since, uint64_t until, std::vector<CompressedBlock>& blocks) const;
+
+        private:
+            std::deque<CompressedBlock> mBlocks;        // Sealed blocks, oldest first
+            Gorilla::Encoder            mOpen;          // Block still receiving samples
+            uint64_t                    mOpenFirst;     // Time of the first open sample
+            uint64_t                    mOpenLast;      // Time of the last open sample
+            size_t                      mCapacity;      // Samples always kept
+            size_t                      mSealedSamples; // Samples in sealed blocks
+            size_t                      mSealedBytes;   // Bytes in sealed blocks
+        };
+
+        /// @brief Configuration of one rollup tier.
+        struct RollupTier
+        {
+            uint64_t    resolution;     // Bucket width in milliseconds
+            uint64_t    retention;      // Time span kept in milliseconds
+        };
+
+        /// @brief Aggregate of the raw samples falling in one bucket.
+        struct RollupBucket
+        {
+            uint64_t    start;          // Bucket start time in milliseconds
+            double      minimum;        // Smallest sample
+            double      maximum;        // Largest sample
+            double      sum;            // Sum of samples, average is sum / count
+            uint32_t    count;          // Number of samples
+        };
+
+        /// @brief Bounded ring of rollup buckets for one tier. Storage grows as buckets
+        ///        close up to retention / resolution entries, then wraps.
+        class RollupRing
+        {
+        public:
+            RollupRing();
+
+            /// @brief Configure the tier.
+            /// @param tier - [in] - Resolution and retention of the tier.
+            /// @return -1 on error, 0 on success
+            int8_t Initialize(const RollupTier& tier);
+
+            /// @brief Fold a raw sample into the open bucket, closing it first if the
+            ///        sample belongs to a later bucket.
+            void Add(uint64_t timestamp, double value);
+
+            /// @brief Get the bucket width in milliseconds.
+            uint64_t Resolution() const { return mTier.resolution; }
+
+            /// @brief Get the number of buckets held, including the open one.
+            size_t Size() const { return mBuckets.size() + (mOpen.count > 0 ? 1 : 0); }
+
+            /// @brief Get a held bucket, 0 being the oldest and the open bucket the newest.
+            const RollupBucket& At(size_t index) const;
+
+            /// @brief Get the start time of the oldest bucket held, UINT64_MAX if empty.
+            uint64_t OldestTime() const { return Size() > 0 ? At(0).start : UINT64_MAX; }
+
+            /// @brief Get the start time of the newest bucket held, 0 if empty.
+            uint64_t NewestTime() const { return Size() > 0 ? At(Size() - 1).start : 0; }
+
+        private:
+            RollupTier                  mTier;          // Tier configuration
+            std::vector<RollupBucket>   mBuckets;       // Closed buckets
+            size_t                      mCapacity;      // Maximum closed buckets
+            size_t                      mHead;          // Slot of the oldest closed bucket once full
+            RollupBucket                mOpen;          // Bucket still receiving samples
+        };
+
+        /// @brief Result of a history query. Raw queries fill times and values, tier
+        ///        queries also fill the bucket minimums and maximums and report the
+        ///        tier resolution.
+        struct GraphQueryResult
+        {
+            uint64_t                resolution;     // Bucket width used, 0 for raw samples
+            std::vector<uint64_t>   times;          // Sample or bucket start times
+            std::vector<double>     values;         // Sample values or bucket averages
+            std::vector<double>     minimums;       // Bucket minimums
+            std::vector<double>     maximums;       // Bucket maximums
+        };
+
+        /// @brief History kept for one published graph data item: raw samples, either in
+        ///        a ring or compressed, plus any number of coarser rollup tiers maintained
+        ///        as samples arrive.
+        class GraphHistory
+        {
+        public:
+            GraphHistory();
+
+            /// @brief Allocate the history.
+            /// @param capacity - [in] - Maximum number of raw samples held.
+            /// @param tiers - [in] - Rollup tiers, finest first.
+            /// @param compressed - [in] - Keep raw samples gorilla compressed instead of in a ring.
+            /// @return -1 on error, 0 on success
+            int8_t Initialize(size_t capacity, const std::vector<RollupTier>& tiers = {}, bool compressed = false);
+
+            /// @brief Record a new sample.
+            /// @param timestamp - [in] - Sample time in milliseconds, raised to the newest held
+            ///                           so a clock stepping back never unorders the storage.
+            /// @param value - [in] - Sample value.
+            void Record(uint64_t timestamp, double value);
+
+            /// @brief Query a time window. The coarsest storage whose resolution is at most
+            ///        the requested one is used, moving to coarser tiers when a finer one no
+            ///        longer holds the start of the window.
+            /// @param since - [in] - Exclusive lower time bound in milliseconds.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param resolution - [in] - Coarsest acceptable spacing in milliseconds, 0 for raw.
+            /// @param result - [out] - Query result.
+            void Query(uint64_t since, uint64_t until, uint64_t resolution, GraphQueryResult& result) const;
+
+            /// @brief Get the newest sample at or before a time. Raw samples are searched first,
+            ///        then the tiers for the latest bucket ended by the time, given as its
+            ///        start and average.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param timestamp - [out] - Time of the sample or bucket.
+            /// @param value - [out] - Value of the sample or bucket.
+            /// @return -1 if there is none, 0 on success
+            int8_t Last(uint64_t until, uint64_t& timestamp, double& value) const;
+
+            /// @brief Get the time of the oldest sample held by any storage, UINT64_MAX if empty.
+            uint64_t OldestTime() const;
+
+            /// @brief Get the time of the newest sample held by any storage, 0 if empty.
+            uint64_t NewestTime() const;
+
+            /// @brief Get the number of raw samples the history can hold.
+            size_t Capacity() const { return mCompressed ? mSeries.Capacity() : mRing.Capacity(); }
+
+            /// @brief Get whether raw samples are kept compressed.
+            bool IsCompressed() const { return mCompressed; }
+
+            /// @brief Copy the compressed raw sample blocks overlapping a time window.
+            /// @param since - [in] - Exclusive lower time bound in milliseconds.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param blocks - [out] - Blocks in time order.
+            /// @return -1 if the history is not compressed, 0 on success
+            int8_t CopyBlocks(uint64_t since, uint64_t until, std::vector<CompressedBlock>& blocks) const;
+
+            /// @brief Move the raw sample ring onto storage owned elsewhere, see GraphRingBuffer::Attach.
+            /// @return -1 if the history is compressed or the capacity differs, 0 on success
+            int8_t AttachStorage(uint64_t* times, double* values, std::atomic<uint64_t>* writeIndex, size_t capacity);
+
+            /// @brief Get the current wall clock time in milliseconds since the epoch.
+            static uint64_t Now();
+
+        private:
+            /// @brief Get the time of the oldest raw sample, UINT64_MAX if empty. Caller holds mMutex.
+            uint64_t RawOldestTime() const;
+
+            /// @brief Get the time of the newest raw sample, 0 if empty. Caller holds mMutex.
+            uint64_t RawNewestTime() const;
+
+            GraphRingBuffer         mRing;          // Raw samples
+            CompressedSeries        mSeries;        // Raw samples when compressed
+            bool                    mCompressed;    // Raw samples are in mSeries
+            std::vector<RollupRing> mTiers;         // Rollup tiers, finest first
+            mutable std::mutex      mMutex;         // Guards the storage between sampler and readers
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_GRAPH_HISTORY
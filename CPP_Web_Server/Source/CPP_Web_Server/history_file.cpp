@@ -0,0 +1,296 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       history_file.cpp
+//!
+//! @brief      Implementation of the memory-mapped graph history file
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "history_file.h"            // History File
+#include    <cstring>                   // memcmp, strncpy
+#include    <new>                       // Placement new
+#ifdef WIN32
+#include    <windows.h>                 // File mapping
+#else
+#include    <fcntl.h>                   // open
+#include    <sys/mman.h>                // mmap
+#include    <sys/stat.h>                // fstat
+#include    <unistd.h>                  // ftruncate, close
+#endif
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        static const char HISTORY_FILE_MAGIC[8] = { 'C', 'P', 'P', 'W', 'S', 'H', 'S', 'T' };
+
+        /// @brief Round a size up to a whole number of cache lines.
+        static uint64_t AlignUp(uint64_t size)
+        {
+            return (size + CACHE_LINE_SIZE - 1) & ~static_cast<uint64_t>(CACHE_LINE_SIZE - 1);
+        }
+
+        /// @brief Get the offset of the first column, right after the directory.
+        static uint64_t DataStart(size_t count)
+        {
+            return AlignUp(sizeof(HistoryFileHeader) + count * sizeof(HistoryFileEntry));
+        }
+
+        /// @brief Get the total file size of a layout.
+        static uint64_t LayoutSize(const std::vector<HistoryFileLayout>& layout)
+        {
+            uint64_t size = DataStart(layout.size());
+            for (const HistoryFileLayout& ring : layout)
+            {
+                size += AlignUp(ring.capacity * sizeof(uint64_t)) + AlignUp(ring.capacity * sizeof(double));
+            }
+
+            return size;
+        }
+
+        /// @brief Flush a range of the mapping to disk and wait for it.
+        static void Flush(void* address, size_t size)
+        {
+#ifdef WIN32
+            FlushViewOfFile(address, size);
+#else
+            // msync wants a page aligned start
+            uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+            uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+            msync(reinterpret_cast<void*>(start), size + (reinterpret_cast<uintptr_t>(address) - start), MS_SYNC);
+#endif
+        }
+
+        HistoryFile::HistoryFile()
+        {
+            mBase = nullptr;
+            mSize = 0;
+            mResumed = false;
+#ifdef WIN32
+            mFile = INVALID_HANDLE_VALUE;
+            mMapping = nullptr;
+#else
+            mFile = -1;
+#endif
+        }
+
+        HistoryFile::~HistoryFile()
+        {
+            Close();
+        }
+
+        int8_t HistoryFile::Open(const std::string& path, const std::vector<HistoryFileLayout>& layout)
+        {
+            if (IsOpen())
+            {
+                return -1;
+            }
+
+            for (const HistoryFileLayout& ring : layout)
+            {
+                if (ring.capacity == 0 || ring.name.size() >= HISTORY_FILE_NAME_SIZE)
+                {
+                    return -1;
+                }
+            }
+
+            uint64_t size = LayoutSize(layout);
+
+            // Resuming is only mapping the file, the rings pick up from their write indexes
+            if (Map(path, size, false) == 0 && Matches(layout))
+            {
+                mResumed = true;
+                return 0;
+            }
+            Close();
+
+            if (Map(path, size, true) < 0)
+            {
+                Close();
+                return -1;
+            }
+
+            Format(layout);
+            mResumed = false;
+            return 0;
+        }
+
+        void HistoryFile::Close()
+        {
+#ifdef WIN32
+            if (mBase != nullptr)
+            {
+                UnmapViewOfFile(mBase);
+            }
+            if (mMapping != nullptr)
+            {
+                CloseHandle(mMapping);
+            }
+            if (mFile != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(mFile);
+            }
+            mFile = INVALID_HANDLE_VALUE;
+            mMapping = nullptr;
+#else
+            if (mBase != nullptr)
+            {
+                munmap(mBase, mSize);
+            }
+            if (mFile >= 0)
+            {
+                close(mFile);
+            }
+            mFile = -1;
+#endif
+            mBase = nullptr;
+            mSize = 0;
+        }
+
+        HistoryFileEntry* HistoryFile::Entry(size_t index) const
+        {
+            return reinterpret_cast<HistoryFileEntry*>(mBase + sizeof(HistoryFileHeader)) + index;
+        }
+
+        uint64_t* HistoryFile::Times(size_t index) const
+        {
+            return reinterpret_cast<uint64_t*>(mBase + Entry(index)->timesOffset);
+        }
+
+        double* HistoryFile::Values(size_t index) const
+        {
+            return reinterpret_cast<double*>(mBase + Entry(index)->valuesOffset);
+        }
+
+        bool HistoryFile::Matches(const std::vector<HistoryFileLayout>& layout) const
+        {
+            const HistoryFileHeader* header = reinterpret_cast<const HistoryFileHeader*>(mBase);
+            if (memcmp(header->magic, HISTORY_FILE_MAGIC, sizeof(HISTORY_FILE_MAGIC)) != 0 ||
+                header->version != HISTORY_FILE_VERSION || header->count != layout.size() || header->size != mSize)
+            {
+                return false;
+            }
+
+            // Every offset must be where this layout puts it, which also keeps them in bounds
+            uint64_t offset = DataStart(layout.size());
+            for (size_t i = 0; i < layout.size(); i++)
+            {
+                const HistoryFileEntry* entry = Entry(i);
+                if (entry->capacity != layout[i].capacity || entry->timesOffset != offset ||
+                    strncmp(entry->name, layout[i].name.c_str(), HISTORY_FILE_NAME_SIZE) != 0)
+                {
+                    return false;
+                }
+
+                offset += AlignUp(entry->capacity * sizeof(uint64_t));
+                if (entry->valuesOffset != offset)
+                {
+                    return false;
+                }
+                offset += AlignUp(entry->capacity * sizeof(double));
+            }
+
+            return true;
+        }
+
+        void HistoryFile::Format(const std::vector<HistoryFileLayout>& layout)
+        {
+            // A new mapping is zero filled, only the directory needs writing
+            uint64_t offset = DataStart(layout.size());
+            for (size_t i = 0; i < layout.size(); i++)
+            {
+                HistoryFileEntry* entry = new (Entry(i)) HistoryFileEntry();
+                entry->writeIndex.store(0, std::memory_order_relaxed);
+                entry->capacity = layout[i].capacity;
+                entry->timesOffset = offset;
+                offset += AlignUp(layout[i].capacity * sizeof(uint64_t));
+                entry->valuesOffset = offset;
+                offset += AlignUp(layout[i].capacity * sizeof(double));
+                strncpy(entry->name, layout[i].name.c_str(), HISTORY_FILE_NAME_SIZE - 1);
+            }
+
+            HistoryFileHeader* header = reinterpret_cast<HistoryFileHeader*>(mBase);
+            header->version = HISTORY_FILE_VERSION;
+            header->count = static_cast<uint32_t>(layout.size());
+            header->size = mSize;
+
+            // The directory must be on disk before the magic marks the file as complete
+            Flush(mBase, static_cast<size_t>(DataStart(layout.size())));
+            memcpy(header->magic, HISTORY_FILE_MAGIC, sizeof(HISTORY_FILE_MAGIC));
+            Flush(mBase, sizeof(HistoryFileHeader));
+        }
+
+        int8_t HistoryFile::Map(const std::string& path, uint64_t size, bool create)
+        {
+#ifdef WIN32
+            mFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (mFile == INVALID_HANDLE_VALUE)
+            {
+                return -1;
+            }
+
+            LARGE_INTEGER current;
+            if (!create && (!GetFileSizeEx(mFile, &current) || static_cast<uint64_t>(current.QuadPart) != size))
+            {
+                return -1;
+            }
+
+            // Mapping past the end grows a new file, zero filled
+            mMapping = CreateFileMappingA(mFile, NULL, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                static_cast<DWORD>(size & 0xFFFFFFFF), NULL);
+            if (mMapping == nullptr)
+            {
+                return -1;
+            }
+
+            mBase = static_cast<uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(size)));
+            if (mBase == nullptr)
+            {
+                return -1;
+            }
+#else
+            mFile = open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+            if (mFile < 0)
+            {
+                return -1;
+            }
+
+            if (create)
+            {
+                // Drop any old contents so the new file starts zero filled
+                if (ftruncate(mFile, 0) < 0 || ftruncate(mFile, static_cast<off_t>(size)) < 0)
+                {
+                    return -1;
+                }
+            }
+            else
+            {
+                struct stat status;
+                if (fstat(mFile, &status) < 0 || static_cast<uint64_t>(status.st_size) != size)
+                {
+                    return -1;
+                }
+            }
+
+            void* base = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0);
+            if (base == MAP_FAILED)
+            {
+                return -1;
+            }
+            mBase = static_cast<uint8_t*>(base);
+#endif
+            mSize = size;
+            return 0;
+        }
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       history_file.h
+//!
+//! @brief      Memory-mapped file backing the graph history rings so samples
+//!             survive a restart.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Paths and names
+#include <vector>                           // Layout
+#include <atomic>                           // Mapped write indexes
+#include "graph_history.h"                  // CACHE_LINE_SIZE
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_HISTORY_FILE                // Define the history file header.
+#define     CPP_HISTORY_FILE
+//
+constexpr uint32_t HISTORY_FILE_VERSION = 1;        //! Bumped on any layout change
+constexpr size_t HISTORY_FILE_NAME_SIZE = 96;       //! Longest ring name, including the terminator
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        //  File layout, every section cache line aligned:
+        //
+        //      HistoryFileHeader
+        //      HistoryFileEntry x count
+        //      per entry { u64 timestamps x capacity, f64 values x capacity }
+        //
+        //  The header magic is written last when a file is created, so a file
+        //  torn during creation is never mistaken for a valid one. After that
+        //  only the ring columns and write indexes change, each ring publishing
+        //  a sample through its write index once both columns hold it.
+
+        /// @brief Size of one ring in the file.
+        struct HistoryFileLayout
+        {
+            std::string name;           // Unique name of the ring
+            uint64_t    capacity;       // Number of samples
+        };
+
+        /// @brief Start of the file.
+        struct alignas(CACHE_LINE_SIZE) HistoryFileHeader
+        {
+            char        magic[8];       // HISTORY_FILE_MAGIC once the file is complete
+            uint32_t    version;        // HISTORY_FILE_VERSION
+            uint32_t    count;          // Number of entries
+            uint64_t    size;           // File size in bytes
+        };
+
+        /// @brief Directory entry of one ring, the write index on its own cache line.
+        struct alignas(CACHE_LINE_SIZE) HistoryFileEntry
+        {
+            std::atomic<uint64_t>   writeIndex;                     // Total samples ever written
+            uint64_t                capacity;                       // Number of samples
+            uint64_t                timesOffset;                    // File offset of the timestamps
+            uint64_t                valuesOffset;                   // File offset of the values
+            char                    name[HISTORY_FILE_NAME_SIZE];   // Unique name, null terminated
+        };
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "mapped write indexes must be lock free");
+
+        /// @brief One mapped history file. The mapping stays valid until Close.
+        class HistoryFile
+        {
+        public:
+            HistoryFile();
+            ~HistoryFile();
+
+            HistoryFile(const HistoryFile&) = delete;
+            HistoryFile& operator=(const HistoryFile&) = delete;
+
+            /// @brief Map a file holding a layout. A file whose header and directory match
+            ///        the layout is resumed as is, anything else is recreated empty.
+            /// @param path - [in] - File to map, created if missing.
+            /// @param layout - [in] - Rings in the file, names shorter than HISTORY_FILE_NAME_SIZE.
+            /// @return -1 on error, 0 on success
+            int8_t Open(const std::string& path, const std::vector<HistoryFileLayout>& layout);
+
+            /// @brief Unmap and close the file.
+            void Close();
+
+            /// @brief Get whether a file is mapped.
+            bool IsOpen() const { return mBase != nullptr; }
+
+            /// @brief Get whether Open found and resumed an existing file.
+            bool IsResumed() const { return mResumed; }
+
+            /// @brief Get the directory entry of a ring, in layout order.
+            HistoryFileEntry* Entry(size_t index) const;
+
+            /// @brief Get the timestamp column of a ring, in layout order.
+            uint64_t* Times(size_t index) const;
+
+            /// @brief Get the value column of a ring, in layout order.
+            double* Values(size_t index) const;
+
+        private:
+            /// @brief Check a mapped file against a layout.
+            bool Matches(const std::vector<HistoryFileLayout>& layout) const;
+
+            /// @brief Lay out a freshly sized file, writing the magic last.
+            void Format(const std::vector<HistoryFileLayout>& layout);
+
+            /// @brief Map a file of a size, creating or resizing it when asked.
+            int8_t Map(const std::string& path, uint64_t size, bool create);
+
+            uint8_t*    mBase;          // Start of the mapping
+            uint64_t    mSize;          // Size of the mapping in bytes
+            bool        mResumed;       // Existing file was reused
+#ifdef WIN32
+            void*       mFile;          // File handle
+            void*       mMapping;       // File mapping handle
+#else
+            int         mFile;          // File descriptor
+#endif
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_HISTORY_FILE
@@ -0,0 +1,519 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       json_index.cpp
+//!
+//! @brief      Implementation of the JSON index
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "json_index.h"              // JSON Index
+#include    <cstring>                   // memcmp
+#include    <charconv>                  // Number parsing
+#include    <cmath>                     // isfinite, trunc
+#include    <limits>                    // Range of long
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        namespace Json
+        {
+            bool Unescape(const char* text, size_t length, std::string& value)
+            {
+                // Unescaping never lengthens the text
+                value.resize(length);
+                size_t used = 0;
+
+                for (size_t i = 0; i < length; i++)
+                {
+                    if (text[i] != '\\')
+                    {
+                        value[used++] = text[i];
+                        continue;
+                    }
+
+                    if (++i >= length)
+                    {
+                        return false;
+                    }
+
+                    switch (text[i])
+                    {
+                    case '"':   value[used++] = '"';  break;
+                    case '\\':  value[used++] = '\\'; break;
+                    case '/':   value[used++] = '/';  break;
+                    case 'b':   value[used++] = '\b'; break;
+                    case 'f':   value[used++] = '\f'; break;
+                    case 'n':   value[used++] = '\n'; break;
+                    case 'r':   value[used++] = '\r'; break;
+                    case 't':   value[used++] = '\t'; break;
+                    case 'u':
+                    {
+                        // Basic plane characters as UTF-8, at most the six bytes of the escape
+                        unsigned int code = 0;
+                        if (i + 4 >= length || std::from_chars(text + i + 1, text + i + 5, code, 16).ptr != text + i + 5)
+                        {
+                            return false;
+                        }
+                        if (code >= 0xD800 && code <= 0xDFFF)
+                        {
+                            return false;
+                        }
+                        i += 4;
+
+                        if (code < 0x80)
+                        {
+                            value[used++] = static_cast<char>(code);
+                        }
+                        else if (code < 0x800)
+                        {
+                            value[used++] = static_cast<char>(0xC0 | (code >> 6));
+                            value[used++] = static_cast<char>(0x80 | (code & 0x3F));
+                        }
+                        else
+                        {
+                            value[used++] = static_cast<char>(0xE0 | (code >> 12));
+                            value[used++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                            value[used++] = static_cast<char>(0x80 | (code & 0x3F));
+                        }
+                        break;
+                    }
+                    default:
+                        return false;
+                    }
+                }
+
+                value.resize(used);
+                return true;
+            }
+        }
+
+        /// @brief Check a character is a hexadecimal digit.
+        static bool IsHex(char c)
+        {
+            return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        }
+
+        /// @brief Check a character is a decimal digit.
+        static bool IsDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        JsonIndex::JsonIndex()
+        {
+            // Enough for a dashboard command without growing
+            mTokens.reserve(64);
+            mJson = nullptr;
+            mLength = 0;
+            mPosition = 0;
+        }
+
+        int8_t JsonIndex::Parse(const char* json, size_t length)
+        {
+            mTokens.clear();
+            mJson = json;
+            mLength = length;
+            mPosition = 0;
+
+            // Offsets are 32 bits, far above any request accepted
+            if (json == nullptr || length >= UINT32_MAX || !ParseValue(0))
+            {
+                mTokens.clear();
+                return -1;
+            }
+
+            SkipSpace();
+            if (mPosition != mLength)
+            {
+                mTokens.clear();
+                return -1;
+            }
+            return 0;
+        }
+
+        void JsonIndex::SkipSpace()
+        {
+            while (mPosition < mLength)
+            {
+                char c = mJson[mPosition];
+                if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+                {
+                    break;
+                }
+                mPosition++;
+            }
+        }
+
+        bool JsonIndex::ParseValue(size_t depth)
+        {
+            SkipSpace();
+            if (mPosition >= mLength)
+            {
+                return false;
+            }
+
+            char c = mJson[mPosition];
+            if (c == '"')
+            {
+                return ParseString();
+            }
+            if (c == '-' || IsDigit(c))
+            {
+                return ParseNumber();
+            }
+            if (c == 't')
+            {
+                return ParseLiteral("true", 4, Json::Kind::BOOL);
+            }
+            if (c == 'f')
+            {
+                return ParseLiteral("false", 5, Json::Kind::BOOL);
+            }
+            if (c == 'n')
+            {
+                return ParseLiteral("null", 4, Json::Kind::NUL);
+            }
+            if ((c != '{' && c != '[') || depth >= JSON_DEPTH_MAX)
+            {
+                return false;
+            }
+
+            // The tape may grow under the children, so the container is kept by index
+            bool object = c == '{';
+            char close = object ? '}' : ']';
+            size_t container = mTokens.size();
+            mTokens.push_back({ static_cast<uint32_t>(mPosition), 0, 0, 0,
+                object ? Json::Kind::OBJECT : Json::Kind::ARRAY, false });
+            mPosition++;
+
+            SkipSpace();
+            uint32_t count = 0;
+            if (mPosition < mLength && mJson[mPosition] == close)
+            {
+                mPosition++;
+            }
+            else
+            {
+                while (true)
+                {
+                    if (object)
+                    {
+                        SkipSpace();
+                        if (mPosition >= mLength || mJson[mPosition] != '"' || !ParseString())
+                        {
+                            return false;
+                        }
+                        SkipSpace();
+                        if (mPosition >= mLength || mJson[mPosition] != ':')
+                        {
+                            return false;
+                        }
+                        mPosition++;
+                    }
+
+                    if (!ParseValue(depth + 1))
+                    {
+                        return false;
+                    }
+                    count++;
+
+                    SkipSpace();
+                    if (mPosition >= mLength)
+                    {
+                        return false;
+                    }
+                    if (mJson[mPosition] == ',')
+                    {
+                        mPosition++;
+                        continue;
+                    }
+                    if (mJson[mPosition] != close)
+                    {
+                        return false;
+                    }
+                    mPosition++;
+                    break;
+                }
+            }
+
+            JsonToken& token = mTokens[container];
+            token.length = static_cast<uint32_t>(mPosition - token.offset);
+            token.next = static_cast<uint32_t>(mTokens.size());
+            token.count = count;
+            return true;
+        }
+
+        bool JsonIndex::ParseString()
+        {
+            size_t start = mPosition++;
+            bool escaped = false;
+
+            while (mPosition < mLength)
+            {
+                unsigned char c = static_cast<unsigned char>(mJson[mPosition]);
+                if (c == '"')
+                {
+                    mPosition++;
+                    mTokens.push_back({ static_cast<uint32_t>(start), static_cast<uint32_t>(mPosition - start),
+                        static_cast<uint32_t>(mTokens.size() + 1), 0, Json::Kind::STRING, escaped });
+                    return true;
+                }
+                if (c < 0x20)
+                {
+                    return false;
+                }
+                if (c != '\\')
+                {
+                    mPosition++;
+                    continue;
+                }
+
+                // Escapes are checked here so lookups can trust the token
+                escaped = true;
+                if (++mPosition >= mLength)
+                {
+                    return false;
+                }
+                switch (mJson[mPosition])
+                {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    mPosition++;
+                    break;
+                case 'u':
+                    if (mPosition + 4 >= mLength || !IsHex(mJson[mPosition + 1]) || !IsHex(mJson[mPosition + 2]) ||
+                        !IsHex(mJson[mPosition + 3]) || !IsHex(mJson[mPosition + 4]))
+                    {
+                        return false;
+                    }
+                    mPosition += 5;
+                    break;
+                default:
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool JsonIndex::ParseNumber()
+        {
+            size_t start = mPosition;
+            if (mJson[mPosition] == '-')
+            {
+                mPosition++;
+            }
+
+            // Integer part, without leading zeros
+            if (mPosition >= mLength || !IsDigit(mJson[mPosition]))
+            {
+                return false;
+            }
+            if (mJson[mPosition++] != '0')
+            {
+                while (mPosition < mLength && IsDigit(mJson[mPosition]))
+                {
+                    mPosition++;
+                }
+            }
+
+            if (mPosition < mLength && mJson[mPosition] == '.')
+            {
+                if (++mPosition >= mLength || !IsDigit(mJson[mPosition]))
+                {
+                    return false;
+                }
+                while (mPosition < mLength && IsDigit(mJson[mPosition]))
+                {
+                    mPosition++;
+                }
+            }
+
+            if (mPosition < mLength && (mJson[mPosition] == 'e' || mJson[mPosition] == 'E'))
+            {
+                if (++mPosition < mLength && (mJson[mPosition] == '+' || mJson[mPosition] == '-'))
+                {
+                    mPosition++;
+                }
+                if (mPosition >= mLength || !IsDigit(mJson[mPosition]))
+                {
+                    return false;
+                }
+                while (mPosition < mLength && IsDigit(mJson[mPosition]))
+                {
+                    mPosition++;
+                }
+            }
+
+            mTokens.push_back({ static_cast<uint32_t>(start), static_cast<uint32_t>(mPosition - start),
+                static_cast<uint32_t>(mTokens.size() + 1), 0, Json::Kind::NUMBER, false });
+            return true;
+        }
+
+        bool JsonIndex::ParseLiteral(const char* literal, size_t length, Json::Kind kind)
+        {
+            if (mLength - mPosition < length || memcmp(mJson + mPosition, literal, length) != 0)
+            {
+                return false;
+            }
+
+            mTokens.push_back({ static_cast<uint32_t>(mPosition), static_cast<uint32_t>(length),
+                static_cast<uint32_t>(mTokens.size() + 1), 0, kind, false });
+            mPosition += length;
+            return true;
+        }
+
+        int JsonIndex::Find(int object, std::string_view key) const
+        {
+            if (!Is(object, Json::Kind::OBJECT))
+            {
+                return -1;
+            }
+
+            // Members alternate key then value, each value's next is the following key
+            uint32_t member = static_cast<uint32_t>(object) + 1;
+            for (uint32_t i = 0; i < mTokens[object].count; i++)
+            {
+                if (Equals(static_cast<int>(member), key))
+                {
+                    return static_cast<int>(member + 1);
+                }
+                member = mTokens[member + 1].next;
+            }
+            return -1;
+        }
+
+        int JsonIndex::At(int array, size_t index) const
+        {
+            if (!Is(array, Json::Kind::ARRAY) || index >= mTokens[array].count)
+            {
+                return -1;
+            }
+
+            uint32_t element = static_cast<uint32_t>(array) + 1;
+            for (size_t i = 0; i < index; i++)
+            {
+                element = mTokens[element].next;
+            }
+            return static_cast<int>(element);
+        }
+
+        int JsonIndex::First(int container) const
+        {
+            if (container < 0 || mTokens[container].count == 0)
+            {
+                return -1;
+            }
+            return container + 1;
+        }
+
+        int JsonIndex::Next(int token, int container) const
+        {
+            if (token < 0 || container < 0)
+            {
+                return -1;
+            }
+
+            uint32_t next = mTokens[token].next;
+            return next < mTokens[container].next ? static_cast<int>(next) : -1;
+        }
+
+        mg_str JsonIndex::GetText(int token) const
+        {
+            if (token < 0)
+            {
+                return mg_str_n(nullptr, 0);
+            }
+            return mg_str_n(mJson + mTokens[token].offset, mTokens[token].length);
+        }
+
+        bool JsonIndex::Equals(int token, std::string_view text) const
+        {
+            if (!Is(token, Json::Kind::STRING))
+            {
+                return false;
+            }
+
+            const JsonToken& string = mTokens[token];
+            if (!string.escaped)
+            {
+                return string.length - 2 == text.size() && memcmp(mJson + string.offset + 1, text.data(), text.size()) == 0;
+            }
+
+            std::string value;
+            return Json::Unescape(mJson + string.offset + 1, string.length - 2, value) && value == text;
+        }
+
+        bool JsonIndex::GetString(int token, std::string& value) const
+        {
+            if (!Is(token, Json::Kind::STRING))
+            {
+                return false;
+            }
+
+            const JsonToken& string = mTokens[token];
+            if (!string.escaped)
+            {
+                value.assign(mJson + string.offset + 1, string.length - 2);
+                return true;
+            }
+            return Json::Unescape(mJson + string.offset + 1, string.length - 2, value);
+        }
+
+        bool JsonIndex::GetNumber(int token, double& value) const
+        {
+            if (!Is(token, Json::Kind::NUMBER))
+            {
+                return false;
+            }
+
+            const char* text = mJson + mTokens[token].offset;
+            const char* end = text + mTokens[token].length;
+            std::from_chars_result result = std::from_chars(text, end, value);
+            return result.ec == std::errc() && result.ptr == end && std::isfinite(value);
+        }
+
+        bool JsonIndex::GetLong(int token, long& value) const
+        {
+            if (!Is(token, Json::Kind::NUMBER))
+            {
+                return false;
+            }
+
+            const char* text = mJson + mTokens[token].offset;
+            const char* end = text + mTokens[token].length;
+            long parsed = 0;
+            std::from_chars_result result = std::from_chars(text, end, parsed);
+            if (result.ec == std::errc() && result.ptr == end)
+            {
+                value = parsed;
+                return true;
+            }
+            if (result.ec == std::errc::result_out_of_range)
+            {
+                // An integer past the range may still round into it as a double
+                return false;
+            }
+
+            // Written with a fraction or exponent, such as 2.0 or 1e3
+            double number = 0.0;
+            // Bounds as doubles: min is a power of two so exact, and -min is one past max
+            const double lowest = static_cast<double>(std::numeric_limits<long>::min());
+            if (!GetNumber(token, number) || std::trunc(number) != number ||
+                number < lowest || number >= -lowest)
+            {
+                return false;
+            }
+            value = static_cast<long>(number);
+            return true;
+        }
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,167 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       json_index.h
+//!
+//! @brief      One pass JSON tokenizer building a tape of a document, so any
+//!             number of fields are looked up without parsing it again.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Unescaped strings
+#include <string_view>                      // Key comparison
+#include <vector>                           // Tape
+#include "../Mongoose/mongoose.h"           // mg_str
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_JSON_INDEX                  // Define the json index header.
+#define     CPP_JSON_INDEX
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static size_t JSON_DEPTH_MAX = 64;    // Deepest nesting of objects and arrays accepted
+
+        namespace Json
+        {
+            enum class Kind : uint8_t
+            {
+                OBJECT,
+                ARRAY,
+                STRING,
+                NUMBER,
+                BOOL,
+                NUL,
+            };
+
+            /// @brief Unescape the body of a JSON string token into a string.
+            /// @param text - [in] - Characters between the quotes.
+            /// @param length - [in] - Character count.
+            /// @param value - [out] - Unescaped string.
+            /// @return false on an invalid escape, true on success.
+            bool Unescape(const char* text, size_t length, std::string& value);
+        }
+
+        /// @brief One value of the tape. Containers are followed by their children, object
+        ///        members as a key token then the value's tokens.
+        struct JsonToken
+        {
+            uint32_t    offset;         // First character in the document
+            uint32_t    length;         // Characters, quotes and brackets included
+            uint32_t    next;           // Token after this value and its children
+            uint32_t    count;          // Members or elements of a container
+            Json::Kind  kind;           // Kind of value
+            bool        escaped;        // String holding escapes, compared after unescaping
+        };
+
+        /// @brief Tape of a parsed document. Tokens are addressed by their index, -1 standing
+        ///        for a value that is absent, so lookups chain without checks in between. An
+        ///        index kept by its owner and parsed into again reuses its tape, and small
+        ///        command objects parse without allocating.
+        class JsonIndex
+        {
+        public:
+            JsonIndex();
+
+            /// @brief Tokenize a document, replacing the previous one. The document must
+            ///        outlive the lookups.
+            /// @param json - [in] - Document text.
+            /// @param length - [in] - Document length.
+            /// @return -1 if the text is not a single valid JSON value, 0 on success
+            int8_t Parse(const char* json, size_t length);
+
+            /// @brief Tokenize a document held in a Mongoose string.
+            int8_t Parse(mg_str json) { return Parse(json.ptr, json.len); }
+
+            /// @brief Get the root value.
+            /// @return 0, -1 if the last parse failed.
+            int Root() const { return mTokens.empty() ? -1 : 0; }
+
+            /// @brief Look up a member of an object.
+            /// @param object - [in] - Object token.
+            /// @param key - [in] - Unescaped member name.
+            /// @return the member's value token, -1 if absent or not an object.
+            int Find(int object, std::string_view key) const;
+
+            /// @brief Look up an element of an array.
+            /// @param array - [in] - Array token.
+            /// @param index - [in] - Element position.
+            /// @return the element token, -1 if absent or not an array.
+            int At(int array, size_t index) const;
+
+            /// @brief Get the first child of a container, an element or an object's first key.
+            /// @return the child token, -1 if empty or not a container.
+            int First(int container) const;
+
+            /// @brief Get the sibling after a value, the next element or an object's next key.
+            ///        For an object member, pass the value token.
+            /// @param token - [in] - Value token.
+            /// @param container - [in] - Container holding it.
+            /// @return the following token, -1 after the last child.
+            int Next(int token, int container) const;
+
+            /// @brief Get the kind of a token.
+            Json::Kind GetKind(int token) const { return mTokens[token].kind; }
+
+            /// @brief Get the members or elements of a container.
+            size_t GetCount(int token) const { return token < 0 ? 0 : mTokens[token].count; }
+
+            /// @brief Check a token is present and of a kind.
+            bool Is(int token, Json::Kind kind) const { return token >= 0 && mTokens[token].kind == kind; }
+
+            /// @brief Get the text of a token as written, quotes and brackets included.
+            /// @return the text, empty when the token is -1.
+            mg_str GetText(int token) const;
+
+            /// @brief Compare a string token against text.
+            bool Equals(int token, std::string_view text) const;
+
+            /// @brief Get an unescaped string.
+            /// @return false if the token is not a string, true on success.
+            bool GetString(int token, std::string& value) const;
+
+            /// @brief Get a number.
+            /// @return false if the token is not a number, true on success.
+            bool GetNumber(int token, double& value) const;
+
+            /// @brief Get a number that is an integer.
+            /// @return false if the token is not an integral number in range, true on success.
+            bool GetLong(int token, long& value) const;
+
+        private:
+            /// @brief Parse the value at mPosition and its children.
+            bool ParseValue(size_t depth);
+
+            /// @brief Parse the string at mPosition into a token.
+            bool ParseString();
+
+            /// @brief Parse the number at mPosition into a token.
+            bool ParseNumber();
+
+            /// @brief Parse a literal at mPosition into a token.
+            bool ParseLiteral(const char* literal, size_t length, Json::Kind kind);
+
+            /// @brief Skip whitespace at mPosition.
+            void SkipSpace();
+
+            std::vector<JsonToken>  mTokens;        // Tape in document order
+            const char*             mJson;          // Document parsed
+            size_t                  mLength;        // Document length
+            size_t                  mPosition;      // Parse position
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_JSON_INDEX
@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       json_writer.cpp
+//!
+//! @brief      Implementation of the JSON writer
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "json_writer.h"             // JSON Writer
+#if defined(__x86_64__) || defined(_M_X64)
+#include    <emmintrin.h>               // SSE2, always present on x86-64
+#define     CPP_JSON_SSE2
+#endif
+#ifdef _MSC_VER
+#include    <intrin.h>                  // Bit scan intrinsics
+#endif
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        namespace Json
+        {
+            /// @brief Check a character must be escaped in a JSON string.
+            static bool NeedsEscape(unsigned char c)
+            {
+                return c < 0x20 || c == '"' || c == '\\';
+            }
+
+#ifdef CPP_JSON_SSE2
+            /// @brief Count trailing zero bits of a non zero mask.
+            static size_t TrailingZeros(uint32_t mask)
+            {
+#ifdef _MSC_VER
+                unsigned long index = 0;
+                _BitScanForward(&index, mask);
+                return static_cast<size_t>(index);
+#else
+                return static_cast<size_t>(__builtin_ctz(mask));
+#endif
+            }
+#endif
+
+            /// @brief Find the first character at or after a position that must be escaped.
+            /// @return its position, the length when there is none.
+            static size_t FindEscape(const char* text, size_t length, size_t position)
+            {
+#ifdef CPP_JSON_SSE2
+                const __m128i quote = _mm_set1_epi8('"');
+                const __m128i backslash = _mm_set1_epi8('\\');
+                const __m128i control = _mm_set1_epi8(0x1F);
+                for (; position + 16 <= length; position += 16)
+                {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+
+                    // Unsigned bytes at most 0x1F are those left unchanged by min with 0x1F
+                    __m128i hits = _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                        _mm_cmpeq_epi8(_mm_min_epu8(block, control), block));
+                    uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+                    if (mask != 0)
+                    {
+                        return position + TrailingZeros(mask);
+                    }
+                }
+#endif
+                while (position < length && !NeedsEscape(static_cast<unsigned char>(text[position])))
+                {
+                    position++;
+                }
+                return position;
+            }
+
+            void AppendString(std::string& out, std::string_view value)
+            {
+                static const char hex[] = "0123456789abcdef";
+
+                out.reserve(out.size() + value.size() + 2);
+                out += '"';
+
+                size_t start = 0;
+                while (start < value.size())
+                {
+                    size_t position = FindEscape(value.data(), value.size(), start);
+                    out.append(value.data() + start, position - start);
+                    if (position == value.size())
+                    {
+                        break;
+                    }
+
+                    unsigned char c = static_cast<unsigned char>(value[position]);
+                    switch (c)
+                    {
+                    case '"':   out += "\\\""; break;
+                    case '\\':  out += "\\\\"; break;
+                    case '\n':  out += "\\n"; break;
+                    case '\r':  out += "\\r"; break;
+                    case '\t':  out += "\\t"; break;
+                    default:
+                    {
+                        char escaped[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+                        out.append(escaped, sizeof(escaped));
+                        break;
+                    }
+                    }
+                    start = position + 1;
+                }
+
+                out += '"';
+            }
+
+            void AppendValue(std::string& out, Data::Type type, const void* address)
+            {
+                switch (type)
+                {
+                case Data::Type::CHAR:      AppendNumber(out, static_cast<int>(*static_cast<const char*>(address))); break;
+                case Data::Type::UCHAR:     AppendNumber(out, static_cast<unsigned int>(*static_cast<const unsigned char*>(address))); break;
+                case Data::Type::SHORT:     AppendNumber(out, *static_cast<const short*>(address)); break;
+                case Data::Type::USHORT:    AppendNumber(out, *static_cast<const unsigned short*>(address)); break;
+                case Data::Type::INT:       AppendNumber(out, *static_cast<const int*>(address)); break;
+                case Data::Type::UINT:      AppendNumber(out, *static_cast<const unsigned int*>(address)); break;
+                case Data::Type::DOUBLE:    AppendNumber(out, *static_cast<const double*>(address)); break;
+                case Data::Type::FLOAT:     AppendNumber(out, *static_cast<const float*>(address)); break;
+                case Data::Type::BOOL:      out += *static_cast<const bool*>(address) ? "true" : "false"; break;
+                case Data::Type::STRING:    AppendString(out, *static_cast<const std::string*>(address)); break;
+                default:                    out += "null"; break;
+                }
+            }
+        }
+
+        JsonWriter::JsonWriter()
+        {
+            mFirst = 0;
+            mDepth = 0;
+            mAfterKey = false;
+        }
+
+        void JsonWriter::Clear()
+        {
+            mOut.clear();
+            mFirst = 0;
+            mDepth = 0;
+            mAfterKey = false;
+        }
+
+        void JsonWriter::Separate()
+        {
+            if (mAfterKey)
+            {
+                mAfterKey = false;
+                return;
+            }
+            if (mDepth == 0 || mDepth > JSON_WRITER_DEPTH_MAX)
+            {
+                return;
+            }
+
+            uint64_t bit = 1ull << (mDepth - 1);
+            if (mFirst & bit)
+            {
+                mFirst &= ~bit;
+            }
+            else
+            {
+                mOut += ',';
+            }
+        }
+
+        void JsonWriter::BeginObject()
+        {
+            Separate();
+            mOut += '{';
+            if (++mDepth <= JSON_WRITER_DEPTH_MAX)
+            {
+                mFirst |= 1ull << (mDepth - 1);
+            }
+        }
+
+        void JsonWriter::BeginArray()
+        {
+            Separate();
+            mOut += '[';
+            if (++mDepth <= JSON_WRITER_DEPTH_MAX)
+            {
+                mFirst |= 1ull << (mDepth - 1);
+            }
+        }
+
+        void JsonWriter::EndObject()
+        {
+            mOut += '}';
+            mDepth--;
+        }
+
+        void JsonWriter::EndArray()
+        {
+            mOut += ']';
+            mDepth--;
+        }
+
+        void JsonWriter::Key(std::string_view key)
+        {
+            Separate();
+            Json::AppendString(mOut, key);
+            mOut += ':';
+            mAfterKey = true;
+        }
+
+        void JsonWriter::String(std::string_view value)
+        {
+            Separate();
+            Json::AppendString(mOut, value);
+        }
+
+        void JsonWriter::Bool(bool value)
+        {
+            Separate();
+            mOut += value ? "true" : "false";
+        }
+
+        void JsonWriter::Null()
+        {
+            Separate();
+            mOut += "null";
+        }
+
+        void JsonWriter::Value(Data::Type type, const void* address)
+        {
+            Separate();
+            Json::AppendValue(mOut, type, address);
+        }
+
+        void JsonWriter::Raw(std::string_view json)
+        {
+            Separate();
+            mOut.append(json.data(), json.size());
+        }
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       json_writer.h
+//!
+//! @brief      Streaming JSON writer appending documents straight into a
+//!             reused buffer, for responses and pushed messages.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Output buffer
+#include <string_view>                      // Text values
+#include <charconv>                         // Number formatting
+#include <cmath>                            // isfinite
+#include <type_traits>                      // Number kinds
+#include "publishable_types.h"              // Data types
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_JSON_WRITER                 // Define the json writer header.
+#define     CPP_JSON_WRITER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static size_t JSON_WRITER_DEPTH_MAX = 64;     // Deepest nesting a writer tracks separators for
+
+        namespace Json
+        {
+            /// @brief Append a string as a quoted JSON string, escaping quotes, backslashes and
+            ///        control characters. Runs needing no escape are found 16 bytes at a time
+            ///        and copied whole.
+            /// @param out - [out] - Document to append to.
+            /// @param value - [in] - Text to append.
+            void AppendString(std::string& out, std::string_view value);
+
+            /// @brief Append a number, null when it is not finite as JSON has no NaN or infinity.
+            /// @param out - [out] - Document to append to.
+            /// @param value - [in] - Number to append.
+            template <typename T>
+            void AppendNumber(std::string& out, T value)
+            {
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    if (!std::isfinite(value))
+                    {
+                        out += "null";
+                        return;
+                    }
+                }
+
+                char buffer[32];
+                std::to_chars_result written = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                out.append(buffer, written.ptr);
+            }
+
+            /// @brief Append numbers separated by commas, without the brackets.
+            /// @param out - [out] - Document to append to.
+            /// @param numbers - [in] - Numbers to append.
+            /// @param count - [in] - Number count.
+            template <typename T>
+            void AppendNumbers(std::string& out, const T* numbers, size_t count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (i > 0)
+                    {
+                        out += ',';
+                    }
+                    AppendNumber(out, numbers[i]);
+                }
+            }
+
+            /// @brief Append the value of a published item read from its address.
+            /// @param out - [out] - Document to append to.
+            /// @param type - [in] - Type of the item.
+            /// @param address - [in] - Address of the item.
+            void AppendValue(std::string& out, Data::Type type, const void* address);
+        }
+
+        /// @brief Writes a JSON document into its buffer as it is described, placing the
+        ///        commas and colons itself. The buffer keeps its capacity when cleared, so a
+        ///        writer kept by its owner builds responses without allocating once warm.
+        class JsonWriter
+        {
+        public:
+            JsonWriter();
+
+            /// @brief Empty the buffer for a new document.
+            void Clear();
+
+            /// @brief Get the document written so far.
+            const std::string& Text() const { return mOut; }
+
+            /// @brief Open an object or array.
+            void BeginObject();
+            void BeginArray();
+
+            /// @brief Close the innermost object or array.
+            void EndObject();
+            void EndArray();
+
+            /// @brief Write the key of the next object member.
+            /// @param key - [in] - Member name.
+            void Key(std::string_view key);
+
+            /// @brief Write a string value.
+            void String(std::string_view value);
+
+            /// @brief Write a number value, null when it is not finite.
+            template <typename T>
+            void Number(T value)
+            {
+                Separate();
+                Json::AppendNumber(mOut, value);
+            }
+
+            /// @brief Write an array of numbers.
+            template <typename T>
+            void Numbers(const T* numbers, size_t count)
+            {
+                Separate();
+                mOut += '[';
+                Json::AppendNumbers(mOut, numbers, count);
+                mOut += ']';
+            }
+
+            /// @brief Write a boolean value.
+            void Bool(bool value);
+
+            /// @brief Write a null value.
+            void Null();
+
+            /// @brief Write the value of a published item read from its address.
+            void Value(Data::Type type, const void* address);
+
+            /// @brief Write a value that is already JSON, as is.
+            void Raw(std::string_view json);
+
+        private:
+            /// @brief Write the comma before a value unless it is the first of its container or
+            ///        follows a key.
+            void Separate();
+
+            std::string mOut;           // Document buffer
+            uint64_t    mFirst;         // Bit per open container, set until its first value
+            size_t      mDepth;         // Open containers
+            bool        mAfterKey;      // A key was written, its value follows without a comma
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_JSON_WRITER
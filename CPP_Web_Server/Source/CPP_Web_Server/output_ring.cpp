@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       output_ring.cpp
+//!
+//! @brief      Implementation of the output ring
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "output_ring.h"             // Output Ring
+#include    <algorithm>                 // min
+#include    <cstring>                   // memcpy
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        OutputRing::OutputRing()
+        {
+            mCapacity = 0;
+            mHead = 0;
+            mWritten = 0;
+        }
+
+        void OutputRing::Reset(size_t capacity)
+        {
+            mBuffer.clear();
+            mCapacity = capacity;
+            mHead = 0;
+            mWritten = 0;
+        }
+
+        void OutputRing::Append(const char* data, size_t size)
+        {
+            mWritten += size;
+            if (mCapacity == 0)
+            {
+                return;
+            }
+
+            // Only the last capacity bytes can survive the write
+            if (size > mCapacity)
+            {
+                data += size - mCapacity;
+                size = mCapacity;
+            }
+
+            if (mBuffer.size() < mCapacity)
+            {
+                size_t grow = std::min(size, mCapacity - mBuffer.size());
+                mBuffer.insert(mBuffer.end(), data, data + grow);
+                data += grow;
+                size -= grow;
+                mHead = 0;
+            }
+
+            if (size > 0)
+            {
+                size_t first = std::min(size, mCapacity - mHead);
+                memcpy(&mBuffer[mHead], data, first);
+                memcpy(&mBuffer[0], data + first, size - first);
+                mHead = (mHead + size) % mCapacity;
+            }
+        }
+
+        uint64_t OutputRing::Read(uint64_t since, std::string& out) const
+        {
+            uint64_t from = std::max(since, Dropped());
+            if (from >= mWritten)
+            {
+                return mWritten;
+            }
+
+            // Until the ring is full the oldest byte is at the front, after that at mHead
+            size_t oldest = mBuffer.size() < mCapacity ? 0 : mHead;
+            size_t start = (oldest + static_cast<size_t>(from - Dropped())) % mBuffer.size();
+            size_t count = static_cast<size_t>(mWritten - from);
+            size_t first = std::min(count, mBuffer.size() - start);
+
+            out.append(&mBuffer[start], first);
+            out.append(&mBuffer[0], count - first);
+            return from;
+        }
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       output_ring.h
+//!
+//! @brief      Bounded ring keeping the most recent output of a command, so a
+//!             client can fetch its tail at any time.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Tail copies
+#include <vector>                           // Ring storage
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_OUTPUT_RING                 // Define the output ring header.
+#define     CPP_OUTPUT_RING
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        /// @brief Keeps the last bytes written to it, up to its capacity. Bytes are addressed
+        ///        by their offset in everything ever written, so a reader resumes where it left
+        ///        off and learns how much was dropped in between. Storage grows with the output
+        ///        and never past the capacity.
+        class OutputRing
+        {
+        public:
+            OutputRing();
+
+            /// @brief Empty the ring and set its capacity.
+            /// @param capacity - [in] - Most bytes kept.
+            void Reset(size_t capacity);
+
+            /// @brief Write bytes, dropping the oldest once full.
+            /// @param data - [in] - Bytes to write.
+            /// @param size - [in] - Byte count.
+            void Append(const char* data, size_t size);
+
+            /// @brief Get the count of bytes ever written, the offset of the next one.
+            uint64_t Written() const { return mWritten; }
+
+            /// @brief Get the count of bytes dropped, the offset of the oldest one kept.
+            uint64_t Dropped() const { return mWritten - mBuffer.size(); }
+
+            /// @brief Copy the bytes kept from an offset on.
+            /// @param since - [in] - Offset to start at, moved up to the oldest byte kept.
+            /// @param out - [out] - Bytes copied, appended.
+            /// @return the offset copied from.
+            uint64_t Read(uint64_t since, std::string& out) const;
+
+        private:
+            std::vector<char>   mBuffer;        // Bytes kept, the oldest at mHead once full
+            size_t              mCapacity;      // Most bytes kept
+            size_t              mHead;          // Next write position once full
+            uint64_t            mWritten;       // Bytes ever written
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_OUTPUT_RING
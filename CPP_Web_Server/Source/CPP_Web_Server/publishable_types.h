@@ -12,6 +12,14 @@
 //
 //    Includes:
 #include <functional>                       // function pointer
+#include <map>                              // Type maps
+#include <string>                           // Strings
+#include <vector>                           // Argument lists
+#include <stdint.h>                         // Standard integer types
+#include <charconv>                         // from_chars
+#include <cmath>                            // isfinite
+#include <cstring>                          // memcpy
+#include <type_traits>                      // is_floating_point
 // 
 //    Defines:
 //          name                        reason defined
@@ -27,6 +35,8 @@ namespace Essentials
     {
         using Funcptr = std::function<void()>;
 
+        class JsonIndex;
+
         namespace Data
         {
             enum class Type
@@ -66,8 +76,172 @@ namespace Essentials
                 EDIT,
                 VIEW_EDIT,
             };
+
+            /// @brief Read a numeric value from memory of a data type.
+            /// @param type - [in] - Data type located at address.
+            /// @param address - [in] - Memory to read.
+            /// @param value - [out] - Value converted to a double.
+            /// @return false if the type is not numeric, true on success.
+            inline bool ReadNumber(Type type, const void* address, double& value)
+            {
+                switch (type)
+                {
+                case Type::CHAR:    value = *(const char*)address;              return true;
+                case Type::UCHAR:   value = *(const unsigned char*)address;     return true;
+                case Type::SHORT:   value = *(const short*)address;             return true;
+                case Type::USHORT:  value = *(const unsigned short*)address;    return true;
+                case Type::INT:     value = *(const int*)address;               return true;
+                case Type::UINT:    value = *(const unsigned int*)address;      return true;
+                case Type::DOUBLE:  value = *(const double*)address;            return true;
+                case Type::FLOAT:   value = *(const float*)address;             return true;
+                case Type::BOOL:    value = *(const bool*)address ? 1.0 : 0.0;  return true;
+                default:
+                    return false;
+                }
+            }
+
+            /// @brief Write a number to memory of a numeric type, converting it to the type.
+            /// @param type - [in] - Data type located at address.
+            /// @param address - [in] - Memory to write.
+            /// @param value - [in] - Value to convert and write.
+            /// @return false if the type is not numeric, true on success.
+            inline bool WriteNumber(Type type, void* address, double value)
+            {
+                switch (type)
+                {
+                case Type::CHAR:    *(char*)address = (char)value;                      return true;
+                case Type::UCHAR:   *(unsigned char*)address = (unsigned char)value;    return true;
+                case Type::SHORT:   *(short*)address = (short)value;                    return true;
+                case Type::USHORT:  *(unsigned short*)address = (unsigned short)value;  return true;
+                case Type::INT:     *(int*)address = (int)value;                        return true;
+                case Type::UINT:    *(unsigned int*)address = (unsigned int)value;      return true;
+                case Type::DOUBLE:  *(double*)address = value;                          return true;
+                case Type::FLOAT:   *(float*)address = (float)value;                    return true;
+                case Type::BOOL:    *(bool*)address = value != 0.0;                     return true;
+                default:
+                    return false;
+                }
+            }
+
+            /// @brief Get the size in memory of a numeric type.
+            /// @param type - [in] - Data type to size.
+            /// @return size in bytes, 0 if the type is not numeric.
+            inline size_t Size(Type type)
+            {
+                switch (type)
+                {
+                case Type::CHAR:    return sizeof(char);
+                case Type::UCHAR:   return sizeof(unsigned char);
+                case Type::SHORT:   return sizeof(short);
+                case Type::USHORT:  return sizeof(unsigned short);
+                case Type::INT:     return sizeof(int);
+                case Type::UINT:    return sizeof(unsigned int);
+                case Type::DOUBLE:  return sizeof(double);
+                case Type::FLOAT:   return sizeof(float);
+                case Type::BOOL:    return sizeof(bool);
+                default:
+                    return 0;
+                }
+            }
+
+            /// @brief Parse the whole of a text as a number of type T, failing when out of range.
+            template <typename T>
+            inline bool ParseNumber(const std::string& text, void* address)
+            {
+                T value{};
+                const char* last = text.data() + text.size();
+                std::from_chars_result result = std::from_chars(text.data(), last, value);
+                if (result.ec != std::errc() || result.ptr != last)
+                {
+                    return false;
+                }
+
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    if (!std::isfinite(value))
+                    {
+                        return false;
+                    }
+                }
+
+                memcpy(address, &value, sizeof(value));
+                return true;
+            }
+
+            /// @brief Parse text into memory of a data type. The text must be entirely a value
+            ///        of the type and within its range.
+            /// @param type - [in] - Data type located at address.
+            /// @param text - [in] - Text to parse, numbers as written by JSON, bools as true, false, 1 or 0.
+            /// @param address - [out] - Memory to write, a std::string for STRING.
+            /// @return false if the text is not a valid value of the type, true on success.
+            inline bool ParseValue(Type type, const std::string& text, void* address)
+            {
+                switch (type)
+                {
+                case Type::CHAR:    return ParseNumber<char>(text, address);
+                case Type::UCHAR:   return ParseNumber<unsigned char>(text, address);
+                case Type::SHORT:   return ParseNumber<short>(text, address);
+                case Type::USHORT:  return ParseNumber<unsigned short>(text, address);
+                case Type::INT:     return ParseNumber<int>(text, address);
+                case Type::UINT:    return ParseNumber<unsigned int>(text, address);
+                case Type::DOUBLE:  return ParseNumber<double>(text, address);
+                case Type::FLOAT:   return ParseNumber<float>(text, address);
+                case Type::STRING:  *(std::string*)address = text;  return true;
+                case Type::BOOL:
+                    if (text == "true" || text == "1")
+                    {
+                        *(bool*)address = true;
+                        return true;
+                    }
+                    if (text == "false" || text == "0")
+                    {
+                        *(bool*)address = false;
+                        return true;
+                    }
+                    return false;
+                default:
+                    return false;
+                }
+            }
+
+            static std::map<Access, std::string> AccessMap
+            {
+                {Access::HIDDEN,    std::string("hidden")},
+                {Access::VIEW,      std::string("view")},
+                {Access::EDIT,      std::string("edit")},
+                {Access::VIEW_EDIT, std::string("view_edit")},
+            };
+
+            /// @brief A value of any data type, as returned by a published function.
+            struct Value
+            {
+                Type        type;       // Type of the value, NONE for no value
+                double      number;     // Numeric and bool values
+                std::string text;       // STRING values
+
+                Value()
+                {
+                    type    = Type::NONE;
+                    number  = 0.0;
+                }
+
+                Value(Type new_type, double new_number)
+                {
+                    type    = new_type;
+                    number  = new_number;
+                }
+
+                Value(std::string new_text)
+                {
+                    type    = Type::STRING;
+                    number  = 0.0;
+                    text    = new_text;
+                }
+            };
         };
 
+        using ReadbackFuncptr = std::function<Data::Value()>;
+
         namespace Function
         {
             enum class Access
@@ -76,8 +250,33 @@ namespace Essentials
                 EXECUTE,
                 EXECUTE_READBACK,
             };
+
+            static std::map<Access, std::string> AccessMap
+            {
+                {Access::HIDDEN,            std::string("hidden")},
+                {Access::EXECUTE,           std::string("execute")},
+                {Access::EXECUTE_READBACK,  std::string("execute_readback")},
+            };
+
+            const static size_t ARGUMENTS_MAX = 256;    // Most encoded argument bytes one call carries
+
+            /// @brief Arguments of one call, encoded back to back as binary protocol values of
+            ///        the declared argument types. Held inline so a queued call needs no allocation.
+            struct Arguments
+            {
+                uint8_t bytes[ARGUMENTS_MAX];   // Encoded arguments
+                size_t  size;                   // Bytes used
+            };
+
+            /// @brief Validates a JSON array of arguments and encodes them, array being -1 when absent.
+            using JsonParser = bool (*)(const JsonIndex& json, int array, Arguments& arguments);
+
+            /// @brief Validates arguments received in the binary encoding and copies them.
+            using BinaryParser = bool (*)(const uint8_t* data, size_t size, Arguments& arguments);
         }
 
+        using ArgumentsFuncptr = std::function<Data::Value(const Function::Arguments& arguments)>;
+
         namespace Graph
         {
             enum class Type
@@ -103,6 +302,8 @@ namespace Essentials
             std::string         description;
             Data::Type          type;
             Data::Access        access;
+            uint32_t            id;             // Assigned by the server on registration
+            uint32_t            sample_period;  // Sample period in milliseconds, 0 to not sample
 
             PublishedData()
             {
@@ -111,6 +312,8 @@ namespace Essentials
                 description = "";
                 type        = Data::Type::NONE;
                 access      = Data::Access::VIEW;
+                id          = 0;
+                sample_period = 0;
             }
 
             PublishedData(void* new_address, std::string name, std::string new_description, Data::Type new_type)
@@ -120,6 +323,8 @@ namespace Essentials
                 description = new_description;
                 type        = new_type;
                 access      = Data::Access::VIEW;
+                id          = 0;
+                sample_period = 0;
             }
 
             PublishedData(std::string name)
@@ -129,6 +334,8 @@ namespace Essentials
                 description = "";
                 type        = Data::Type::NONE;
                 access      = Data::Access::VIEW;
+                id          = 0;
+                sample_period = 0;
             }
 
             std::string Peek()
@@ -191,6 +398,10 @@ namespace Essentials
         struct PublishedFunction
         {
             Funcptr                 address;
+            ReadbackFuncptr         readback;       // Called instead of address for EXECUTE_READBACK
+            ArgumentsFuncptr        typed;          // Called with the arguments for functions taking any
+            Function::JsonParser    parse_json      = nullptr;  // Argument parser of typed
+            Function::BinaryParser  parse_binary    = nullptr;  // Argument parser of typed
             //ObjectPointer<C> owner;
             std::string             unique_name;
             std::string             description;
@@ -227,6 +438,16 @@ namespace Essentials
                 access      = Function::Access::EXECUTE;
             }
 
+            PublishedFunction(ReadbackFuncptr new_readback, std::string name, std::string new_description, Data::Type new_return_type)
+            {
+                address     = nullptr;
+                readback    = new_readback;
+                unique_name = name;
+                description = new_description;
+                return_type = new_return_type;
+                access      = Function::Access::EXECUTE_READBACK;
+            }
+
             // PublishedFunction(void* object, Funcptr new_address, std::string name, std::string new_description)
             // {   
             //     address = new_address;
@@ -237,16 +458,22 @@ namespace Essentials
             //     access = Function::Access::EXECUTE;
             // }
 
-            PublishedFunction operator=(const PublishedFunction& old)
+            PublishedFunction& operator=(const PublishedFunction& old)
             {
-                PublishedFunction ret("ret");
-                ret.address     = old.address;
-                ret.unique_name = old.unique_name;
-                ret.description = old.description;
-                ret.return_type = old.return_type;
-                ret.access      = old.access;
-                return ret;
+                address     = old.address;
+                readback    = old.readback;
+                typed       = old.typed;
+                parse_json  = old.parse_json;
+                parse_binary = old.parse_binary;
+                unique_name = old.unique_name;
+                description = old.description;
+                return_type = old.return_type;
+                access      = old.access;
+                args        = old.args;
+                return *this;
             }
+
+            PublishedFunction(const PublishedFunction& old) = default;
             void Execute()
             {
                 Funcptr function = address;
@@ -259,6 +486,31 @@ namespace Essentials
                 //     owner.get_object()->f();
                 // }
             }
+
+            /// @brief Call the function, through typed when it has arguments or readback when it
+            ///        returns a value.
+            /// @param arguments - [in] - Arguments accepted by parse_json or parse_binary, unused without typed.
+            /// @return The returned value as return_type, a NONE value when nothing is returned.
+            Data::Value Invoke(const Function::Arguments& arguments)
+            {
+                if (typed)
+                {
+                    return typed(arguments);
+                }
+
+                if (readback)
+                {
+                    Data::Value value = readback();
+                    if (value.type != Data::Type::STRING && return_type != Data::Type::STRING)
+                    {
+                        value.type = return_type;
+                    }
+                    return value;
+                }
+
+                Execute();
+                return Data::Value();
+            }
         };
 #pragma pack(pop)
 
@@ -273,6 +525,8 @@ namespace Essentials
             std::string     graph_name;
             Graph::Type     graph_type;
             int             graph_size;
+            uint32_t        id;             // Assigned by the server on registration
+            uint32_t        sample_period;  // Sample period in milliseconds, 0 for the server default
 
             PublishedGraphData()
             {
@@ -284,6 +538,8 @@ namespace Essentials
                 graph_name = "";
                 graph_type = Graph::Type::NONE;
                 graph_size = 0;
+                id = 0;
+                sample_period = 0;
             }
 
             PublishedGraphData(void* new_address, std::string name, std::string new_description, Data::Type new_type, std::string new_graph_name, Graph::Type new_graph_type, int max_graph_size)
@@ -296,6 +552,8 @@ namespace Essentials
                 graph_name = new_graph_name;
                 graph_type = new_graph_type;
                 graph_size = max_graph_size;
+                id = 0;
+                sample_period = 0;
             }
 
             PublishedGraphData(std::string name)
@@ -308,6 +566,8 @@ namespace Essentials
                 graph_name = "";
                 graph_type = Graph::Type::NONE;
                 graph_size = 0;
+                id = 0;
+                sample_period = 0;
             }
 
             std::string Peek()
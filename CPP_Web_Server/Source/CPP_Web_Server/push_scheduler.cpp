@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       push_scheduler.cpp
+//!
+//! @brief      Implementation of the push scheduler
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "push_scheduler.h"          // Push Scheduler
+#include    <algorithm>                 // remove_if, any_of
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        PushScheduler::PushScheduler()
+        {
+            mChangePending = false;
+            mInterval = PUSH_INTERVAL_MSEC;
+            mLastTick = 0;
+        }
+
+        void PushScheduler::SetInterval(uint32_t msec)
+        {
+            mInterval = std::max<uint32_t>(msec, 1);
+        }
+
+        uint32_t PushScheduler::GetInterval() const
+        {
+            return mInterval;
+        }
+
+        bool PushScheduler::MarkChanged(const SubscribedItem& item)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mChangedMarked.size() <= item.id)
+            {
+                mChangedMarked.resize(item.id + 1, false);
+            }
+
+            if (!mChangedMarked[item.id])
+            {
+                mChangedMarked[item.id] = true;
+                mChanged.push_back(item);
+            }
+
+            return !mChangePending.exchange(true);
+        }
+
+        void PushScheduler::AddClient(unsigned long connection)
+        {
+            mClients.push_back({ connection, {}, {} });
+        }
+
+        void PushScheduler::RemoveClient(unsigned long connection)
+        {
+            mClients.erase(std::remove_if(mClients.begin(), mClients.end(),
+                [&](const PushClient& client) { return client.connection == connection; }), mClients.end());
+        }
+
+        uint64_t PushScheduler::NextDue() const
+        {
+            if (!mChangePending && std::none_of(mClients.begin(), mClients.end(),
+                [](const PushClient& client) { return !client.pending.empty(); }))
+            {
+                return UINT64_MAX;
+            }
+            return mLastTick + mInterval;
+        }
+
+        bool PushScheduler::TakeDue(uint64_t now)
+        {
+            if (now < NextDue())
+            {
+                return false;
+            }
+            mLastTick = now;
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mTaken.swap(mChanged);
+                mChanged.clear();
+                for (const SubscribedItem& item : mTaken)
+                {
+                    mChangedMarked[item.id] = false;
+                }
+                mChangePending = false;
+            }
+
+            for (PushClient& client : mClients)
+            {
+                for (const SubscribedItem& item : mTaken)
+                {
+                    if (client.marked.size() <= item.id)
+                    {
+                        client.marked.resize(item.id + 1, false);
+                    }
+                    if (!client.marked[item.id])
+                    {
+                        client.marked[item.id] = true;
+                        client.pending.push_back(item);
+                    }
+                }
+            }
+            return true;
+        }
+
+        void PushScheduler::Clear(PushClient& client)
+        {
+            for (const SubscribedItem& item : client.pending)
+            {
+                client.marked[item.id] = false;
+            }
+            client.pending.clear();
+        }
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       push_scheduler.h
+//!
+//! @brief      Coalesces changes of published items into one frame per client
+//!             per tick.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <vector>                           // Clients and changes
+#include <mutex>                            // Change protection
+#include <atomic>                           // Cross thread flags
+#include "subscription_table.h"             // SubscribedItem
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_PUSH_SCHEDULER              // Define the push scheduler header.
+#define     CPP_PUSH_SCHEDULER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static uint32_t PUSH_INTERVAL_MSEC = 50;      // Default time between pushed frames, 20 Hz
+
+        /// @brief Items waiting to be pushed to one websocket.
+        struct PushClient
+        {
+            unsigned long               connection;     // Websocket the frames go to
+            std::vector<SubscribedItem> pending;        // Items changed since its last frame
+            std::vector<bool>           marked;         // Items in pending, by item id
+        };
+
+        /// @brief Collects item changes from any thread and hands them to the server thread
+        ///        once per tick, merged into each client's pending items. An item changed many
+        ///        times between frames is pending once, so its frame carries only the latest
+        ///        value. A client left pending keeps its items until the next tick it can take.
+        class PushScheduler
+        {
+        public:
+            PushScheduler();
+
+            /// @brief Set the time between pushed frames.
+            /// @param msec - [in] - Milliseconds between frames, at least 1.
+            void SetInterval(uint32_t msec);
+
+            /// @brief Get the time between pushed frames.
+            /// @return milliseconds between frames.
+            uint32_t GetInterval() const;
+
+            /// @brief Record a change of an item, from any thread.
+            /// @param item - [in] - Item changed.
+            /// @return true if it is the first change since the last tick, false otherwise.
+            bool MarkChanged(const SubscribedItem& item);
+
+            /// @brief Add a websocket to push to. Server thread only.
+            /// @param connection - [in] - Websocket opened.
+            void AddClient(unsigned long connection);
+
+            /// @brief Remove a websocket. Server thread only.
+            /// @param connection - [in] - Websocket closed.
+            void RemoveClient(unsigned long connection);
+
+            /// @brief Get the time the next frames are due. Server thread only.
+            /// @return time in milliseconds, UINT64_MAX with nothing to push.
+            uint64_t NextDue() const;
+
+            /// @brief Merge the changes into every client when a tick is due. Server thread only.
+            /// @param now - [in] - Current time in milliseconds.
+            /// @return true if a tick is due and clients may be flushed, false otherwise.
+            bool TakeDue(uint64_t now);
+
+            /// @brief Get the clients to flush after TakeDue. Server thread only.
+            std::vector<PushClient>& Clients() { return mClients; }
+
+            /// @brief Clear the pending items of a client once its frame is sent.
+            /// @param client - [in/out] - Client flushed.
+            void Clear(PushClient& client);
+
+        private:
+            std::vector<PushClient>     mClients;           // Websockets, server thread only
+            std::vector<SubscribedItem> mChanged;           // Items changed since the last tick
+            std::vector<SubscribedItem> mTaken;             // Changes being merged, reused
+            std::vector<bool>           mChangedMarked;     // Items in mChanged, by item id
+            std::mutex                  mMutex;             // Guards mChanged and mChangedMarked
+            std::atomic<bool>           mChangePending;     // Set while mChanged holds changes
+            std::atomic<uint32_t>       mInterval;          // Milliseconds between frames
+            uint64_t                    mLastTick;          // Time of the last tick
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_PUSH_SCHEDULER
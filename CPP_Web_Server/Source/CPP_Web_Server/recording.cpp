@@ -0,0 +1,666 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       recording.cpp
+//!
+//! @brief      Implementation of the columnar recorder and reader
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "recording.h"               // Recording
+#include    <cstring>                   // memcmp, memcpy
+#include    <algorithm>                 // sort, partition_point
+#include    <chrono>                    // Chunk interval
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        static const char RECORDING_MAGIC[8] = { 'C', 'P', 'P', 'W', 'S', 'R', 'E', 'C' };
+        static const char RECORDING_END_MAGIC[8] = { 'C', 'P', 'P', 'W', 'S', 'E', 'N', 'D' };
+        static const uint32_t CHUNK_MAGIC = 0x4B4E4843;     // "CHNK"
+        static const uint32_t INDEX_MAGIC = 0x58444E49;     // "INDX"
+        static const size_t CHUNK_HEADER_SIZE = 32;
+        static const size_t COLUMN_ENTRY_SIZE = 12;
+        static const size_t TRAILER_SIZE = 16;
+
+        static void Put32(std::vector<uint8_t>& out, uint32_t value)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        static void Put64(std::vector<uint8_t>& out, uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        /// @brief Append raw bytes. Grows then copies, a range insert from a small fixed
+        ///        array trips -Wstringop-overflow in optimised builds.
+        static void PutBytes(std::vector<uint8_t>& out, const void* data, size_t size)
+        {
+            size_t at = out.size();
+            out.resize(at + size);
+            memcpy(out.data() + at, data, size);
+        }
+
+        static void PutString(std::vector<uint8_t>& out, const std::string& value)
+        {
+            uint16_t length = static_cast<uint16_t>(value.size() < UINT16_MAX ? value.size() : UINT16_MAX);
+            out.push_back(static_cast<uint8_t>(length));
+            out.push_back(static_cast<uint8_t>(length >> 8));
+            out.insert(out.end(), value.begin(), value.begin() + length);
+        }
+
+        static uint32_t Get32(const uint8_t* in)
+        {
+            uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+            {
+                value = (value << 8) | in[i];
+            }
+            return value;
+        }
+
+        static uint64_t Get64(const uint8_t* in)
+        {
+            uint64_t value = 0;
+            for (int i = 7; i >= 0; i--)
+            {
+                value = (value << 8) | in[i];
+            }
+            return value;
+        }
+
+        static bool ReadExact(FILE* file, void* out, size_t size)
+        {
+            return fread(out, 1, size, file) == size;
+        }
+
+        static bool ReadString(FILE* file, std::string& value)
+        {
+            uint8_t length[2];
+            if (!ReadExact(file, length, sizeof(length)))
+            {
+                return false;
+            }
+
+            value.resize(length[0] | (length[1] << 8));
+            return value.empty() || ReadExact(file, &value[0], value.size());
+        }
+
+        /// @brief Seek to an absolute 64 bit offset.
+        static bool Seek(FILE* file, uint64_t offset)
+        {
+#ifdef WIN32
+            return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+            return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+        }
+
+        /// @brief Get the size of a file, leaving the position at the end.
+        static uint64_t FileSize(FILE* file)
+        {
+#ifdef WIN32
+            _fseeki64(file, 0, SEEK_END);
+            return static_cast<uint64_t>(_ftelli64(file));
+#else
+            fseeko(file, 0, SEEK_END);
+            return static_cast<uint64_t>(ftello(file));
+#endif
+        }
+
+        Recorder::Recorder()
+        {
+            mFile = nullptr;
+            mOffset = 0;
+            mPending = 0;
+            mChunkMilliseconds = RECORDING_CHUNK_MSEC;
+            mRecording = false;
+            mStopping = false;
+        }
+
+        Recorder::~Recorder()
+        {
+            Stop();
+        }
+
+        int8_t Recorder::Start(const std::string& path, const std::vector<RecordingItem>& items, uint32_t chunkMilliseconds)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (mRecording || mThread.joinable() || items.empty() || chunkMilliseconds == 0)
+            {
+                return -1;
+            }
+
+            mFile = fopen(path.c_str(), "wb");
+            if (mFile == nullptr)
+            {
+                return -1;
+            }
+
+            // Chunks are built whole in memory, so skip stdio buffering and write each in one go
+            setvbuf(mFile, nullptr, _IONBF, 0);
+
+            mBuffer.clear();
+            PutBytes(mBuffer, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+            Put32(mBuffer, RECORDING_VERSION);
+            Put32(mBuffer, static_cast<uint32_t>(items.size()));
+
+            mColumnOf.clear();
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                const RecordingItem& item = items[i];
+                Put32(mBuffer, item.id);
+                mBuffer.push_back(item.graph ? 1 : 0);
+                mBuffer.push_back(static_cast<uint8_t>(item.type));
+                mBuffer.push_back(static_cast<uint8_t>(item.access));
+                mBuffer.push_back(static_cast<uint8_t>(item.graph_type));
+                Put32(mBuffer, static_cast<uint32_t>(item.graph_size));
+                Put32(mBuffer, item.sample_period);
+                PutString(mBuffer, item.unique_name);
+                PutString(mBuffer, item.description);
+                PutString(mBuffer, item.graph_name);
+
+                if (mColumnOf.size() <= item.id)
+                {
+                    mColumnOf.resize(item.id + 1, UINT32_MAX);
+                }
+                mColumnOf[item.id] = static_cast<uint32_t>(i);
+            }
+
+            if (fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size())
+            {
+                fclose(mFile);
+                mFile = nullptr;
+                return -1;
+            }
+
+            mOffset = mBuffer.size();
+            mColumns.clear();
+            mColumns.resize(items.size());
+            mPending = 0;
+            mIndex.clear();
+            mChunkMilliseconds = chunkMilliseconds;
+            mStopping = false;
+            mRecording = true;
+            mThread = std::thread(&Recorder::Run, this);
+            return 0;
+        }
+
+        void Recorder::Stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (!mRecording)
+                {
+                    return;
+                }
+                mRecording = false;
+                mStopping = true;
+            }
+
+            mCondition.notify_one();
+            if (mThread.joinable())
+            {
+                mThread.join();
+            }
+
+            fclose(mFile);
+            mFile = nullptr;
+        }
+
+        void Recorder::Record(uint32_t id, uint64_t timestamp, double value)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (!mRecording || id >= mColumnOf.size() || mColumnOf[id] == UINT32_MAX)
+            {
+                return;
+            }
+
+            Column& column = mColumns[mColumnOf[id]];
+            if (column.encoder.Count() == 0)
+            {
+                column.first = timestamp;
+            }
+            column.encoder.Append(timestamp, value);
+            column.last = timestamp;
+
+            // Bound the open chunk when items sample faster than expected
+            if (++mPending == RECORDING_CHUNK_SAMPLES_MAX)
+            {
+                mCondition.notify_one();
+            }
+        }
+
+        void Recorder::Run()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+
+            while (true)
+            {
+                mCondition.wait_for(lock, std::chrono::milliseconds(mChunkMilliseconds), [this]()
+                {
+                    return mStopping || mPending >= RECORDING_CHUNK_SAMPLES_MAX;
+                });
+
+                // Take the open chunk, the sampler carries on into a fresh one
+                std::vector<Column> columns(mColumns.size());
+                columns.swap(mColumns);
+                mPending = 0;
+                bool stopping = mStopping;
+
+                lock.unlock();
+                WriteChunk(columns);
+                if (stopping)
+                {
+                    WriteFooter();
+                    return;
+                }
+                lock.lock();
+            }
+        }
+
+        void Recorder::WriteChunk(std::vector<Column>& columns)
+        {
+            uint64_t first = UINT64_MAX;
+            uint64_t last = 0;
+            uint32_t count = 0;
+            for (const Column& column : columns)
+            {
+                if (column.encoder.Count() > 0)
+                {
+                    first = column.first < first ? column.first : first;
+                    last = column.last > last ? column.last : last;
+                    count++;
+                }
+            }
+
+            if (count == 0)
+            {
+                return;
+            }
+
+            mBuffer.clear();
+            Put32(mBuffer, CHUNK_MAGIC);
+            Put32(mBuffer, count);
+            Put64(mBuffer, first);
+            Put64(mBuffer, last);
+            Put64(mBuffer, 0);
+
+            // Column directory first so a reader after one item can skip straight to its block
+            for (size_t i = 0; i < columns.size(); i++)
+            {
+                const Gorilla::Encoder& encoder = columns[i].encoder;
+                if (encoder.Count() > 0)
+                {
+                    Put32(mBuffer, static_cast<uint32_t>(i));
+                    Put32(mBuffer, encoder.Count());
+                    Put32(mBuffer, static_cast<uint32_t>(encoder.Bytes().size()));
+                }
+            }
+
+            for (size_t i = 0; i < columns.size(); i++)
+            {
+                const Gorilla::Encoder& encoder = columns[i].encoder;
+                mBuffer.insert(mBuffer.end(), encoder.Bytes().begin(), encoder.Bytes().end());
+            }
+
+            // Patch the payload size now that it is known
+            uint64_t payload = mBuffer.size() - CHUNK_HEADER_SIZE;
+            for (int i = 0; i < 8; i++)
+            {
+                mBuffer[24 + i] = static_cast<uint8_t>(payload >> (i * 8));
+            }
+
+            if (fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) == mBuffer.size())
+            {
+                mIndex.push_back({ first, last, mOffset });
+                mOffset += mBuffer.size();
+            }
+        }
+
+        void Recorder::WriteFooter()
+        {
+            mBuffer.clear();
+            Put32(mBuffer, INDEX_MAGIC);
+            Put32(mBuffer, static_cast<uint32_t>(mIndex.size()));
+            for (const RecordingChunk& chunk : mIndex)
+            {
+                Put64(mBuffer, chunk.first);
+                Put64(mBuffer, chunk.last);
+                Put64(mBuffer, chunk.offset);
+            }
+            Put64(mBuffer, mOffset);
+            PutBytes(mBuffer, RECORDING_END_MAGIC, sizeof(RECORDING_END_MAGIC));
+
+            if (fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) == mBuffer.size())
+            {
+                mOffset += mBuffer.size();
+            }
+        }
+
+        RecordingReader::RecordingReader()
+        {
+            mFile = nullptr;
+        }
+
+        RecordingReader::~RecordingReader()
+        {
+            Close();
+        }
+
+        int8_t RecordingReader::Open(const std::string& path)
+        {
+            if (IsOpen())
+            {
+                return -1;
+            }
+
+            mFile = fopen(path.c_str(), "rb");
+            if (mFile == nullptr)
+            {
+                return -1;
+            }
+
+            uint8_t header[16];
+            if (!ReadExact(mFile, header, sizeof(header)) || memcmp(header, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0 ||
+                Get32(header + 8) != RECORDING_VERSION)
+            {
+                Close();
+                return -1;
+            }
+
+            mItems.resize(Get32(header + 12));
+            for (RecordingItem& item : mItems)
+            {
+                uint8_t fixed[16];
+                if (!ReadExact(mFile, fixed, sizeof(fixed)) || !ReadString(mFile, item.unique_name) ||
+                    !ReadString(mFile, item.description) || !ReadString(mFile, item.graph_name))
+                {
+                    Close();
+                    return -1;
+                }
+
+                item.id = Get32(fixed);
+                item.graph = fixed[4] != 0;
+                item.type = static_cast<Data::Type>(fixed[5]);
+                item.access = static_cast<Data::Access>(fixed[6]);
+                item.graph_type = static_cast<Graph::Type>(fixed[7]);
+                item.graph_size = static_cast<int>(Get32(fixed + 8));
+                item.sample_period = Get32(fixed + 12);
+            }
+
+            uint64_t start = static_cast<uint64_t>(ftell(mFile));
+            uint64_t size = FileSize(mFile);
+
+            mChunks.clear();
+            if (!ReadFooter(size))
+            {
+                ScanChunks(start, size);
+            }
+
+            return 0;
+        }
+
+        void RecordingReader::Close()
+        {
+            if (mFile != nullptr)
+            {
+                fclose(mFile);
+            }
+
+            mFile = nullptr;
+            mItems.clear();
+            mChunks.clear();
+        }
+
+        int8_t RecordingReader::LoadDirectory(size_t index, std::vector<uint8_t>& directory, uint64_t& payload)
+        {
+            uint8_t header[CHUNK_HEADER_SIZE];
+            if (index >= mChunks.size() || !Seek(mFile, mChunks[index].offset) ||
+                !ReadExact(mFile, header, sizeof(header)) || Get32(header) != CHUNK_MAGIC)
+            {
+                return -1;
+            }
+
+            payload = Get64(header + 24);
+            directory.resize(static_cast<size_t>(Get32(header + 4)) * COLUMN_ENTRY_SIZE);
+            if (directory.size() > payload || !ReadExact(mFile, directory.data(), directory.size()))
+            {
+                return -1;
+            }
+
+            return 0;
+        }
+
+        int8_t RecordingReader::ReadChunk(size_t index, std::vector<RecordingSample>& samples)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            samples.clear();
+
+            uint64_t payload = 0;
+            if (LoadDirectory(index, mDirectory, payload) < 0)
+            {
+                return -1;
+            }
+
+            // The blocks follow the directory, the rest of the chunk comes in with one read
+            mBuffer.resize(static_cast<size_t>(payload - mDirectory.size()));
+            if (!ReadExact(mFile, mBuffer.data(), mBuffer.size()))
+            {
+                return -1;
+            }
+
+            size_t position = 0;
+            for (size_t entry = 0; entry < mDirectory.size(); entry += COLUMN_ENTRY_SIZE)
+            {
+                uint32_t item = Get32(&mDirectory[entry]);
+                uint32_t count = Get32(&mDirectory[entry + 4]);
+                uint32_t bytes = Get32(&mDirectory[entry + 8]);
+                if (item >= mItems.size() || position + bytes > mBuffer.size())
+                {
+                    return -1;
+                }
+
+                Gorilla::Decoder decoder(&mBuffer[position], bytes, count);
+                RecordingSample sample = { 0, item, 0.0 };
+                while (decoder.Next(sample.timestamp, sample.value))
+                {
+                    samples.push_back(sample);
+                }
+                position += bytes;
+            }
+
+            // Columns are each in time order, interleave them for playback
+            std::stable_sort(samples.begin(), samples.end(), [](const RecordingSample& a, const RecordingSample& b)
+            {
+                return a.timestamp < b.timestamp;
+            });
+            return 0;
+        }
+
+        int8_t RecordingReader::ReadItem(uint32_t item, uint64_t since, uint64_t until, std::vector<uint64_t>& times, std::vector<double>& values)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (item >= mItems.size())
+            {
+                return -1;
+            }
+
+            // Chunks are written in time order, binary search the first one ending after since
+            auto first = std::partition_point(mChunks.begin(), mChunks.end(),
+                [&](const RecordingChunk& chunk) { return chunk.last <= since; });
+
+            for (auto chunk = first; chunk != mChunks.end() && chunk->first <= until; ++chunk)
+            {
+                uint32_t count = 0;
+                if (LoadBlock(static_cast<size_t>(chunk - mChunks.begin()), item, count) < 0)
+                {
+                    return -1;
+                }
+
+                Gorilla::Decoder decoder(mBuffer.data(), mBuffer.size(), count);
+                uint64_t timestamp = 0;
+                double value = 0.0;
+                while (decoder.Next(timestamp, value) && timestamp <= until)
+                {
+                    if (timestamp > since)
+                    {
+                        times.push_back(timestamp);
+                        values.push_back(value);
+                    }
+                }
+            }
+
+            return 0;
+        }
+
+        int8_t RecordingReader::ReadLast(uint32_t item, uint64_t until, uint64_t& timestamp, double& value)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            if (item >= mItems.size())
+            {
+                return -1;
+            }
+
+            // The last chunk starting by until, then earlier ones for items that skip chunks
+            size_t chunk = static_cast<size_t>(std::partition_point(mChunks.begin(), mChunks.end(),
+                [&](const RecordingChunk& entry) { return entry.first <= until; }) - mChunks.begin());
+
+            while (chunk-- > 0)
+            {
+                uint32_t count = 0;
+                if (LoadBlock(chunk, item, count) < 0)
+                {
+                    return -1;
+                }
+
+                bool found = false;
+                Gorilla::Decoder decoder(mBuffer.data(), mBuffer.size(), count);
+                uint64_t sampleTime = 0;
+                double sampleValue = 0.0;
+                while (decoder.Next(sampleTime, sampleValue) && sampleTime <= until)
+                {
+                    timestamp = sampleTime;
+                    value = sampleValue;
+                    found = true;
+                }
+
+                if (found)
+                {
+                    return 0;
+                }
+            }
+
+            return -1;
+        }
+
+        int8_t RecordingReader::LoadBlock(size_t index, uint32_t item, uint32_t& count)
+        {
+            count = 0;
+            mBuffer.clear();
+
+            uint64_t payload = 0;
+            if (LoadDirectory(index, mDirectory, payload) < 0)
+            {
+                return -1;
+            }
+
+            // Find this item's block in the directory, only that block is read
+            uint64_t position = mDirectory.size();
+            for (size_t entry = 0; entry < mDirectory.size(); entry += COLUMN_ENTRY_SIZE)
+            {
+                uint32_t bytes = Get32(&mDirectory[entry + 8]);
+                if (position + bytes > payload)
+                {
+                    return -1;
+                }
+
+                if (Get32(&mDirectory[entry]) == item)
+                {
+                    mBuffer.resize(bytes);
+                    if (!Seek(mFile, mChunks[index].offset + CHUNK_HEADER_SIZE + position) || !ReadExact(mFile, mBuffer.data(), bytes))
+                    {
+                        return -1;
+                    }
+
+                    count = Get32(&mDirectory[entry + 4]);
+                    return 0;
+                }
+                position += bytes;
+            }
+
+            return 0;
+        }
+
+        bool RecordingReader::ReadFooter(uint64_t size)
+        {
+            uint8_t trailer[TRAILER_SIZE];
+            if (size < TRAILER_SIZE || !Seek(mFile, size - TRAILER_SIZE) || !ReadExact(mFile, trailer, sizeof(trailer)) ||
+                memcmp(trailer + 8, RECORDING_END_MAGIC, sizeof(RECORDING_END_MAGIC)) != 0)
+            {
+                return false;
+            }
+
+            uint64_t offset = Get64(trailer);
+            uint8_t header[8];
+            if (offset + sizeof(header) > size || !Seek(mFile, offset) || !ReadExact(mFile, header, sizeof(header)) ||
+                Get32(header) != INDEX_MAGIC)
+            {
+                return false;
+            }
+
+            std::vector<uint8_t> entries(static_cast<size_t>(Get32(header + 4)) * 24);
+            if (offset + sizeof(header) + entries.size() + TRAILER_SIZE != size || !ReadExact(mFile, entries.data(), entries.size()))
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < entries.size(); i += 24)
+            {
+                mChunks.push_back({ Get64(&entries[i]), Get64(&entries[i + 8]), Get64(&entries[i + 16]) });
+            }
+
+            return true;
+        }
+
+        void RecordingReader::ScanChunks(uint64_t start, uint64_t size)
+        {
+            uint64_t offset = start;
+            uint8_t header[CHUNK_HEADER_SIZE];
+
+            while (offset + CHUNK_HEADER_SIZE <= size && Seek(mFile, offset) && ReadExact(mFile, header, sizeof(header)) &&
+                   Get32(header) == CHUNK_MAGIC)
+            {
+                uint64_t end = offset + CHUNK_HEADER_SIZE + Get64(header + 24);
+                if (end > size)
+                {
+                    // Torn by a crash mid write
+                    break;
+                }
+
+                mChunks.push_back({ Get64(header + 8), Get64(header + 16), offset });
+                offset = end;
+            }
+        }
+    } // End Communications
+} // End Essentials
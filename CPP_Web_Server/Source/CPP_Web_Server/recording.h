@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       recording.h
+//!
+//! @brief      Chunked columnar recording of sampled published items to disk
+//!             and reading it back for replay.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <stdio.h>                          // File access
+#include <string>                           // Paths and names
+#include <vector>                           // Columns and index
+#include <mutex>                            // Sampler / writer hand off
+#include <thread>                           // Writer thread
+#include <condition_variable>               // Writer wake up
+#include <atomic>                           // Recording flag
+#include "publishable_types.h"              // Item descriptions
+#include "gorilla_codec.h"                  // Column blocks
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_RECORDING                   // Define the recording header.
+#define     CPP_RECORDING
+//
+constexpr uint32_t RECORDING_VERSION = 2;                   //! Bumped on any layout change
+constexpr uint32_t RECORDING_CHUNK_MSEC = 10000;            //! Default time span of one chunk
+constexpr uint32_t RECORDING_CHUNK_SAMPLES_MAX = 1 << 20;   //! Samples that close a chunk early
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        //  File layout, little-endian:
+        //
+        //      header:     "CPPWSREC", u32 version, u32 item count,
+        //                  items x { u32 id, u8 graph, u8 Data::Type, u8 Data::Access,
+        //                            u8 Graph::Type, i32 graph size, u32 sample period,
+        //                            3 x { u16 length, bytes } unique name, description, graph name }
+        //      chunks:     u32 'CHNK', u32 column count, u64 first ms, u64 last ms, u64 payload bytes,
+        //                  columns x { u32 item index, u32 samples, u32 bytes }, columns x gorilla block
+        //      footer:     u32 'INDX', u32 chunk count, chunks x { u64 first ms, u64 last ms, u64 offset }
+        //      trailer:    u64 footer offset, "CPPWSEND"
+        //
+        //  A recording cut short has no footer, the reader then walks the chunk
+        //  headers instead and drops a torn last chunk.
+
+        /// @brief Description of one recorded item, enough to publish it again on replay.
+        struct RecordingItem
+        {
+            uint32_t        id;             // Item id at recording time
+            bool            graph;          // Published as graph data
+            Data::Type      type;
+            Data::Access    access;
+            std::string     unique_name;
+            std::string     description;
+            std::string     graph_name;
+            Graph::Type     graph_type;
+            int             graph_size;
+            uint32_t        sample_period;
+        };
+
+        /// @brief Time span and position of one chunk.
+        struct RecordingChunk
+        {
+            uint64_t    first;          // Earliest sample in milliseconds
+            uint64_t    last;           // Latest sample in milliseconds
+            uint64_t    offset;         // File offset of the chunk header
+        };
+
+        /// @brief One decoded sample.
+        struct RecordingSample
+        {
+            uint64_t    timestamp;      // Sample time in milliseconds
+            uint32_t    item;           // Index into the item table
+            double      value;          // Sample value
+        };
+
+        /// @brief Appends samples to a recording. Samples are encoded into per item
+        ///        columns in memory, a background thread turns each chunk interval
+        ///        into one sequential write.
+        class Recorder
+        {
+        public:
+            Recorder();
+            ~Recorder();
+
+            Recorder(const Recorder&) = delete;
+            Recorder& operator=(const Recorder&) = delete;
+
+            /// @brief Create a recording and start the writer thread.
+            /// @param path - [in] - File to write, replaced if it exists.
+            /// @param items - [in] - Items recorded, Record takes their ids.
+            /// @param chunkMilliseconds - [in] - Time span of one chunk.
+            /// @return -1 on error, 0 on success
+            int8_t Start(const std::string& path, const std::vector<RecordingItem>& items, uint32_t chunkMilliseconds = RECORDING_CHUNK_MSEC);
+
+            /// @brief Write the last chunk and the footer, then close the file.
+            void Stop();
+
+            /// @brief Get whether a recording is open.
+            bool IsRecording() const { return mRecording; }
+
+            /// @brief Append a sample. Items not in the recording are ignored.
+            /// @param id - [in] - Item id.
+            /// @param timestamp - [in] - Sample time in milliseconds, ascending per item.
+            /// @param value - [in] - Sample value.
+            void Record(uint32_t id, uint64_t timestamp, double value);
+
+            /// @brief Get the number of bytes written so far.
+            uint64_t BytesWritten() const { return mOffset; }
+
+        private:
+            /// @brief Samples of one item in the open chunk.
+            struct Column
+            {
+                Gorilla::Encoder    encoder;
+                uint64_t            first = 0;
+                uint64_t            last = 0;
+            };
+
+            /// @brief Writer thread, flushes a chunk every interval.
+            void Run();
+
+            /// @brief Encode and write one chunk of columns. Runs on the writer thread.
+            void WriteChunk(std::vector<Column>& columns);
+
+            /// @brief Write the footer and trailer.
+            void WriteFooter();
+
+            FILE*                       mFile;              // Recording file
+            std::atomic<uint64_t>       mOffset;            // Bytes written
+            std::vector<uint32_t>       mColumnOf;          // Column per item id, UINT32_MAX if not recorded
+            std::vector<Column>         mColumns;           // Open chunk
+            size_t                      mPending;           // Samples in the open chunk
+            std::vector<RecordingChunk> mIndex;             // Chunks written
+            std::vector<uint8_t>        mBuffer;            // Reused chunk write buffer
+            uint32_t                    mChunkMilliseconds; // Time span of one chunk
+            std::atomic<bool>           mRecording;         // File open
+            bool                        mStopping;          // Writer asked to finish
+            std::mutex                  mMutex;             // Guards the open chunk and flags
+            std::condition_variable     mCondition;         // Wakes the writer
+            std::thread                 mThread;            // Writer thread
+        };
+
+        /// @brief Reads a recording back chunk by chunk.
+        class RecordingReader
+        {
+        public:
+            RecordingReader();
+            ~RecordingReader();
+
+            RecordingReader(const RecordingReader&) = delete;
+            RecordingReader& operator=(const RecordingReader&) = delete;
+
+            /// @brief Open a recording and load its item table and time index.
+            /// @param path - [in] - File to read.
+            /// @return -1 on error, 0 on success
+            int8_t Open(const std::string& path);
+
+            /// @brief Close the file.
+            void Close();
+
+            /// @brief Get whether a recording is open.
+            bool IsOpen() const { return mFile != nullptr; }
+
+            /// @brief Get the recorded items.
+            const std::vector<RecordingItem>& Items() const { return mItems; }
+
+            /// @brief Get the chunk time index, in time order.
+            const std::vector<RecordingChunk>& Chunks() const { return mChunks; }
+
+            /// @brief Decode one chunk.
+            /// @param index - [in] - Chunk to read.
+            /// @param samples - [out] - Samples of every item, in time order.
+            /// @return -1 on error, 0 on success
+            int8_t ReadChunk(size_t index, std::vector<RecordingSample>& samples);
+
+            /// @brief Decode one item over a time window, binary searching the time index
+            ///        and reading only the chunks that overlap it.
+            /// @param item - [in] - Index into the item table.
+            /// @param since - [in] - Exclusive lower time bound in milliseconds.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param times - [out] - Timestamps appended here.
+            /// @param values - [out] - Values appended here.
+            /// @return -1 on error, 0 on success
+            int8_t ReadItem(uint32_t item, uint64_t since, uint64_t until, std::vector<uint64_t>& times, std::vector<double>& values);
+
+            /// @brief Decode the newest sample of one item at or before a time, walking back
+            ///        from the chunk holding the time until one holds the item.
+            /// @param item - [in] - Index into the item table.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param timestamp - [out] - Time of the sample.
+            /// @param value - [out] - Value of the sample.
+            /// @return -1 if there is none or on error, 0 on success
+            int8_t ReadLast(uint32_t item, uint64_t until, uint64_t& timestamp, double& value);
+
+        private:
+            /// @brief Read a chunk header and its column directory, leaving the file at the
+            ///        first block. Caller holds mMutex.
+            /// @param index - [in] - Chunk to read.
+            /// @param directory - [out] - Column directory entries.
+            /// @param payload - [out] - Payload size, directory included.
+            /// @return -1 on error, 0 on success
+            int8_t LoadDirectory(size_t index, std::vector<uint8_t>& directory, uint64_t& payload);
+
+            /// @brief Read the block of one item from a chunk into mBuffer. Caller holds mMutex.
+            /// @param index - [in] - Chunk to read.
+            /// @param item - [in] - Index into the item table.
+            /// @param count - [out] - Samples in the block, 0 if the chunk has none of the item.
+            /// @return -1 on error, 0 on success
+            int8_t LoadBlock(size_t index, uint32_t item, uint32_t& count);
+
+            /// @brief Load the footer index, false if the recording has none.
+            bool ReadFooter(uint64_t size);
+
+            /// @brief Rebuild the index by walking the chunk headers.
+            void ScanChunks(uint64_t start, uint64_t size);
+
+            FILE*                       mFile;          // Recording file
+            std::vector<RecordingItem>  mItems;         // Item table
+            std::vector<RecordingChunk> mChunks;        // Time index
+            std::vector<uint8_t>        mDirectory;     // Reused column directory buffer
+            std::vector<uint8_t>        mBuffer;        // Reused chunk read buffer
+            std::mutex                  mMutex;         // Guards the file position and buffer between readers
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_RECORDING
@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       sample_scheduler.cpp
+//!
+//! @brief      Implementation of the sampling scheduler
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "sample_scheduler.h"        // Sample Scheduler
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        SampleScheduler::SampleScheduler()
+        {
+            mTick = 0;
+            mEpoch = std::chrono::steady_clock::now();
+            mWallEpoch = 0;
+            mStatistics = {};
+            mRunning = false;
+        }
+
+        SampleScheduler::~SampleScheduler()
+        {
+            Stop();
+        }
+
+        int8_t SampleScheduler::Start(SweepCallback callback)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mRunning || !callback)
+            {
+                return -1;
+            }
+
+            // Tick 0 is now, groups added before starting already count from it
+            mEpoch = std::chrono::steady_clock::now();
+            mWallEpoch = GraphHistory::Now();
+            mCallback = callback;
+            mRunning = true;
+            mThread = std::thread(&SampleScheduler::Run, this);
+            return 0;
+        }
+
+        void SampleScheduler::Stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRunning = false;
+            }
+            mWake.notify_all();
+
+            if (mThread.joinable())
+            {
+                mThread.join();
+            }
+        }
+
+        int8_t SampleScheduler::AddTarget(uint32_t period, const SampleTarget& target)
+        {
+            if (period == 0 || period > SAMPLE_PERIOD_MAX_MSEC || target.address == nullptr)
+            {
+                return -1;
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            auto existing = mGroupByPeriod.find(period);
+            if (existing != mGroupByPeriod.end())
+            {
+                mGroups[existing->second].targets.push_back(target);
+                return 0;
+            }
+
+            SampleGroup group;
+            group.period = period;
+            group.expiry = mTick + period;
+            group.targets.push_back(target);
+
+            mGroups.push_back(std::move(group));
+            mGroupByPeriod[period] = mGroups.size() - 1;
+            Insert(mGroups.size() - 1);
+
+            // The new group may be due before the thread's current wake up time
+            mWake.notify_all();
+            return 0;
+        }
+
+        size_t SampleScheduler::GetNumberOfGroups()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mGroups.size();
+        }
+
+        SampleSchedulerStatistics SampleScheduler::GetStatistics()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            SampleSchedulerStatistics statistics = mStatistics;
+            statistics.elapsedNSec = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - mEpoch).count());
+            return statistics;
+        }
+
+        void SampleScheduler::Run()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            std::vector<size_t> due;
+
+            while (mRunning)
+            {
+                auto start = std::chrono::steady_clock::now();
+
+                // Catch the wheel up to the clock
+                uint64_t now = CurrentTick();
+                while (mTick < now)
+                {
+                    Tick(due);
+                }
+
+                auto bookkeeping = std::chrono::steady_clock::now();
+
+                if (!due.empty())
+                {
+                    // A wall clock step, such as an NTP correction, must not reorder the histories
+                    uint64_t timestamp = mWallEpoch + static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - mEpoch).count());
+                    for (size_t group : due)
+                    {
+                        mCallback(mGroups[group], timestamp);
+                    }
+                }
+
+                auto swept = std::chrono::steady_clock::now();
+
+                // Re-arm each fired group, skipping periods missed while behind
+                for (size_t group : due)
+                {
+                    SampleGroup& g = mGroups[group];
+                    g.expiry += g.period;
+                    if (g.expiry <= mTick)
+                    {
+                        g.expiry = mTick + g.period - ((mTick - g.expiry) % g.period);
+                    }
+                    Insert(group);
+                }
+
+                mStatistics.sweeps += due.size();
+                due.clear();
+
+                // Sleep until the earliest group is due. Groups are one per period so
+                // this scan is short regardless of how many items are sampled.
+                uint64_t next = UINT64_MAX;
+                for (const SampleGroup& g : mGroups)
+                {
+                    next = g.expiry < next ? g.expiry : next;
+                }
+
+                auto end = std::chrono::steady_clock::now();
+                mStatistics.overheadNSec += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    (bookkeeping - start) + (end - swept)).count());
+                mStatistics.sweepNSec += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    swept - bookkeeping).count());
+
+                if (next == UINT64_MAX)
+                {
+                    mWake.wait(lock);
+                }
+                else
+                {
+                    mWake.wait_until(lock, mEpoch + std::chrono::milliseconds(next));
+                }
+            }
+        }
+
+        uint64_t SampleScheduler::CurrentTick() const
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - mEpoch).count());
+        }
+
+        void SampleScheduler::Insert(size_t group)
+        {
+            uint64_t expiry = mGroups[group].expiry;
+            uint64_t delta = expiry > mTick ? expiry - mTick : 0;
+
+            // Pick the lowest level whose span covers the delay
+            uint32_t level = 0;
+            while (level < SAMPLE_WHEEL_LEVELS - 1 && delta >= (1ull << ((level + 1) * SAMPLE_WHEEL_SLOT_BITS)))
+            {
+                level++;
+            }
+
+            size_t slot = static_cast<size_t>((expiry >> (level * SAMPLE_WHEEL_SLOT_BITS)) & (SAMPLE_WHEEL_SLOTS - 1));
+            mWheel[level][slot].push_back(group);
+        }
+
+        void SampleScheduler::Tick(std::vector<size_t>& due)
+        {
+            mTick++;
+            mStatistics.ticks++;
+
+            // Cascade higher levels down as their slot comes around, highest first so
+            // groups can fall through more than one level in the same tick.
+            for (uint32_t level = SAMPLE_WHEEL_LEVELS - 1; level > 0; level--)
+            {
+                uint64_t mask = (1ull << (level * SAMPLE_WHEEL_SLOT_BITS)) - 1;
+                if ((mTick & mask) != 0)
+                {
+                    continue;
+                }
+
+                size_t slot = static_cast<size_t>((mTick >> (level * SAMPLE_WHEEL_SLOT_BITS)) & (SAMPLE_WHEEL_SLOTS - 1));
+                std::vector<size_t> cascade;
+                cascade.swap(mWheel[level][slot]);
+                for (size_t group : cascade)
+                {
+                    Insert(group);
+                }
+            }
+
+            std::vector<size_t>& expired = mWheel[0][mTick & (SAMPLE_WHEEL_SLOTS - 1)];
+            due.insert(due.end(), expired.begin(), expired.end());
+            expired.clear();
+        }
+    } // End Communications
+} // End Essentials
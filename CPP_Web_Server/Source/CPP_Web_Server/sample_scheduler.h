@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       sample_scheduler.h
+//!
+//! @brief      Per item sampling scheduler driven by a hierarchical timing
+//!             wheel on a dedicated thread.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <vector>                           // Groups and wheel slots
+#include <map>                              // Period to group lookup
+#include <functional>                       // Sweep callback
+#include <thread>                           // Scheduler thread
+#include <mutex>                            // Group protection
+#include <condition_variable>               // Scheduler wake up
+#include <chrono>                           // Tick clock
+#include "publishable_types.h"              // Data::Type
+#include "graph_history.h"                  // Graph history
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_SAMPLE_SCHEDULER            // Define the sample scheduler header.
+#define     CPP_SAMPLE_SCHEDULER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static uint32_t SAMPLE_WHEEL_LEVELS       = 4;    // Wheel levels
+        const static uint32_t SAMPLE_WHEEL_SLOT_BITS    = 6;    // 64 slots per level
+        const static uint32_t SAMPLE_WHEEL_SLOTS        = 1 << SAMPLE_WHEEL_SLOT_BITS;
+
+        /// @brief Longest supported sample period, the span of the whole wheel (about 4.6 hours).
+        const static uint32_t SAMPLE_PERIOD_MAX_MSEC    = (1u << (SAMPLE_WHEEL_LEVELS * SAMPLE_WHEEL_SLOT_BITS)) - 1;
+
+        /// @brief One item read during a sweep.
+        struct SampleTarget
+        {
+            const void*     address;        // Memory to sample
+            Data::Type      type;           // Type located at address
+            uint32_t        id;             // Item id assigned at registration
+            GraphHistory*   history;        // History to record into, nullptr for plain data
+        };
+
+        /// @brief All items sharing a sample period. Targets are stored contiguously
+        ///        so a sweep walks a single array.
+        struct SampleGroup
+        {
+            uint32_t                    period;     // Sample period in milliseconds
+            uint64_t                    expiry;     // Tick of the next sweep
+            std::vector<SampleTarget>   targets;    // Items sampled by this group
+        };
+
+        /// @brief Scheduler bookkeeping counters.
+        struct SampleSchedulerStatistics
+        {
+            uint64_t    sweeps;             // Group sweeps fired
+            uint64_t    ticks;              // Wheel ticks advanced
+            uint64_t    overheadNSec;       // Time spent in wheel bookkeeping, excluding sweeps
+            uint64_t    sweepNSec;          // Time spent inside sweep callbacks
+            uint64_t    elapsedNSec;        // Time since the scheduler started
+        };
+
+        /// @brief Samples groups of items at their own period. Each distinct period is
+        ///        one timer on a 4 level, 64 slot, 1 ms tick hierarchical wheel, so the
+        ///        cost of a tick does not grow with the number of items.
+        class SampleScheduler
+        {
+        public:
+            using SweepCallback = std::function<void(const SampleGroup& group, uint64_t timestamp)>;
+
+            SampleScheduler();
+            ~SampleScheduler();
+
+            /// @brief Start the scheduler thread.
+            /// @param callback - [in] - Called on the scheduler thread for every due group, with a
+            ///                          timestamp that follows the steady clock from the wall clock
+            ///                          time of the start, so it never goes backwards.
+            /// @return -1 on error, 0 on success
+            int8_t Start(SweepCallback callback);
+
+            /// @brief Stop and join the scheduler thread.
+            void Stop();
+
+            /// @brief Add an item, joining the group of its period.
+            /// @param period - [in] - Sample period in milliseconds, 1 to SAMPLE_PERIOD_MAX_MSEC.
+            /// @param target - [in] - Item to sample.
+            /// @return -1 on error, 0 on success
+            int8_t AddTarget(uint32_t period, const SampleTarget& target);
+
+            /// @brief Get the number of distinct periods scheduled.
+            size_t GetNumberOfGroups();
+
+            /// @brief Get a copy of the scheduler counters.
+            SampleSchedulerStatistics GetStatistics();
+
+        private:
+            /// @brief Blocking function that runs the wheel.
+            void Run();
+
+            /// @brief Get the current tick.
+            uint64_t CurrentTick() const;
+
+            /// @brief Place a group in the wheel slot for its expiry.
+            void Insert(size_t group);
+
+            /// @brief Advance the wheel one tick, collecting groups that are due.
+            void Tick(std::vector<size_t>& due);
+
+            std::vector<size_t>                     mWheel[SAMPLE_WHEEL_LEVELS][SAMPLE_WHEEL_SLOTS]; // Group indices per slot
+            std::vector<SampleGroup>                mGroups;        // Groups, one per period
+            std::map<uint32_t, size_t>              mGroupByPeriod; // Period to group index
+            uint64_t                                mTick;          // Last tick processed
+            std::chrono::steady_clock::time_point   mEpoch;         // Time of tick 0
+            uint64_t                                mWallEpoch;     // Wall clock time of tick 0 in milliseconds
+            SweepCallback                           mCallback;      // Sweep callback
+            SampleSchedulerStatistics               mStatistics;    // Counters
+            std::mutex                              mMutex;         // Guards wheel and groups
+            std::condition_variable                 mWake;          // Wakes the thread on change
+            std::thread                             mThread;        // Scheduler thread
+            bool                                    mRunning;       // Thread run flag
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_SAMPLE_SCHEDULER
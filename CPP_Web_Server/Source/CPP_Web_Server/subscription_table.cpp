@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       subscription_table.cpp
+//!
+//! @brief      Implementation of the subscription table
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "subscription_table.h"      // Subscription Table
+#include    <algorithm>                 // remove_if
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        /// @brief Get the first multiple of an interval after a time.
+        static uint64_t NextMultiple(uint64_t now, uint32_t interval)
+        {
+            return (now / interval + 1) * interval;
+        }
+
+        SubscriptionTable::SubscriptionTable()
+        {
+            mNextId = 1;
+            mNextDue = UINT64_MAX;
+        }
+
+        uint64_t SubscriptionTable::Add(unsigned long connection, uint32_t interval, std::vector<SubscribedItem> items, uint64_t now)
+        {
+            size_t held = static_cast<size_t>(std::count_if(mSubscriptions.begin(), mSubscriptions.end(),
+                [&](const Subscription& existing) { return existing.connection == connection; }));
+            if (held >= SUBSCRIPTIONS_PER_CONNECTION_MAX)
+            {
+                return 0;
+            }
+
+            interval = std::clamp(interval, SUBSCRIPTION_INTERVAL_MIN_MSEC, SUBSCRIPTION_INTERVAL_MAX_MSEC);
+
+            // Sorted items let a sweep read memory in registration order
+            std::sort(items.begin(), items.end(),
+                [](const SubscribedItem& a, const SubscribedItem& b) { return a.id < b.id; });
+
+            Subscription subscription = { mNextId++, connection, interval, NextMultiple(now, interval), std::move(items) };
+            mNextDue = std::min(mNextDue, subscription.due);
+            mSubscriptions.push_back(std::move(subscription));
+            return mSubscriptions.back().id;
+        }
+
+        int8_t SubscriptionTable::Remove(unsigned long connection, uint64_t id)
+        {
+            auto found = std::find_if(mSubscriptions.begin(), mSubscriptions.end(),
+                [&](const Subscription& existing) { return existing.id == id && existing.connection == connection; });
+            if (found == mSubscriptions.end())
+            {
+                return -1;
+            }
+
+            mSubscriptions.erase(found);
+            return 0;
+        }
+
+        void SubscriptionTable::RemoveConnection(unsigned long connection)
+        {
+            mSubscriptions.erase(std::remove_if(mSubscriptions.begin(), mSubscriptions.end(),
+                [&](const Subscription& existing) { return existing.connection == connection; }), mSubscriptions.end());
+
+            if (mSubscriptions.empty())
+            {
+                mNextDue = UINT64_MAX;
+            }
+        }
+
+        uint64_t SubscriptionTable::NextDue() const
+        {
+            return mNextDue;
+        }
+
+        void SubscriptionTable::TakeDue(uint64_t now, std::vector<const Subscription*>& due)
+        {
+            due.clear();
+            if (now < mNextDue)
+            {
+                return;
+            }
+
+            mNextDue = UINT64_MAX;
+            for (Subscription& subscription : mSubscriptions)
+            {
+                if (subscription.due <= now)
+                {
+                    due.push_back(&subscription);
+                    subscription.due = NextMultiple(now, subscription.interval);
+                }
+                mNextDue = std::min(mNextDue, subscription.due);
+            }
+        }
+    } // End Communications
+} // End Essentials
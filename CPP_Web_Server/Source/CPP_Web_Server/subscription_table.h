@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       subscription_table.h
+//!
+//! @brief      Per client subscriptions to published items, each sent at its
+//!             own rate.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <vector>                           // Subscriptions and items
+#include "publishable_types.h"              // Data::Type
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_SUBSCRIPTION_TABLE          // Define the subscription table header.
+#define     CPP_SUBSCRIPTION_TABLE
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static uint32_t SUBSCRIPTION_INTERVAL_MIN_MSEC    = 10;       // Fastest update, 100 Hz
+        const static uint32_t SUBSCRIPTION_INTERVAL_MAX_MSEC    = 3600000;  // Slowest update, once an hour
+        const static size_t   SUBSCRIPTIONS_PER_CONNECTION_MAX  = 32;       // Subscriptions one connection may hold
+
+        /// @brief One item of a subscription.
+        struct SubscribedItem
+        {
+            uint32_t        id;             // Item id assigned at registration
+            Data::Type      type;           // Type located at address
+            const void*     address;        // Memory of the item
+        };
+
+        /// @brief Items one connection receives at one rate.
+        struct Subscription
+        {
+            uint64_t                    id;             // Subscription id handed back to the client
+            unsigned long               connection;     // Websocket the updates go to
+            uint32_t                    interval;       // Milliseconds between updates
+            uint64_t                    due;            // Time of the next update in milliseconds
+            std::vector<SubscribedItem> items;          // Items sent, in id order
+        };
+
+        /// @brief Schedules subscriptions on a common millisecond clock. Updates fall on
+        ///        multiples of their interval, so subscriptions of the same or harmonic rates
+        ///        come due together and share one read of their items. Server thread only.
+        class SubscriptionTable
+        {
+        public:
+            SubscriptionTable();
+
+            /// @brief Add a subscription.
+            /// @param connection - [in] - Websocket the updates go to.
+            /// @param interval - [in] - Milliseconds between updates, clamped to the supported range.
+            /// @param items - [in] - Items sent.
+            /// @param now - [in] - Current time in milliseconds.
+            /// @return the subscription id, 0 if the connection holds too many.
+            uint64_t Add(unsigned long connection, uint32_t interval, std::vector<SubscribedItem> items, uint64_t now);
+
+            /// @brief Remove a subscription of a connection.
+            /// @param connection - [in] - Websocket holding the subscription.
+            /// @param id - [in] - Subscription id.
+            /// @return -1 if the connection holds no such subscription, 0 on success
+            int8_t Remove(unsigned long connection, uint64_t id);
+
+            /// @brief Remove every subscription of a connection.
+            /// @param connection - [in] - Websocket closed.
+            void RemoveConnection(unsigned long connection);
+
+            /// @brief Get the time the next subscription is due.
+            /// @return time in milliseconds, UINT64_MAX with no subscriptions.
+            uint64_t NextDue() const;
+
+            /// @brief Collect the subscriptions due and schedule their next update. Updates
+            ///        missed while late are skipped rather than sent in a burst.
+            /// @param now - [in] - Current time in milliseconds.
+            /// @param due - [out] - Subscriptions due, valid until the table next changes.
+            void TakeDue(uint64_t now, std::vector<const Subscription*>& due);
+
+            /// @brief Get the number of subscriptions.
+            size_t Size() const { return mSubscriptions.size(); }
+
+        private:
+            std::vector<Subscription>   mSubscriptions;     // Every subscription
+            uint64_t                    mNextId;            // Next id handed out
+            uint64_t                    mNextDue;           // Earliest due time
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_SUBSCRIPTION_TABLE
@@ -15,6 +15,11 @@
 //          --------------------        ---------------------------------------
 #include    "web_server.h"                // Web Server Class
 //
+//  Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#define     JSON_HEADERS                "Content-Type: application/json\r\n"
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 namespace Essentials
@@ -67,6 +72,24 @@ namespace Essentials
                 return -1;
             }
 
+            // Rings move onto the mapped file once, before anything samples into them
+            if (!mHistoryPath.empty() && !mHistoryFile.IsOpen() && MapGraphHistories() < 0)
+            {
+                mLastError = WebServerError::HISTORY_MAP_FAILURE;
+                return -1;
+            }
+
+            // Workers write a byte to the pipe as calls finish, waking the poll to deliver them
+            if (mWakeSocket < 0)
+            {
+                mWakeSocket = mg_mkpipe(&mManager, wakeCallback, static_cast<void*>(this), true);
+                if (mWakeSocket < 0)
+                {
+                    mLastError = WebServerError::WAKEUP_PIPE_FAILURE;
+                    return -1;
+                }
+            }
+
             std::string fullAddress = mAddress + ":" + std::to_string(mPort);
 
             mConnection = mg_http_listen(&mManager, fullAddress.c_str(), eventCallback, static_cast<void*>(this));
@@ -86,6 +109,25 @@ namespace Essentials
             // Set class thread to run the server connection. 
             mThread = std::thread(&Web_Server::Poll, this);
 
+            // Published functions run on the executor, never on the server thread.
+            mExecutor.Start([this]()
+            {
+                WakeServer();
+            });
+
+            // Start sampling published items at their periods.
+            mScheduler.Start([this](const SampleGroup& group, uint64_t timestamp)
+            {
+                SweepGroup(group, timestamp);
+            });
+
+            if (mReplayReader.IsOpen())
+            {
+                mReplayStop = false;
+                mReplayPosition = 0;
+                mReplayThread = std::thread(&Web_Server::Replay, this);
+            }
+
             // Set the default thread priority until user decides to change
 #ifdef WIN32
             SetServerThreadPriority(WebServerThreadPriority::NORMAL);
@@ -99,6 +141,19 @@ namespace Essentials
         void Web_Server::Stop()
         {
             mRunning = false;
+            mScheduler.Stop();
+            mRecorder.Stop();
+            mExecutor.Stop();
+
+            {
+                std::lock_guard<std::mutex> lock(mReplayMutex);
+                mReplayStop = true;
+            }
+            mReplayCondition.notify_one();
+            if (mReplayThread.joinable())
+            {
+                mReplayThread.join();
+            }
         }
 
         bool Web_Server::IsRunning()
@@ -158,12 +213,8 @@ namespace Essentials
             PublishedFunction temp;
             temp = function;
 
-            // Check if the unique_name already exists using this callable lambda function
-            if (std::any_of(mFunctions.begin(), mFunctions.end(),
-                [&](const PublishedFunction& existing)
-                {
-                    return existing.unique_name == temp.unique_name;
-                })) 
+            // Check if the unique_name already exists
+            if (!mFunctionIndex.emplace(temp.unique_name, mFunctions.size()).second)
             {
                 // Duplicate found, return failure
                 return -1;
@@ -179,19 +230,28 @@ namespace Essentials
             PublishedData temp;
             temp = data;
 
-            // Check if the unique_name already exists using this callable lambda function
-            if (std::any_of(mDatas.begin(), mDatas.end(),
-                [&](const PublishedData& existing)
-                {
-                    return existing.unique_name == temp.unique_name;
-                }))
+            // A period the scheduler would refuse is refused before the item is added
+            if (temp.sample_period > 0 && (temp.sample_period > SAMPLE_PERIOD_MAX_MSEC || temp.address == nullptr))
+            {
+                return -1;
+            }
+
+            // Check if the unique_name already exists
+            if (!mDataIndex.emplace(temp.unique_name, mDatas.size()).second)
             {
                 // Duplicate found, return failure
                 return -1;
             }
 
             // No duplicate found, add the function to the vector
+            temp.id = mNextItemId++;
             mDatas.push_back(temp);
+
+            // Data with a period is sampled for its latest value
+            if (temp.sample_period > 0)
+            {
+                return ScheduleSampling(temp.sample_period, { temp.address, temp.type, temp.id, nullptr });
+            }
             return 0;
         }
 
@@ -200,6 +260,12 @@ namespace Essentials
             PublishedGraphData temp;
             temp = graph;
 
+            // A period the scheduler would refuse is refused before the graph is added
+            if (temp.sample_period > SAMPLE_PERIOD_MAX_MSEC)
+            {
+                return -1;
+            }
+
             // Check if the unique_name already exists using this callable lambda function
             if (std::any_of(mGraphDatas.begin(), mGraphDatas.end(),
                 [&](const PublishedGraphData& existing)
@@ -211,10 +277,260 @@ namespace Essentials
                 return -1;
             }
 
+            // Numeric graphs with a size get a history to sample into
+            std::unique_ptr<GraphHistory> history;
+            double value = 0.0;
+            if (temp.graph_size > 0 && temp.address != nullptr && Data::ReadNumber(temp.type, temp.address, value))
+            {
+                history = std::make_unique<GraphHistory>();
+                if (history->Initialize(static_cast<size_t>(temp.graph_size), mRollupTiers, mGraphCompression) < 0)
+                {
+                    return -1;
+                }
+            }
+
+            GraphHistory* target = history.get();
+
             // No duplicate found, add the function to the vector
-            mGraphDatas.push_back(temp);
+            {
+                std::lock_guard<std::mutex> lock(mHistoryMutex);
+                temp.id = mNextItemId++;
+                mGraphDatas.push_back(temp);
+                mGraphHistories.push_back(std::move(history));
+            }
+
+            if (target != nullptr)
+            {
+                uint32_t period = temp.sample_period > 0 ? temp.sample_period : mGraphSampleRate;
+                return ScheduleSampling(period, { temp.address, temp.type, temp.id, target });
+            }
+            return 0;
+        }
+
+        int8_t Web_Server::SetGraphSampleRate(uint32_t milliseconds)
+        {
+            if (milliseconds == 0 || milliseconds > SAMPLE_PERIOD_MAX_MSEC)
+            {
+                return -1;
+            }
+
+            mGraphSampleRate = milliseconds;
+            return 0;
+        }
+
+        int8_t Web_Server::SetGraphRollupTiers(const std::vector<RollupTier>& tiers)
+        {
+            for (size_t i = 0; i < tiers.size(); i++)
+            {
+                if (tiers[i].resolution == 0 || tiers[i].retention < tiers[i].resolution)
+                {
+                    return -1;
+                }
+
+                // Tiers must go from finest to coarsest
+                if (i > 0 && tiers[i].resolution <= tiers[i - 1].resolution)
+                {
+                    return -1;
+                }
+            }
+
+            mRollupTiers = tiers;
+            return 0;
+        }
+
+        void Web_Server::SetGraphCompression(bool enable)
+        {
+            mGraphCompression = enable;
+        }
+
+        int8_t Web_Server::EnablePersistentHistory(const std::string& path)
+        {
+            if (mRunning)
+            {
+                return -1;
+            }
+
+            mHistoryPath = path;
+            return 0;
+        }
+
+        int8_t Web_Server::StartRecording(const std::string& path)
+        {
+            std::vector<RecordingItem> items;
+            double value = 0.0;
+
+            {
+                std::lock_guard<std::mutex> lock(mHistoryMutex);
+
+                // Only sampled items have values to record
+                for (const PublishedData& data : mDatas)
+                {
+                    if (data.sample_period > 0 && data.address != nullptr && Data::ReadNumber(data.type, data.address, value))
+                    {
+                        items.push_back({ data.id, false, data.type, data.access, data.unique_name, data.description,
+                            "", Graph::Type::NONE, 0, data.sample_period });
+                    }
+                }
+
+                for (size_t i = 0; i < mGraphDatas.size(); i++)
+                {
+                    const PublishedGraphData& graph = mGraphDatas[i];
+                    if (mGraphHistories[i])
+                    {
+                        items.push_back({ graph.id, true, graph.type, graph.access, graph.unique_name, graph.description,
+                            graph.graph_name, graph.graph_type, graph.graph_size,
+                            graph.sample_period > 0 ? graph.sample_period : mGraphSampleRate });
+                    }
+                }
+            }
+
+            return mRecorder.Start(path, items);
+        }
+
+        void Web_Server::StopRecording()
+        {
+            mRecorder.Stop();
+        }
+
+        int8_t Web_Server::StartReplay(const std::string& path, double speed)
+        {
+            if (mRunning || speed <= 0.0 || mReplayReader.IsOpen() || !mDatas.empty() || !mGraphDatas.empty())
+            {
+                return -1;
+            }
+
+            if (mReplayReader.Open(path) < 0)
+            {
+                return -1;
+            }
+
+            const std::vector<RecordingItem>& items = mReplayReader.Items();
+            mReplaySpeed = speed;
+            mReplayValues.assign(items.size(), 0);
+            mReplayTargets.clear();
+
+            // Publish the recorded items from replay storage. Nothing is scheduled for sampling,
+            // the replay thread feeds the latest samples and graph histories itself.
+            std::lock_guard<std::mutex> lock(mHistoryMutex);
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                const RecordingItem& item = items[i];
+                void* address = &mReplayValues[i];
+                SampleTarget target = { address, item.type, mNextItemId++, nullptr };
+
+                if (item.graph)
+                {
+                    PublishedGraphData graph(address, item.unique_name, item.description, item.type,
+                        item.graph_name, item.graph_type, item.graph_size);
+                    graph.access = item.access;
+                    graph.id = target.id;
+                    graph.sample_period = item.sample_period;
+
+                    std::unique_ptr<GraphHistory> history = std::make_unique<GraphHistory>();
+                    if (history->Initialize(static_cast<size_t>(item.graph_size), mRollupTiers, mGraphCompression) < 0)
+                    {
+                        return -1;
+                    }
+                    target.history = history.get();
+
+                    mGraphDatas.push_back(graph);
+                    mGraphHistories.push_back(std::move(history));
+                }
+                else
+                {
+                    PublishedData data(address, item.unique_name, item.description, item.type);
+                    data.access = item.access;
+                    data.id = target.id;
+                    data.sample_period = item.sample_period;
+                    mDataIndex.emplace(data.unique_name, mDatas.size());
+                    mDatas.push_back(data);
+                }
+
+                mReplayTargets.push_back(target);
+            }
+
+            {
+                std::lock_guard<std::mutex> sampleLock(mSampleMutex);
+                mLatestSamples.resize(mNextItemId, { 0.0, 0 });
+            }
+
+            return 0;
+        }
+
+        int8_t Web_Server::GetLatestSample(const std::string& name, double& value, uint64_t& timestamp)
+        {
+            uint32_t id = UINT32_MAX;
+            for (const auto& data : mDatas)
+            {
+                if (data.unique_name == name)
+                {
+                    id = data.id;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mHistoryMutex);
+                for (const auto& graph : mGraphDatas)
+                {
+                    if (graph.unique_name == name)
+                    {
+                        id = graph.id;
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mSampleMutex);
+            if (id >= mLatestSamples.size() || mLatestSamples[id].timestamp == 0)
+            {
+                return -1;
+            }
+
+            value = mLatestSamples[id].value;
+            timestamp = mLatestSamples[id].timestamp;
+            return 0;
+        }
+
+        void Web_Server::SetEditCallback(EditCallback callback)
+        {
+            std::lock_guard<std::mutex> lock(mDataMutex);
+            mEditCallback = callback;
+        }
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+        int8_t Web_Server::SetShellLimits(size_t sessions, uint64_t idleMilliseconds)
+        {
+            if (mRunning || idleMilliseconds < 1000)
+            {
+                return -1;
+            }
+
+            mShellSessionsMax = sessions;
+            mShellIdleTimeout = idleMilliseconds;
+            return 0;
+        }
+
+        int8_t Web_Server::SetTerminalJobLimits(size_t running, size_t outputBytes)
+        {
+            if (mRunning)
+            {
+                return -1;
+            }
+
+            mTerminalJobsMax = running;
+            mTerminalJobOutput = outputBytes;
             return 0;
         }
+#endif
+
+        std::unique_lock<std::mutex> Web_Server::LockPublishedData()
+        {
+            return std::unique_lock<std::mutex>(mDataMutex);
+        }
+
+        SampleSchedulerStatistics Web_Server::GetSampleSchedulerStatistics()
+        {
+            return mScheduler.GetStatistics();
+        }
 
         int8_t Web_Server::GetNumberOfPublishedFunctions()
         {
@@ -288,9 +604,31 @@ namespace Essentials
             mConnection = nullptr;
             mWebsocketConnetion = nullptr;
             mUpgraded = false;
+            mNextItemId = 0;
+            mGraphSampleRate = 100;
+            mRollupTiers = { { 1000, 24ull * 60 * 60 * 1000 }, { 60 * 1000, 30ull * 24 * 60 * 60 * 1000 } };
+            mGraphCompression = false;
+            mReplaySpeed = 1.0;
+            mReplayStop = false;
+            mWakeSocket = -1;
+            mNextCallId = 1;
+            mNextRpcBatch = 1;
+            mRecordSweep = 0;
+#ifdef CPP_WEBSOCKET_DEFLATE
+            mDeflateLevel = WEBSOCKET_DEFLATE_LEVEL;
+#else
+            mDeflateLevel = 0;
+#endif
+            mDeflateThreshold = WEBSOCKET_DEFLATE_THRESHOLD;
+            mRpcMethods = { { "data.get", &Web_Server::RpcDataGet }, { "data.set", &Web_Server::RpcDataSet } };
 
-#ifdef CPP_TERMINAL
+#ifdef CPP_WEB_SERVER_TERMINAL
             mTerminal = new Essentials::Utilities::Terminal;
+            mNextTerminalJob = 1;
+            mTerminalJobsMax = TERMINAL_JOBS_MAX;
+            mTerminalJobOutput = TERMINAL_JOB_OUTPUT;
+            mShellSessionsMax = SHELL_SESSIONS_MAX;
+            mShellIdleTimeout = SHELL_IDLE_MSEC;
 #endif
 
 #ifdef CPP_LOGGER
@@ -301,19 +639,175 @@ namespace Essentials
         Web_Server::~Web_Server()
         {
             Stop();
-            mg_mgr_free(&mManager);
 
+            // The poll thread may still be sending, let it finish before the connections go
             if (mThread.joinable())
             {
                 mThread.join();
             }
+
+            mg_mgr_free(&mManager);
+
+            if (mWakeSocket >= 0)
+            {
+#ifdef WIN32
+                closesocket(mWakeSocket);
+#else
+                close(mWakeSocket);
+#endif
+            }
+
         }
 
         void Web_Server::Poll()
         {
             while (mRunning)
             {
-                mg_mgr_poll(&mManager, 100);
+                // Wake in time for the next subscription update or push tick
+                uint64_t now = mg_millis();
+                uint64_t due = std::min(mSubscriptions.NextDue(), mPushScheduler.NextDue());
+                int timeout = due <= now ? 0 : static_cast<int>(std::min<uint64_t>(100, due - now));
+                mg_mgr_poll(&mManager, timeout);
+
+                now = mg_millis();
+                PublishSubscriptions(now);
+                PushUpdates(now);
+                FlushConsoleLogs();
+#ifdef CPP_WEB_SERVER_TERMINAL
+                ServiceTerminals();
+                ServiceShells(now);
+#endif
+            }
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+            // Commands and shells still running would outlive the server
+            KillTerminalJobs();
+            KillShells(0, true);
+#endif
+        }
+
+        int8_t Web_Server::ScheduleSampling(uint32_t period, const SampleTarget& target)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mSampleMutex);
+                if (mLatestSamples.size() <= target.id)
+                {
+                    mLatestSamples.resize(target.id + 1, { 0.0, 0 });
+                }
+            }
+
+            return mScheduler.AddTarget(period, target);
+        }
+
+        int8_t Web_Server::MapGraphHistories()
+        {
+            std::lock_guard<std::mutex> lock(mHistoryMutex);
+
+            // Ring backed graphs with a name that fits the file directory, in registration order
+            std::vector<HistoryFileLayout> layout;
+            std::vector<GraphHistory*> histories;
+            for (size_t i = 0; i < mGraphDatas.size(); i++)
+            {
+                GraphHistory* history = mGraphHistories[i].get();
+                if (history != nullptr && !history->IsCompressed() && mGraphDatas[i].unique_name.size() < HISTORY_FILE_NAME_SIZE)
+                {
+                    layout.push_back({ mGraphDatas[i].unique_name, history->Capacity() });
+                    histories.push_back(history);
+                }
+            }
+
+            if (mHistoryFile.Open(mHistoryPath, layout) < 0)
+            {
+                return -1;
+            }
+
+            for (size_t i = 0; i < histories.size(); i++)
+            {
+                HistoryFileEntry* entry = mHistoryFile.Entry(i);
+                if (histories[i]->AttachStorage(mHistoryFile.Times(i), mHistoryFile.Values(i), &entry->writeIndex,
+                    static_cast<size_t>(entry->capacity)) < 0)
+                {
+                    return -1;
+                }
+            }
+
+            MG_INFO(("Graph history    : %s (%s)", mHistoryPath.c_str(), mHistoryFile.IsResumed() ? "resumed" : "created"));
+            return 0;
+        }
+
+        void Web_Server::Replay()
+        {
+            const std::vector<RecordingChunk>& chunks = mReplayReader.Chunks();
+            if (chunks.empty())
+            {
+                return;
+            }
+
+            // Recording time maps onto wall time from the moment playback starts
+            const uint64_t origin = chunks.front().first;
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<RecordingSample> samples;
+
+            MG_INFO(("Replay           : %u chunks at %.2fx", static_cast<unsigned>(chunks.size()), mReplaySpeed));
+
+            for (size_t c = 0; c < chunks.size(); c++)
+            {
+                if (mReplayReader.ReadChunk(c, samples) < 0)
+                {
+                    continue;
+                }
+
+                for (const RecordingSample& sample : samples)
+                {
+                    auto due = start + std::chrono::microseconds(static_cast<int64_t>(
+                        static_cast<double>(sample.timestamp - origin) * 1000.0 / mReplaySpeed));
+
+                    {
+                        std::unique_lock<std::mutex> lock(mReplayMutex);
+                        if (mReplayCondition.wait_until(lock, due, [this]() { return mReplayStop; }))
+                        {
+                            return;
+                        }
+                    }
+
+                    const SampleTarget& target = mReplayTargets[sample.item];
+                    std::scoped_lock lock(mDataMutex, mSampleMutex);
+                    Data::WriteNumber(target.type, &mReplayValues[sample.item], sample.value);
+                    if (target.history != nullptr)
+                    {
+                        target.history->Record(sample.timestamp, sample.value);
+                    }
+                    mLatestSamples[target.id] = { sample.value, sample.timestamp };
+                    mReplayPosition.store(sample.timestamp, std::memory_order_relaxed);
+                }
+            }
+
+            MG_INFO(("Replay           : finished"));
+        }
+
+        void Web_Server::SweepGroup(const SampleGroup& group, uint64_t timestamp)
+        {
+            std::scoped_lock lock(mDataMutex, mSampleMutex);
+
+            for (const SampleTarget& target : group.targets)
+            {
+                double value = 0.0;
+                if (!Data::ReadNumber(target.type, target.address, value))
+                {
+                    continue;
+                }
+
+                if (target.history != nullptr)
+                {
+                    target.history->Record(timestamp, value);
+                }
+
+                mLatestSamples[target.id] = { value, timestamp };
+
+                if (mRecorder.IsRecording())
+                {
+                    mRecorder.Record(target.id, timestamp, value);
+                }
             }
         }
 
@@ -341,12 +835,2561 @@ namespace Essentials
         {
             if (this->mWebsocketConnetion && this->mUpgraded)
             {
-                mg_ws_send(this->mWebsocketConnetion, message.c_str(), message.size(), WEBSOCKET_OP_TEXT);
+                bool wake = false;
+                {
+                    std::lock_guard<std::mutex> lock(mConsoleMutex);
+                    wake = mConsoleLogs.empty();
+                    mConsoleLogs.push_back(message);
+                }
+
+                if (wake)
+                {
+                    WakeServer();
+                }
                 return 0;
             }
 
             // WebSocket connection not available or not upgraded
             return -1;
         }
+
+        int8_t Web_Server::ConfigureCompression(int level, size_t threshold)
+        {
+#ifdef CPP_WEBSOCKET_DEFLATE
+            if (mRunning || level < 0 || level > 9)
+            {
+                return -1;
+            }
+
+            mDeflateLevel = level;
+            mDeflateThreshold = threshold;
+            return 0;
+#else
+            // Without zlib compression can only be off
+            return level == 0 ? 0 : -1;
+#endif
+        }
+
+        int8_t Web_Server::SendDataUpdate()
+        {
+            if (!this->mWebsocketConnetion || !this->mUpgraded)
+            {
+                // WebSocket connection not available or not upgraded
+                return -1;
+            }
+
+            bool wake = false;
+            for (const auto& data : mDatas)
+            {
+                if (IsViewable(data.access) && data.address != nullptr)
+                {
+                    wake |= mPushScheduler.MarkChanged({ data.id, data.type, data.address });
+                }
+            }
+
+            for (const auto& graph : mGraphDatas)
+            {
+                if (IsViewable(graph.access) && graph.address != nullptr)
+                {
+                    wake |= mPushScheduler.MarkChanged({ graph.id, graph.type, graph.address });
+                }
+            }
+
+            // The server thread may be asleep until well after the next tick
+            if (wake)
+            {
+                WakeServer();
+            }
+            return 0;
+        }
+
+        int8_t Web_Server::SendDataUpdate(const std::string& name)
+        {
+            if (!this->mWebsocketConnetion || !this->mUpgraded)
+            {
+                return -1;
+            }
+
+            SubscribedItem item = { 0, Data::Type::NONE, nullptr };
+            auto position = mDataIndex.find(name);
+            if (position != mDataIndex.end())
+            {
+                const PublishedData& data = mDatas[position->second];
+                item = { data.id, data.type, IsViewable(data.access) ? data.address : nullptr };
+            }
+            else
+            {
+                for (const auto& graph : mGraphDatas)
+                {
+                    if (graph.unique_name == name)
+                    {
+                        item = { graph.id, graph.type, IsViewable(graph.access) ? graph.address : nullptr };
+                        break;
+                    }
+                }
+            }
+
+            if (item.address == nullptr)
+            {
+                return -1;
+            }
+
+            if (mPushScheduler.MarkChanged(item))
+            {
+                WakeServer();
+            }
+            return 0;
+        }
+
+        void Web_Server::SetPushInterval(uint32_t msec)
+        {
+            mPushScheduler.SetInterval(msec);
+        }
+
+        void Web_Server::HandleSchemaRequest(mg_connection* conn)
+        {
+            JsonWriter& json = mResponseWriter;
+            json.Clear();
+            json.BeginObject();
+            json.Key("version");
+            json.Number(Binary::PROTOCOL_VERSION);
+            json.Key("items");
+            json.BeginArray();
+
+            auto addItem = [&](uint32_t id, const std::string& name, const std::string& description,
+                               Data::Type type, Data::Access access, const char* kind)
+            {
+                json.BeginObject();
+                json.Key("id");
+                json.Number(id);
+                json.Key("name");
+                json.String(name);
+                json.Key("description");
+                json.String(description);
+                json.Key("type");
+                json.String(Data::TypeMap[type]);
+                json.Key("type_id");
+                json.Number(static_cast<int>(type));
+                json.Key("access");
+                json.String(Data::AccessMap[access]);
+                json.Key("kind");
+                json.String(kind);
+                json.EndObject();
+            };
+
+            for (const auto& data : mDatas)
+            {
+                if (data.access != Data::Access::HIDDEN)
+                {
+                    addItem(data.id, data.unique_name, data.description, data.type, data.access, "data");
+                }
+            }
+
+            for (const auto& graph : mGraphDatas)
+            {
+                if (graph.access != Data::Access::HIDDEN)
+                {
+                    addItem(graph.id, graph.unique_name, graph.description, graph.type, graph.access, "graph");
+                }
+            }
+
+            json.EndArray();
+            json.Key("functions");
+            json.BeginArray();
+            for (const auto& function : mFunctions)
+            {
+                if (function.access == Function::Access::HIDDEN)
+                {
+                    continue;
+                }
+
+                json.BeginObject();
+                json.Key("name");
+                json.String(function.unique_name);
+                json.Key("description");
+                json.String(function.description);
+                json.Key("return_type");
+                json.String(Data::TypeMap[function.return_type]);
+                json.Key("args");
+                json.BeginArray();
+                for (Data::Type arg : function.args)
+                {
+                    json.String(Data::TypeMap[arg]);
+                }
+                json.EndArray();
+                json.Key("access");
+                json.String(Function::AccessMap[function.access]);
+                json.EndObject();
+            }
+            json.EndArray();
+            json.EndObject();
+
+            SendJsonReply(conn, 200, json.Text());
+        }
+
+        void Web_Server::HandleDataRequest(mg_connection* conn)
+        {
+            // Values are formatted straight from their addresses, no per item strings
+            JsonWriter& json = mResponseWriter;
+            json.Clear();
+            json.BeginObject();
+
+            std::lock_guard<std::mutex> lock(mDataMutex);
+            for (const auto& data : mDatas)
+            {
+                if (IsViewable(data.access) && data.address != nullptr)
+                {
+                    json.Key(data.unique_name);
+                    json.Value(data.type, data.address);
+                }
+            }
+
+            for (const auto& graph : mGraphDatas)
+            {
+                if (IsViewable(graph.access) && graph.address != nullptr)
+                {
+                    json.Key(graph.unique_name);
+                    json.Value(graph.type, graph.address);
+                }
+            }
+
+            json.EndObject();
+            SendJsonReply(conn, 200, json.Text());
+        }
+
+        void Web_Server::HandleGraphRequest(mg_connection* conn, mg_http_message* hm)
+        {
+            // Name is everything after the endpoint prefix
+            const size_t prefixLength = sizeof("/api/graph/") - 1;
+            char name[256] = { 0 };
+            if (hm->uri.len <= prefixLength)
+            {
+                mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"missing graph name\"}");
+                return;
+            }
+
+            if (mg_url_decode(hm->uri.ptr + prefixLength, hm->uri.len - prefixLength, name, sizeof(name), 0) < 0)
+            {
+                // Decoding never grows the name, so a failure with room for all of it is bad escaping
+                std::string decoded(hm->uri.len - prefixLength + 1, '\0');
+                if (mg_url_decode(hm->uri.ptr + prefixLength, hm->uri.len - prefixLength, decoded.data(), decoded.size(), 0) < 0)
+                {
+                    mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"invalid graph name\"}");
+                    return;
+                }
+
+                mg_http_reply(conn, 414, JSON_HEADERS, "{\"error\":\"graph name too long\"}");
+                return;
+            }
+
+            char buffer[32] = { 0 };
+            uint64_t since = 0;
+            if (mg_http_get_var(&hm->query, "since", buffer, sizeof(buffer)) > 0)
+            {
+                since = strtoull(buffer, nullptr, 10);
+            }
+
+            uint64_t until = UINT64_MAX;
+            if (mg_http_get_var(&hm->query, "until", buffer, sizeof(buffer)) > 0)
+            {
+                until = strtoull(buffer, nullptr, 10);
+            }
+
+            bool binary = false;
+            bool gorilla = false;
+            if (mg_http_get_var(&hm->query, "format", buffer, sizeof(buffer)) > 0)
+            {
+                binary = strcmp(buffer, "binary") == 0;
+                gorilla = strcmp(buffer, "gorilla") == 0;
+            }
+
+            // A target point count reduces the series, LTTB unless another mode is asked for
+            size_t points = 0;
+            Downsample::Mode mode = Downsample::Mode::NONE;
+            if (mg_http_get_var(&hm->query, "points", buffer, sizeof(buffer)) > 0)
+            {
+                // Fewer than 3 points leaves LTTB no bucket between the first and last samples
+                points = static_cast<size_t>(strtoull(buffer, nullptr, 10));
+                if (points < 3)
+                {
+                    mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"points must be at least 3\"}");
+                    return;
+                }
+                mode = Downsample::Mode::LTTB;
+                if (mg_http_get_var(&hm->query, "mode", buffer, sizeof(buffer)) > 0)
+                {
+                    mode = Downsample::ModeFromName(buffer);
+                    if (mode == Downsample::Mode::NONE)
+                    {
+                        mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"unknown mode\"}");
+                        return;
+                    }
+                }
+            }
+
+            GraphQueryResult result;
+            std::vector<CompressedBlock> blocks;
+            PublishedGraphData graph;
+            bool found = false;
+            int8_t status = 0;
+
+            {
+                std::lock_guard<std::mutex> lock(mHistoryMutex);
+                for (size_t i = 0; i < mGraphDatas.size(); i++)
+                {
+                    if (mGraphDatas[i].unique_name == name && IsViewable(mGraphDatas[i].access) && mGraphHistories[i])
+                    {
+                        graph = mGraphDatas[i];
+                        found = true;
+
+                        // Compressed blocks go out as stored, the client decodes them
+                        if (gorilla)
+                        {
+                            status = mGraphHistories[i]->CopyBlocks(since, until, blocks);
+                            break;
+                        }
+
+                        // The spacing a chart of the requested point count can show picks the tier.
+                        // The window ends at the newest sample held, which for a replayed or
+                        // resumed history can be far from the wall clock.
+                        uint64_t resolution = 0;
+                        if (points > 0)
+                        {
+                            uint64_t start = since > 0 ? since : mGraphHistories[i]->OldestTime();
+                            uint64_t end = std::min(until, mGraphHistories[i]->NewestTime());
+                            resolution = end > start ? (end - start) / points : 0;
+                        }
+
+                        mGraphHistories[i]->Query(since, until, resolution, result);
+                        break;
+                    }
+                }
+            }
+
+            if (!found)
+            {
+                mg_http_reply(conn, 404, JSON_HEADERS, "{\"error\":\"unknown graph\"}");
+                return;
+            }
+
+            if (gorilla)
+            {
+                if (status < 0)
+                {
+                    mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"graph is not compressed\"}");
+                    return;
+                }
+
+                size_t size = 16;
+                for (const CompressedBlock& block : blocks)
+                {
+                    size += block.bytes.size() + 10;
+                }
+
+                Binary::Writer writer;
+                writer.Begin(Binary::FrameType::GORILLA, size);
+                writer.BeginBlocks(graph.id, graph.type, blocks.size());
+                for (const CompressedBlock& block : blocks)
+                {
+                    writer.AddBlock(block.count, block.bytes.data(), block.bytes.size());
+                }
+                const std::vector<uint8_t>& frame = writer.Finish(1);
+
+                mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %lu\r\n\r\n",
+                    static_cast<unsigned long>(frame.size()));
+                mg_send(conn, frame.data(), frame.size());
+                return;
+            }
+
+            std::vector<uint64_t>& times = result.times;
+            std::vector<double>& values = result.values;
+            if (points > 0 && result.resolution > 0)
+            {
+                Downsample::MergeBuckets(points, times, values, result.minimums, result.maximums);
+            }
+            else if (points > 0)
+            {
+                Downsample::Apply(mode, points, times, values);
+            }
+
+            if (binary)
+            {
+                Binary::Writer writer;
+                writer.Begin(Binary::FrameType::SAMPLES, 16 + times.size() * 10);
+                writer.AddSeries(graph.id, graph.type, times.data(), values.data(), times.size());
+                const std::vector<uint8_t>& frame = writer.Finish(1);
+
+                mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %lu\r\n\r\n",
+                    static_cast<unsigned long>(frame.size()));
+                mg_send(conn, frame.data(), frame.size());
+                return;
+            }
+
+            // Columnar arrays keep the document small and map straight onto chart datasets
+            JsonWriter& json = mResponseWriter;
+            json.Clear();
+            json.BeginObject();
+            json.Key("id");
+            json.Number(graph.id);
+            json.Key("name");
+            json.String(graph.unique_name);
+            json.Key("graph_name");
+            json.String(graph.graph_name);
+            json.Key("graph_type");
+            json.String(Graph::TypeMap[graph.graph_type]);
+            json.Key("graph_size");
+            json.Number(graph.graph_size);
+            json.Key("resolution");
+            json.Number(result.resolution);
+            json.Key("timestamps");
+            json.Numbers(times.data(), times.size());
+            json.Key("values");
+            json.Numbers(values.data(), values.size());
+
+            // Tier results carry the spread of each bucket
+            if (result.resolution > 0)
+            {
+                json.Key("minimums");
+                json.Numbers(result.minimums.data(), result.minimums.size());
+                json.Key("maximums");
+                json.Numbers(result.maximums.data(), result.maximums.size());
+            }
+            json.EndObject();
+
+            SendJsonReply(conn, 200, json.Text());
+        }
+
+        void Web_Server::HandleQueryRequest(mg_connection* conn, mg_http_message* hm)
+        {
+            char buffer[32] = { 0 };
+            uint64_t t0 = 0;
+            if (mg_http_get_var(&hm->query, "t0", buffer, sizeof(buffer)) > 0)
+            {
+                t0 = strtoull(buffer, nullptr, 10);
+            }
+
+            uint64_t t1 = GraphHistory::Now();
+            if (mg_http_get_var(&hm->query, "t1", buffer, sizeof(buffer)) > 0)
+            {
+                t1 = strtoull(buffer, nullptr, 10);
+            }
+
+            uint64_t step = 0;
+            if (mg_http_get_var(&hm->query, "step", buffer, sizeof(buffer)) > 0)
+            {
+                step = strtoull(buffer, nullptr, 10);
+            }
+
+            if (t1 < t0)
+            {
+                mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"t1 is before t0\"}");
+                return;
+            }
+
+            size_t steps = 0;
+            if (step > 0)
+            {
+                uint64_t count = (t1 - t0) / step + 1;
+                if (count > QUERY_STEPS_MAX)
+                {
+                    mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"too many steps\"}");
+                    return;
+                }
+                steps = static_cast<size_t>(count);
+            }
+
+            if (mQueries.count(conn->id) > 0 || mExports.count(conn->id) > 0)
+            {
+                mg_http_reply(conn, 409, JSON_HEADERS, "{\"error\":\"query in progress\"}");
+                return;
+            }
+
+            QueryState state;
+            if (ResolveSignals(conn, hm, state.sources) < 0)
+            {
+                return;
+            }
+
+            state.t0 = t0;
+            state.since = t0 > 0 ? t0 - 1 : 0;
+            state.until = t1;
+            state.step = step;
+            state.steps = steps;
+            state.timebase = steps > 0;
+            state.signal = 0;
+            state.open = false;
+            state.next = 0;
+            state.first = true;
+            state.cursor = state.since;
+            state.window = QUERY_WINDOW_MSEC;
+            state.resolution = 0;
+            state.held = std::numeric_limits<double>::quiet_NaN();
+
+            mg_printf(conn, "HTTP/1.1 200 OK\r\n" JSON_HEADERS "Transfer-Encoding: chunked\r\n\r\n");
+
+            // The common timebase is implied by t0 and step, it is spelled out for charting
+            state.out = "{\"t0\":" + std::to_string(t0) + ",\"t1\":" + std::to_string(t1) + ",\"step\":" + std::to_string(step);
+            state.out += state.timebase ? ",\"timestamps\":[" : ",\"series\":[";
+            mg_http_write_chunk(conn, state.out.data(), state.out.size());
+
+            mQueries.emplace(conn->id, std::move(state));
+            ContinueQuery(conn);
+        }
+
+        void Web_Server::ContinueQuery(mg_connection* conn)
+        {
+            if (mQueries.empty())
+            {
+                return;
+            }
+
+            auto found = mQueries.find(conn->id);
+            if (found == mQueries.end())
+            {
+                return;
+            }
+
+            // Only a slice of one signal is ever held, the send buffer paces the rest
+            QueryState& state = found->second;
+            while (conn->send.len < QUERY_SEND_WATERMARK)
+            {
+                state.out.clear();
+                if (state.timebase)
+                {
+                    size_t last = std::min(state.steps, state.next + QUERY_SLICE_SAMPLES);
+                    for (; state.next < last; state.next++)
+                    {
+                        if (state.next > 0)
+                        {
+                            state.out += ',';
+                        }
+                        Json::AppendNumber(state.out, state.t0 + state.next * state.step);
+                    }
+
+                    if (state.next == state.steps)
+                    {
+                        state.out += "],\"series\":[";
+                        state.timebase = false;
+                    }
+                }
+                else if (state.signal == state.sources.size())
+                {
+                    mg_http_write_chunk(conn, "]}", 2);
+                    mg_http_write_chunk(conn, "", 0);
+                    mQueries.erase(found);
+                    return;
+                }
+                else if (!state.open)
+                {
+                    state.out += state.signal > 0 ? ",{\"name\":" : "{\"name\":";
+                    Json::AppendString(state.out, state.sources[state.signal].name);
+                    state.out += state.steps > 0 ? ",\"values\":[" : ",\"samples\":[";
+
+                    state.open = true;
+                    state.next = 0;
+                    state.first = true;
+                    state.cursor = state.since;
+                    state.window = QUERY_WINDOW_MSEC;
+                    state.resolution = 0;
+                    state.held = std::numeric_limits<double>::quiet_NaN();
+
+                    // Steps before the first sample in the window hold the last one before it
+                    if (state.steps > 0 && state.t0 > 0)
+                    {
+                        ReadSignalLast(state.sources[state.signal], state.since, state.held);
+                    }
+                }
+                else if (AppendQuerySlice(state))
+                {
+                    // The resolution follows the samples, a later slice may read finer storage
+                    state.out += "],\"resolution\":" + std::to_string(state.resolution) + "}";
+                    state.open = false;
+                    state.signal++;
+                }
+
+                if (!state.out.empty())
+                {
+                    mg_http_write_chunk(conn, state.out.data(), state.out.size());
+                }
+            }
+        }
+
+        bool Web_Server::AppendQuerySlice(QueryState& state)
+        {
+            const bool aligned = state.steps > 0;
+            const uint64_t from = state.cursor;
+            GraphQueryResult& slice = state.slice;
+
+            uint64_t end = state.until;
+            if (from < state.until)
+            {
+                end = state.until - from > state.window ? from + state.window : state.until;
+                if (aligned)
+                {
+                    // Never more steps in a slice than it aims for samples
+                    size_t last = std::min(state.steps, state.next + QUERY_SLICE_SAMPLES) - 1;
+                    end = std::min(end, state.t0 + last * state.step);
+                }
+            }
+
+            size_t count = 0;
+            if (end > from)
+            {
+                ReadSignal(state.sources[state.signal], from, end, state.step, slice);
+                state.resolution = std::max(state.resolution, slice.resolution);
+                state.cursor = end;
+                count = slice.times.size();
+
+                // Size the next slice so each holds about QUERY_SLICE_SAMPLES
+                if (count > QUERY_SLICE_SAMPLES && state.window > 1)
+                {
+                    state.window /= 2;
+                }
+                else if (count < QUERY_SLICE_SAMPLES / 2 && state.window < UINT64_MAX / 4)
+                {
+                    state.window *= 2;
+                }
+            }
+
+            // A bucket spanning the previous slice end comes back again, it was already read
+            size_t j = 0;
+            if (from != state.since)
+            {
+                while (j < count && slice.times[j] <= from)
+                {
+                    j++;
+                }
+            }
+
+            if (aligned)
+            {
+                // Hold the last sample at or before each step, null before the first
+                for (; state.next < state.steps; state.next++)
+                {
+                    uint64_t t = state.t0 + state.next * state.step;
+                    if (t > end)
+                    {
+                        break;
+                    }
+                    while (j < count && slice.times[j] <= t)
+                    {
+                        state.held = slice.values[j];
+                        j++;
+                    }
+                    if (state.next > 0)
+                    {
+                        state.out += ',';
+                    }
+                    Json::AppendNumber(state.out, state.held);
+                }
+
+                // Samples after the last step sent are read already, hold the latest for the next
+                if (j < count)
+                {
+                    state.held = slice.values[count - 1];
+                }
+                return state.next == state.steps;
+            }
+
+            for (; j < count; j++)
+            {
+                state.out += state.first ? "[" : ",[";
+                Json::AppendNumber(state.out, slice.times[j]);
+                state.out += ',';
+                Json::AppendNumber(state.out, slice.values[j]);
+                state.out += ']';
+                state.first = false;
+            }
+            return state.cursor >= state.until;
+        }
+
+        void Web_Server::HandleEditRequest(mg_connection* conn, mg_http_message* hm)
+        {
+            if (mg_vcasecmp(&hm->method, "POST") != 0)
+            {
+                mg_http_reply(conn, 405, "Allow: POST\r\n" JSON_HEADERS, "{\"error\":\"edits must be posted\"}");
+                return;
+            }
+
+            if (mRequestJson.Parse(hm->body) < 0)
+            {
+                mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"invalid JSON\"}");
+                return;
+            }
+
+            std::string result;
+            int status = ApplyEdits(mRequestJson, mRequestJson.Root(), result);
+            SendJsonReply(conn, status, result);
+        }
+
+        void Web_Server::HandleWebsocketCommand(mg_connection* conn, mg_str message)
+        {
+            // Parsed once, every field below is a lookup on the tape
+            JsonIndex& json = mRequestJson;
+            if (json.Parse(message) < 0 && message.ptr[0] == '[')
+            {
+                HandleRpc(conn, json, true);
+                return;
+            }
+            if (json.Root() < 0)
+            {
+                SendCommandReply(conn, "error", 400, mg_str_n(nullptr, 0), "{\"error\":\"invalid JSON\"}");
+                return;
+            }
+
+            int root = json.Root();
+            if (json.Is(root, Json::Kind::ARRAY) || json.Find(root, "jsonrpc") >= 0)
+            {
+                HandleRpc(conn, json, true);
+                return;
+            }
+
+            std::string type = "error";
+            std::string result = "{\"error\":\"unknown command\"}";
+            int status = 400;
+            int node = -1;
+
+            if (json.Find(root, "edits") >= 0)
+            {
+                type = "edit";
+                status = ApplyEdits(json, root, result);
+            }
+            else if ((node = json.Find(root, "invoke")) >= 0)
+            {
+                type = "invoke";
+                status = QueueCall(json, node, conn->id, result);
+            }
+            else if ((node = json.Find(root, "subscribe")) >= 0)
+            {
+                type = "subscribe";
+                status = Subscribe(json, node, conn->id, result);
+            }
+            else if ((node = json.Find(root, "unsubscribe")) >= 0)
+            {
+                type = "unsubscribe";
+                status = Unsubscribe(json, node, conn->id, result);
+            }
+#ifdef CPP_WEB_SERVER_TERMINAL
+            else if ((node = json.Find(root, "shell")) >= 0)
+            {
+                type = "shell";
+                status = ControlShell(json, node, conn->id, result);
+            }
+            else if ((node = json.Find(root, "job")) >= 0)
+            {
+                type = "job";
+                status = ControlJob(json, node, conn->id, result);
+            }
+#endif
+
+            // An id sent with the command is echoed back so replies can be matched up
+            SendCommandReply(conn, type, status, json.GetText(json.Find(root, "id")), result);
+        }
+
+        void Web_Server::HandleBinaryCommand(mg_connection* conn, mg_str message)
+        {
+            Binary::Reader reader(reinterpret_cast<const uint8_t*>(message.ptr), message.len);
+            uint8_t version = 0;
+            uint8_t frame = 0;
+            uint64_t request = 0;
+            uint64_t length = 0;
+            const uint8_t* name = nullptr;
+
+            std::string result = "{\"error\":\"invalid frame\"}";
+            int status = 400;
+
+            if (!reader.GetU8(version) || version != Binary::PROTOCOL_VERSION ||
+                !reader.GetU8(frame) || frame != static_cast<uint8_t>(Binary::FrameType::INVOKE) ||
+                !reader.GetVarint(request) || !reader.GetVarint(length) || !reader.GetBytes(static_cast<size_t>(length), name))
+            {
+                SendCommandReply(conn, "error", status, mg_str_n(nullptr, 0), result);
+                return;
+            }
+
+            // The rest of the frame is the arguments, checked in place against the signature
+            PublishedFunction* function = FindFunction(mg_str_n(reinterpret_cast<const char*>(name), static_cast<size_t>(length)));
+            FunctionCall call = { 0, function, conn->id, {} };
+            if (function == nullptr)
+            {
+                status = FunctionError(result, 404, "unknown function", std::string(reinterpret_cast<const char*>(name), static_cast<size_t>(length)));
+            }
+            else if (function->parse_binary == nullptr ? reader.Remaining() != 0 :
+                !function->parse_binary(reader.Position(), reader.Remaining(), call.arguments))
+            {
+                status = FunctionError(result, 400, "invalid arguments", function->unique_name);
+            }
+            else
+            {
+                status = SubmitCall(call, result);
+            }
+
+            char id[24];
+            std::to_chars_result written = std::to_chars(id, id + sizeof(id), request);
+            SendCommandReply(conn, "invoke", status, mg_str_n(id, static_cast<size_t>(written.ptr - id)), result);
+        }
+
+        int Web_Server::Subscribe(const JsonIndex& json, int node, unsigned long connection, std::string& result)
+        {
+            double rate = 0.0;
+            if (!json.GetNumber(json.Find(node, "rate"), rate) || rate <= 0.0)
+            {
+                result = "{\"error\":\"rate must be a positive number of updates per second\"}";
+                return 400;
+            }
+
+            int array = json.Find(node, "items");
+            if (!json.Is(array, Json::Kind::ARRAY))
+            {
+                result = "{\"error\":\"items must be an array\"}";
+                return 400;
+            }
+
+            std::vector<SubscribedItem> items;
+            std::vector<bool> chosen(mNextItemId, false);
+
+            // Names and patterns may overlap, each item is sent once
+            auto choose = [&](const std::string& pattern, bool glob, uint32_t id, const std::string& name,
+                              Data::Type type, Data::Access access, const void* address)
+            {
+                if (chosen[id] || !IsViewable(access) || address == nullptr)
+                {
+                    return;
+                }
+                if (glob ? mg_globmatch(pattern.data(), pattern.size(), name.data(), name.size()) : name == pattern)
+                {
+                    chosen[id] = true;
+                    items.push_back({ id, type, address });
+                }
+            };
+
+            std::string pattern;
+            for (int element = json.First(array); element >= 0; element = json.Next(element, array))
+            {
+                if (!json.GetString(element, pattern))
+                {
+                    result = "{\"error\":\"items must be names or patterns\"}";
+                    return 400;
+                }
+
+                bool glob = pattern.find_first_of("?*#") != std::string::npos;
+                if (!glob)
+                {
+                    auto position = mDataIndex.find(pattern);
+                    if (position != mDataIndex.end())
+                    {
+                        const PublishedData& data = mDatas[position->second];
+                        choose(pattern, false, data.id, data.unique_name, data.type, data.access, data.address);
+                        continue;
+                    }
+                }
+                else
+                {
+                    for (const auto& data : mDatas)
+                    {
+                        choose(pattern, true, data.id, data.unique_name, data.type, data.access, data.address);
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mHistoryMutex);
+                for (const auto& graph : mGraphDatas)
+                {
+                    choose(pattern, glob, graph.id, graph.unique_name, graph.type, graph.access, graph.address);
+                }
+            }
+
+            if (items.empty())
+            {
+                result = "{\"error\":\"no items matched\"}";
+                return 404;
+            }
+
+            // Rates above the supported range are clamped by the table
+            double interval = 1000.0 / rate;
+            uint32_t msec = interval >= SUBSCRIPTION_INTERVAL_MAX_MSEC ? SUBSCRIPTION_INTERVAL_MAX_MSEC : static_cast<uint32_t>(std::lround(interval));
+            size_t count = items.size();
+            uint64_t id = mSubscriptions.Add(connection, msec, std::move(items), mg_millis());
+            if (id == 0)
+            {
+                result = "{\"error\":\"too many subscriptions\"}";
+                return 429;
+            }
+
+            msec = std::clamp(msec, SUBSCRIPTION_INTERVAL_MIN_MSEC, SUBSCRIPTION_INTERVAL_MAX_MSEC);
+            result = "{\"subscription\":" + std::to_string(id) + ",\"interval\":" + std::to_string(msec) +
+                ",\"items\":" + std::to_string(count) + "}";
+            return 200;
+        }
+
+        int Web_Server::Unsubscribe(const JsonIndex& json, int node, unsigned long connection, std::string& result)
+        {
+            long id = 0;
+            if (!json.GetLong(node, id) || id <= 0 || mSubscriptions.Remove(connection, static_cast<uint64_t>(id)) < 0)
+            {
+                result = "{\"error\":\"unknown subscription\"}";
+                return 404;
+            }
+
+            result = "{\"subscription\":" + std::to_string(id) + "}";
+            return 200;
+        }
+
+        void Web_Server::PublishSubscriptions(uint64_t now)
+        {
+            mSubscriptions.TakeDue(now, mDueSubscriptions);
+            if (mDueSubscriptions.empty())
+            {
+                return;
+            }
+
+            // Each item due is read and encoded once for every subscription sharing it
+            std::lock_guard<std::mutex> lock(mDataMutex);
+            BeginItemRecords();
+            for (const Subscription* subscription : mDueSubscriptions)
+            {
+                // A client not keeping up misses updates instead of queueing them
+                mg_connection* conn = FindConnection(subscription->connection);
+                if (conn == nullptr || conn->send.len > CLIENT_SEND_WATERMARK)
+                {
+                    continue;
+                }
+
+                mSubscriptionWriter.Begin(Binary::FrameType::VALUES);
+                for (const SubscribedItem& item : subscription->items)
+                {
+                    const std::pair<size_t, size_t>& record = EncodeItemRecord(item);
+                    mSubscriptionWriter.PutBytes(mItemRecords.Buffer().data() + record.first, record.second);
+                }
+
+                const std::vector<uint8_t>& frame = mSubscriptionWriter.Finish(static_cast<uint32_t>(subscription->items.size()));
+                SendWebsocket(conn, frame.data(), frame.size(), WEBSOCKET_OP_BINARY);
+            }
+        }
+
+        void Web_Server::PushUpdates(uint64_t now)
+        {
+            if (!mPushScheduler.TakeDue(now))
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mDataMutex);
+            BeginItemRecords();
+            for (PushClient& client : mPushScheduler.Clients())
+            {
+                if (client.pending.empty())
+                {
+                    continue;
+                }
+
+                // A backlogged client keeps its changes and is sent their latest values
+                // once it drains, rather than every value in between
+                mg_connection* conn = FindConnection(client.connection);
+                if (conn == nullptr || conn->send.len > CLIENT_SEND_WATERMARK)
+                {
+                    continue;
+                }
+
+                mSubscriptionWriter.Begin(Binary::FrameType::VALUES);
+                for (const SubscribedItem& item : client.pending)
+                {
+                    const std::pair<size_t, size_t>& record = EncodeItemRecord(item);
+                    mSubscriptionWriter.PutBytes(mItemRecords.Buffer().data() + record.first, record.second);
+                }
+
+                const std::vector<uint8_t>& frame = mSubscriptionWriter.Finish(static_cast<uint32_t>(client.pending.size()));
+                SendWebsocket(conn, frame.data(), frame.size(), WEBSOCKET_OP_BINARY);
+                mPushScheduler.Clear(client);
+            }
+        }
+
+        void Web_Server::BeginItemRecords()
+        {
+            mRecordSweep++;
+            mItemRecords.Begin(Binary::FrameType::VALUES);
+        }
+
+        const std::pair<size_t, size_t>& Web_Server::EncodeItemRecord(const SubscribedItem& item)
+        {
+            if (mItemSweep.size() <= item.id)
+            {
+                mItemSweep.resize(item.id + 1, 0);
+                mItemRecord.resize(item.id + 1, { 0, 0 });
+            }
+
+            if (mItemSweep[item.id] != mRecordSweep)
+            {
+                size_t start = mItemRecords.Buffer().size();
+                mItemRecords.AddValue(item.id, item.type, item.address);
+                mItemSweep[item.id] = mRecordSweep;
+                mItemRecord[item.id] = { start, mItemRecords.Buffer().size() - start };
+            }
+            return mItemRecord[item.id];
+        }
+
+        mg_connection* Web_Server::FindConnection(unsigned long id)
+        {
+            for (mg_connection* conn = mManager.conns; conn != nullptr; conn = conn->next)
+            {
+                if (conn->id == id)
+                {
+                    return conn->is_closing ? nullptr : conn;
+                }
+            }
+            return nullptr;
+        }
+
+        void Web_Server::UpgradeWebsocket(mg_connection* conn, mg_http_message* hm)
+        {
+            mg_str* offers = mg_http_get_header(hm, "Sec-WebSocket-Extensions");
+            DeflateParameters parameters = {};
+            std::string extension;
+
+            if (mDeflateLevel > 0 && offers != nullptr && NegotiateDeflate(*offers, parameters, extension))
+            {
+                std::unique_ptr<WebsocketDeflate> deflater = std::make_unique<WebsocketDeflate>();
+                if (deflater->Start(parameters, mDeflateLevel) == 0)
+                {
+                    mDeflaters[conn->id] = std::move(deflater);
+                }
+            }
+
+            if (mDeflaters.count(conn->id) > 0)
+            {
+                mg_ws_upgrade(conn, hm, "Sec-WebSocket-Extensions: %s\r\n", extension.c_str());
+            }
+            else
+            {
+                mg_ws_upgrade(conn, hm, NULL);
+            }
+
+            mPushScheduler.AddClient(conn->id);
+            mWebsocketConnetion = conn;
+            mUpgraded = true;
+        }
+
+        void Web_Server::SendWebsocket(mg_connection* conn, const void* data, size_t size, int op)
+        {
+            // Once compressed, a message must go out compressed: the receiver's window has to
+            // follow the compressor's even when a message does not shrink
+            auto deflater = size >= mDeflateThreshold ? mDeflaters.find(conn->id) : mDeflaters.end();
+            if (deflater != mDeflaters.end() && deflater->second->Compress(data, size, mDeflateBuffer))
+            {
+                mg_ws_send(conn, mDeflateBuffer.data(), mDeflateBuffer.size(), op | WEBSOCKET_FLAG_COMPRESSED);
+                return;
+            }
+
+            mg_ws_send(conn, data, size, op);
+        }
+
+        bool Web_Server::InflateMessage(mg_connection* conn, mg_str& message)
+        {
+            auto deflater = mDeflaters.find(conn->id);
+            if (deflater == mDeflaters.end() || !deflater->second->Decompress(message.ptr, message.len, mInflateBuffer))
+            {
+                return false;
+            }
+
+            message = mg_str_n(reinterpret_cast<const char*>(mInflateBuffer.data()), mInflateBuffer.size());
+            return true;
+        }
+
+        void Web_Server::FlushConsoleLogs()
+        {
+            std::vector<std::string> messages;
+            {
+                std::lock_guard<std::mutex> lock(mConsoleMutex);
+                if (mConsoleLogs.empty())
+                {
+                    return;
+                }
+                messages.swap(mConsoleLogs);
+            }
+
+            for (const PushClient& client : mPushScheduler.Clients())
+            {
+                mg_connection* conn = FindConnection(client.connection);
+                if (conn == nullptr)
+                {
+                    continue;
+                }
+
+                for (const std::string& message : messages)
+                {
+                    SendWebsocket(conn, message.data(), message.size(), WEBSOCKET_OP_TEXT);
+                }
+            }
+        }
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+        void Web_Server::StartTerminalCommand(mg_connection* conn, const std::string& command)
+        {
+#ifdef WIN32
+            // Windows runs the command to completion on the server thread
+            std::string result;
+            if (mTerminal->ExecuteCommand(command, result) >= 0)
+            {
+                SendConsoleLog(result);
+            }
+#else
+            size_t running = std::count_if(mTerminalJobs.begin(), mTerminalJobs.end(),
+                [](const std::pair<const uint64_t, TerminalJob>& job) { return job.second.running; });
+            if (running >= mTerminalJobsMax)
+            {
+                SendCommandReply(conn, "terminal", 429, mg_str_n(nullptr, 0), "{\"error\":\"too many terminal jobs\"}");
+                return;
+            }
+
+            Essentials::Utilities::CommandProcess process = {};
+            if (mTerminal->SpawnCommand(command, process) < 0)
+            {
+                std::string result = "{\"error\":";
+                Json::AppendString(result, mTerminal->GetLastError());
+                result += "}";
+                SendCommandReply(conn, "terminal", 500, mg_str_n(nullptr, 0), result);
+                return;
+            }
+
+            // The stream connections own the descriptors from here and close them at the end
+            mg_connection* output = mg_wrapfd(&mManager, process.output, terminalCallback, this);
+            mg_connection* error = output == nullptr ? nullptr : mg_wrapfd(&mManager, process.error, terminalCallback, this);
+            if (error == nullptr)
+            {
+                Essentials::Utilities::Terminal::KillCommand(process, true);
+                if (output != nullptr)
+                {
+                    output->is_closing = 1;
+                }
+                else
+                {
+                    close(process.output);
+                }
+                close(process.error);
+                SendCommandReply(conn, "terminal", 500, mg_str_n(nullptr, 0), "{\"error\":\"out of memory\"}");
+                return;
+            }
+
+            uint64_t id = mNextTerminalJob++;
+            TerminalJob& job = mTerminalJobs[id];
+            job.id = id;
+            job.command = command;
+            job.client = conn->id;
+            job.process = process;
+            job.streams[0] = output->id;
+            job.streams[1] = error->id;
+            job.running = true;
+            job.exitstatus = 0;
+            job.output.Reset(mTerminalJobOutput);
+
+            std::string text = std::to_string(id);
+            SendCommandReply(conn, "terminal", 202, mg_str_n(text.data(), text.size()), "{\"job\":" + text + "}");
+#endif
+        }
+
+        void Web_Server::RelayTerminalOutput(mg_connection* conn, size_t received, bool closing)
+        {
+            for (auto& [id, job] : mTerminalJobs)
+            {
+                int stream = job.streams[0] == conn->id ? 0 : job.streams[1] == conn->id ? 1 : -1;
+                if (stream < 0)
+                {
+                    continue;
+                }
+
+                // Only the new bytes go to the ring, an unfinished character stays in recv
+                // until the rest of it arrives
+                job.output.Append(reinterpret_cast<const char*>(conn->recv.buf) + conn->recv.len - received, received);
+                ForwardTerminalOutput(conn, job.client, closing);
+                if (closing)
+                {
+                    job.streams[stream] = 0;
+                }
+                return;
+            }
+        }
+
+        int Web_Server::ControlJob(const JsonIndex& json, int node, unsigned long connection, std::string& result)
+        {
+            int action = json.Is(node, Json::Kind::STRING) ? node : json.Find(node, "action");
+            if (json.Equals(action, "list"))
+            {
+                result = "{\"jobs\":[";
+                for (const auto& [id, job] : mTerminalJobs)
+                {
+                    result += result.back() == '[' ? "{\"id\":" : ",{\"id\":";
+                    Json::AppendNumber(result, id);
+                    result += ",\"command\":";
+                    Json::AppendString(result, job.command);
+                    result += job.running ? ",\"running\":true,\"exit\":null" : ",\"running\":false,\"exit\":";
+                    if (!job.running)
+                    {
+                        Json::AppendNumber(result, job.exitstatus);
+                    }
+                    result += ",\"written\":";
+                    Json::AppendNumber(result, job.output.Written());
+                    result += ",\"dropped\":";
+                    Json::AppendNumber(result, job.output.Dropped());
+                    result += job.client == connection ? ",\"attached\":true}" : ",\"attached\":false}";
+                }
+                result += "]}";
+                return 200;
+            }
+
+            long id = 0;
+            auto found = json.GetLong(json.Find(node, "id"), id) ? mTerminalJobs.find(static_cast<uint64_t>(id)) : mTerminalJobs.end();
+            if (found == mTerminalJobs.end())
+            {
+                result = "{\"error\":\"unknown job\"}";
+                return 404;
+            }
+            TerminalJob& job = found->second;
+
+            if (json.Equals(action, "kill"))
+            {
+                if (!job.running)
+                {
+                    result = "{\"error\":\"job finished\"}";
+                    return 409;
+                }
+
+                // The exit status follows once the job is reaped
+                Essentials::Utilities::Terminal::KillCommand(job.process, false);
+                result = "{\"id\":" + std::to_string(job.id) + ",\"killed\":true}";
+                return 200;
+            }
+
+            if (json.Equals(action, "tail") || json.Equals(action, "attach"))
+            {
+                double since = 0.0;
+                json.GetNumber(json.Find(node, "since"), since);
+
+                std::string output;
+                uint64_t offset = job.output.Read(since > 0.0 ? static_cast<uint64_t>(since) : 0, output);
+
+                // Text frames must hold whole characters: skip a partial one at the start, and
+                // hold back an unfinished one at the end while more may follow
+                size_t skip = 0;
+                while (skip < output.size() && skip < 3 && (static_cast<unsigned char>(output[skip]) & 0xC0) == 0x80)
+                {
+                    skip++;
+                }
+                size_t length = job.running ? CompleteUtf8(output.data() + skip, output.size() - skip) : output.size() - skip;
+
+                result = "{\"id\":" + std::to_string(job.id) + ",\"offset\":" + std::to_string(offset + skip) +
+                    ",\"next\":" + std::to_string(offset + skip + length) + ",\"dropped\":" + std::to_string(job.output.Dropped()) +
+                    (job.running ? ",\"running\":true,\"exit\":null" : ",\"running\":false,\"exit\":" + std::to_string(job.exitstatus)) +
+                    ",\"output\":";
+                Json::AppendString(result, std::string_view(output).substr(skip, length));
+                result += "}";
+
+                // Output read from here on streams to the websocket as it arrives
+                if (json.Equals(action, "attach") && job.running)
+                {
+                    job.client = connection;
+                }
+                return 200;
+            }
+
+            result = "{\"error\":\"unknown job action\"}";
+            return 400;
+        }
+
+        void Web_Server::ServiceTerminals()
+        {
+            size_t finished = 0;
+            for (auto& [id, job] : mTerminalJobs)
+            {
+                if (!job.running)
+                {
+                    finished++;
+                    continue;
+                }
+
+                ResumeTerminalStream(job.streams[0], job.client);
+                ResumeTerminalStream(job.streams[1], job.client);
+
+                // The exit status follows the last of the output
+                if (job.streams[0] != 0 || job.streams[1] != 0 ||
+                    Essentials::Utilities::Terminal::CheckCommand(job.process, job.exitstatus) == 0)
+                {
+                    continue;
+                }
+
+                job.running = false;
+                finished++;
+
+                mg_connection* client = job.client == 0 ? nullptr : FindConnection(job.client);
+                if (client != nullptr)
+                {
+                    std::string text = std::to_string(job.id);
+                    SendCommandReply(client, "terminal", 200, mg_str_n(text.data(), text.size()), "{\"exit\":" + std::to_string(job.exitstatus) + "}");
+                }
+            }
+
+            // Jobs are kept in id order, so the first finished ones are the oldest
+            for (auto job = mTerminalJobs.begin(); job != mTerminalJobs.end() && finished > TERMINAL_JOBS_KEPT;)
+            {
+                if (job->second.running)
+                {
+                    ++job;
+                    continue;
+                }
+                job = mTerminalJobs.erase(job);
+                finished--;
+            }
+        }
+
+        void Web_Server::DetachTerminalJobs(unsigned long client)
+        {
+            for (auto& [id, job] : mTerminalJobs)
+            {
+                if (job.client == client)
+                {
+                    job.client = 0;
+                }
+            }
+        }
+
+        void Web_Server::KillTerminalJobs()
+        {
+            for (auto& [id, job] : mTerminalJobs)
+            {
+                if (job.running)
+                {
+                    Essentials::Utilities::Terminal::KillCommand(job.process, true);
+                }
+            }
+            mTerminalJobs.clear();
+        }
+
+        void Web_Server::ForwardTerminalOutput(mg_connection* conn, unsigned long client, bool closing)
+        {
+            mg_connection* target = client == 0 ? nullptr : FindConnection(client);
+            if (target == nullptr)
+            {
+                // Nobody is listening, output is dropped until the kill takes effect
+                conn->recv.len = 0;
+                return;
+            }
+
+            size_t length = closing ? conn->recv.len : CompleteUtf8(reinterpret_cast<const char*>(conn->recv.buf), conn->recv.len);
+            if (length > 0)
+            {
+                SendWebsocket(target, conn->recv.buf, length, WEBSOCKET_OP_TEXT);
+                mg_iobuf_del(&conn->recv, 0, length);
+            }
+
+            // Stop reading until the client catches up, the writer then blocks on its pipe
+            if (target->send.len > CLIENT_SEND_WATERMARK)
+            {
+                conn->is_full = 1;
+            }
+        }
+
+        void Web_Server::ResumeTerminalStream(unsigned long stream, unsigned long client)
+        {
+            mg_connection* conn = stream == 0 ? nullptr : FindConnection(stream);
+            if (conn == nullptr || !conn->is_full)
+            {
+                return;
+            }
+
+            mg_connection* target = client == 0 ? nullptr : FindConnection(client);
+            if (target == nullptr || target->send.len <= CLIENT_SEND_WATERMARK)
+            {
+                conn->is_full = 0;
+            }
+        }
+
+        int Web_Server::ControlShell(const JsonIndex& json, int node, unsigned long connection, std::string& result)
+        {
+            auto session = std::find_if(mShellSessions.begin(), mShellSessions.end(),
+                [connection](const ShellSession& shell) { return shell.client == connection; });
+
+            if (json.Equals(node, "open"))
+            {
+                if (session != mShellSessions.end())
+                {
+                    result = "{\"shell\":\"open\"}";
+                    return 200;
+                }
+                if (mShellSessions.size() >= mShellSessionsMax)
+                {
+                    result = "{\"error\":\"too many shells\"}";
+                    return 429;
+                }
+
+                ShellSession shell = {};
+                if (mTerminal->OpenShell(shell.process) < 0)
+                {
+                    result = "{\"error\":";
+                    Json::AppendString(result, mTerminal->GetLastError());
+                    result += "}";
+                    return 500;
+                }
+
+                // The terminal connection owns the master from here and closes it at the end
+                mg_connection* conn = mg_wrapfd(&mManager, shell.process.output, shellCallback, this);
+                if (conn == nullptr)
+                {
+                    Essentials::Utilities::Terminal::KillCommand(shell.process, true);
+                    close(shell.process.output);
+                    result = "{\"error\":\"out of memory\"}";
+                    return 500;
+                }
+
+                shell.client = connection;
+                shell.stream = conn->id;
+                shell.active = mg_millis();
+                mShellSessions.push_back(shell);
+                result = "{\"shell\":\"open\"}";
+                return 200;
+            }
+
+            if (json.Equals(node, "close") || json.Equals(node, "interrupt"))
+            {
+                if (session == mShellSessions.end())
+                {
+                    result = "{\"error\":\"no shell open\"}";
+                    return 404;
+                }
+
+                if (json.Equals(node, "close"))
+                {
+                    // The exit status follows once the shell is reaped
+                    if (!session->exited)
+                    {
+                        Essentials::Utilities::Terminal::KillCommand(session->process, false);
+                    }
+                    result = "{\"shell\":\"closing\"}";
+                    return 200;
+                }
+
+                // Ctrl-C through the terminal reaches the foreground command, not the shell
+                mg_connection* conn = FindConnection(session->stream);
+                if (conn != nullptr)
+                {
+                    mg_send(conn, "\x03", 1);
+                }
+                session->active = mg_millis();
+                result = "{\"shell\":\"interrupted\"}";
+                return 200;
+            }
+
+            result = "{\"error\":\"unknown shell action\"}";
+            return 400;
+        }
+
+        bool Web_Server::WriteShell(mg_connection* conn, const std::string& line)
+        {
+            for (ShellSession& session : mShellSessions)
+            {
+                if (session.client != conn->id)
+                {
+                    continue;
+                }
+
+                mg_connection* terminal = session.stream == 0 ? nullptr : FindConnection(session.stream);
+                if (terminal != nullptr)
+                {
+                    mg_send(terminal, line.data(), line.size());
+                    mg_send(terminal, "\n", 1);
+                }
+                session.active = mg_millis();
+                return true;
+            }
+            return false;
+        }
+
+        void Web_Server::RelayShellOutput(mg_connection* conn, bool closing)
+        {
+            for (ShellSession& session : mShellSessions)
+            {
+                if (session.stream != conn->id)
+                {
+                    continue;
+                }
+
+                ForwardTerminalOutput(conn, session.client, closing);
+                session.active = mg_millis();
+                if (closing)
+                {
+                    session.stream = 0;
+                }
+                return;
+            }
+        }
+
+        void Web_Server::ServiceShells(uint64_t now)
+        {
+            for (size_t i = 0; i < mShellSessions.size();)
+            {
+                ShellSession& session = mShellSessions[i];
+                ResumeTerminalStream(session.stream, session.client);
+
+                if (!session.exited && !session.idle && session.active + mShellIdleTimeout < now)
+                {
+                    Essentials::Utilities::Terminal::KillCommand(session.process, false);
+                    session.idle = true;
+                }
+
+                // Background jobs may hold the terminal open after the shell exits. It is
+                // closed after reaping once a poll finds nothing in it to read, as one poll
+                // may read only part of what the shell wrote last.
+                mg_connection* terminal = session.stream == 0 ? nullptr : FindConnection(session.stream);
+                if (session.exited)
+                {
+                    if (terminal != nullptr && !terminal->is_full && !terminal->is_readable)
+                    {
+                        terminal->is_closing = 1;
+                    }
+                }
+                else if (Essentials::Utilities::Terminal::CheckCommand(session.process, session.exitstatus) != 0)
+                {
+                    session.exited = true;
+                }
+
+                if (!session.exited || session.stream != 0)
+                {
+                    i++;
+                    continue;
+                }
+
+                mg_connection* client = session.client == 0 ? nullptr : FindConnection(session.client);
+                if (client != nullptr)
+                {
+                    std::string result = "{\"exit\":" + std::to_string(session.exitstatus) + (session.idle ? ",\"idle\":true}" : "}");
+                    SendCommandReply(client, "shell", 200, mg_str_n(nullptr, 0), result);
+                }
+                mShellSessions.erase(mShellSessions.begin() + i);
+            }
+        }
+
+        void Web_Server::KillShells(unsigned long client, bool wait)
+        {
+            for (size_t i = 0; i < mShellSessions.size();)
+            {
+                ShellSession& session = mShellSessions[i];
+                if (client != 0 && session.client != client)
+                {
+                    i++;
+                    continue;
+                }
+
+                // Without waiting, the session stays until ServiceShells reaps the shell
+                if (!session.exited)
+                {
+                    Essentials::Utilities::Terminal::KillCommand(session.process, wait);
+                }
+                if (wait)
+                {
+                    mShellSessions.erase(mShellSessions.begin() + i);
+                }
+                else
+                {
+                    session.client = 0;
+                    i++;
+                }
+            }
+        }
+#endif
+
+        size_t Web_Server::CompleteUtf8(const char* text, size_t length)
+        {
+            // Look back at most three bytes for the lead byte of the last character
+            size_t lead = length;
+            while (lead > 0 && length - lead < 4 && (static_cast<unsigned char>(text[lead - 1]) & 0xC0) == 0x80)
+            {
+                lead--;
+            }
+            if (lead == 0 || length - lead >= 4)
+            {
+                return length;
+            }
+
+            unsigned char c = static_cast<unsigned char>(text[lead - 1]);
+            size_t needed = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+            return length - (lead - 1) < needed ? lead - 1 : length;
+        }
+
+        void Web_Server::WakeServer()
+        {
+            if (mWakeSocket >= 0)
+            {
+                send(mWakeSocket, "x", 1, 0);
+            }
+        }
+
+        void Web_Server::SendJsonReply(mg_connection* conn, int status, std::string_view body)
+        {
+            // The body is copied into the send buffer whole rather than formatted through printf
+            mg_printf(conn, "HTTP/1.1 %d %s\r\n" JSON_HEADERS "Content-Length: %lu\r\n\r\n", status,
+                mg_http_status_code_str(status), static_cast<unsigned long>(body.size()));
+            mg_send(conn, body.data(), body.size());
+        }
+
+        void Web_Server::SendCommandReply(mg_connection* conn, const std::string& type, int status, mg_str id, const std::string& result)
+        {
+            std::string reply = "{\"type\":\"" + type + "\",\"status\":" + std::to_string(status);
+            if (id.len > 0)
+            {
+                reply += ",\"id\":";
+                reply.append(id.ptr, id.len);
+            }
+
+            reply += ",\"result\":" + result + "}";
+            SendWebsocket(conn, reply.data(), reply.size(), WEBSOCKET_OP_TEXT);
+        }
+
+        int Web_Server::ApplyEdits(const JsonIndex& json, int node, std::string& result)
+        {
+            // Every edit is parsed into a staged value first, the batch is written only once all are valid
+            struct StagedEdit
+            {
+                PublishedData*  data;
+                uint64_t        number;     // Numeric value laid out as its type
+                std::string     text;       // STRING value
+            };
+
+            auto fail = [&](int status, const std::string& error, const std::string& name)
+            {
+                result = "{\"error\":\"" + error + "\",\"name\":";
+                Json::AppendString(result, name);
+                result += "}";
+                return status;
+            };
+
+            int edits = json.Find(node, "edits");
+            if (json.Is(edits, Json::Kind::ARRAY) && json.GetCount(edits) > EDIT_BATCH_MAX)
+            {
+                result = "{\"error\":\"too many edits\"}";
+                return 400;
+            }
+
+            std::vector<StagedEdit> staged;
+            std::string name;
+            std::string text;
+            for (int element = json.Is(edits, Json::Kind::ARRAY) ? json.First(edits) : -1; element >= 0;
+                 element = json.Next(element, edits))
+            {
+                name.clear();
+                json.GetString(json.Find(element, "name"), name);
+
+                auto position = mDataIndex.find(name);
+                if (position == mDataIndex.end() || mDatas[position->second].address == nullptr)
+                {
+                    return fail(404, "unknown data", name);
+                }
+                PublishedData* data = &mDatas[position->second];
+
+                if (!IsEditable(data->access))
+                {
+                    return fail(403, "not editable", name);
+                }
+
+                // Strings are unescaped, anything else is parsed exactly as written
+                int value = json.Find(element, "value");
+                if (value < 0)
+                {
+                    return fail(400, "missing value", name);
+                }
+
+                if (json.Is(value, Json::Kind::STRING))
+                {
+                    if (!json.GetString(value, text))
+                    {
+                        return fail(400, "invalid value", name);
+                    }
+                }
+                else
+                {
+                    mg_str token = json.GetText(value);
+                    text.assign(token.ptr, token.len);
+                }
+
+                StagedEdit edit = { data, 0, std::string() };
+                void* parsed = data->type == Data::Type::STRING ? static_cast<void*>(&edit.text) : static_cast<void*>(&edit.number);
+                if (!Data::ParseValue(data->type, text, parsed))
+                {
+                    return fail(400, "invalid value", name);
+                }
+
+                staged.push_back(std::move(edit));
+            }
+
+            if (staged.empty())
+            {
+                result = "{\"error\":\"no edits\"}";
+                return 400;
+            }
+
+            // Readers holding the data lock see none or all of the batch
+            std::vector<std::string> names;
+            EditCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(mDataMutex);
+                for (StagedEdit& edit : staged)
+                {
+                    if (edit.data->type == Data::Type::STRING)
+                    {
+                        *static_cast<std::string*>(edit.data->address) = std::move(edit.text);
+                    }
+                    else
+                    {
+                        memcpy(edit.data->address, &edit.number, Data::Size(edit.data->type));
+                    }
+
+                    if (std::find(names.begin(), names.end(), edit.data->unique_name) == names.end())
+                    {
+                        names.push_back(edit.data->unique_name);
+                    }
+                }
+                callback = mEditCallback;
+            }
+
+            // One notification for the whole batch, after the lock so it can read the new values
+            if (callback)
+            {
+                callback(names);
+            }
+
+            result = "{\"applied\":" + std::to_string(staged.size()) + "}";
+            return 200;
+        }
+
+        int8_t Web_Server::ResolveSignals(mg_connection* conn, mg_http_message* hm, std::vector<SignalSource>& sources)
+        {
+            std::string names(hm->query.len + 1, '\0');
+            int length = mg_http_get_var(&hm->query, "names", &names[0], names.size());
+            if (length <= 0)
+            {
+                mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"missing names\"}");
+                return -1;
+            }
+            sources.clear();
+            names.resize(static_cast<size_t>(length));
+
+            // Resolve every name before the response starts, while errors can still set the status.
+            // A recording being replayed holds the complete history, otherwise graph history is used.
+            {
+                std::lock_guard<std::mutex> lock(mHistoryMutex);
+
+                size_t start = 0;
+                while (start <= names.size())
+                {
+                    size_t end = names.find(',', start);
+                    end = end == std::string::npos ? names.size() : end;
+                    SignalSource source = { names.substr(start, end - start), Data::Type::DOUBLE, nullptr, -1 };
+                    start = end + 1;
+
+                    if (source.name.empty())
+                    {
+                        continue;
+                    }
+
+                    bool viewable = false;
+                    for (size_t i = 0; i < mGraphDatas.size(); i++)
+                    {
+                        if (mGraphDatas[i].unique_name == source.name)
+                        {
+                            viewable = IsViewable(mGraphDatas[i].access);
+                            source.type = mGraphDatas[i].type;
+                            source.history = mGraphHistories[i].get();
+                        }
+                    }
+
+                    for (const PublishedData& data : mDatas)
+                    {
+                        if (data.unique_name == source.name)
+                        {
+                            viewable = IsViewable(data.access);
+                            source.type = data.type;
+                        }
+                    }
+
+                    if (mReplayReader.IsOpen())
+                    {
+                        const std::vector<RecordingItem>& items = mReplayReader.Items();
+                        for (size_t i = 0; i < items.size(); i++)
+                        {
+                            if (items[i].unique_name == source.name)
+                            {
+                                source.recorded = static_cast<int64_t>(i);
+                            }
+                        }
+                    }
+
+                    if (!viewable || (source.history == nullptr && source.recorded < 0))
+                    {
+                        std::string body = "{\"error\":\"unknown signal\",\"name\":";
+                        Json::AppendString(body, source.name);
+                        body += "}";
+                        SendJsonReply(conn, 404, body);
+                        return -1;
+                    }
+
+                    sources.push_back(source);
+                }
+            }
+
+
+            return 0;
+        }
+
+        void Web_Server::ReadSignal(const SignalSource& source, uint64_t since, uint64_t until, uint64_t resolution, GraphQueryResult& result)
+        {
+            result.resolution = 0;
+            result.times.clear();
+            result.values.clear();
+            result.minimums.clear();
+            result.maximums.clear();
+
+            if (source.recorded >= 0)
+            {
+                // Only what has been replayed so far is visible
+                until = std::min(until, mReplayPosition.load(std::memory_order_relaxed));
+                mReplayReader.ReadItem(static_cast<uint32_t>(source.recorded), since, until, result.times, result.values);
+            }
+            else
+            {
+                source.history->Query(since, until, resolution, result);
+            }
+        }
+
+        int8_t Web_Server::ReadSignalLast(const SignalSource& source, uint64_t until, double& value)
+        {
+            uint64_t timestamp = 0;
+            if (source.recorded >= 0)
+            {
+                until = std::min(until, mReplayPosition.load(std::memory_order_relaxed));
+                return mReplayReader.ReadLast(static_cast<uint32_t>(source.recorded), until, timestamp, value);
+            }
+
+            return source.history->Last(until, timestamp, value);
+        }
+
+        void Web_Server::HandleExportRequest(mg_connection* conn, mg_http_message* hm)
+        {
+            char buffer[32] = { 0 };
+            uint64_t t0 = 0;
+            if (mg_http_get_var(&hm->query, "t0", buffer, sizeof(buffer)) > 0)
+            {
+                t0 = strtoull(buffer, nullptr, 10);
+            }
+
+            uint64_t t1 = GraphHistory::Now();
+            if (mg_http_get_var(&hm->query, "t1", buffer, sizeof(buffer)) > 0)
+            {
+                t1 = strtoull(buffer, nullptr, 10);
+            }
+
+            bool csv = true;
+            if (mg_http_get_var(&hm->query, "format", buffer, sizeof(buffer)) > 0)
+            {
+                if (strcmp(buffer, "binary") == 0)
+                {
+                    csv = false;
+                }
+                else if (strcmp(buffer, "csv") != 0)
+                {
+                    mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"unknown format\"}");
+                    return;
+                }
+            }
+
+            if (t1 < t0)
+            {
+                mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"t1 is before t0\"}");
+                return;
+            }
+
+            if (mExports.count(conn->id) > 0 || mQueries.count(conn->id) > 0)
+            {
+                mg_http_reply(conn, 409, JSON_HEADERS, "{\"error\":\"export in progress\"}");
+                return;
+            }
+
+            ExportState state;
+            if (ResolveSignals(conn, hm, state.sources) < 0)
+            {
+                return;
+            }
+
+            state.slices.resize(state.sources.size());
+            state.csv = csv;
+            state.cursor = t0 > 0 ? t0 - 1 : 0;
+            state.until = t1;
+            state.window = EXPORT_WINDOW_MSEC;
+
+            mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Disposition: attachment; filename=\"export.%s\"\r\n"
+                "Transfer-Encoding: chunked\r\n\r\n", csv ? "text/csv" : "application/octet-stream", csv ? "csv" : "bin");
+
+            // Column names lead the file, the samples follow slice by slice
+            if (csv)
+            {
+                state.out = "timestamp";
+                for (const SignalSource& source : state.sources)
+                {
+                    state.out += ',';
+                    AppendCsvField(state.out, source.name);
+                }
+                state.out += "\r\n";
+            }
+            else
+            {
+                state.out.assign(EXPORT_MAGIC, sizeof(EXPORT_MAGIC));
+                AppendVarint(state.out, state.sources.size());
+                for (const SignalSource& source : state.sources)
+                {
+                    state.out += static_cast<char>(source.type);
+                    AppendVarint(state.out, source.name.size());
+                    state.out += source.name;
+                }
+            }
+            mg_http_write_chunk(conn, state.out.data(), state.out.size());
+
+            mExports.emplace(conn->id, std::move(state));
+            ContinueExport(conn);
+        }
+
+        void Web_Server::ContinueExport(mg_connection* conn)
+        {
+            if (mExports.empty())
+            {
+                return;
+            }
+
+            auto found = mExports.find(conn->id);
+            if (found == mExports.end())
+            {
+                return;
+            }
+
+            // Only a slice at a time is ever held, the send buffer paces the rest
+            ExportState& state = found->second;
+            while (conn->send.len < EXPORT_SEND_WATERMARK)
+            {
+                if (state.cursor >= state.until)
+                {
+                    if (!state.csv)
+                    {
+                        // A zero length frame ends the stream
+                        mg_http_write_chunk(conn, "\0", 1);
+                    }
+                    mg_http_write_chunk(conn, "", 0);
+                    mExports.erase(found);
+                    return;
+                }
+
+                uint64_t end = state.until - state.cursor > state.window ? state.cursor + state.window : state.until;
+                size_t largest = 0;
+                for (size_t s = 0; s < state.sources.size(); s++)
+                {
+                    ReadSignal(state.sources[s], state.cursor, end, 0, state.slices[s]);
+                    largest = std::max(largest, state.slices[s].times.size());
+                }
+                state.cursor = end;
+
+                // Size the next slice so each holds about EXPORT_SLICE_SAMPLES per signal
+                if (largest > EXPORT_SLICE_SAMPLES && state.window > 1)
+                {
+                    state.window /= 2;
+                }
+                else if (largest < EXPORT_SLICE_SAMPLES / 2 && state.window < UINT64_MAX / 4)
+                {
+                    state.window *= 2;
+                }
+
+                if (largest == 0)
+                {
+                    continue;
+                }
+
+                state.out.clear();
+                if (state.csv)
+                {
+                    AppendCsvRows(state.out, state.slices);
+                }
+                else
+                {
+                    // One gorilla block per signal and slice
+                    uint32_t count = 0;
+                    state.writer.Begin(Binary::FrameType::GORILLA, 16 + largest * state.sources.size() * 2);
+                    for (size_t s = 0; s < state.sources.size(); s++)
+                    {
+                        const GraphQueryResult& slice = state.slices[s];
+                        if (!slice.times.empty())
+                        {
+                            for (size_t i = 0; i < slice.times.size(); i++)
+                            {
+                                state.encoder.Append(slice.times[i], slice.values[i]);
+                            }
+
+                            state.writer.BeginBlocks(static_cast<uint32_t>(s), state.sources[s].type, 1);
+                            state.writer.AddBlock(state.encoder.Count(), state.encoder.Bytes().data(), state.encoder.Bytes().size());
+                            state.encoder.Take();
+                            count++;
+                        }
+                    }
+
+                    const std::vector<uint8_t>& frame = state.writer.Finish(count);
+                    AppendVarint(state.out, frame.size());
+                    state.out.append(reinterpret_cast<const char*>(frame.data()), frame.size());
+                }
+
+                mg_http_write_chunk(conn, state.out.data(), state.out.size());
+            }
+        }
+
+        void Web_Server::HandleInvokeRequest(mg_connection* conn, mg_http_message* hm)
+        {
+            if (mg_vcasecmp(&hm->method, "POST") != 0)
+            {
+                mg_http_reply(conn, 405, "Allow: POST\r\n" JSON_HEADERS, "{\"error\":\"calls must be posted\"}");
+                return;
+            }
+
+            if (mRequestJson.Parse(hm->body) < 0)
+            {
+                mg_http_reply(conn, 400, JSON_HEADERS, "{\"error\":\"invalid JSON\"}");
+                return;
+            }
+
+            // Nothing to reply on over HTTP, the outcome goes to every websocket
+            std::string result;
+            int status = QueueCall(mRequestJson, mRequestJson.Root(), 0, result);
+            SendJsonReply(conn, status, result);
+        }
+
+        int Web_Server::QueueCall(const JsonIndex& json, int node, unsigned long connection, std::string& result)
+        {
+            // Names without escapes are matched in place
+            int name = json.Find(node, "name");
+            mg_str text = json.GetText(name);
+            PublishedFunction* function = nullptr;
+            if (json.Is(name, Json::Kind::STRING))
+            {
+                function = FindFunction(mg_str_n(text.ptr + 1, text.len - 2));
+            }
+
+            if (function == nullptr)
+            {
+                std::string unescaped;
+                json.GetString(name, unescaped);
+                function = FindFunction(mg_str_n(unescaped.data(), unescaped.size()));
+                if (function == nullptr)
+                {
+                    return FunctionError(result, 404, "unknown function", unescaped);
+                }
+            }
+
+            // Functions published without a signature take no arguments
+            FunctionCall call = { 0, function, connection, {} };
+            int args = json.Find(node, "args");
+            bool valid = function->parse_json != nullptr ?
+                function->parse_json(json, args, call.arguments) :
+                json.GetCount(args) == 0;
+            if (!valid)
+            {
+                return FunctionError(result, 400, "invalid arguments", function->unique_name);
+            }
+
+            return SubmitCall(call, result);
+        }
+
+        void Web_Server::HandleRpcRequest(mg_connection* conn, mg_http_message* hm)
+        {
+            if (mg_vcasecmp(&hm->method, "POST") != 0)
+            {
+                mg_http_reply(conn, 405, "Allow: POST\r\n" JSON_HEADERS, "{\"error\":\"requests must be posted\"}");
+                return;
+            }
+
+            mRequestJson.Parse(hm->body);
+            HandleRpc(conn, mRequestJson, false);
+        }
+
+        void Web_Server::HandleRpc(mg_connection* conn, const JsonIndex& json, bool websocket)
+        {
+            RpcBatch batch = { conn->id, websocket, false, {}, 0 };
+            uint64_t batchId = mNextRpcBatch++;
+
+            int root = json.Root();
+            if (root < 0)
+            {
+                batch.responses.emplace_back();
+                AppendRpcResponse(batch.responses.back(), "null", -32700, "");
+            }
+            else if (!json.Is(root, Json::Kind::ARRAY))
+            {
+                ProcessRpcRequest(json, root, batch, batchId);
+            }
+            else if (json.GetCount(root) == 0 || json.GetCount(root) > RPC_BATCH_MAX)
+            {
+                batch.responses.emplace_back();
+                AppendRpcResponse(batch.responses.back(), "null", -32600, "");
+            }
+            else
+            {
+                batch.array = true;
+                for (int request = json.First(root); request >= 0; request = json.Next(request, root))
+                {
+                    ProcessRpcRequest(json, request, batch, batchId);
+                }
+            }
+
+            if (batch.pending == 0)
+            {
+                SendRpcResponse(conn, batch);
+            }
+            else
+            {
+                mRpcBatches.emplace(batchId, std::move(batch));
+            }
+        }
+
+        void Web_Server::ProcessRpcRequest(const JsonIndex& json, int request, RpcBatch& batch, uint64_t batchId)
+        {
+            // Requests without an id are notifications and get no response, unless invalid
+            int idNode = json.Find(request, "id");
+            std::string_view id = "null";
+            bool notification = idNode < 0;
+            bool valid = json.Is(request, Json::Kind::OBJECT);
+            if (idNode >= 0)
+            {
+                valid = valid && (json.Is(idNode, Json::Kind::STRING) || json.Is(idNode, Json::Kind::NUMBER) ||
+                    json.Is(idNode, Json::Kind::NUL));
+                if (valid)
+                {
+                    mg_str text = json.GetText(idNode);
+                    id = std::string_view(text.ptr, text.len);
+                }
+            }
+
+            valid = valid && json.Equals(json.Find(request, "jsonrpc"), "2.0");
+
+            int methodNode = json.Find(request, "method");
+            valid = valid && json.Is(methodNode, Json::Kind::STRING);
+
+            int params = json.Find(request, "params");
+            valid = valid && (params < 0 || json.Is(params, Json::Kind::ARRAY) || json.Is(params, Json::Kind::OBJECT));
+
+            auto respond = [&](int code, const std::string& body)
+            {
+                if (!notification || code == -32600)
+                {
+                    batch.responses.emplace_back();
+                    AppendRpcResponse(batch.responses.back(), id, code, body);
+                }
+            };
+
+            if (!valid)
+            {
+                respond(-32600, "");
+                return;
+            }
+
+            // Names without escapes are looked up in place
+            std::string unescaped;
+            mg_str text = json.GetText(methodNode);
+            std::string_view method(text.ptr + 1, text.len - 2);
+            if (method.find('\\') != std::string_view::npos)
+            {
+                json.GetString(methodNode, unescaped);
+                method = unescaped;
+            }
+
+            std::string result;
+            auto builtin = mRpcMethods.find(method);
+            if (builtin != mRpcMethods.end())
+            {
+                int code = (this->*builtin->second)(json, params, result);
+                respond(code, result);
+                return;
+            }
+
+            PublishedFunction* function = FindFunction(mg_str_n(method.data(), method.size()));
+            if (function == nullptr)
+            {
+                respond(-32601, "");
+                return;
+            }
+
+            // Functions take their arguments by position
+            FunctionCall call = { 0, function, batch.connection, {} };
+            bool parsed = params < 0 || json.Is(params, Json::Kind::ARRAY);
+            if (parsed)
+            {
+                parsed = function->parse_json != nullptr ?
+                    function->parse_json(json, params, call.arguments) :
+                    json.GetCount(params) == 0;
+            }
+            if (!parsed)
+            {
+                FunctionError(result, 400, "invalid arguments", function->unique_name);
+                respond(-32602, result);
+                return;
+            }
+
+            if (SubmitCall(call, result) != 202)
+            {
+                respond(-32000, result);
+                return;
+            }
+
+            // The response slot is filled in when the call finishes
+            RpcCall pending = { notification ? 0 : batchId, batch.responses.size(), std::string(id) };
+            mRpcCalls.emplace(call.id, std::move(pending));
+            if (!notification)
+            {
+                batch.responses.emplace_back();
+                batch.pending++;
+            }
+        }
+
+        void Web_Server::SendRpcResponse(mg_connection* conn, const RpcBatch& batch)
+        {
+            std::string body;
+            for (const std::string& response : batch.responses)
+            {
+                body += body.empty() ? (batch.array ? "[" : "") : ",";
+                body += response;
+            }
+            if (batch.array && !body.empty())
+            {
+                body += "]";
+            }
+
+            // Nothing is sent back for notifications
+            if (batch.websocket)
+            {
+                if (!body.empty())
+                {
+                    SendWebsocket(conn, body.data(), body.size(), WEBSOCKET_OP_TEXT);
+                }
+            }
+            else if (body.empty())
+            {
+                mg_http_reply(conn, 204, "", "");
+            }
+            else
+            {
+                SendJsonReply(conn, 200, body);
+            }
+        }
+
+        int Web_Server::RpcDataGet(const JsonIndex& json, int params, std::string& result)
+        {
+            result = "{";
+            bool first = true;
+
+            auto addValue = [&](PublishedData& data)
+            {
+                if (!first)
+                {
+                    result += ",";
+                }
+                first = false;
+
+                Json::AppendString(result, data.unique_name);
+                result += ":";
+                Json::AppendValue(result, data.type, data.address);
+            };
+
+            int names = json.Find(params, "names");
+
+            std::lock_guard<std::mutex> lock(mDataMutex);
+            if (names < 0)
+            {
+                for (auto& data : mDatas)
+                {
+                    if (IsViewable(data.access) && data.address != nullptr)
+                    {
+                        addValue(data);
+                    }
+                }
+            }
+            else
+            {
+                if (!json.Is(names, Json::Kind::ARRAY))
+                {
+                    result = "{\"error\":\"names must be an array\"}";
+                    return -32602;
+                }
+
+                std::string name;
+                for (int element = json.First(names); element >= 0; element = json.Next(element, names))
+                {
+                    name.clear();
+                    json.GetString(element, name);
+
+                    auto position = mDataIndex.find(name);
+                    if (position == mDataIndex.end() || !IsViewable(mDatas[position->second].access) ||
+                        mDatas[position->second].address == nullptr)
+                    {
+                        result = "{\"error\":\"unknown data\",\"name\":";
+                        Json::AppendString(result, name);
+                        result += "}";
+                        return -32602;
+                    }
+                    addValue(mDatas[position->second]);
+                }
+            }
+
+            result += "}";
+            return 0;
+        }
+
+        int Web_Server::RpcDataSet(const JsonIndex& json, int params, std::string& result)
+        {
+            return ApplyEdits(json, params, result) == 200 ? 0 : -32602;
+        }
+
+        PublishedFunction* Web_Server::FindFunction(mg_str name)
+        {
+            auto position = mFunctionIndex.find(std::string_view(name.ptr, name.len));
+            if (position == mFunctionIndex.end() || mFunctions[position->second].access == Function::Access::HIDDEN)
+            {
+                return nullptr;
+            }
+            return &mFunctions[position->second];
+        }
+
+        int Web_Server::SubmitCall(FunctionCall& call, std::string& result)
+        {
+            call.id = mNextCallId;
+            if (mExecutor.Submit(call) < 0)
+            {
+                return FunctionError(result, 503, "too many calls", call.function->unique_name);
+            }
+
+            mNextCallId++;
+            result = "{\"call_id\":" + std::to_string(call.id) + "}";
+            return 202;
+        }
+
+        int Web_Server::FunctionError(std::string& result, int status, const char* error, const std::string& name)
+        {
+            result = "{\"error\":\"";
+            result += error;
+            result += "\",\"name\":";
+            Json::AppendString(result, name);
+            result += "}";
+            return status;
+        }
+
+        void Web_Server::DeliverResults()
+        {
+            mExecutor.TakeResults(mFinishedCalls);
+
+            for (const FunctionResult& finished : mFinishedCalls)
+            {
+                // Calls made over JSON-RPC answer their request instead
+                auto rpc = mRpcCalls.find(finished.id);
+                if (rpc != mRpcCalls.end())
+                {
+                    auto batch = mRpcBatches.find(rpc->second.batch);
+                    if (batch != mRpcBatches.end())
+                    {
+                        std::string body;
+                        if (finished.success)
+                        {
+                            AppendJsonValue(body, finished.value);
+                        }
+                        else
+                        {
+                            body = "{\"error\":";
+                            Json::AppendString(body, finished.error);
+                            body += "}";
+                        }
+                        AppendRpcResponse(batch->second.responses[rpc->second.slot], rpc->second.id, finished.success ? 0 : -32000, body);
+
+                        if (--batch->second.pending == 0)
+                        {
+                            for (mg_connection* conn = mManager.conns; conn != nullptr; conn = conn->next)
+                            {
+                                if (conn->id == batch->second.connection)
+                                {
+                                    SendRpcResponse(conn, batch->second);
+                                    break;
+                                }
+                            }
+                            mRpcBatches.erase(batch);
+                        }
+                    }
+
+                    mRpcCalls.erase(rpc);
+                    continue;
+                }
+
+                std::string message = "{\"type\":\"result\",\"call_id\":" + std::to_string(finished.id) + ",\"name\":";
+                Json::AppendString(message, finished.function->unique_name);
+                message += ",\"status\":";
+
+                if (finished.success)
+                {
+                    message += "200,\"result\":{\"value\":";
+                    AppendJsonValue(message, finished.value);
+                }
+                else
+                {
+                    message += "500,\"result\":{\"error\":";
+                    Json::AppendString(message, finished.error);
+                }
+                message += "}}";
+
+                // The caller may have gone, then the result is dropped
+                for (mg_connection* conn = mManager.conns; conn != nullptr; conn = conn->next)
+                {
+                    if (conn->is_websocket && (finished.connection == 0 || conn->id == finished.connection))
+                    {
+                        SendWebsocket(conn, message.data(), message.size(), WEBSOCKET_OP_TEXT);
+                    }
+                }
+            }
+        }
+
+        bool Web_Server::IsViewable(Data::Access access)
+        {
+            return access == Data::Access::VIEW || access == Data::Access::VIEW_EDIT;
+        }
+
+        bool Web_Server::IsEditable(Data::Access access)
+        {
+            return access == Data::Access::EDIT || access == Data::Access::VIEW_EDIT;
+        }
+
+        void Web_Server::AppendCsvField(std::string& out, const std::string& value)
+        {
+            if (value.find_first_of(",\"\r\n") == std::string::npos)
+            {
+                out += value;
+                return;
+            }
+
+            out += '"';
+            for (char c : value)
+            {
+                if (c == '"')
+                {
+                    out += '"';
+                }
+                out += c;
+            }
+            out += '"';
+        }
+
+        void Web_Server::AppendCsvRows(std::string& out, const std::vector<GraphQueryResult>& slices)
+        {
+            char buffer[32];
+            std::vector<size_t> next(slices.size(), 0);
+            while (true)
+            {
+                // The row is the earliest sample not yet written across all signals
+                uint64_t timestamp = UINT64_MAX;
+                for (size_t s = 0; s < slices.size(); s++)
+                {
+                    if (next[s] < slices[s].times.size())
+                    {
+                        timestamp = std::min(timestamp, slices[s].times[next[s]]);
+                    }
+                }
+
+                if (timestamp == UINT64_MAX)
+                {
+                    return;
+                }
+
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), timestamp);
+                out.append(buffer, result.ptr);
+                for (size_t s = 0; s < slices.size(); s++)
+                {
+                    out += ',';
+                    if (next[s] < slices[s].times.size() && slices[s].times[next[s]] == timestamp)
+                    {
+                        double value = slices[s].values[next[s]++];
+                        if (std::isfinite(value))
+                        {
+                            result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+                            out.append(buffer, result.ptr);
+                        }
+                    }
+                }
+                out += "\r\n";
+            }
+        }
+
+        void Web_Server::AppendVarint(std::string& out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out += static_cast<char>((value & 0x7F) | 0x80);
+                value >>= 7;
+            }
+            out += static_cast<char>(value);
+        }
+
+        void Web_Server::AppendRpcResponse(std::string& out, std::string_view id, int code, const std::string& body)
+        {
+            out += "{\"jsonrpc\":\"2.0\",";
+            if (code == 0)
+            {
+                out += "\"result\":";
+                out += body;
+            }
+            else
+            {
+                const char* message = "Server error";
+                switch (code)
+                {
+                case -32700: message = "Parse error"; break;
+                case -32600: message = "Invalid Request"; break;
+                case -32601: message = "Method not found"; break;
+                case -32602: message = "Invalid params"; break;
+                case -32603: message = "Internal error"; break;
+                default: break;
+                }
+
+                out += "\"error\":{\"code\":" + std::to_string(code) + ",\"message\":\"" + message + "\"";
+                if (!body.empty())
+                {
+                    out += ",\"data\":" + body;
+                }
+                out += "}";
+            }
+            out += ",\"id\":";
+            out.append(id.data(), id.size());
+            out += "}";
+        }
+
+        void Web_Server::AppendJsonValue(std::string& out, const Data::Value& value)
+        {
+            if (value.type == Data::Type::STRING)
+            {
+                Json::AppendString(out, value.text);
+                return;
+            }
+
+            if (value.type == Data::Type::NONE || !std::isfinite(value.number))
+            {
+                out += "null";
+                return;
+            }
+
+            if (value.type == Data::Type::BOOL)
+            {
+                out += value.number != 0.0 ? "true" : "false";
+                return;
+            }
+
+            // Integer types print without a fraction
+            if (value.type == Data::Type::DOUBLE || value.type == Data::Type::FLOAT)
+            {
+                Json::AppendNumber(out, value.number);
+            }
+            else
+            {
+                Json::AppendNumber(out, static_cast<int64_t>(value.number));
+            }
+        }
     }
 }
\ No newline at end of file
@@ -21,10 +21,35 @@
 #include "../Mongoose/mongoose.h"           // Mongoose functionality
 #include <thread>                           // Threading
 #include <vector>                           // vectors
+#include <deque>                            // Stable published function storage
+#include <unordered_map>                    // Name lookup tables
+#include <string_view>                      // Name lookup without copies
 #include <algorithm>                        // algorithms
 #include "publishable_types.h"              // Publishable data types
+#include "binary_protocol.h"                // Binary websocket frames
+#include "graph_history.h"                  // Graph sample storage
+#include "history_file.h"                   // Persistent graph history
+#include "recording.h"                      // Recording and replay
+#include "sample_scheduler.h"               // Per item sampling
+#include "downsample.h"                     // Graph series reduction
+#include "function_executor.h"              // Published function calls
+#include "function_marshal.h"               // Typed published functions
+#include "subscription_table.h"             // Per client subscriptions
+#include "push_scheduler.h"                 // Coalesced data updates
+#include "websocket_deflate.h"              // Websocket compression
+#include "json_index.h"                     // Request parsing
+#include "json_writer.h"                    // Response formatting
+#include "output_ring.h"                    // Terminal job output
+#include <memory>                           // Unique pointers
+#include <mutex>                            // History protection
+#include <charconv>                         // Number formatting
+#include <cmath>                            // isfinite
+#include <limits>                           // NaN
+#include <atomic>                           // Replay position
+#include <condition_variable>               // Replay pacing
+#include <chrono>                           // Replay clock
 
-#ifdef CPP_TERMINAL
+#ifdef CPP_WEB_SERVER_TERMINAL                // Set by the CPP_WEB_SERVER_TERMINAL build option
 #include "../CPP_Terminal/cpp_terminal.h"   // Terminal access
 #endif
 
@@ -48,6 +73,21 @@ namespace Essentials
         const static uint8_t WEB_SERVER_VERSION_MINOR = 1;
         const static uint8_t WEB_SERVER_VERSION_PATCH = 0;
         const static uint8_t WEB_SERVER_VERSION_BUILD = 0;
+        const static size_t QUERY_STEPS_MAX = 100000;       // Largest aligned timebase a range query returns
+        const static size_t QUERY_SEND_WATERMARK = 65536;   // Send buffer level a range query refills below
+        const static size_t QUERY_SLICE_SAMPLES = 4096;     // Samples or steps a range query slice aims for
+        const static uint64_t QUERY_WINDOW_MSEC = 60000;    // Time span of the first slice of each signal
+        const static size_t EXPORT_SEND_WATERMARK = 65536;  // Send buffer level an export refills below
+        const static size_t EXPORT_SLICE_SAMPLES = 4096;    // Samples per signal an export slice aims for
+        const static uint64_t EXPORT_WINDOW_MSEC = 60000;   // Time span of the first export slice
+        const static size_t EDIT_BATCH_MAX = 256;           // Most edits applied in one batch
+        const static size_t RPC_BATCH_MAX = 1024;           // Most requests in one JSON-RPC batch
+        const static size_t CLIENT_SEND_WATERMARK = 262144; // Send buffer level above which pushed updates are skipped
+        const static size_t TERMINAL_JOBS_MAX = 8;          // Default most terminal jobs running at once
+        const static size_t TERMINAL_JOB_OUTPUT = 65536;    // Default output kept per terminal job, in bytes
+        const static size_t TERMINAL_JOBS_KEPT = 16;        // Finished terminal jobs kept for their output
+        const static size_t SHELL_SESSIONS_MAX = 4;         // Default most shells open at once
+        const static uint64_t SHELL_IDLE_MSEC = 600000;     // Default time a shell stays open without input or output
 
         /// @brief Printable string of the web server version
         const static std::string WebServerVersion = "Web Server v" +
@@ -69,6 +109,8 @@ namespace Essentials
             LINUX_THREAD_PRIORITY_OOR,
             THREAD_PRIORITY_GET_FAILURE,
             THREAD_PRIORITY_SET_FAILURE,
+            HISTORY_MAP_FAILURE,
+            WAKEUP_PIPE_FAILURE,
         };
 
         /// @brief Error enum to readable string conversion map
@@ -88,6 +130,10 @@ namespace Essentials
             std::string("Error Code " + std::to_string((uint8_t)WebServerError::THREAD_PRIORITY_GET_FAILURE) + ": Failed to get thread priority.")},
             {WebServerError::THREAD_PRIORITY_SET_FAILURE,
             std::string("Error Code " + std::to_string((uint8_t)WebServerError::THREAD_PRIORITY_SET_FAILURE) + ": Failed to set thread priority.")},
+            {WebServerError::HISTORY_MAP_FAILURE,
+            std::string("Error Code " + std::to_string((uint8_t)WebServerError::HISTORY_MAP_FAILURE) + ": Failed to map the persistent graph history file.")},
+            {WebServerError::WAKEUP_PIPE_FAILURE,
+            std::string("Error Code " + std::to_string((uint8_t)WebServerError::WAKEUP_PIPE_FAILURE) + ": Failed to create the function result wake up pipe.")},
         };
 
         enum class WebServerThreadPriority
@@ -111,6 +157,17 @@ namespace Essentials
 #endif
         };
 
+        /// @brief Called once per applied batch of edits with the unique names of the
+        ///        published data it changed.
+        using EditCallback = std::function<void(const std::vector<std::string>& names)>;
+
+        /// @brief Most recent sample of an item
+        struct ItemSample
+        {
+            double      value;          // Sampled value
+            uint64_t    timestamp;      // Sample time in milliseconds, 0 if never sampled
+        };
+
         /// @brief Web server class
         class Web_Server
         {
@@ -167,14 +224,94 @@ namespace Essentials
 
             /// @brief Add a data to the web server.
             /// @param data - [in] - A PublishedData to be added to the webserver. 
-            /// @return -1 on error (@param unique_name already exists, 0 on success
+            /// @return -1 on error (@param unique_name already exists, or sample_period is past
+            ///         SAMPLE_PERIOD_MAX_MSEC or has no address to sample), 0 on success
             int8_t AddPublishedData(PublishedData data);
 
             /// @brief Add a graph data to the web server.
             /// @param graph - [in] - A PublishedGraphData to be added to the webserver.
-            /// @return -1 on error (@param unique_name already exists, 0 on success
+            /// @return -1 on error (@param unique_name already exists, or sample_period is past
+            ///         SAMPLE_PERIOD_MAX_MSEC), 0 on success
             int8_t AddPublishedGraphData(PublishedGraphData graph);
 
+            /// @brief Set the sample period used by graph data registered afterwards without
+            ///        their own sample_period.
+            /// @param milliseconds - [in] - Sample period, 1 to SAMPLE_PERIOD_MAX_MSEC.
+            /// @return -1 on error, 0 on success
+            int8_t SetGraphSampleRate(uint32_t milliseconds);
+
+            /// @brief Set the rollup tiers kept for graph data registered afterwards. Defaults
+            ///        to 1 second buckets for 24 hours and 1 minute buckets for 30 days.
+            /// @param tiers - [in] - Tiers ordered finest to coarsest, empty for raw samples only.
+            /// @return -1 on error, 0 on success
+            int8_t SetGraphRollupTiers(const std::vector<RollupTier>& tiers);
+
+            /// @brief Set whether graph data registered afterwards keep their raw samples
+            ///        gorilla compressed, trading decode time on queries for memory.
+            /// @param enable - [in] - true to compress, false for a plain ring. Defaults to false.
+            void SetGraphCompression(bool enable);
+
+            /// @brief Keep graph history rings in a memory-mapped file so they survive restarts.
+            ///        The file is mapped on Start for the graph data registered by then, resuming
+            ///        where the last run stopped when the same graphs and sizes are registered,
+            ///        otherwise starting empty. Compressed graphs stay in memory.
+            /// @param path - [in] - File holding the rings, one per server instance.
+            /// @return -1 if the server is running, 0 on success
+            int8_t EnablePersistentHistory(const std::string& path);
+
+            /// @brief Get the most recent sample of a sampled published data or graph data.
+            /// @param name - [in] - Unique name of the item.
+            /// @param value - [out] - Sampled value.
+            /// @param timestamp - [out] - Sample time in milliseconds since the epoch.
+            /// @return -1 if the item is unknown or not sampled yet, 0 on success
+            int8_t GetLatestSample(const std::string& name, double& value, uint64_t& timestamp);
+
+            /// @brief Get the sampling scheduler counters.
+            SampleSchedulerStatistics GetSampleSchedulerStatistics();
+
+            /// @brief Record every sampled published data and graph data to a columnar file
+            ///        until StopRecording or Stop. Data is only sampled with a sample_period.
+            /// @param path - [in] - File to write, replaced if it exists.
+            /// @return -1 if already recording, nothing is sampled or the file failed, 0 on success
+            int8_t StartRecording(const std::string& path);
+
+            /// @brief Finish the recording, writing its time index.
+            void StopRecording();
+
+            /// @brief Serve a recording instead of live data. The recorded items are published
+            ///        in place of any of your own and played back into the data and graph
+            ///        endpoints from Start, with their original timestamps.
+            /// @param path - [in] - Recording to play.
+            /// @param speed - [in] - Playback rate, 1.0 for real time, higher to accelerate.
+            /// @return -1 if running, items are already published or the file failed, 0 on success
+            int8_t StartReplay(const std::string& path, double speed = 1.0);
+
+            /// @brief Set the callback told about each batch of edits applied from the web page.
+            ///        It runs on the server thread after the batch is applied, keep it short.
+            /// @param callback - [in] - Callback to call, empty for none.
+            void SetEditCallback(EditCallback callback);
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+            /// @brief Set how many websockets may hold a shell at once and how long a shell stays
+            ///        open without input or output before it is closed.
+            /// @param sessions - [in] - Most shells open at once, 0 to refuse shells.
+            /// @param idleMilliseconds - [in] - Idle time before a shell is closed, at least 1000.
+            /// @return -1 if running or out of range, 0 on success
+            int8_t SetShellLimits(size_t sessions, uint64_t idleMilliseconds);
+
+            /// @brief Set how many terminal jobs may run at once and how much of each job's
+            ///        most recent output is kept for clients to fetch.
+            /// @param running - [in] - Most jobs running at once, 0 to refuse commands.
+            /// @param outputBytes - [in] - Output kept per job, older output is dropped.
+            /// @return -1 if running, 0 on success
+            int8_t SetTerminalJobLimits(size_t running, size_t outputBytes);
+#endif
+
+            /// @brief Lock the published data memory against edits and sampling. Hold the lock
+            ///        while reading editable values that must be consistent with each other.
+            /// @return Lock over the published data.
+            std::unique_lock<std::mutex> LockPublishedData();
+
             /// @brief Get the number of published functions.
             /// @return 0+ indicating the number of published functions. 
             int8_t GetNumberOfPublishedFunctions();
@@ -203,11 +340,36 @@ namespace Essentials
             /// @return String containing information on the last error
             std::string GetLastError();
 
-            /// @brief Send a console log message to the websocket. 
+            /// @brief Send a console log message to every websocket. Messages are queued and
+            ///        sent by the server thread.
             /// @param message - [in] - message to be published.
             /// @return -1 on error, 0 on success
             int8_t SendConsoleLog(const std::string& message);
 
+            /// @brief Configure permessage-deflate for websockets opened after Start. Clients
+            ///        offering the extension get their own compressor, kept from message to
+            ///        message. Requires a build with zlib.
+            /// @param level - [in] - zlib level 1 to 9, 0 to turn compression off.
+            /// @param threshold - [in] - Messages smaller than this many bytes go uncompressed.
+            /// @return -1 on error, 0 on success
+            int8_t ConfigureCompression(int level, size_t threshold = WEBSOCKET_DEFLATE_THRESHOLD);
+
+            /// @brief Mark every viewable published data and graph data as changed. Changes are
+            ///        sent to each websocket as one binary VALUES frame per push interval, holding
+            ///        the values current when the frame is built.
+            /// @return -1 on error, 0 on success
+            int8_t SendDataUpdate();
+
+            /// @brief Mark one published data or graph data as changed.
+            /// @param name - [in] - Unique name of the item.
+            /// @return -1 on error, 0 on success
+            int8_t SendDataUpdate(const std::string& name);
+
+            /// @brief Set the time between pushed VALUES frames. A websocket still sending its
+            ///        previous frames skips ticks and is sent the latest values once it drains.
+            /// @param msec - [in] - Milliseconds between frames.
+            void SetPushInterval(uint32_t msec);
+
         protected:
         private:
 
@@ -217,13 +379,524 @@ namespace Essentials
             /// @brief Hidden deconstructor
             ~Web_Server();
 
+            /// @brief A signal resolved for a range query or export.
+            struct SignalSource
+            {
+                std::string     name;
+                Data::Type      type;
+                GraphHistory*   history;        // Graph history, nullptr if only recorded
+                int64_t         recorded;       // Item index in the replayed recording, -1 if none
+            };
+
+            //  Binary export stream, after the chunked encoding is removed:
+            //
+            //      "CPPWSEXP", varint signal count,
+            //      signals x { u8 Data::Type, varint name length, name }
+            //      slices x { varint frame length, GORILLA frame }
+            //      varint 0
+            //
+            //  Series ids in the GORILLA frames index the signal table, each series
+            //  holds one block per slice.
+            static constexpr char EXPORT_MAGIC[8] = { 'C', 'P', 'P', 'W', 'S', 'E', 'X', 'P' };
+
+            /// @brief An export in progress on one connection.
+            struct ExportState
+            {
+                std::vector<SignalSource>       sources;    // Signals exported, in column order
+                std::vector<GraphQueryResult>   slices;     // Reused samples of the current slice per signal
+                Binary::Writer                  writer;     // Reused frame buffer
+                Gorilla::Encoder                encoder;    // Reused block encoder
+                std::string                     out;        // Reused chunk buffer
+                bool                            csv;        // CSV rows, otherwise binary frames
+                uint64_t                        cursor;     // Samples up to this time are sent
+                uint64_t                        until;      // End of the exported window
+                uint64_t                        window;     // Time span of the next slice
+            };
+
+            /// @brief A range query in progress on one connection.
+            struct QueryState
+            {
+                std::vector<SignalSource>   sources;    // Signals queried, in the order named
+                GraphQueryResult            slice;      // Reused samples of the current slice
+                std::string                 out;        // Reused chunk buffer
+                uint64_t                    t0;         // Start of the window, the first step
+                uint64_t                    since;      // Exclusive lower bound of the window
+                uint64_t                    until;      // End of the window
+                uint64_t                    step;       // Timebase step, 0 for raw samples
+                size_t                      steps;      // Steps on the timebase
+                bool                        timebase;   // Still sending the timebase
+                size_t                      signal;     // Signal being sent
+                bool                        open;       // The current signal has been started
+                size_t                      next;       // Next step to send, of the timebase or the current signal
+                bool                        first;      // No sample of the current signal sent yet
+                uint64_t                    cursor;     // Samples of the current signal up to this time are read
+                uint64_t                    window;     // Time span of the next slice
+                uint64_t                    resolution; // Coarsest bucket width read for the current signal
+                double                      held;       // Last sample read of the current signal
+            };
+
+            /// @brief Hashes names so tables keyed by std::string can be searched with a view.
+            struct NameHash
+            {
+                using is_transparent = void;
+                size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+            };
+
+            /// @brief Position of each item by unique name.
+            using NameIndex = std::unordered_map<std::string, size_t, NameHash, std::equal_to<>>;
+
+            /// @brief A JSON-RPC method built into the server.
+            /// @param json - [in] - Request document.
+            /// @param params - [in] - Params of the request, -1 when absent.
+            /// @param result - [out] - JSON result, or the error object when failing.
+            /// @return 0 on success, a JSON-RPC error code on failure.
+            using RpcMethod = int (Web_Server::*)(const JsonIndex& json, int params, std::string& result);
+
+            /// @brief A JSON-RPC request or batch with responses still to come from function calls.
+            struct RpcBatch
+            {
+                unsigned long               connection;     // Connection to respond on
+                bool                        websocket;      // Respond with a websocket message, otherwise HTTP
+                bool                        array;          // Batch request, responded to with an array
+                std::vector<std::string>    responses;      // Responses in request order, empty while pending
+                size_t                      pending;        // Responses still pending
+            };
+
+            /// @brief Where the result of a function called over JSON-RPC goes.
+            struct RpcCall
+            {
+                uint64_t        batch;      // Batch waiting for it, 0 for a notification
+                size_t          slot;       // Response slot in the batch
+                std::string     id;         // Request id token to respond with
+            };
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+            /// @brief A terminal command, its output kept in a ring and streamed to the websocket
+            ///        attached to it. It runs on when that websocket closes.
+            struct TerminalJob
+            {
+                uint64_t        id;         // Job id echoed in its replies
+                std::string     command;    // Command line
+                unsigned long   client;     // Websocket to stream to, 0 when detached
+                Essentials::Utilities::CommandProcess process;  // Running command
+                unsigned long   streams[2]; // Output and error connection ids, 0 once read to the end
+                bool            running;    // Not yet reaped
+                int             exitstatus; // Exit status once reaped
+                OutputRing      output;     // Most recent output and error
+            };
+
+            /// @brief A shell on a pseudo terminal held open for one websocket.
+            struct ShellSession
+            {
+                unsigned long   client;     // Websocket owning the shell, 0 once it has closed
+                Essentials::Utilities::CommandProcess process;  // Running shell
+                unsigned long   stream;     // Terminal connection id, 0 once read to the end
+                uint64_t        active;     // Time of the last input or output in milliseconds
+                bool            exited;     // Shell has been reaped
+                int             exitstatus; // Exit status once reaped
+                bool            idle;       // Closed for being idle
+            };
+#endif
+
             /// @brief Blocking function that runs a while loop to poll the web server. 
             void Poll();
 
+            /// @brief Add an item to the sampling scheduler.
+            /// @param period - [in] - Sample period in milliseconds.
+            /// @param target - [in] - Item to sample.
+            /// @return -1 on error, 0 on success
+            int8_t ScheduleSampling(uint32_t period, const SampleTarget& target);
+
+            /// @brief Sample every item of a group. Runs on the scheduler thread.
+            /// @param group - [in] - Group that is due.
+            /// @param timestamp - [in] - Sample time in milliseconds since the epoch.
+            void SweepGroup(const SampleGroup& group, uint64_t timestamp);
+
+            /// @brief Map the persistent history file and move the graph rings onto it.
+            /// @return -1 on error, 0 on success
+            int8_t MapGraphHistories();
+
+            /// @brief Play the recording back at mReplaySpeed. Runs on mReplayThread.
+            void Replay();
+
             /// @brief Getter to check if all necessary data is set (address, port, and root directory)
             /// @return true or false appropriately. 
             bool IsDataSet();
 
+            /// @brief Reply with the id, name, type and access of every published item.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            void HandleSchemaRequest(mg_connection* conn);
+
+            /// @brief Reply with the current values of every viewable published item as JSON.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            void HandleDataRequest(mg_connection* conn);
+
+            /// @brief Reply with the history of a published graph data item.
+            ///        Handles /api/graph/<name>?since=<ms>&until=<ms>&format=<json|binary|gorilla>&points=<n>&mode=<lttb|minmax>
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            void HandleGraphRequest(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Start streaming a time window of many signals with chunked encoding, raw
+            ///        as "samples":[[t,v],...] or aligned onto a common timebase holding the last
+            ///        sample at each step. The reply is produced a slice at a time as the send
+            ///        buffer drains.
+            ///        Handles /api/query?names=<a,b,...>&t0=<ms>&t1=<ms>&step=<ms>
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            void HandleQueryRequest(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Send query slices until the send buffer reaches QUERY_SEND_WATERMARK,
+            ///        finishing the reply once every signal is covered.
+            /// @param conn - [in] - Mongoose connection the query runs on.
+            void ContinueQuery(mg_connection* conn);
+
+            /// @brief Read the next slice of the signal being sent and append it to the chunk.
+            /// @param state - [in/out] - Query in progress.
+            /// @return true once the signal is complete, false if slices remain.
+            bool AppendQuerySlice(QueryState& state);
+
+            /// @brief Start streaming a time window of many signals as a file download. The
+            ///        export is produced a slice at a time as the send buffer drains.
+            ///        Handles /api/export?names=<a,b,...>&t0=<ms>&t1=<ms>&format=<csv|binary>
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            void HandleExportRequest(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Send export slices until the send buffer reaches EXPORT_SEND_WATERMARK,
+            ///        finishing the reply once the window is covered.
+            /// @param conn - [in] - Mongoose connection the export runs on.
+            void ContinueExport(mg_connection* conn);
+
+            /// @brief Apply a batch of edits posted as {"edits":[{"name":<name>,"value":<value>},...]}.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            void HandleEditRequest(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Handle a JSON command sent as a websocket text message. Replies on the
+            ///        websocket with {"type":<command>,"status":<http status>,"result":<result>}.
+            /// @param conn - [in] - Websocket connection to reply on.
+            /// @param message - [in] - Command document.
+            void HandleWebsocketCommand(mg_connection* conn, mg_str message);
+
+            /// @brief Handle a binary protocol INVOKE frame sent on the websocket. Replies with the
+            ///        same JSON text as HandleWebsocketCommand, echoing the request id.
+            /// @param conn - [in] - Websocket connection to reply on.
+            /// @param message - [in] - Frame received.
+            void HandleBinaryCommand(mg_connection* conn, mg_str message);
+
+            /// @brief Subscribe a websocket to items sent as {"subscribe":{"items":[...],"rate":<Hz>}}.
+            ///        Items are unique names or mg_match patterns, where ? is one character,
+            ///        * any run without a slash and # any run.
+            /// @param json - [in] - Command document.
+            /// @param node - [in] - Subscribe object.
+            /// @param connection - [in] - Websocket subscribing.
+            /// @param result - [out] - JSON result, the subscription or the error.
+            /// @return HTTP status of the result, 200 when subscribed.
+            int Subscribe(const JsonIndex& json, int node, unsigned long connection, std::string& result);
+
+            /// @brief Remove a subscription sent as {"unsubscribe":<subscription id>}.
+            /// @param json - [in] - Command document.
+            /// @param node - [in] - Subscription id.
+            /// @param connection - [in] - Websocket holding the subscription.
+            /// @param result - [out] - JSON result.
+            /// @return HTTP status of the result, 200 when removed.
+            int Unsubscribe(const JsonIndex& json, int node, unsigned long connection, std::string& result);
+
+            /// @brief Send a VALUES frame to every subscription due. Each item needed is read
+            ///        and encoded once, however many subscriptions include it.
+            /// @param now - [in] - Current time in milliseconds.
+            void PublishSubscriptions(uint64_t now);
+
+            /// @brief Send each websocket one VALUES frame of its changed items when a push
+            ///        tick is due.
+            /// @param now - [in] - Current time in milliseconds.
+            void PushUpdates(uint64_t now);
+
+            /// @brief Start a sweep of item records, encoded items from earlier sweeps are dropped.
+            void BeginItemRecords();
+
+            /// @brief Get the VALUES record of an item, encoding it on its first use in the sweep.
+            ///        The caller holds mDataMutex.
+            /// @param item - [in] - Item to encode.
+            /// @return Offset and length of the record in mItemRecords.
+            const std::pair<size_t, size_t>& EncodeItemRecord(const SubscribedItem& item);
+
+            /// @brief Find an open connection by id.
+            /// @param id - [in] - Connection id.
+            /// @return the connection, nullptr if it is closed or closing.
+            mg_connection* FindConnection(unsigned long id);
+
+            /// @brief Wake the server thread from its poll.
+            void WakeServer();
+
+            /// @brief Upgrade a connection to a websocket, agreeing on compression if offered.
+            /// @param conn - [in] - Connection requesting the upgrade.
+            /// @param hm - [in] - Upgrade request.
+            void UpgradeWebsocket(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Send a websocket message, compressed if agreed for the connection and at
+            ///        least the compression threshold in size.
+            /// @param conn - [in] - Websocket to send on.
+            /// @param data - [in] - Message payload.
+            /// @param size - [in] - Payload size.
+            /// @param op - [in] - WEBSOCKET_OP_TEXT or WEBSOCKET_OP_BINARY.
+            void SendWebsocket(mg_connection* conn, const void* data, size_t size, int op);
+
+            /// @brief Decompress a received message sent with RSV1 set.
+            /// @param conn - [in] - Websocket received on.
+            /// @param message - [in/out] - Compressed payload, replaced with the message.
+            /// @return false if compression was not agreed or the payload is invalid, true on success.
+            bool InflateMessage(mg_connection* conn, mg_str& message);
+
+            /// @brief Send the queued console log messages to every websocket.
+            void FlushConsoleLogs();
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+            /// @brief Start a terminal job without waiting for it. Its output and error are
+            ///        read by the poll loop and sent to the websocket as they arrive, a 202 reply
+            ///        with the job id comes first and one with the exit status last.
+            /// @param conn - [in] - Websocket that sent the command.
+            /// @param command - [in] - Command line.
+            void StartTerminalCommand(mg_connection* conn, const std::string& command);
+
+            /// @brief Keep what a job stream has read in the job's ring and send it to the
+            ///        attached websocket. Reading pauses while that websocket's send buffer is
+            ///        above CLIENT_SEND_WATERMARK, so a command writing faster than the client
+            ///        reads blocks on its pipe. A detached job is read freely, its ring dropping
+            ///        the oldest output.
+            /// @param conn - [in] - Stream connection.
+            /// @param received - [in] - Bytes just read, at the end of the receive buffer.
+            /// @param closing - [in] - true when the stream has ended, the remainder is sent whole.
+            void RelayTerminalOutput(mg_connection* conn, size_t received, bool closing);
+
+            /// @brief List, tail, attach to or kill terminal jobs, sent as {"job":"list"} or
+            ///        {"job":{"action":"tail"|"attach"|"kill","id":<job id>,"since":<offset>}}.
+            ///        tail returns the output kept from since on, attach does the same and
+            ///        streams the job's further output to the websocket.
+            /// @param json - [in] - Command document.
+            /// @param node - [in] - Job action or object.
+            /// @param connection - [in] - Websocket sending the command.
+            /// @param result - [out] - JSON result.
+            /// @return HTTP status of the result, 200 when done.
+            int ControlJob(const JsonIndex& json, int node, unsigned long connection, std::string& result);
+
+            /// @brief Send what a terminal stream has read to a websocket, pausing the stream
+            ///        while the websocket's send buffer is above CLIENT_SEND_WATERMARK.
+            /// @param conn - [in] - Stream connection.
+            /// @param client - [in] - Websocket id, 0 to drop the output.
+            /// @param closing - [in] - true when the stream has ended, the remainder is sent whole.
+            void ForwardTerminalOutput(mg_connection* conn, unsigned long client, bool closing);
+
+            /// @brief Resume a paused stream once its websocket has drained.
+            /// @param stream - [in] - Stream connection id, 0 for none.
+            /// @param client - [in] - Websocket id.
+            void ResumeTerminalStream(unsigned long stream, unsigned long client);
+
+            /// @brief Open, close or interrupt the shell of a websocket, sent as
+            ///        {"shell":"open"|"close"|"interrupt"}. While a shell is open the
+            ///        websocket's plain text messages are written to it as lines, instead of
+            ///        each starting a command.
+            /// @param json - [in] - Command document.
+            /// @param node - [in] - Shell action.
+            /// @param connection - [in] - Websocket sending the command.
+            /// @param result - [out] - JSON result.
+            /// @return HTTP status of the result, 200 when done.
+            int ControlShell(const JsonIndex& json, int node, unsigned long connection, std::string& result);
+
+            /// @brief Write a line to the shell of a websocket.
+            /// @param conn - [in] - Websocket that sent the line.
+            /// @param line - [in] - Line without its newline.
+            /// @return false if the websocket has no shell open, true when written.
+            bool WriteShell(mg_connection* conn, const std::string& line);
+
+            /// @brief Send what a shell has written to its websocket.
+            /// @param conn - [in] - Terminal connection.
+            /// @param closing - [in] - true when the terminal has closed.
+            void RelayShellOutput(mg_connection* conn, bool closing);
+
+            /// @brief Resume paused shells, close idle ones and reply with the exit status of
+            ///        shells that have ended.
+            /// @param now - [in] - Current time in milliseconds.
+            void ServiceShells(uint64_t now);
+
+            /// @brief Kill the shell of a websocket.
+            /// @param client - [in] - Websocket id, 0 for every shell.
+            /// @param wait - [in] - true to reap the shells and drop their sessions.
+            void KillShells(unsigned long client, bool wait);
+
+            /// @brief Resume paused streams whose websocket has drained, reply with the exit
+            ///        status of jobs that have finished and drop the oldest finished jobs past
+            ///        TERMINAL_JOBS_KEPT.
+            void ServiceTerminals();
+
+            /// @brief Detach the jobs of a closed websocket, they run on into their rings.
+            /// @param client - [in] - Websocket id.
+            void DetachTerminalJobs(unsigned long client);
+
+            /// @brief Kill and reap every running job.
+            void KillTerminalJobs();
+#endif
+
+            /// @brief Send an HTTP reply with a JSON body.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param status - [in] - HTTP status.
+            /// @param body - [in] - JSON body.
+            void SendJsonReply(mg_connection* conn, int status, std::string_view body);
+
+            /// @brief Send the JSON reply to a websocket command.
+            /// @param conn - [in] - Websocket connection to reply on.
+            /// @param type - [in] - Command type.
+            /// @param status - [in] - HTTP status of the result.
+            /// @param id - [in] - JSON id to echo, empty for none.
+            /// @param result - [in] - JSON result.
+            void SendCommandReply(mg_connection* conn, const std::string& type, int status, mg_str id, const std::string& result);
+
+            /// @brief Parse and validate a batch of edits, then write them all under the data lock
+            ///        and call the edit callback once. Nothing is written unless every edit is valid.
+            /// @param json - [in] - Request document.
+            /// @param node - [in] - Object holding the edits array.
+            /// @param result - [out] - JSON result, the number applied or the first error.
+            /// @return HTTP status of the result, 200 when applied.
+            int ApplyEdits(const JsonIndex& json, int node, std::string& result);
+
+            /// @brief Queue a call of a published function posted as {"name":<name>,"args":[...]}.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            void HandleInvokeRequest(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Queue a call of a published function on the executor. The call id is
+            ///        returned at once, the outcome follows as a websocket result message.
+            /// @param json - [in] - Request document.
+            /// @param node - [in] - Call object.
+            /// @param connection - [in] - Websocket id to deliver the result to, 0 for every websocket.
+            /// @param result - [out] - JSON result, the call id or the error.
+            /// @return HTTP status of the result, 202 when queued.
+            int QueueCall(const JsonIndex& json, int node, unsigned long connection, std::string& result);
+
+            /// @brief Handle JSON-RPC posted to /rpc.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            void HandleRpcRequest(mg_connection* conn, mg_http_message* hm);
+
+            /// @brief Handle a JSON-RPC 2.0 request or batch posted to /rpc or sent on a websocket.
+            ///        Published functions are methods called with positional params, along with the
+            ///        built in data.get and data.set. Responses to function calls wait for the call.
+            /// @param conn - [in] - Connection to respond on.
+            /// @param json - [in] - Request document, a parse error when it holds no root.
+            /// @param websocket - [in] - true to respond with a websocket message, false for HTTP.
+            void HandleRpc(mg_connection* conn, const JsonIndex& json, bool websocket);
+
+            /// @brief Process one JSON-RPC request of a batch.
+            /// @param json - [in] - Request document.
+            /// @param request - [in] - Request object.
+            /// @param batch - [in/out] - Batch the response slot is added to, unless a notification.
+            /// @param batchId - [in] - Id the batch is kept under while calls are pending.
+            void ProcessRpcRequest(const JsonIndex& json, int request, RpcBatch& batch, uint64_t batchId);
+
+            /// @brief Send the responses of a batch, nothing if it held only notifications.
+            /// @param conn - [in] - Connection to respond on.
+            /// @param batch - [in] - Batch to respond to.
+            void SendRpcResponse(mg_connection* conn, const RpcBatch& batch);
+
+            /// @brief JSON-RPC data.get, params {"names":[...]} or none for every viewable data.
+            int RpcDataGet(const JsonIndex& json, int params, std::string& result);
+
+            /// @brief JSON-RPC data.set, params {"edits":[...]} applied as one batch.
+            int RpcDataSet(const JsonIndex& json, int params, std::string& result);
+
+            /// @brief Append a JSON-RPC response.
+            /// @param out - [out] - Document to append to.
+            /// @param id - [in] - Request id token.
+            /// @param code - [in] - 0 for a result, otherwise the error code.
+            /// @param body - [in] - Result, or the error data with code set, empty for none.
+            static void AppendRpcResponse(std::string& out, std::string_view id, int code, const std::string& body);
+
+            /// @brief Find a published function that is not hidden.
+            /// @param name - [in] - Unique name, unescaped.
+            /// @return The function, nullptr if there is none by the name.
+            PublishedFunction* FindFunction(mg_str name);
+
+            /// @brief Give a call with its arguments parsed an id and queue it.
+            /// @param call - [in/out] - Call to queue, its id is set.
+            /// @param result - [out] - JSON result, the call id or the error.
+            /// @return HTTP status of the result, 202 when queued.
+            int SubmitCall(FunctionCall& call, std::string& result);
+
+            /// @brief Set a function error result.
+            /// @param result - [out] - JSON result to set.
+            /// @param status - [in] - HTTP status of the error.
+            /// @param error - [in] - Error text.
+            /// @param name - [in] - Function the error is about.
+            /// @return status
+            static int FunctionError(std::string& result, int status, const char* error, const std::string& name);
+
+            /// @brief Send the results of finished calls to their websockets. Server thread only.
+            void DeliverResults();
+
+            /// @brief Resolve the names query variable to viewable signals. Replies with an
+            ///        error when a name is missing or unknown.
+            /// @param conn - [in] - Mongoose connection to reply on.
+            /// @param hm - [in] - Request message.
+            /// @param sources - [out] - Signals in the order named.
+            /// @return -1 on error, 0 on success
+            int8_t ResolveSignals(mg_connection* conn, mg_http_message* hm, std::vector<SignalSource>& sources);
+
+            /// @brief Read the samples of a signal in a time window, from the recording being
+            ///        replayed if it has the signal, otherwise from graph history.
+            /// @param source - [in] - Signal to read.
+            /// @param since - [in] - Exclusive lower time bound in milliseconds.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param resolution - [in] - Coarsest bucket width acceptable, 0 for raw samples.
+            /// @param result - [out] - Samples read.
+            void ReadSignal(const SignalSource& source, uint64_t since, uint64_t until, uint64_t resolution, GraphQueryResult& result);
+
+            /// @brief Read the value of the newest sample of a signal at or before a time, from
+            ///        the same storage as ReadSignal.
+            /// @param source - [in] - Signal to read.
+            /// @param until - [in] - Inclusive upper time bound in milliseconds.
+            /// @param value - [out] - Value of the sample.
+            /// @return -1 if there is none, 0 on success
+            int8_t ReadSignalLast(const SignalSource& source, uint64_t until, double& value);
+
+            /// @brief Check if an access level allows viewing.
+            /// @param access - [in] - Access level to check.
+            /// @return true if the item can be viewed, false if not.
+            static bool IsViewable(Data::Access access);
+
+            /// @brief Check if an access level allows editing.
+            /// @param access - [in] - Access level to check.
+            /// @return true if the item can be edited, false if not.
+            static bool IsEditable(Data::Access access);
+
+            /// @brief Append a value returned by a published function, null when there is none.
+            /// @param out - [out] - Document to append to.
+            /// @param value - [in] - Value to append.
+            static void AppendJsonValue(std::string& out, const Data::Value& value);
+
+            /// @brief Append a string to a CSV file as one field, quoted when it needs to be.
+            /// @param out - [out] - File to append to.
+            /// @param value - [in] - String to append.
+            static void AppendCsvField(std::string& out, const std::string& value);
+
+            /// @brief Append the samples of many signals as CSV rows, one per distinct timestamp
+            ///        with an empty field where a signal has no sample at that time.
+            /// @param out - [out] - File to append to.
+            /// @param slices - [in] - Samples per signal, each ascending in time.
+            static void AppendCsvRows(std::string& out, const std::vector<GraphQueryResult>& slices);
+
+            /// @brief Append a base 128 varint.
+            /// @param out - [out] - Buffer to append to.
+            /// @param value - [in] - Value to append.
+            static void AppendVarint(std::string& out, uint64_t value);
+
+            /// @brief Get the length of text without an unfinished UTF-8 sequence at its end, so
+            ///        text frames never split a character.
+            /// @param text - [in] - Text read so far.
+            /// @param length - [in] - Text length.
+            /// @return Length up to the last complete character.
+            static size_t CompleteUtf8(const char* text, size_t length);
+
             /// @brief Event callback for the web server. 
             /// @param conn Mongoose connection
             /// @param event - [in] - event that is happening
@@ -237,9 +910,29 @@ namespace Essentials
                 {
                     // Event "open" happened.
                 }
-                else if (event == MG_EV_POLL)
+                else if (event == MG_EV_POLL || event == MG_EV_WRITE)
+                {
+                    // Queries and exports carry on as their send buffer drains
+                    server->ContinueQuery(conn);
+                    server->ContinueExport(conn);
+                }
+                else if (event == MG_EV_CLOSE)
                 {
-                    // Do nothing - just a heartbeart
+                    server->mQueries.erase(conn->id);
+                    server->mExports.erase(conn->id);
+                    server->mSubscriptions.RemoveConnection(conn->id);
+                    server->mPushScheduler.RemoveClient(conn->id);
+                    server->mDeflaters.erase(conn->id);
+#ifdef CPP_WEB_SERVER_TERMINAL
+                    server->DetachTerminalJobs(conn->id);
+                    server->KillShells(conn->id, false);
+#endif
+
+                    // Calls still running for a batch are answered nowhere
+                    for (auto batch = server->mRpcBatches.begin(); batch != server->mRpcBatches.end();)
+                    {
+                        batch = batch->second.connection == conn->id ? server->mRpcBatches.erase(batch) : std::next(batch);
+                    }
                 }
                 else if (event == MG_EV_HTTP_MSG)
                 {
@@ -248,14 +941,44 @@ namespace Essentials
                     if (mg_http_match_uri(hm, "/ws"))
                     {
                         // Upgrade to websocket..
-                        mg_ws_upgrade(conn, hm, NULL);
-                        server->mWebsocketConnetion = conn;
-                        server->mUpgraded = true;
+                        server->UpgradeWebsocket(conn, hm);
                     }
                     else if (mg_http_match_uri(hm, "/hello"))
                     {
                         mg_http_reply(conn, 200, "Content-Type: text/plain\r\n", "Hello, %s\n", "world");
                     }
+                    else if (mg_http_match_uri(hm, "/api/schema"))
+                    {
+                        server->HandleSchemaRequest(conn);
+                    }
+                    else if (mg_http_match_uri(hm, "/api/data"))
+                    {
+                        server->HandleDataRequest(conn);
+                    }
+                    else if (mg_http_match_uri(hm, "/api/graph/*"))
+                    {
+                        server->HandleGraphRequest(conn, hm);
+                    }
+                    else if (mg_http_match_uri(hm, "/api/query"))
+                    {
+                        server->HandleQueryRequest(conn, hm);
+                    }
+                    else if (mg_http_match_uri(hm, "/api/export"))
+                    {
+                        server->HandleExportRequest(conn, hm);
+                    }
+                    else if (mg_http_match_uri(hm, "/api/edit"))
+                    {
+                        server->HandleEditRequest(conn, hm);
+                    }
+                    else if (mg_http_match_uri(hm, "/api/invoke"))
+                    {
+                        server->HandleInvokeRequest(conn, hm);
+                    }
+                    else if (mg_http_match_uri(hm, "/rpc"))
+                    {
+                        server->HandleRpcRequest(conn, hm);
+                    }
                     else
                     {
                         struct mg_http_serve_opts opts;
@@ -267,13 +990,34 @@ namespace Essentials
                 else if (event == MG_EV_WS_MSG)
                 {
                     mg_ws_message* wm = (mg_ws_message*)eventData;
-                    std::string data = wm->data.ptr;
-#ifdef CPP_TERMINAL
-                    std::string result;
-                    if (server->mTerminal->ExecuteCommand(data, result) >= 0)
+                    mg_str message = wm->data;
+
+                    // A message that fails to inflate fails the connection
+                    if ((wm->flags & WEBSOCKET_FLAG_COMPRESSED) && !server->InflateMessage(conn, message))
+                    {
+                        mg_error(conn, "invalid compressed message");
+                        return;
+                    }
+
+                    // Binary frames and JSON documents are commands, anything else goes to the terminal
+                    if ((wm->flags & 0x0F) == WEBSOCKET_OP_BINARY)
+                    {
+                        server->HandleBinaryCommand(conn, message);
+                        return;
+                    }
+
+                    if (message.len > 0 && (message.ptr[0] == '{' || message.ptr[0] == '['))
                     {
-                        std::cout << result << std::endl;
-                        server->SendConsoleLog(result);
+                        server->HandleWebsocketCommand(conn, message);
+                        return;
+                    }
+
+                    // The message is not terminated, copy exactly its length
+                    std::string data(message.ptr, message.len);
+#ifdef CPP_WEB_SERVER_TERMINAL
+                    if (!server->WriteShell(conn, data))
+                    {
+                        server->StartTerminalCommand(conn, data);
                     }
 #else
                     server->SendConsoleLog("NOTICE: Terminal access not enabled");
@@ -281,6 +1025,61 @@ namespace Essentials
                 }
             }
 
+            /// @brief Callback for the wake up pipe, written by executor workers as calls finish.
+            /// @param conn - [in] - Pipe connection.
+            /// @param event - [in] - event that is happening
+            /// @param eventData - [in] - data for the event happening.
+            /// @param funcData - [in] - additional data.
+            static void wakeCallback(mg_connection* conn, int event, void* eventData, void* funcData)
+            {
+                (void)eventData;
+
+                if (event == MG_EV_READ)
+                {
+                    // The bytes only wake the poll, the results are on the executor
+                    conn->recv.len = 0;
+                    static_cast<Web_Server*>(funcData)->DeliverResults();
+                }
+            }
+
+#ifdef CPP_WEB_SERVER_TERMINAL
+            /// @brief Callback for the output and error streams of terminal commands.
+            /// @param conn - [in] - Stream connection.
+            /// @param event - [in] - event that is happening
+            /// @param eventData - [in] - data for the event happening.
+            /// @param funcData - [in] - additional data.
+            static void terminalCallback(mg_connection* conn, int event, void* eventData, void* funcData)
+            {
+                if (event == MG_EV_READ)
+                {
+                    static_cast<Web_Server*>(funcData)->RelayTerminalOutput(conn, static_cast<size_t>(*static_cast<long*>(eventData)), false);
+                }
+                else if (event == MG_EV_CLOSE)
+                {
+                    static_cast<Web_Server*>(funcData)->RelayTerminalOutput(conn, 0, true);
+                }
+            }
+
+            /// @brief Callback for the pseudo terminals of shells.
+            /// @param conn - [in] - Terminal connection.
+            /// @param event - [in] - event that is happening
+            /// @param eventData - [in] - data for the event happening.
+            /// @param funcData - [in] - additional data.
+            static void shellCallback(mg_connection* conn, int event, void* eventData, void* funcData)
+            {
+                (void)eventData;
+
+                if (event == MG_EV_READ)
+                {
+                    static_cast<Web_Server*>(funcData)->RelayShellOutput(conn, false);
+                }
+                else if (event == MG_EV_CLOSE)
+                {
+                    static_cast<Web_Server*>(funcData)->RelayShellOutput(conn, true);
+                }
+            }
+#endif
+
             std::string                     mAddress;               // Address to spawn the server on.
             int16_t                         mPort;                  // Port to spawn the server on.
             std::string                     mRootDirectory;         // Root directory for the server files. 
@@ -293,12 +1092,71 @@ namespace Essentials
             bool                            mUpgraded;              // flag for if the websocket has been upgraded. 
             static Web_Server*              mInstance;              // Pointer to the instance
             WebServerThreadPriority         mThreadPriority;        // Thread priority for windows.
-            std::vector<PublishedFunction>  mFunctions;             // Vector of published functions to the webpage. 
+            std::deque<PublishedFunction>   mFunctions;             // Published functions to the webpage, a deque so queued calls keep their address.
+            NameIndex                       mFunctionIndex;         // Position of each function in mFunctions.
             std::vector<PublishedData>      mDatas;                 // Vector of published data to the webpage. 
+            NameIndex                       mDataIndex;             // Position of each data in mDatas.
             std::vector<PublishedGraphData> mGraphDatas;            // Vector of published graph data to the webpage. 
+            uint32_t                        mNextItemId;            // Next id handed out to a published data or graph data.
+            std::vector<std::unique_ptr<GraphHistory>> mGraphHistories; // History per graph data, parallel to mGraphDatas.
+            std::mutex                      mHistoryMutex;          // Guards the graph lists between sampler and server threads.
+            uint32_t                        mGraphSampleRate;       // Default graph sample period in milliseconds.
+            std::vector<RollupTier>         mRollupTiers;           // Rollup tiers for new graph data.
+            bool                            mGraphCompression;      // Compress raw samples of new graph data.
+            std::string                     mHistoryPath;           // Persistent history file, empty for memory only.
+            HistoryFile                     mHistoryFile;           // Mapping backing the graph history rings.
+            SampleScheduler                 mScheduler;             // Samples items at their own period.
+            std::vector<ItemSample>         mLatestSamples;         // Most recent sample per item id.
+            std::mutex                      mSampleMutex;           // Guards the latest samples.
+            Recorder                        mRecorder;              // Columnar recording of samples.
+            RecordingReader                 mReplayReader;          // Recording played back, if any.
+            std::vector<uint64_t>           mReplayValues;          // Storage the replayed items publish from.
+            std::vector<SampleTarget>       mReplayTargets;         // Replayed item per recorded item index.
+            double                          mReplaySpeed;           // Playback rate.
+            std::thread                     mReplayThread;          // Plays the recording back.
+            bool                            mReplayStop;            // Asks the replay thread to finish.
+            std::mutex                      mReplayMutex;           // Guards mReplayStop.
+            std::condition_variable         mReplayCondition;       // Wakes the replay thread early.
+            std::atomic<uint64_t>           mReplayPosition;        // Timestamp of the last replayed sample.
+            std::map<unsigned long, QueryState> mQueries;           // Range queries in progress by connection id, server thread only.
+            std::map<unsigned long, ExportState> mExports;          // Exports in progress by connection id, server thread only.
+            std::mutex                      mDataMutex;             // Guards published data memory between edits, sampling and readers.
+            EditCallback                    mEditCallback;          // Told about each applied batch of edits.
+            FunctionExecutor                mExecutor;              // Runs published function calls off the server thread.
+            int                             mWakeSocket;            // Worker end of the wake up pipe, -1 until created.
+            uint64_t                        mNextCallId;            // Next id handed out to a queued call, server thread only.
+            std::vector<FunctionResult>     mFinishedCalls;         // Reused list of results being delivered.
+            std::unordered_map<std::string, RpcMethod, NameHash, std::equal_to<>> mRpcMethods; // JSON-RPC methods built in.
+            std::map<uint64_t, RpcBatch>    mRpcBatches;            // JSON-RPC batches waiting on calls by batch id, server thread only.
+            std::map<uint64_t, RpcCall>     mRpcCalls;              // JSON-RPC calls running by call id, server thread only.
+            uint64_t                        mNextRpcBatch;          // Next id handed out to a waiting batch.
+            SubscriptionTable               mSubscriptions;         // Websocket subscriptions, server thread only.
+            std::vector<const Subscription*> mDueSubscriptions;     // Reused list of subscriptions due.
+            PushScheduler                   mPushScheduler;         // Coalesces data updates into frames.
+            uint64_t                        mRecordSweep;           // Count of item record sweeps.
+            std::vector<uint64_t>           mItemSweep;             // Sweep each item was last encoded in, by item id.
+            std::vector<std::pair<size_t, size_t>> mItemRecord;     // Offset and length of each item's record in mItemRecords, by item id.
+            Binary::Writer                  mItemRecords;           // Items encoded this sweep as VALUES frame records.
+            Binary::Writer                  mSubscriptionWriter;    // Reused frame buffer for subscription and pushed updates.
+            int                             mDeflateLevel;          // zlib level for websocket messages, 0 when off.
+            size_t                          mDeflateThreshold;      // Smallest websocket message compressed.
+            std::unordered_map<unsigned long, std::unique_ptr<WebsocketDeflate>> mDeflaters; // Compressors of websockets that agreed to compression.
+            std::vector<uint8_t>            mDeflateBuffer;         // Reused compressed message buffer.
+            std::vector<uint8_t>            mInflateBuffer;         // Reused received message buffer.
+            std::vector<std::string>        mConsoleLogs;           // Console messages waiting for the server thread.
+            std::mutex                      mConsoleMutex;          // Guards mConsoleLogs.
+            JsonIndex                       mRequestJson;           // Reused index of the request being handled, server thread only.
+            JsonWriter                      mResponseWriter;        // Reused document of the response being built, server thread only.
 
-#ifdef CPP_TERMINAL
+#ifdef CPP_WEB_SERVER_TERMINAL
             Essentials::Utilities::Terminal* mTerminal;    
+            std::map<uint64_t, TerminalJob> mTerminalJobs;          // Terminal jobs running or kept by job id, server thread only.
+            uint64_t                        mNextTerminalJob;       // Next id handed out to a terminal job.
+            size_t                          mTerminalJobsMax;       // Most terminal jobs running at once.
+            size_t                          mTerminalJobOutput;     // Output kept per terminal job.
+            std::vector<ShellSession>       mShellSessions;         // Shells open, server thread only.
+            size_t                          mShellSessionsMax;      // Most shells open at once.
+            uint64_t                        mShellIdleTimeout;      // Idle time before a shell is closed, in milliseconds.
 #endif
 
 #ifdef CPP_LOGGER
@@ -0,0 +1,304 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       websocket_deflate.cpp
+//!
+//! @brief      Implementation of websocket permessage-deflate
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    "websocket_deflate.h"       // Websocket Deflate
+#include    <string_view>               // Header parsing
+#include    <charconv>                  // Window bits
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        /// @brief Remove surrounding spaces, tabs and quotes.
+        static std::string_view Trim(std::string_view text)
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '"'))
+            {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '"'))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        /// @brief Split off the text before a separator, leaving the rest.
+        static std::string_view NextToken(std::string_view& rest, char separator)
+        {
+            size_t end = rest.find(separator);
+            std::string_view token = rest.substr(0, end);
+            rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+            return Trim(token);
+        }
+
+        /// @brief Check the parameters of one offer, filling in those accepted.
+        static bool AcceptOffer(std::string_view offer, DeflateParameters& parameters)
+        {
+            if (NextToken(offer, ';') != "permessage-deflate")
+            {
+                return false;
+            }
+
+            parameters = { false, false, 15 };
+            while (!offer.empty())
+            {
+                std::string_view parameter = NextToken(offer, ';');
+                std::string_view name = NextToken(parameter, '=');
+                std::string_view value = Trim(parameter);
+
+                int bits = 15;
+                bool hasBits = !value.empty();
+                if (hasBits && (std::from_chars(value.data(), value.data() + value.size(), bits).ptr != value.data() + value.size() ||
+                    bits < 8 || bits > 15))
+                {
+                    return false;
+                }
+
+                if (name == "server_no_context_takeover" && !hasBits)
+                {
+                    parameters.serverNoContextTakeover = true;
+                }
+                else if (name == "client_no_context_takeover" && !hasBits)
+                {
+                    parameters.clientNoContextTakeover = true;
+                }
+                else if (name == "server_max_window_bits" && hasBits)
+                {
+                    // zlib raw streams cannot use a 256 byte window
+                    if (bits < 9)
+                    {
+                        return false;
+                    }
+                    parameters.serverMaxWindowBits = bits;
+                }
+                else if (name != "client_max_window_bits")
+                {
+                    // The client window is left at its default, inflate takes any size
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool NegotiateDeflate(mg_str offers, DeflateParameters& parameters, std::string& response)
+        {
+            std::string_view rest(offers.ptr, offers.len);
+            while (!rest.empty())
+            {
+                if (!AcceptOffer(NextToken(rest, ','), parameters))
+                {
+                    continue;
+                }
+
+                response = "permessage-deflate";
+                if (parameters.serverNoContextTakeover)
+                {
+                    response += "; server_no_context_takeover";
+                }
+                if (parameters.clientNoContextTakeover)
+                {
+                    response += "; client_no_context_takeover";
+                }
+                if (parameters.serverMaxWindowBits < 15)
+                {
+                    response += "; server_max_window_bits=" + std::to_string(parameters.serverMaxWindowBits);
+                }
+                return true;
+            }
+            return false;
+        }
+
+#ifdef CPP_WEBSOCKET_DEFLATE
+        WebsocketDeflate::WebsocketDeflate()
+        {
+            mDeflate = {};
+            mInflate = {};
+            mParameters = { false, false, 15 };
+            mStarted = false;
+        }
+
+        WebsocketDeflate::~WebsocketDeflate()
+        {
+            if (mStarted)
+            {
+                deflateEnd(&mDeflate);
+                inflateEnd(&mInflate);
+            }
+        }
+
+        int8_t WebsocketDeflate::Start(const DeflateParameters& parameters, int level)
+        {
+            if (mStarted || level < 1 || level > 9)
+            {
+                return -1;
+            }
+
+            // Negative window bits give raw deflate, without the zlib header and checksum
+            if (deflateInit2(&mDeflate, level, Z_DEFLATED, -parameters.serverMaxWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                return -1;
+            }
+            if (inflateInit2(&mInflate, -15) != Z_OK)
+            {
+                deflateEnd(&mDeflate);
+                return -1;
+            }
+
+            mParameters = parameters;
+            mStarted = true;
+            return 0;
+        }
+
+        bool WebsocketDeflate::Compress(const void* data, size_t size, std::vector<uint8_t>& out)
+        {
+            if (!mStarted)
+            {
+                return false;
+            }
+
+            // A flushed stream makes no progress on empty input, RFC 7692 sends an empty stored block
+            if (size == 0)
+            {
+                out.assign(1, 0x00);
+                return true;
+            }
+
+            out.resize(deflateBound(&mDeflate, static_cast<uLong>(size)) + 16);
+            mDeflate.next_in = static_cast<Bytef*>(const_cast<void*>(data));
+            mDeflate.avail_in = static_cast<uInt>(size);
+            mDeflate.next_out = out.data();
+            mDeflate.avail_out = static_cast<uInt>(out.size());
+
+            // A sync flush ends the message on a byte boundary with an empty stored block
+            int result = deflate(&mDeflate, Z_SYNC_FLUSH);
+            size_t used = out.size() - mDeflate.avail_out;
+            if (result != Z_OK || mDeflate.avail_in != 0 || used < 4)
+            {
+                deflateReset(&mDeflate);
+                return false;
+            }
+
+            // The empty block's 00 00 FF FF tail is implied by the protocol
+            out.resize(used - 4);
+
+            if (mParameters.serverNoContextTakeover)
+            {
+                deflateReset(&mDeflate);
+            }
+            return true;
+        }
+
+        bool WebsocketDeflate::Decompress(const void* data, size_t size, std::vector<uint8_t>& out)
+        {
+            static const uint8_t tail[4] = { 0x00, 0x00, 0xFF, 0xFF };
+            if (!mStarted)
+            {
+                return false;
+            }
+
+            // One byte over the maximum tells a message of exactly the maximum from a longer one
+            const size_t limit = WEBSOCKET_INFLATE_MAX + 1;
+            out.resize(size * 4 + 64 < limit ? size * 4 + 64 : limit);
+            size_t used = 0;
+
+            // The payload, then the tail the sender removed
+            const uint8_t* inputs[2] = { static_cast<const uint8_t*>(data), tail };
+            size_t sizes[2] = { size, sizeof(tail) };
+            for (int i = 0; i < 2; i++)
+            {
+                mInflate.next_in = const_cast<Bytef*>(inputs[i]);
+                mInflate.avail_in = static_cast<uInt>(sizes[i]);
+                // A full buffer may leave output held inside zlib even once the input is used up
+                while (mInflate.avail_in > 0 || used == out.size())
+                {
+                    if (used == out.size())
+                    {
+                        if (out.size() >= limit)
+                        {
+                            inflateReset(&mInflate);
+                            return false;
+                        }
+                        out.resize(out.size() * 2 < limit ? out.size() * 2 : limit);
+                    }
+
+                    mInflate.next_out = out.data() + used;
+                    mInflate.avail_out = static_cast<uInt>(out.size() - used);
+                    int result = inflate(&mInflate, Z_SYNC_FLUSH);
+                    used = out.size() - mInflate.avail_out;
+                    if (result == Z_STREAM_END)
+                    {
+                        // A final block closes the sender's stream, the next message starts a new one
+                        inflateReset(&mInflate);
+                    }
+                    else if (result == Z_BUF_ERROR && mInflate.avail_in == 0 && mInflate.avail_out > 0)
+                    {
+                        // Nothing was held back
+                        break;
+                    }
+                    else if (result != Z_OK && !(result == Z_BUF_ERROR && mInflate.avail_out == 0))
+                    {
+                        inflateReset(&mInflate);
+                        return false;
+                    }
+                }
+            }
+
+            out.resize(used);
+            if (mParameters.clientNoContextTakeover)
+            {
+                inflateReset(&mInflate);
+            }
+            return true;
+        }
+#else
+        WebsocketDeflate::WebsocketDeflate()
+        {
+            mParameters = { false, false, 15 };
+            mStarted = false;
+        }
+
+        WebsocketDeflate::~WebsocketDeflate()
+        {
+        }
+
+        int8_t WebsocketDeflate::Start(const DeflateParameters& parameters, int level)
+        {
+            // Built without zlib, messages are never compressed
+            (void)parameters;
+            (void)level;
+            return -1;
+        }
+
+        bool WebsocketDeflate::Compress(const void* data, size_t size, std::vector<uint8_t>& out)
+        {
+            (void)data;
+            (void)size;
+            out.clear();
+            return false;
+        }
+
+        bool WebsocketDeflate::Decompress(const void* data, size_t size, std::vector<uint8_t>& out)
+        {
+            (void)data;
+            (void)size;
+            out.clear();
+            return false;
+        }
+#endif
+    } // End Communications
+} // End Essentials
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       websocket_deflate.h
+//!
+//! @brief      permessage-deflate (RFC 7692) negotiation and per connection
+//!             compression contexts for websocket messages.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdint.h>                         // Standard integer types
+#include <string>                           // Negotiated header
+#include <vector>                           // Message buffers
+#include "../Mongoose/mongoose.h"           // mg_str
+#ifdef CPP_WEBSOCKET_DEFLATE
+#include <zlib.h>                           // Deflate streams
+#endif
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_WEBSOCKET_DEFLATE_HEADER    // Define the websocket deflate header.
+#define     CPP_WEBSOCKET_DEFLATE_HEADER
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Communications
+    {
+        const static int    WEBSOCKET_DEFLATE_LEVEL     = 1;                // Default zlib level, 0 sends uncompressed
+        const static size_t WEBSOCKET_DEFLATE_THRESHOLD = 256;              // Default smallest message compressed, in bytes
+        const static size_t WEBSOCKET_INFLATE_MAX       = 4 * 1024 * 1024;  // Largest inflated message accepted
+        const static uint8_t WEBSOCKET_FLAG_COMPRESSED  = 0x40;             // RSV1, set on compressed messages
+
+        /// @brief Parameters agreed for one connection.
+        struct DeflateParameters
+        {
+            bool    serverNoContextTakeover;    // Reset the server compressor after every message
+            bool    clientNoContextTakeover;    // Client resets its compressor after every message
+            int     serverMaxWindowBits;        // Server window size, 9 to 15
+        };
+
+        /// @brief Choose the first permessage-deflate offer that can be accepted.
+        /// @param offers - [in] - Value of the client's Sec-WebSocket-Extensions header.
+        /// @param parameters - [out] - Parameters of the accepted offer.
+        /// @param response - [out] - Extension to answer with, without the header name.
+        /// @return false if no offer is acceptable, true on success.
+        bool NegotiateDeflate(mg_str offers, DeflateParameters& parameters, std::string& response);
+
+        /// @brief Compression contexts of one connection. With context takeover the
+        ///        window carries from message to message, so repeated keys and values in
+        ///        successive pushes compress to back references. Server thread only.
+        class WebsocketDeflate
+        {
+        public:
+            WebsocketDeflate();
+            ~WebsocketDeflate();
+
+            WebsocketDeflate(const WebsocketDeflate&) = delete;
+            WebsocketDeflate& operator=(const WebsocketDeflate&) = delete;
+
+            /// @brief Create the compression contexts.
+            /// @param parameters - [in] - Negotiated parameters.
+            /// @param level - [in] - zlib level, 1 to 9.
+            /// @return -1 on error, 0 on success
+            int8_t Start(const DeflateParameters& parameters, int level);
+
+            /// @brief Compress one message payload.
+            /// @param data - [in] - Message payload.
+            /// @param size - [in] - Payload size.
+            /// @param out - [out] - Compressed payload, replaced.
+            /// @return false on error, true on success.
+            bool Compress(const void* data, size_t size, std::vector<uint8_t>& out);
+
+            /// @brief Decompress one message payload received with RSV1 set.
+            /// @param data - [in] - Compressed payload.
+            /// @param size - [in] - Payload size.
+            /// @param out - [out] - Message payload, replaced.
+            /// @return false if the payload is invalid or inflates past WEBSOCKET_INFLATE_MAX, true on success.
+            bool Decompress(const void* data, size_t size, std::vector<uint8_t>& out);
+
+        private:
+#ifdef CPP_WEBSOCKET_DEFLATE
+            z_stream            mDeflate;       // Outgoing messages
+            z_stream            mInflate;       // Incoming messages
+#endif
+            DeflateParameters   mParameters;    // Negotiated parameters
+            bool                mStarted;       // true once the streams are created
+        };
+    } // End Communications
+} // End Essentials
+
+#endif // CPP_WEBSOCKET_DEFLATE_HEADER
@@ -19,6 +19,29 @@
 
 #include "mongoose.h"
 
+// x86-64 always has SSE2, wider instruction sets are chosen at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define MG_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MG_TARGET_AVX2
+#else
+#define MG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Index of the lowest set bit of a non zero mask
+static unsigned mg_ctz(unsigned mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (unsigned) index;
+#else
+  return (unsigned) __builtin_ctz(mask);
+#endif
+}
+#endif
+
 #ifdef MG_ENABLE_LINES
 #line 1 "src/base64.c"
 #endif
@@ -1511,9 +1534,27 @@ int mg_url_decode(const char *src, size_t src_len, char *dst, size_t dst_len,
 
 static bool isok(uint8_t c) { return c == '\n' || c == '\r' || c >= ' '; }
 
+// Index of the first control character, below ' ', at or after i. Only those
+// end lines or make a request invalid, so the rest is skipped 16 at a time.
+static size_t mg_http_skip_text(const unsigned char *buf, size_t i,
+                                size_t len) {
+#ifdef MG_SIMD_X86
+  const __m128i limit = _mm_set1_epi8(0x1f);
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *) (buf + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, limit), v));
+    if (mask != 0) return i + mg_ctz((unsigned) mask);
+  }
+#endif
+  while (i < len && buf[i] >= ' ') i++;
+  return i;
+}
+
 int mg_http_get_request_len(const unsigned char *buf, size_t buf_len) {
   size_t i;
   for (i = 0; i < buf_len; i++) {
+    i = mg_http_skip_text(buf, i, buf_len);
+    if (i >= buf_len) break;
     if (!isok(buf[i])) return -1;
     if ((i > 0 && buf[i] == '\n' && buf[i - 1] == '\n') ||
         (i > 3 && buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n'))
@@ -1531,8 +1572,48 @@ static const char *skip(const char *s, const char *e, const char *d,
   return s;
 }
 
+// Case insensitive FNV-1a hash of a header name
+static size_t mg_http_header_hash(const char *name, size_t len) {
+  uint32_t hash = 2166136261U;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash ^= (uint8_t) (name[i] | 0x20);
+    hash *= 16777619U;
+  }
+  return (size_t) (hash ^ (hash >> 16)) & (MG_HTTP_INDEX_SIZE - 1);
+}
+
+// Hash the header names once per message. Only the first header of a name is
+// indexed, as that is the one the linear search found.
+static void mg_http_index_headers(struct mg_http_message *h) {
+  size_t i, max = sizeof(h->headers) / sizeof(h->headers[0]);
+  memset(h->header_index, 0, sizeof(h->header_index));
+  for (i = 0; i < max && h->headers[i].name.len > 0; i++) {
+    struct mg_str *k = &h->headers[i].name;
+    size_t slot = mg_http_header_hash(k->ptr, k->len);
+    while (h->header_index[slot] != 0) {
+      struct mg_str *e = &h->headers[h->header_index[slot] - 1].name;
+      if (e->len == k->len && mg_ncasecmp(e->ptr, k->ptr, k->len) == 0) break;
+      slot = (slot + 1) & (MG_HTTP_INDEX_SIZE - 1);
+    }
+    if (h->header_index[slot] == 0) h->header_index[slot] = (uint8_t) (i + 1);
+  }
+  h->header_indexed = true;
+}
+
 struct mg_str *mg_http_get_header(struct mg_http_message *h, const char *name) {
   size_t i, n = strlen(name), max = sizeof(h->headers) / sizeof(h->headers[0]);
+  if (h->header_indexed) {
+    size_t slot = mg_http_header_hash(name, n);
+    while (h->header_index[slot] != 0) {
+      struct mg_http_header *e = &h->headers[h->header_index[slot] - 1];
+      if (n == e->name.len && mg_ncasecmp(e->name.ptr, name, n) == 0) {
+        return &e->value;
+      }
+      slot = (slot + 1) & (MG_HTTP_INDEX_SIZE - 1);
+    }
+    return NULL;
+  }
   for (i = 0; i < max && h->headers[i].name.len > 0; i++) {
     struct mg_str *k = &h->headers[i].name, *v = &h->headers[i].value;
     if (n == k->len && mg_ncasecmp(k->ptr, name, n) == 0) return v;
@@ -1545,9 +1626,19 @@ static void mg_http_parse_headers(const char *s, const char *end,
   int i;
   for (i = 0; i < max_headers; i++) {
     struct mg_str k, v, tmp;
-    const char *he = skip(s, end, "\n", &tmp);
+    // Lines and values are found with memchr, long values like cookies and
+    // user agents are not walked a byte at a time
+    const char *nl = (const char *) memchr(s, '\n', (size_t) (end - s));
+    const char *le = nl == NULL ? end : nl, *he = le, *ve;
+    tmp = mg_str_n(s, (size_t) (le - s));
+    while (he < end && *he == '\n') he++;
     s = skip(s, he, ": \r\n", &k);
-    s = skip(s, he, "\r\n", &v);
+    ve = s < le ? (const char *) memchr(s, '\r', (size_t) (le - s)) : s;
+    if (ve == NULL) ve = le;
+    v = mg_str_n(s, (size_t) (ve - s));
+    // A stray CR ends the value, the next header starts after it
+    s = ve;
+    while (s < he && (*s == '\r' || *s == '\n')) s++;
     if (k.len == tmp.len) continue;
     while (v.len > 0 && v.ptr[v.len - 1] == ' ') v.len--;  // Trim spaces
     if (k.len == 0) break;
@@ -1589,6 +1680,7 @@ int mg_http_parse(const char *s, size_t len, struct mg_http_message *hm) {
 
   mg_http_parse_headers(s, end, hm->headers,
                         sizeof(hm->headers) / sizeof(hm->headers[0]));
+  mg_http_index_headers(hm);
   if ((cl = mg_http_get_header(hm, "Content-Length")) != NULL) {
     hm->body.len = (size_t) mg_to64(*cl);
     hm->message.len = (size_t) req_len + hm->body.len;
@@ -1652,7 +1744,7 @@ void mg_http_write_chunk(struct mg_connection *c, const char *buf, size_t len) {
 }
 
 // clang-format off
-static const char *mg_http_status_code_str(int status_code) {
+const char *mg_http_status_code_str(int status_code) {
   switch (status_code) {
     case 100: return "Continue";
     case 201: return "Created";
@@ -1666,6 +1758,7 @@ static const char *mg_http_status_code_str(int status_code) {
     case 401: return "Unauthorized";
     case 403: return "Forbidden";
     case 404: return "Not Found";
+    case 414: return "URI Too Long";
     case 418: return "I'm a teapot";
     case 500: return "Internal Server Error";
     case 501: return "Not Implemented";
@@ -3537,6 +3630,8 @@ void mg_mgr_free(struct mg_mgr *mgr) {
 
 void mg_mgr_init(struct mg_mgr *mgr) {
   memset(mgr, 0, sizeof(*mgr));
+  // Picked here, so threads running their own managers never share a write
+  mgr->ws_mask = mg_ws_mask_select();
 #if MG_ENABLE_EPOLL
   if ((mgr->epoll_fd = epoll_create1(0)) < 0) MG_ERROR(("epoll: %d", errno));
 #else
@@ -4092,6 +4187,10 @@ long mg_io_send(struct mg_connection *c, const void *buf, size_t len) {
     n = send(FD(c), (char *) buf, len, MSG_NONBLOCKING);
 #if MG_ARCH == MG_ARCH_RTX
     if (n == EWOULDBLOCK) return MG_IO_WAIT;
+#endif
+#if MG_ARCH == MG_ARCH_UNIX
+    // Descriptors wrapped with mg_wrapfd() may be terminals rather than sockets
+    if (n < 0 && errno == ENOTSOCK) n = write(FD(c), buf, len);
 #endif
   }
   if (n < 0 && mg_sock_would_block()) return MG_IO_WAIT;
@@ -4210,6 +4309,9 @@ long mg_io_recv(struct mg_connection *c, void *buf, size_t len) {
     if (n > 0) tomgaddr(&usa, &c->rem, slen != sizeof(usa.sin));
   } else {
     n = recv(FD(c), (char *) buf, len, MSG_NONBLOCKING);
+#if MG_ARCH == MG_ARCH_UNIX
+    if (n < 0 && errno == ENOTSOCK) n = read(FD(c), buf, len);
+#endif
   }
   if (n < 0 && mg_sock_would_block()) return MG_IO_WAIT;
   if (n < 0 && mg_sock_conn_reset()) return MG_IO_RESET;
@@ -5643,6 +5745,114 @@ struct ws_msg {
   size_t data_len;
 };
 
+// Masking XORs the payload with the 4 byte key repeated from the first byte.
+// Wide blocks repeat the key too, so blocks of 8, 16 and 32 bytes keep the key
+// in phase. x86-64 always has SSE2, AVX2 is used when the CPU reports it.
+
+static size_t ws_mask_words(uint8_t *buf, size_t len, const uint8_t mask[4]) {
+  uint64_t key, word;
+  size_t i = 0;
+  memcpy(&key, mask, 4);
+  memcpy((uint8_t *) &key + 4, mask, 4);
+  for (; i + 8 <= len; i += 8) {
+    memcpy(&word, buf + i, 8);
+    word ^= key;
+    memcpy(buf + i, &word, 8);
+  }
+  return i;
+}
+
+static void ws_mask_scalar(uint8_t *buf, size_t len, const uint8_t mask[4]) {
+  size_t i = ws_mask_words(buf, len, mask);
+  for (; i < len; i++) buf[i] ^= mask[i & 3];
+}
+
+#ifdef MG_SIMD_X86
+static void ws_mask_sse2(uint8_t *buf, size_t len, const uint8_t mask[4]) {
+  int32_t word;
+  __m128i key;
+  size_t i = 0;
+  memcpy(&word, mask, 4);
+  key = _mm_set1_epi32(word);
+  for (; i + 64 <= len; i += 64) {
+    __m128i a = _mm_loadu_si128((const __m128i *) (buf + i));
+    __m128i b = _mm_loadu_si128((const __m128i *) (buf + i + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *) (buf + i + 32));
+    __m128i d = _mm_loadu_si128((const __m128i *) (buf + i + 48));
+    _mm_storeu_si128((__m128i *) (buf + i), _mm_xor_si128(a, key));
+    _mm_storeu_si128((__m128i *) (buf + i + 16), _mm_xor_si128(b, key));
+    _mm_storeu_si128((__m128i *) (buf + i + 32), _mm_xor_si128(c, key));
+    _mm_storeu_si128((__m128i *) (buf + i + 48), _mm_xor_si128(d, key));
+  }
+  for (; i + 16 <= len; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *) (buf + i));
+    _mm_storeu_si128((__m128i *) (buf + i), _mm_xor_si128(a, key));
+  }
+  ws_mask_scalar(buf + i, len - i, mask);
+}
+
+MG_TARGET_AVX2
+static void ws_mask_avx2(uint8_t *buf, size_t len, const uint8_t mask[4]) {
+  int32_t word;
+  __m256i key;
+  size_t i = 0;
+  memcpy(&word, mask, 4);
+  key = _mm256_set1_epi32(word);
+  for (; i + 128 <= len; i += 128) {
+    __m256i a = _mm256_loadu_si256((const __m256i *) (buf + i));
+    __m256i b = _mm256_loadu_si256((const __m256i *) (buf + i + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *) (buf + i + 64));
+    __m256i d = _mm256_loadu_si256((const __m256i *) (buf + i + 96));
+    _mm256_storeu_si256((__m256i *) (buf + i), _mm256_xor_si256(a, key));
+    _mm256_storeu_si256((__m256i *) (buf + i + 32), _mm256_xor_si256(b, key));
+    _mm256_storeu_si256((__m256i *) (buf + i + 64), _mm256_xor_si256(c, key));
+    _mm256_storeu_si256((__m256i *) (buf + i + 96), _mm256_xor_si256(d, key));
+  }
+  for (; i + 32 <= len; i += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *) (buf + i));
+    _mm256_storeu_si256((__m256i *) (buf + i), _mm256_xor_si256(a, key));
+  }
+  // Leave AVX state clean, SSE code run with dirty upper lanes stalls
+  _mm256_zeroupper();
+  ws_mask_scalar(buf + i, len - i, mask);
+}
+
+static bool ws_cpu_has_avx2(void) {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  // OSXSAVE and AVX, with the OS saving the YMM registers
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+  if ((_xgetbv(0) & 6) != 6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+mg_ws_mask_fn_t mg_ws_mask_select(void) {
+#ifdef MG_SIMD_X86
+  return ws_cpu_has_avx2() ? ws_mask_avx2 : ws_mask_sse2;
+#else
+  return ws_mask_scalar;
+#endif
+}
+
+void mg_ws_mask_buf(struct mg_mgr *mgr, uint8_t *buf, size_t len,
+                    const uint8_t mask[4]) {
+  // Short control frames are not worth a call through the pointer
+  if (len < 16 || mgr == NULL || mgr->ws_mask == NULL) {
+    ws_mask_scalar(buf, len, mask);
+  } else {
+    mgr->ws_mask(buf, len, mask);
+  }
+}
+
 size_t mg_ws_vprintf(struct mg_connection *c, int op, const char *fmt,
                      va_list *ap) {
   size_t len = c->send.len;
@@ -5691,8 +5901,9 @@ static uint32_t be32(const uint8_t *p) {
          (((uint32_t) p[1]) << 16) | (((uint32_t) p[0]) << 24);
 }
 
-static size_t ws_process(uint8_t *buf, size_t len, struct ws_msg *msg) {
-  size_t i, n = 0, mask_len = 0;
+static size_t ws_process(struct mg_mgr *mgr, uint8_t *buf, size_t len,
+                         struct ws_msg *msg) {
+  size_t n = 0, mask_len = 0;
   memset(msg, 0, sizeof(*msg));
   if (len >= 2) {
     n = buf[1] & 0x7f;                // Frame length
@@ -5716,7 +5927,7 @@ static size_t ws_process(uint8_t *buf, size_t len, struct ws_msg *msg) {
   if (msg->header_len + msg->data_len > len) return 0;
   if (mask_len > 0) {
     uint8_t *p = buf + msg->header_len, *m = p - mask_len;
-    for (i = 0; i < msg->data_len; i++) p[i] ^= m[i & 3];
+    mg_ws_mask_buf(mgr, p, msg->data_len, m);
   }
   return msg->header_len + msg->data_len;
 }
@@ -5751,9 +5962,8 @@ static size_t mkhdr(size_t len, int op, bool is_client, uint8_t *buf) {
 
 static void mg_ws_mask(struct mg_connection *c, size_t len) {
   if (c->is_client && c->send.buf != NULL) {
-    size_t i;
     uint8_t *p = c->send.buf + c->send.len - len, *mask = p - 4;
-    for (i = 0; i < len; i++) p[i] ^= mask[i & 3];
+    mg_ws_mask_buf(c->mgr, p, len, mask);
   }
 }
 
@@ -5797,7 +6007,8 @@ static void mg_ws_cb(struct mg_connection *c, int ev, void *ev_data,
   if (ev == MG_EV_READ) {
     if (c->is_client && !c->is_websocket && mg_ws_client_handshake(c)) return;
 
-    while (ws_process(c->recv.buf + ofs, c->recv.len - ofs, &msg) > 0) {
+    while (ws_process(c->mgr, c->recv.buf + ofs, c->recv.len - ofs, &msg) >
+           0) {
       char *s = (char *) c->recv.buf + ofs + msg.header_len;
       struct mg_ws_message m = {{s, msg.data_len}, msg.flags};
       size_t len = msg.header_len + msg.data_len;
@@ -675,6 +675,15 @@ struct timeval {
 #define MG_MAX_HTTP_HEADERS 30
 #endif
 
+// Slots of the header name index, a power of two at least twice the headers
+#if MG_MAX_HTTP_HEADERS > 127
+#error "MG_MAX_HTTP_HEADERS must be at most 127"
+#elif MG_MAX_HTTP_HEADERS > 32
+#define MG_HTTP_INDEX_SIZE 256
+#else
+#define MG_HTTP_INDEX_SIZE 64
+#endif
+
 #ifndef MG_HTTP_INDEX
 #define MG_HTTP_INDEX "index.html"
 #endif
@@ -1027,6 +1036,8 @@ struct mg_addr {
   bool is_ip6;      // True when address is IPv6 address
 };
 
+typedef void (*mg_ws_mask_fn_t)(uint8_t *buf, size_t len, const uint8_t *mask);
+
 struct mg_mgr {
   struct mg_connection *conns;  // List of active connections
   struct mg_dns dns4;           // DNS for IPv4
@@ -1042,6 +1053,7 @@ struct mg_mgr {
   int epoll_fd;                 // Used when MG_EPOLL_ENABLE=1
   void *priv;                   // Used by the MIP stack
   size_t extraconnsize;         // Used by the MIP stack
+  mg_ws_mask_fn_t ws_mask;      // Websocket mask kernel, picked at init
 #if MG_ENABLE_FREERTOS_TCP
   SocketSet_t ss;  // NOTE(lsm): referenced from socket struct
 #endif
@@ -1129,6 +1141,8 @@ struct mg_http_message {
   struct mg_str head;                                  // Request + headers
   struct mg_str chunk;    // Chunk for chunked encoding,  or partial body
   struct mg_str message;  // Request + headers + body
+  uint8_t header_index[MG_HTTP_INDEX_SIZE];  // Header number + 1 by name hash
+  bool header_indexed;    // header_index is filled in by mg_http_parse()
 };
 
 // Parameter for mg_http_serve_dir()
@@ -1163,6 +1177,7 @@ void mg_http_serve_file(struct mg_connection *, struct mg_http_message *hm,
                         const char *path, const struct mg_http_serve_opts *);
 void mg_http_reply(struct mg_connection *, int status_code, const char *headers,
                    const char *body_fmt, ...);
+const char *mg_http_status_code_str(int status_code);
 struct mg_str *mg_http_get_header(struct mg_http_message *, const char *name);
 struct mg_str mg_http_var(struct mg_str buf, struct mg_str name);
 int mg_http_get_var(const struct mg_str *, const char *name, char *, size_t);
@@ -1259,6 +1274,9 @@ void mg_ws_upgrade(struct mg_connection *, struct mg_http_message *,
                    const char *fmt, ...);
 size_t mg_ws_send(struct mg_connection *, const void *buf, size_t len, int op);
 size_t mg_ws_wrap(struct mg_connection *, size_t len, int op);
+mg_ws_mask_fn_t mg_ws_mask_select(void);
+void mg_ws_mask_buf(struct mg_mgr *, uint8_t *buf, size_t len,
+                    const uint8_t mask[4]);
 size_t mg_ws_printf(struct mg_connection *c, int op, const char *fmt, ...);
 size_t mg_ws_vprintf(struct mg_connection *c, int op, const char *fmt,
                      va_list *);
@@ -0,0 +1,195 @@
+// Decoder for the binary websocket frames sent by the web server.
+// See binary_protocol.h for the frame layout.
+var BinaryProtocol = (function () {
+    var VERSION = 1;
+    var FrameType = { VALUES: 1, SAMPLES: 2, GORILLA: 3 };
+
+    // Data::Type ids in declaration order
+    var DataType = {
+        NONE: 0, CHAR: 1, UCHAR: 2, SHORT: 3, USHORT: 4, INT: 5,
+        UINT: 6, DOUBLE: 7, FLOAT: 8, STRING: 9, BOOL: 10
+    };
+
+    var textDecoder = new TextDecoder('utf-8');
+
+    function Reader(buffer) {
+        this.view = new DataView(buffer);
+        this.bytes = new Uint8Array(buffer);
+        this.offset = 0;
+    }
+
+    Reader.prototype.u8 = function () {
+        return this.view.getUint8(this.offset++);
+    };
+
+    Reader.prototype.varint = function () {
+        var result = 0, scale = 1, byte;
+        do {
+            byte = this.bytes[this.offset++];
+            result += (byte & 0x7f) * scale;
+            scale *= 128;
+        } while (byte & 0x80);
+        return result;
+    };
+
+    Reader.prototype.u64 = function () {
+        var low = this.view.getUint32(this.offset, true);
+        var high = this.view.getUint32(this.offset + 4, true);
+        this.offset += 8;
+        return high * 4294967296 + low;
+    };
+
+    Reader.prototype.value = function (type) {
+        var v, o = this.offset, view = this.view;
+        switch (type) {
+            case DataType.CHAR: v = view.getInt8(o); this.offset += 1; break;
+            case DataType.UCHAR: v = view.getUint8(o); this.offset += 1; break;
+            case DataType.BOOL: v = view.getUint8(o) !== 0; this.offset += 1; break;
+            case DataType.SHORT: v = view.getInt16(o, true); this.offset += 2; break;
+            case DataType.USHORT: v = view.getUint16(o, true); this.offset += 2; break;
+            case DataType.INT: v = view.getInt32(o, true); this.offset += 4; break;
+            case DataType.UINT: v = view.getUint32(o, true); this.offset += 4; break;
+            case DataType.FLOAT: v = view.getFloat32(o, true); this.offset += 4; break;
+            case DataType.DOUBLE: v = view.getFloat64(o, true); this.offset += 8; break;
+            case DataType.STRING:
+                var len = this.varint();
+                v = textDecoder.decode(this.bytes.subarray(this.offset, this.offset + len));
+                this.offset += len;
+                break;
+            default: v = null;
+        }
+        return v;
+    };
+
+    // Reads gorilla block bits most significant first, see gorilla_codec.h.
+    function BitReader(bytes, offset, length) {
+        this.bytes = bytes;
+        this.position = offset * 8;
+        this.end = (offset + length) * 8;
+    }
+
+    // Read up to 53 bits as a Number
+    BitReader.prototype.bits = function (count) {
+        if (this.position + count > this.end) {
+            throw new Error('Gorilla block truncated');
+        }
+        var result = 0;
+        while (count > 0) {
+            var space = 8 - (this.position & 7);
+            var take = count < space ? count : space;
+            var chunk = (this.bytes[this.position >> 3] >> (space - take)) & ((1 << take) - 1);
+            result = result * (1 << take) + chunk;
+            this.position += take;
+            count -= take;
+        }
+        return result;
+    };
+
+    // Read up to 64 bits as a BigInt
+    BitReader.prototype.bigBits = function (count) {
+        var high = count > 32 ? this.bits(count - 32) : 0;
+        var low = this.bits(count > 32 ? 32 : count);
+        return (BigInt(high) << 32n) | BigInt(low);
+    };
+
+    var scratch = new DataView(new ArrayBuffer(8));
+    var DOD_WIDTHS = [0, 7, 9, 12, 64];
+
+    // Decode one block of count samples into the output arrays from index at.
+    function decodeBlock(bits, count, timestamps, values, at) {
+        var time = 0, delta = 0, value = 0n, leading = 0, trailing = 0;
+        for (var i = 0; i < count; i++) {
+            if (i === 0) {
+                time = Number(bits.bigBits(64));
+                value = bits.bigBits(64);
+            } else {
+                var ones = 0;
+                while (ones < 4 && bits.bits(1) === 1) {
+                    ones++;
+                }
+                var dod = 0;
+                if (ones === 4) {
+                    dod = Number(BigInt.asIntN(64, bits.bigBits(64)));
+                } else if (ones > 0) {
+                    var width = DOD_WIDTHS[ones];
+                    dod = bits.bits(width);
+                    if (dod >= Math.pow(2, width - 1)) {
+                        dod -= Math.pow(2, width);
+                    }
+                }
+                delta += dod;
+                time += delta;
+
+                if (bits.bits(1) === 1) {
+                    if (bits.bits(1) === 1) {
+                        leading = bits.bits(5);
+                        var significant = bits.bits(6) || 64;
+                        trailing = 64 - leading - significant;
+                    }
+                    value ^= bits.bigBits(64 - leading - trailing) << BigInt(trailing);
+                }
+            }
+            scratch.setBigUint64(0, value);
+            timestamps[at + i] = time;
+            values[at + i] = scratch.getFloat64(0);
+        }
+    }
+
+    // Decode a frame into { version, type, items } for VALUES frames, where each
+    // item is { id, type, value }, or { version, type, series } for SAMPLES frames,
+    // where each series is { id, type, timestamps, values }. GORILLA frames decode
+    // into the same series shape as SAMPLES frames.
+    function decode(buffer) {
+        var r = new Reader(buffer);
+        var frame = { version: r.u8(), type: r.u8() };
+        if (frame.version !== VERSION) {
+            throw new Error('Unsupported binary protocol version ' + frame.version);
+        }
+
+        var count = r.varint(), i, j;
+        if (frame.type === FrameType.VALUES) {
+            frame.items = new Array(count);
+            for (i = 0; i < count; i++) {
+                var id = r.varint(), type = r.u8();
+                frame.items[i] = { id: id, type: type, value: r.value(type) };
+            }
+        } else if (frame.type === FrameType.SAMPLES) {
+            frame.series = new Array(count);
+            for (i = 0; i < count; i++) {
+                var sid = r.varint(), stype = r.u8(), n = r.varint();
+                var time = r.u64();
+                var timestamps = new Float64Array(n);
+                var values = new Array(n);
+                for (j = 0; j < n; j++) {
+                    time += r.varint();
+                    timestamps[j] = time;
+                    values[j] = r.value(stype);
+                }
+                frame.series[i] = { id: sid, type: stype, timestamps: timestamps, values: values };
+            }
+        } else if (frame.type === FrameType.GORILLA) {
+            frame.series = new Array(count);
+            for (i = 0; i < count; i++) {
+                var gid = r.varint(), gtype = r.u8(), blocks = r.varint();
+                var sizes = [], offsets = [], counts = [], total = 0;
+                for (j = 0; j < blocks; j++) {
+                    counts.push(r.varint());
+                    sizes.push(r.varint());
+                    offsets.push(r.offset);
+                    r.offset += sizes[j];
+                    total += counts[j];
+                }
+                var gtimes = new Float64Array(total);
+                var gvalues = new Float64Array(total);
+                for (j = 0, total = 0; j < blocks; j++) {
+                    decodeBlock(new BitReader(r.bytes, offsets[j], sizes[j]), counts[j], gtimes, gvalues, total);
+                    total += counts[j];
+                }
+                frame.series[i] = { id: gid, type: gtype, timestamps: gtimes, values: gvalues };
+            }
+        }
+        return frame;
+    }
+
+    return { VERSION: VERSION, FrameType: FrameType, DataType: DataType, decode: decode };
+})();
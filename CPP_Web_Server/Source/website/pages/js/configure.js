@@ -0,0 +1,136 @@
+var configureRows = document.getElementById('configure-rows');
+var configureApply = document.getElementById('configure-apply');
+var configureReload = document.getElementById('configure-reload');
+var configureStatus = document.getElementById('configure-status');
+
+// Range of each integer type, the server rejects values outside them
+var integerRanges = {
+    'char': [-128, 127],
+    'unsigned char': [0, 255],
+    'short': [-32768, 32767],
+    'unsigned short': [0, 65535],
+    'int': [-2147483648, 2147483647],
+    'unsigned int': [0, 4294967295],
+};
+
+// Build an input suited to the item type holding its current value
+function createEditor(item, value) {
+    var input = document.createElement('input');
+    input.name = item.name;
+
+    if (item.type === 'bool') {
+        input.type = 'checkbox';
+        input.checked = value === true;
+        input.dataset.original = String(input.checked);
+        return input;
+    }
+
+    if (item.type === 'string') {
+        input.type = 'text';
+    } else {
+        input.type = 'number';
+        var range = integerRanges[item.type];
+        if (range) {
+            input.min = range[0];
+            input.max = range[1];
+            input.step = 1;
+        } else {
+            input.step = 'any';
+        }
+    }
+
+    input.value = value === undefined || value === null ? '' : String(value);
+    input.dataset.original = input.value;
+    return input;
+}
+
+// Get the text of an input as the server parses it
+function editorValue(input) {
+    return input.type === 'checkbox' ? String(input.checked) : input.value;
+}
+
+// List every editable published data with its current value
+function loadConfiguration() {
+    configureStatus.textContent = '';
+    Promise.all([
+        fetch('/api/schema').then(function (response) { return response.json(); }),
+        fetch('/api/data').then(function (response) { return response.json(); }),
+    ]).then(function (results) {
+        var schema = results[0], values = results[1];
+        configureRows.innerHTML = '';
+
+        schema.items.forEach(function (item) {
+            if (item.kind !== 'data' || (item.access !== 'edit' && item.access !== 'view_edit')) {
+                return;
+            }
+
+            var row = document.createElement('tr');
+            var name = document.createElement('td');
+            var editor = document.createElement('td');
+            var type = document.createElement('td');
+            var description = document.createElement('td');
+
+            name.textContent = item.name;
+            editor.appendChild(createEditor(item, values[item.name]));
+            type.textContent = item.type;
+            description.textContent = item.description;
+
+            row.appendChild(name);
+            row.appendChild(editor);
+            row.appendChild(type);
+            row.appendChild(description);
+            configureRows.appendChild(row);
+        });
+
+        if (!configureRows.children.length) {
+            configureStatus.textContent = 'Nothing is editable.';
+        }
+    }).catch(function (error) {
+        configureStatus.textContent = 'Failed to load: ' + error;
+    });
+}
+
+// Send every changed value as one batch, the server applies all of them or none
+configureApply.onclick = function () {
+    var inputs = configureRows.querySelectorAll('input');
+    var edits = [];
+
+    inputs.forEach(function (input) {
+        input.classList.remove('configure-invalid');
+        if (editorValue(input) !== input.dataset.original) {
+            edits.push({ name: input.name, value: editorValue(input) });
+        }
+    });
+
+    if (!edits.length) {
+        configureStatus.textContent = 'No changes.';
+        return;
+    }
+
+    fetch('/api/edit', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({ edits: edits }),
+    }).then(function (response) {
+        return response.json();
+    }).then(function (result) {
+        if (result.error) {
+            configureStatus.textContent = result.name ? result.error + ': ' + result.name : result.error;
+            inputs.forEach(function (input) {
+                if (input.name === result.name) {
+                    input.classList.add('configure-invalid');
+                }
+            });
+            return;
+        }
+
+        inputs.forEach(function (input) { input.dataset.original = editorValue(input); });
+        configureStatus.textContent = 'Applied ' + result.applied + (result.applied === 1 ? ' change.' : ' changes.');
+    }).catch(function (error) {
+        configureStatus.textContent = 'Failed to apply: ' + error;
+    });
+};
+
+configureReload.onclick = loadConfiguration;
+
+loadConfiguration();
@@ -11,11 +11,16 @@ connect.onclick = function () {
     if (ws) { ws.close(); return; }
     ws = new WebSocket(url.value);
     if (!ws) return;
+    ws.binaryType = 'arraybuffer';
 
     ws.onopen = function () {
         console.innerHTML += 'CONNECTION OPENED<br/>';
     }
     ws.onmessage = function (ev) {
+        if (ev.data instanceof ArrayBuffer) {
+            onBinaryFrame(BinaryProtocol.decode(ev.data));
+            return;
+        }
         console.innerHTML += 'RECEIVED: ' + ev.data + '<br/>';
         scrollToBottom();
     }
@@ -39,4 +44,18 @@ send.onclick = function () {
 // Function to scroll the div to the bottom over the dashboard console log
 function scrollToBottom() {
     logElement.scrollTop = logElement.scrollHeight;
-}
\ No newline at end of file
+}
+
+// Latest decoded value of every published item, keyed by item id
+var latestValues = {};
+
+// Handle a decoded binary frame from the server
+function onBinaryFrame(frame) {
+    if (frame.type === BinaryProtocol.FrameType.VALUES) {
+        frame.items.forEach(function (item) { latestValues[item.id] = item.value; });
+    } else if (frame.type === BinaryProtocol.FrameType.SAMPLES) {
+        frame.series.forEach(function (series) {
+            latestValues[series.id] = series.values[series.values.length - 1];
+        });
+    }
+}
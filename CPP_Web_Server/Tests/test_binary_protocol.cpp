@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_binary_protocol.cpp
+//!
+//! @brief      Tests of binary websocket frames, written and read back
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // memcmp
+#include    <cfloat>                    // Float limits
+#include    <climits>                   // Integer limits
+#include    <string>                    // String values
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/binary_protocol.h"    // Binary Protocol
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Write a value into a frame, read it back into another of the same type.
+template <typename T>
+static bool ValueRoundTrip(Data::Type type, T value)
+{
+    Binary::Writer writer;
+    writer.Begin(Binary::FrameType::VALUES);
+    writer.PutValue(type, &value);
+    const std::vector<uint8_t>& frame = writer.Buffer();
+
+    // The fixed buffer encoding lays the value out the same
+    uint8_t encoded[64];
+    size_t size = Binary::EncodeValue(type, &value, encoded, sizeof(encoded));
+    if (size != frame.size() - 7 || memcmp(encoded, frame.data() + 7, size) != 0)
+    {
+        return false;
+    }
+
+    T parsed{};
+    Binary::Reader reader(frame.data() + 7, frame.size() - 7);
+    return reader.GetValue(type, &parsed) && parsed == value && reader.Remaining() == 0;
+}
+
+static void TestValues()
+{
+    CHECK(ValueRoundTrip<char>(Data::Type::CHAR, CHAR_MIN));
+    CHECK(ValueRoundTrip<unsigned char>(Data::Type::UCHAR, UCHAR_MAX));
+    CHECK(ValueRoundTrip<short>(Data::Type::SHORT, SHRT_MIN));
+    CHECK(ValueRoundTrip<unsigned short>(Data::Type::USHORT, USHRT_MAX));
+    CHECK(ValueRoundTrip<int>(Data::Type::INT, INT_MIN));
+    CHECK(ValueRoundTrip<int>(Data::Type::INT, -1));
+    CHECK(ValueRoundTrip<unsigned int>(Data::Type::UINT, UINT_MAX));
+    CHECK(ValueRoundTrip<float>(Data::Type::FLOAT, -FLT_MAX));
+    CHECK(ValueRoundTrip<double>(Data::Type::DOUBLE, DBL_MIN));
+    CHECK(ValueRoundTrip<double>(Data::Type::DOUBLE, -0.0));
+    CHECK(ValueRoundTrip<bool>(Data::Type::BOOL, true));
+    CHECK(ValueRoundTrip<bool>(Data::Type::BOOL, false));
+    CHECK(ValueRoundTrip<std::string>(Data::Type::STRING, ""));
+    CHECK(ValueRoundTrip<std::string>(Data::Type::STRING, std::string("a\0b", 3)));
+
+    // Values are little-endian on any host
+    Binary::Writer writer;
+    writer.Begin(Binary::FrameType::VALUES);
+    int value = 0x01020304;
+    writer.PutValue(Data::Type::INT, &value);
+    const uint8_t expected[4] = { 0x04, 0x03, 0x02, 0x01 };
+    CHECK(memcmp(writer.Buffer().data() + 7, expected, 4) == 0);
+
+    // Long strings take a longer length prefix, and must fit whole
+    std::string text(300, 's');
+    uint8_t encoded[302];
+    CHECK(Binary::EncodeValue(Data::Type::STRING, &text, encoded, sizeof(encoded)) == 302);
+    CHECK(encoded[0] == 0xAC && encoded[1] == 0x02);
+    CHECK(Binary::EncodeValue(Data::Type::STRING, &text, encoded, sizeof(encoded) - 1) == 0);
+    CHECK(Binary::EncodeValue(Data::Type::DOUBLE, &value, encoded, 7) == 0);
+    CHECK(Binary::EncodeValue(Data::Type::NONE, &value, encoded, sizeof(encoded)) == 0);
+    CHECK(Binary::FixedSize(Data::Type::STRING) == 0);
+}
+
+static void TestVarints()
+{
+    const uint64_t values[] = { 0, 1, 127, 128, 16383, 16384, 0xFFFFFFFFull, 1ull << 63, UINT64_MAX };
+    Binary::Writer writer;
+    writer.Begin(Binary::FrameType::VALUES);
+    for (uint64_t value : values)
+    {
+        writer.PutVarint(value);
+    }
+
+    const std::vector<uint8_t>& frame = writer.Buffer();
+    Binary::Reader reader(frame.data() + 7, frame.size() - 7);
+    for (uint64_t value : values)
+    {
+        uint64_t parsed = 0;
+        CHECK(reader.GetVarint(parsed) && parsed == value);
+    }
+    CHECK(reader.Remaining() == 0);
+
+    uint64_t parsed = 0;
+    const uint8_t truncated[] = { 0x80, 0x80 };
+    Binary::Reader shortReader(truncated, sizeof(truncated));
+    CHECK(!shortReader.GetVarint(parsed));
+
+    // Eleven bytes, or a tenth byte carrying more than the top bit, do not fit 64 bits
+    const uint8_t tooLong[11] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x81, 0x00 };
+    Binary::Reader longReader(tooLong, sizeof(tooLong));
+    CHECK(!longReader.GetVarint(parsed));
+    const uint8_t overflow[10] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 };
+    Binary::Reader overflowReader(overflow, sizeof(overflow));
+    CHECK(!overflowReader.GetVarint(parsed));
+}
+
+static void TestFrames()
+{
+    // VALUES: the count is patched into its slot once the items are known
+    Binary::Writer writer;
+    writer.Begin(Binary::FrameType::VALUES);
+    int count = 42;
+    std::string name = "pump";
+    bool on = true;
+    writer.AddValue(1, Data::Type::INT, &count);
+    writer.AddValue(300, Data::Type::STRING, &name);
+    writer.AddValue(2, Data::Type::BOOL, &on);
+    const std::vector<uint8_t>& values = writer.Finish(3);
+
+    Binary::Reader reader(values.data(), values.size());
+    uint8_t version = 0;
+    uint8_t type = 0;
+    uint64_t items = 0;
+    CHECK(reader.GetU8(version) && version == Binary::PROTOCOL_VERSION);
+    CHECK(reader.GetU8(type) && type == static_cast<uint8_t>(Binary::FrameType::VALUES));
+    CHECK(reader.GetVarint(items) && items == 3);
+
+    uint64_t id = 0;
+    uint8_t itemType = 0;
+    int parsedCount = 0;
+    std::string parsedName;
+    bool parsedOn = false;
+    CHECK(reader.GetVarint(id) && id == 1 && reader.GetU8(itemType) && itemType == static_cast<uint8_t>(Data::Type::INT));
+    CHECK(reader.GetValue(Data::Type::INT, &parsedCount) && parsedCount == 42);
+    CHECK(reader.GetVarint(id) && id == 300 && reader.GetU8(itemType) && itemType == static_cast<uint8_t>(Data::Type::STRING));
+    CHECK(reader.GetValue(Data::Type::STRING, &parsedName) && parsedName == "pump");
+    CHECK(reader.GetVarint(id) && id == 2 && reader.GetU8(itemType));
+    CHECK(reader.GetValue(Data::Type::BOOL, &parsedOn) && parsedOn);
+    CHECK(reader.Remaining() == 0);
+    CHECK(!reader.GetU8(type));
+
+    // SAMPLES: times are deltas from a base, values take the item's type
+    const uint64_t times[4] = { 1700000000000ull, 1700000000010ull, 1700000000010ull, 1700000300000ull };
+    const double samples[4] = { 1.9, -2.0, 3.0, 70000.0 };
+    writer.Begin(Binary::FrameType::SAMPLES);
+    writer.AddSeries(7, Data::Type::SHORT, times, samples, 4);
+    writer.AddSeries(8, Data::Type::DOUBLE, times, samples, 0);
+    const std::vector<uint8_t>& series = writer.Finish(2);
+
+    Binary::Reader samplesReader(series.data() + 2, series.size() - 2);
+    uint64_t seriesCount = 0;
+    uint64_t n = 0;
+    const uint8_t* base = nullptr;
+    CHECK(samplesReader.GetVarint(seriesCount) && seriesCount == 2);
+    CHECK(samplesReader.GetVarint(id) && id == 7 && samplesReader.GetU8(itemType));
+    CHECK(samplesReader.GetVarint(n) && n == 4);
+    CHECK(samplesReader.GetBytes(8, base));
+    uint64_t time = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        time |= static_cast<uint64_t>(base[i]) << (i * 8);
+    }
+    const short expected[4] = { 1, -2, 3, static_cast<short>(70000) };
+    for (int i = 0; i < 4; i++)
+    {
+        uint64_t delta = 0;
+        short value = 0;
+        CHECK(samplesReader.GetVarint(delta));
+        time += delta;
+        CHECK(time == times[i]);
+        CHECK(samplesReader.GetValue(Data::Type::SHORT, &value) && value == expected[i]);
+    }
+    CHECK(samplesReader.GetVarint(id) && id == 8 && samplesReader.GetU8(itemType));
+    CHECK(samplesReader.GetVarint(n) && n == 0);
+    CHECK(samplesReader.GetBytes(8, base) && samplesReader.Remaining() == 0);
+
+    // A new frame starts from scratch
+    writer.Begin(Binary::FrameType::INVOKE, 0);
+    CHECK(writer.Finish(0).size() == 7);
+}
+
+static void TestTruncated()
+{
+    std::string text = "truncated";
+    Binary::Writer writer;
+    writer.Begin(Binary::FrameType::VALUES);
+    writer.PutValue(Data::Type::STRING, &text);
+    const std::vector<uint8_t>& frame = writer.Buffer();
+
+    // Every shorter read fails instead of running past the end
+    for (size_t size = 7; size < frame.size(); size++)
+    {
+        std::string parsed;
+        Binary::Reader reader(frame.data() + 7, size - 7);
+        CHECK(!reader.GetValue(Data::Type::STRING, &parsed));
+    }
+
+    double value = 0.0;
+    Binary::Reader reader(frame.data(), 7);
+    CHECK(!reader.GetValue(Data::Type::DOUBLE, &value));
+    CHECK(!reader.GetValue(Data::Type::NONE, &value));
+    const uint8_t* bytes = nullptr;
+    CHECK(!reader.GetBytes(8, bytes));
+    CHECK(reader.GetBytes(7, bytes) && reader.Remaining() == 0);
+}
+
+int main()
+{
+    TestValues();
+    TestVarints();
+    TestFrames();
+    TestTruncated();
+    return Essentials::Tests::Result();
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_check.h
+//!
+//! @brief      Checks shared by the unit tests. Each test is its own program,
+//!             a failed check prints where it failed and the program returns
+//!             non zero for ctest.
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include <stdio.h>                          // Failure reports
+//
+//    Defines:
+//          name                        reason defined
+//          --------------------        ---------------------------------------
+#ifndef     CPP_TEST_CHECK                  // Define the test check header.
+#define     CPP_TEST_CHECK
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Tests
+    {
+        /// @brief Number of checks failed so far in this program.
+        inline int& Failures()
+        {
+            static int failures = 0;
+            return failures;
+        }
+
+        /// @brief Record the outcome of one check.
+        /// @param passed - [in] - Outcome of the check.
+        /// @param text - [in] - The checked expression.
+        /// @param file - [in] - File of the check.
+        /// @param line - [in] - Line of the check.
+        inline void Check(bool passed, const char* text, const char* file, int line)
+        {
+            if (!passed)
+            {
+                fprintf(stderr, "%s:%d: check failed: %s\n", file, line, text);
+                Failures()++;
+            }
+        }
+
+        /// @brief Summarise the checks, the result is the program's exit code.
+        /// @return 1 if any check failed, 0 otherwise.
+        inline int Result()
+        {
+            if (Failures() > 0)
+            {
+                fprintf(stderr, "%d check(s) failed\n", Failures());
+                return 1;
+            }
+            return 0;
+        }
+    } // End Tests
+} // End Essentials
+
+#define CHECK(condition) Essentials::Tests::Check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#endif // CPP_TEST_CHECK
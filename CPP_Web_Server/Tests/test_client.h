@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_client.h
+//!
+//! @brief      Blocking HTTP and websocket clients for tests that talk to a
+//!             running server
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+#pragma once
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <chrono>                    // Deadline
+#include    <string>                    // Requests and replies
+#include    "../Source/Mongoose/mongoose.h"     // Mongoose
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace Essentials
+{
+    namespace Tests
+    {
+        /// @brief Reply to one request, status 0 if none arrived.
+        struct HttpReply
+        {
+            int             status = 0;     // HTTP status code
+            std::string     body;           // Reply body
+        };
+
+        /// @brief Request state shared with the event handler.
+        struct HttpExchange
+        {
+            std::string     request;        // Raw request sent once connected
+            HttpReply       reply;          // Reply received
+            bool            done = false;   // Reply received or connection failed
+        };
+
+        inline void HttpHandler(mg_connection* conn, int ev, void* ev_data, void* fn_data)
+        {
+            HttpExchange* exchange = static_cast<HttpExchange*>(fn_data);
+            if (ev == MG_EV_CONNECT)
+            {
+                mg_send(conn, exchange->request.data(), exchange->request.size());
+            }
+            else if (ev == MG_EV_HTTP_MSG)
+            {
+                mg_http_message* hm = static_cast<mg_http_message*>(ev_data);
+                exchange->reply.status = mg_http_status(hm);
+                exchange->reply.body.assign(hm->body.ptr, hm->body.len);
+                exchange->done = true;
+                conn->is_closing = 1;
+            }
+            else if (ev == MG_EV_ERROR || ev == MG_EV_CLOSE)
+            {
+                exchange->done = true;
+            }
+        }
+
+        /// @brief Send a request and wait for the reply.
+        /// @param host - [in] - Server url, such as "http://127.0.0.1:8080".
+        /// @param method - [in] - Request method.
+        /// @param uri - [in] - Path and query, sent as given.
+        /// @param body - [in] - Request body, none if empty.
+        /// @param timeoutMilliseconds - [in] - Time to wait for the reply.
+        /// @return reply, status 0 if none arrived in time.
+        inline HttpReply HttpRequest(const std::string& host, const std::string& method, const std::string& uri,
+                                     const std::string& body, int timeoutMilliseconds = 5000)
+        {
+            HttpExchange exchange;
+            exchange.request = method + " " + uri + " HTTP/1.1\r\nHost: test\r\nConnection: close\r\n";
+            if (!body.empty())
+            {
+                exchange.request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+            }
+            exchange.request += "\r\n" + body;
+
+            mg_mgr manager;
+            mg_mgr_init(&manager);
+            mg_http_connect(&manager, host.c_str(), HttpHandler, &exchange);
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+            while (!exchange.done && std::chrono::steady_clock::now() < deadline)
+            {
+                mg_mgr_poll(&manager, 10);
+            }
+            mg_mgr_free(&manager);
+
+            return exchange.reply;
+        }
+
+        /// @brief Send a GET and wait for the reply.
+        inline HttpReply HttpGet(const std::string& host, const std::string& uri, int timeoutMilliseconds = 5000)
+        {
+            return HttpRequest(host, "GET", uri, "", timeoutMilliseconds);
+        }
+
+        /// @brief Post a body and wait for the reply.
+        inline HttpReply HttpPost(const std::string& host, const std::string& uri, const std::string& body, int timeoutMilliseconds = 5000)
+        {
+            return HttpRequest(host, "POST", uri, body, timeoutMilliseconds);
+        }
+
+        /// @brief Websocket connection polled by the caller, every message received kept in one transcript.
+        class WebsocketClient
+        {
+        public:
+            WebsocketClient()
+            {
+                mg_mgr_init(&mManager);
+            }
+
+            ~WebsocketClient()
+            {
+                mg_mgr_free(&mManager);
+            }
+
+            WebsocketClient(const WebsocketClient&) = delete;
+            WebsocketClient& operator=(const WebsocketClient&) = delete;
+
+            /// @brief Connect and wait for the upgrade.
+            /// @param url - [in] - Websocket url, such as "ws://127.0.0.1:8080/ws".
+            /// @param timeoutMilliseconds - [in] - Time to wait for the upgrade.
+            /// @return true once upgraded.
+            bool Connect(const std::string& url, int timeoutMilliseconds = 5000)
+            {
+                mConnection = mg_ws_connect(&mManager, url.c_str(), Handler, this, NULL);
+                Poll([this]() { return mOpen || mClosed; }, timeoutMilliseconds);
+                return mOpen && !mClosed;
+            }
+
+            /// @brief Send a text message.
+            void Send(const std::string& text)
+            {
+                if (mConnection != nullptr)
+                {
+                    mg_ws_send(mConnection, text.data(), text.size(), WEBSOCKET_OP_TEXT);
+                }
+                mg_mgr_poll(&mManager, 0);
+            }
+
+            /// @brief Wait for text to arrive after what earlier waits matched.
+            /// @param text - [in] - Text to look for, messages are searched back to back.
+            /// @param timeoutMilliseconds - [in] - Time to wait for it.
+            /// @return the transcript from the match on, empty if it did not arrive in time.
+            std::string WaitFor(const std::string& text, int timeoutMilliseconds = 5000)
+            {
+                size_t found = std::string::npos;
+                Poll([&]() { return (found = mTranscript.find(text, mMatched)) != std::string::npos; }, timeoutMilliseconds);
+                if (found == std::string::npos)
+                {
+                    return "";
+                }
+
+                mMatched = found + text.size();
+                return mTranscript.substr(found);
+            }
+
+            /// @brief Close the connection and wait for it to go.
+            void Close()
+            {
+                if (mConnection != nullptr)
+                {
+                    mConnection->is_closing = 1;
+                }
+                Poll([this]() { return mClosed; }, 1000);
+            }
+
+            /// @brief Check whether the server closed the connection.
+            bool IsClosed() const
+            {
+                return mClosed;
+            }
+
+        private:
+            template <typename Done>
+            void Poll(Done done, int timeoutMilliseconds)
+            {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMilliseconds);
+                while (!done() && std::chrono::steady_clock::now() < deadline)
+                {
+                    mg_mgr_poll(&mManager, 10);
+                }
+            }
+
+            static void Handler(mg_connection* conn, int ev, void* ev_data, void* fn_data)
+            {
+                WebsocketClient* client = static_cast<WebsocketClient*>(fn_data);
+                if (ev == MG_EV_WS_OPEN)
+                {
+                    client->mOpen = true;
+                }
+                else if (ev == MG_EV_WS_MSG)
+                {
+                    mg_ws_message* wm = static_cast<mg_ws_message*>(ev_data);
+                    client->mTranscript.append(wm->data.ptr, wm->data.len);
+                }
+                else if (ev == MG_EV_ERROR || ev == MG_EV_CLOSE)
+                {
+                    client->mClosed = true;
+                    if (client->mConnection == conn)
+                    {
+                        client->mConnection = nullptr;
+                    }
+                }
+            }
+
+            mg_mgr              mManager;                   // Manager of this connection only
+            mg_connection*      mConnection = nullptr;      // Connection, null once closed
+            bool                mOpen = false;              // Upgrade completed
+            bool                mClosed = false;            // Connection closed or failed
+            std::string         mTranscript;                // Every message received, back to back
+            size_t              mMatched = 0;               // End of the last match in the transcript
+        };
+    }
+}
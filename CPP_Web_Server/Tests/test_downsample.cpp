@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_downsample.cpp
+//!
+//! @brief      Tests of graph series reduction, each kernel at its edges
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <cmath>                     // sin
+#include    <vector>                    // Series
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/downsample.h"     // Downsample
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief A wave with one spike up and one spike down.
+static void MakeSeries(size_t count, std::vector<uint64_t>& times, std::vector<double>& values)
+{
+    times.clear();
+    values.clear();
+    for (size_t i = 0; i < count; i++)
+    {
+        times.push_back(1000 + i * 10);
+        values.push_back(std::sin(static_cast<double>(i) / 50.0));
+    }
+    values[count / 3] = 100.0;
+    values[2 * count / 3] = -100.0;
+}
+
+/// @brief Check a reduced series is a time ordered subset of the original.
+static bool IsSubset(const std::vector<uint64_t>& times, const std::vector<double>& values,
+                     const std::vector<uint64_t>& outTimes, const std::vector<double>& outValues)
+{
+    if (outTimes.size() != outValues.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < outTimes.size(); i++)
+    {
+        if (i > 0 && outTimes[i] <= outTimes[i - 1])
+        {
+            return false;
+        }
+
+        size_t index = static_cast<size_t>((outTimes[i] - 1000) / 10);
+        if (index >= times.size() || times[index] != outTimes[i] || values[index] != outValues[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief Check a reduced series holds a value.
+static bool Holds(const std::vector<double>& values, double value)
+{
+    for (double v : values)
+    {
+        if (v == value)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void TestMinMax()
+{
+    std::vector<uint64_t> times;
+    std::vector<double> values;
+    std::vector<uint64_t> outTimes;
+    std::vector<double> outValues;
+    MakeSeries(1000, times, values);
+
+    // Never more than the target, and both spikes survive
+    for (size_t target = 1; target <= 64; target++)
+    {
+        Downsample::MinMax(times.data(), values.data(), times.size(), target, outTimes, outValues);
+        CHECK(!outTimes.empty() && outTimes.size() <= target);
+        CHECK(IsSubset(times, values, outTimes, outValues));
+        CHECK(Holds(outValues, 100.0));
+        CHECK(target < 2 || Holds(outValues, -100.0));
+    }
+
+    // A target of 0, or one the series already fits, keeps every sample
+    Downsample::MinMax(times.data(), values.data(), times.size(), 0, outTimes, outValues);
+    CHECK(outTimes == times && outValues == values);
+    Downsample::MinMax(times.data(), values.data(), times.size(), times.size(), outTimes, outValues);
+    CHECK(outTimes == times && outValues == values);
+    Downsample::MinMax(times.data(), values.data(), 0, 10, outTimes, outValues);
+    CHECK(outTimes.empty() && outValues.empty());
+}
+
+static void TestLTTB()
+{
+    std::vector<uint64_t> times;
+    std::vector<double> values;
+    std::vector<uint64_t> outTimes;
+    std::vector<double> outValues;
+    MakeSeries(1000, times, values);
+
+    // Exactly the target, first and last kept, and both spikes survive
+    for (size_t target = 3; target <= 64; target++)
+    {
+        Downsample::LTTB(times.data(), values.data(), times.size(), target, outTimes, outValues);
+        CHECK(outTimes.size() == target);
+        CHECK(IsSubset(times, values, outTimes, outValues));
+        CHECK(outTimes.front() == times.front() && outTimes.back() == times.back());
+        CHECK(target < 4 || (Holds(outValues, 100.0) && Holds(outValues, -100.0)));
+    }
+
+    // Below 3 there is no bucket between the ends
+    Downsample::LTTB(times.data(), values.data(), times.size(), 1, outTimes, outValues);
+    CHECK(outTimes.size() == 1 && outTimes[0] == times.front() && outValues[0] == values.front());
+    Downsample::LTTB(times.data(), values.data(), times.size(), 2, outTimes, outValues);
+    CHECK(outTimes.size() == 2 && outTimes[0] == times.front() && outTimes[1] == times.back());
+
+    Downsample::LTTB(times.data(), values.data(), times.size(), 0, outTimes, outValues);
+    CHECK(outTimes == times && outValues == values);
+    Downsample::LTTB(times.data(), values.data(), 5, 10, outTimes, outValues);
+    CHECK(outTimes.size() == 5 && outTimes.back() == times[4]);
+}
+
+static void TestMergeBuckets()
+{
+    std::vector<uint64_t> times;
+    std::vector<double> values;
+    std::vector<double> minimums;
+    std::vector<double> maximums;
+    for (int i = 0; i < 10; i++)
+    {
+        times.push_back(i * 100);
+        values.push_back(i);
+        minimums.push_back(i - 0.5);
+        maximums.push_back(i + 0.5);
+    }
+
+    // Ten buckets into three of 3, 3 and 4
+    Downsample::MergeBuckets(3, times, values, minimums, maximums);
+    CHECK(times.size() == 3 && values.size() == 3 && minimums.size() == 3 && maximums.size() == 3);
+    CHECK(times[0] == 0 && times[1] == 300 && times[2] == 600);
+    CHECK(values[0] == 1.0 && values[1] == 4.0 && values[2] == 7.5);
+    CHECK(minimums[0] == -0.5 && minimums[2] == 5.5);
+    CHECK(maximums[0] == 2.5 && maximums[2] == 9.5);
+
+    // Fewer buckets than the target, or no target, are left alone
+    Downsample::MergeBuckets(5, times, values, minimums, maximums);
+    CHECK(times.size() == 3);
+    Downsample::MergeBuckets(0, times, values, minimums, maximums);
+    CHECK(times.size() == 3);
+    Downsample::MergeBuckets(1, times, values, minimums, maximums);
+    CHECK(times.size() == 1 && times[0] == 0 && minimums[0] == -0.5 && maximums[0] == 9.5);
+}
+
+static void TestApply()
+{
+    std::vector<uint64_t> times;
+    std::vector<double> values;
+    MakeSeries(500, times, values);
+
+    Downsample::Apply(Downsample::Mode::NONE, 10, times, values);
+    CHECK(times.size() == 500);
+    Downsample::Apply(Downsample::Mode::MINMAX, 11, times, values);
+    CHECK(times.size() <= 10 && times.size() == values.size() && Holds(values, 100.0));
+
+    MakeSeries(500, times, values);
+    Downsample::Apply(Downsample::Mode::LTTB, 10, times, values);
+    CHECK(times.size() == 10 && values.size() == 10);
+    Downsample::Apply(Downsample::Mode::LTTB, 20, times, values);
+    CHECK(times.size() == 10);
+
+    CHECK(Downsample::ModeFromName("minmax") == Downsample::Mode::MINMAX);
+    CHECK(Downsample::ModeFromName("lttb") == Downsample::Mode::LTTB);
+    CHECK(Downsample::ModeFromName("LTTB") == Downsample::Mode::NONE);
+}
+
+int main()
+{
+    TestMinMax();
+    TestLTTB();
+    TestMergeBuckets();
+    TestApply();
+    return Essentials::Tests::Result();
+}
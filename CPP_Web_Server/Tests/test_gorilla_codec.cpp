@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_gorilla_codec.cpp
+//!
+//! @brief      Tests of gorilla block compression, encoded and decoded back
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // memcpy
+#include    <cmath>                     // Special values
+#include    <limits>                    // Special values
+#include    <vector>                    // Samples
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/gorilla_codec.h"  // Gorilla Codec
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Get the bits of a double, so NaN payloads and signed zeros compare exactly.
+static uint64_t Bits(double value)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/// @brief Get a double from its bits.
+static double FromBits(uint64_t bits)
+{
+    double value = 0.0;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// @brief Small deterministic generator, the same on every platform.
+static uint64_t Random(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/// @brief Encode samples into one block and decode them back.
+static bool RoundTrip(const std::vector<uint64_t>& timestamps, const std::vector<double>& values, size_t* size = nullptr)
+{
+    Gorilla::Encoder encoder;
+    for (size_t i = 0; i < timestamps.size(); i++)
+    {
+        encoder.Append(timestamps[i], values[i]);
+    }
+    if (encoder.Count() != timestamps.size())
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> block = encoder.Take();
+    if (size != nullptr)
+    {
+        *size = block.size();
+    }
+
+    Gorilla::Decoder decoder(block.data(), block.size(), static_cast<uint32_t>(timestamps.size()));
+    for (size_t i = 0; i < timestamps.size(); i++)
+    {
+        uint64_t timestamp = 0;
+        double value = 0.0;
+        if (!decoder.Next(timestamp, value) || timestamp != timestamps[i] || Bits(value) != Bits(values[i]))
+        {
+            return false;
+        }
+    }
+
+    uint64_t timestamp = 0;
+    double value = 0.0;
+    return !decoder.Next(timestamp, value);
+}
+
+static void TestBits()
+{
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    std::vector<uint32_t> counts;
+    std::vector<uint64_t> values;
+    Gorilla::BitWriter writer;
+    for (int i = 0; i < 2000; i++)
+    {
+        uint32_t count = static_cast<uint32_t>(Random(state) % 65);
+        uint64_t value = count == 64 ? Random(state) : Random(state) & ((1ull << count) - 1);
+        counts.push_back(count);
+        values.push_back(value);
+        writer.Write(value, count);
+    }
+
+    std::vector<uint8_t> bytes = writer.Take();
+    CHECK(writer.Bytes().empty());
+    Gorilla::BitReader reader(bytes.data(), bytes.size());
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        uint64_t value = 0;
+        CHECK(reader.Read(counts[i], value) && value == values[i]);
+    }
+
+    // Bits past the end are zeros to peek at, and fail to read
+    const uint8_t one[1] = { 0xA5 };
+    Gorilla::BitReader shortReader(one, 1);
+    CHECK(shortReader.Peek(12) == 0xA50);
+    uint64_t value = 0;
+    CHECK(shortReader.Read(4, value) && value == 0xA);
+    CHECK(!shortReader.Read(5, value));
+    CHECK(shortReader.Read(4, value) && value == 0x5);
+    CHECK(shortReader.Read(0, value) && value == 0);
+}
+
+static void TestTimestamps()
+{
+    // Delta of deltas at each edge of each bucket, both sides
+    const int64_t edges[] = { 0, 63, -64, 64, -65, 255, -256, 256, -257, 2047, -2048, 2048, -2049, 1ll << 40, -(1ll << 30) };
+    std::vector<uint64_t> timestamps;
+    std::vector<double> values;
+    uint64_t time = 1700000000000ull;
+    int64_t delta = 1000000;
+    timestamps.push_back(time);
+    values.push_back(0.0);
+    for (int64_t edge : edges)
+    {
+        delta += edge;
+        time += static_cast<uint64_t>(delta);
+        timestamps.push_back(time);
+        values.push_back(0.0);
+    }
+    CHECK(RoundTrip(timestamps, values));
+
+    // Repeated timestamps and a zero first timestamp
+    CHECK(RoundTrip({ 0, 0, 0, 1, 1 }, { 1.0, 2.0, 3.0, 4.0, 5.0 }));
+    CHECK(RoundTrip({ UINT64_MAX - 1, UINT64_MAX }, { 1.0, 2.0 }));
+
+    // A steady period costs a bit per timestamp
+    std::vector<uint64_t> regular;
+    std::vector<double> constant;
+    for (int i = 0; i < 1000; i++)
+    {
+        regular.push_back(1700000000000ull + i * 100ull);
+        constant.push_back(42.5);
+    }
+    size_t size = 0;
+    CHECK(RoundTrip(regular, constant, &size));
+    CHECK(size < 16 + 3 + 1000 * 2 / 8 + 8);
+}
+
+static void TestValues()
+{
+    const double specials[] = { 0.0, -0.0, 1.0, -1.0, std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN(), FromBits(0x7FF0000000000001ull),
+        std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+        FromBits(0x8000000000000001ull), FromBits(0xFFFFFFFFFFFFFFFFull), 1.0, 1.0, 0.1, 0.2, 0.30000000000000004 };
+    std::vector<uint64_t> timestamps;
+    std::vector<double> values;
+    for (size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); i++)
+    {
+        timestamps.push_back(i * 10);
+        values.push_back(specials[i]);
+    }
+    CHECK(RoundTrip(timestamps, values));
+
+    // XORs with more leading zeros than the 5 bit field holds, and with every bit meaningful
+    CHECK(RoundTrip({ 0, 1, 2, 3, 4 }, { FromBits(0), FromBits(1), FromBits(0), FromBits(~0ull), FromBits(1ull << 63) }));
+
+    // Random walks and random bits, in a long block
+    uint64_t state = 12345;
+    timestamps.clear();
+    values.clear();
+    double walk = 100.0;
+    uint64_t time = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        time += 90 + Random(state) % 20;
+        walk += static_cast<double>(static_cast<int64_t>(Random(state) % 2001) - 1000) / 1000.0;
+        timestamps.push_back(time);
+        values.push_back(i % 3 == 0 ? FromBits(Random(state)) : walk);
+    }
+    CHECK(RoundTrip(timestamps, values));
+    CHECK(RoundTrip({}, {}));
+    CHECK(RoundTrip({ 5 }, { -2.5 }));
+}
+
+static void TestCorrupt()
+{
+    Gorilla::Encoder encoder;
+    for (int i = 0; i < 100; i++)
+    {
+        encoder.Append(1000 + i * 7 + (i % 5) * 300, i * 1.5 + (i % 7) * 1e6);
+    }
+    std::vector<uint8_t> block = encoder.Take();
+    CHECK(encoder.Count() == 0 && encoder.Bytes().empty());
+
+    // A short block, or a count past its end, stops the decoder instead of reading on
+    for (size_t size = 0; size < block.size(); size++)
+    {
+        Gorilla::Decoder decoder(block.data(), size, 100);
+        uint64_t timestamp = 0;
+        double value = 0.0;
+        uint32_t decoded = 0;
+        while (decoded <= 100 && decoder.Next(timestamp, value))
+        {
+            decoded++;
+        }
+        CHECK(decoded < 100);
+    }
+
+    Gorilla::Decoder decoder(block.data(), block.size(), 1000);
+    uint64_t timestamp = 0;
+    double value = 0.0;
+    uint32_t decoded = 0;
+    while (decoded <= 1000 && decoder.Next(timestamp, value))
+    {
+        decoded++;
+    }
+    CHECK(decoded >= 100 && decoded < 1000);
+}
+
+int main()
+{
+    TestBits();
+    TestTimestamps();
+    TestValues();
+    TestCorrupt();
+    return Essentials::Tests::Result();
+}
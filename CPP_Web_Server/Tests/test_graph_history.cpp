@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_graph_history.cpp
+//!
+//! @brief      Tests of the raw sample ring and the graph history around it
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <atomic>                    // Attached write index
+#include    <vector>                    // Samples
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/graph_history.h"  // Graph History
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Check a ring holds consecutive samples ending at a time, in order.
+static bool Holds(const GraphRingBuffer& ring, size_t size, uint64_t newest)
+{
+    if (ring.Size() != size)
+    {
+        return false;
+    }
+
+    std::vector<uint64_t> times;
+    std::vector<double> values;
+    ring.Copy(0, size, times, values);
+    for (size_t i = 0; i < size; i++)
+    {
+        uint64_t expected = newest - (size - 1 - i);
+        if (ring.TimeAt(i) != expected || ring.ValueAt(i) != static_cast<double>(expected) ||
+            times[i] != expected || values[i] != static_cast<double>(expected))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestRing()
+{
+    GraphRingBuffer ring;
+    CHECK(ring.Initialize(0) == -1);
+    CHECK(ring.Initialize(8) == 0);
+    CHECK(ring.Initialize(8) == -1);
+    CHECK(ring.Size() == 0 && ring.UpperBound(0) == 0);
+
+    for (uint64_t t = 1; t <= 20; t++)
+    {
+        ring.Push(t, static_cast<double>(t));
+        CHECK(Holds(ring, t < 8 ? t : 8, t));
+    }
+    CHECK(ring.UpperBound(12) == 0 && ring.UpperBound(13) == 1 && ring.UpperBound(20) == 8);
+}
+
+static void TestInterruptedOverwrite()
+{
+    // Storage as a mapped file would hold it
+    uint64_t times[4] = { 0 };
+    double values[4] = { 0.0 };
+    std::atomic<uint64_t> writeIndex(0);
+
+    GraphRingBuffer ring;
+    CHECK(ring.Attach(nullptr, values, &writeIndex, 4) == -1);
+    CHECK(ring.Attach(times, values, &writeIndex, 4) == 0);
+    for (uint64_t t = 1; t <= 6; t++)
+    {
+        ring.Push(t, static_cast<double>(t));
+    }
+    CHECK(writeIndex.load() == 6 && Holds(ring, 4, 6));
+
+    // A crash after flagging the overwrite and writing only the timestamp leaves
+    // the torn slot out, the rest still in order
+    writeIndex.store(6 | RING_WRITE_PENDING);
+    times[6 % 4] = 7;
+
+    GraphRingBuffer resumed;
+    CHECK(resumed.Attach(times, values, &writeIndex, 4) == 0);
+    CHECK(Holds(resumed, 3, 6));
+    CHECK(resumed.UpperBound(5) == 2);
+
+    // The next sample writes that slot again and clears the flag
+    resumed.Push(7, 7.0);
+    CHECK(writeIndex.load() == 7 && Holds(resumed, 4, 7));
+    resumed.Push(8, 8.0);
+    CHECK(writeIndex.load() == 8 && Holds(resumed, 4, 8));
+}
+
+static void TestClockStep()
+{
+    for (bool compressed : { false, true })
+    {
+        GraphHistory history;
+        CHECK(history.Initialize(16, { { 10, 1000 } }, compressed) == 0);
+        CHECK(history.NewestTime() == 0);
+
+        // A sample from before the newest one is kept at the newest time
+        history.Record(100, 1.0);
+        history.Record(110, 2.0);
+        history.Record(50, 3.0);
+        history.Record(120, 4.0);
+        CHECK(history.NewestTime() == 120 && history.OldestTime() == 100);
+
+        GraphQueryResult result;
+        history.Query(0, UINT64_MAX, 0, result);
+        CHECK(result.times == std::vector<uint64_t>({ 100, 110, 110, 120 }));
+        CHECK(result.values == std::vector<double>({ 1.0, 2.0, 3.0, 4.0 }));
+
+        history.Query(105, 110, 0, result);
+        CHECK(result.times.size() == 2);
+    }
+}
+
+static void TestLast()
+{
+    for (bool compressed : { false, true })
+    {
+        // Five thousand samples over a 500 sample ring, the 100 ms tier reaching back further
+        GraphHistory history;
+        CHECK(history.Initialize(500, { { 100, 1000000 } }, compressed) == 0);
+        uint64_t timestamp = 0;
+        double value = 0.0;
+        CHECK(history.Last(UINT64_MAX, timestamp, value) == -1);
+
+        for (uint64_t t = 1000; t < 51000; t += 10)
+        {
+            history.Record(t, static_cast<double>(t));
+        }
+
+        // Raw samples when held, including the newest and one landing between samples
+        CHECK(history.Last(UINT64_MAX, timestamp, value) == 0 && timestamp == 50990 && value == 50990.0);
+        CHECK(history.Last(49995, timestamp, value) == 0 && timestamp == 49990 && value == 49990.0);
+        CHECK(history.Last(47000, timestamp, value) == 0 && timestamp == 47000);
+
+        // Before the raw samples, the last tier bucket ended by then, as its start and average
+        CHECK(history.Last(5055, timestamp, value) == 0 && timestamp == 4900 && value == 4945.0);
+        CHECK(history.Last(999, timestamp, value) == -1);
+    }
+}
+
+int main()
+{
+    TestRing();
+    TestInterruptedOverwrite();
+    TestClockStep();
+    TestLast();
+    return Essentials::Tests::Result();
+}
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_http_parse.cpp
+//!
+//! @brief      Tests of HTTP head parsing and the header name index
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // strlen
+#include    <string>                    // Requests
+#include    "test_check.h"              // Checks
+#include    "../Source/Mongoose/mongoose.h" // Mongoose
+//
+///////////////////////////////////////////////////////////////////////////////
+
+static const char* REQUESTS[] =
+{
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef; theme=dark; layout=wide\r\n"
+    "If-None-Match: \"1a2b3c4d.1234\"\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n",
+
+    "GET /websocket HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "Upgrade: websocket\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "Sec-WebSocket-Version: 13\r\n"
+    "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n"
+    "\r\n",
+
+    "POST /api/command HTTP/1.1\nHost: x\nContent-Length: 2\n\n{}",
+
+    "GET / HTTP/1.0\r\n\r\n",
+};
+
+/// @brief The byte at a time request length, as Mongoose had it before the vector scan.
+static int ReferenceRequestLength(const unsigned char* buf, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!(buf[i] == '\n' || buf[i] == '\r' || buf[i] >= ' '))
+        {
+            return -1;
+        }
+        if ((i > 0 && buf[i] == '\n' && buf[i - 1] == '\n') ||
+            (i > 3 && buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n'))
+        {
+            return static_cast<int>(i) + 1;
+        }
+    }
+    return 0;
+}
+
+/// @brief Find a header with the linear search used for hand built messages.
+static struct mg_str* LinearHeader(struct mg_http_message* message, const char* name)
+{
+    struct mg_http_message copy = *message;
+    copy.header_indexed = false;
+    struct mg_str* value = mg_http_get_header(&copy, name);
+    for (int i = 0; value != NULL && i < MG_MAX_HTTP_HEADERS; i++)
+    {
+        if (value == &copy.headers[i].value)
+        {
+            return &message->headers[i].value;
+        }
+    }
+    return NULL;
+}
+
+/// @brief Request lengths of every prefix and of every single byte change match the reference.
+static void TestRequestLength()
+{
+    for (const char* request : REQUESTS)
+    {
+        std::string text(request);
+        for (size_t length = 0; length <= text.size(); length++)
+        {
+            const unsigned char* buf = reinterpret_cast<const unsigned char*>(text.data());
+            CHECK(mg_http_get_request_len(buf, length) == ReferenceRequestLength(buf, length));
+        }
+
+        const unsigned char changes[] = { 0x00, 0x01, '\t', '\n', '\r', 0x1F, ' ', 0x7F, 0x80, 0xFF };
+        for (size_t position = 0; position < text.size(); position++)
+        {
+            for (unsigned char change : changes)
+            {
+                std::string changed = text;
+                changed[position] = static_cast<char>(change);
+                const unsigned char* buf = reinterpret_cast<const unsigned char*>(changed.data());
+                CHECK(mg_http_get_request_len(buf, changed.size()) == ReferenceRequestLength(buf, changed.size()));
+            }
+        }
+    }
+
+    // Long header values cross many vector blocks before the end of the head
+    std::string big = "GET / HTTP/1.1\r\nCookie: " + std::string(10000, 'c') + "\r\n\r\n";
+    CHECK(mg_http_get_request_len(reinterpret_cast<const unsigned char*>(big.data()), big.size()) == static_cast<int>(big.size()));
+    big[5000] = '\x01';
+    CHECK(mg_http_get_request_len(reinterpret_cast<const unsigned char*>(big.data()), big.size()) == -1);
+}
+
+static void TestHeaders()
+{
+    struct mg_http_message message;
+    const char* request = REQUESTS[0];
+    CHECK(mg_http_parse(request, strlen(request), &message) == static_cast<int>(strlen(request)));
+    CHECK(mg_vcmp(&message.method, "GET") == 0);
+    CHECK(mg_vcmp(&message.uri, "/index.html") == 0);
+    CHECK(message.header_indexed);
+
+    struct mg_str* host = mg_http_get_header(&message, "host");
+    CHECK(host != NULL && mg_vcmp(host, "127.0.0.1") == 0);
+    struct mg_str* etag = mg_http_get_header(&message, "IF-NONE-MATCH");
+    CHECK(etag != NULL && mg_vcmp(etag, "\"1a2b3c4d.1234\"") == 0);
+    CHECK(mg_http_get_header(&message, "Content-Length") == NULL);
+    CHECK(mg_http_get_header(&message, "") == NULL);
+    CHECK(mg_http_get_header(&message, "Hos") == NULL);
+
+    const char* names[] = { "Host", "user-agent", "ACCEPT", "Accept-Encoding", "accept-language", "Cookie",
+        "If-None-Match", "Connection", "Range", "Upgrade", "X" };
+    for (const char* name : names)
+    {
+        CHECK(mg_http_get_header(&message, name) == LinearHeader(&message, name));
+    }
+
+    // A line feed alone ends lines too
+    request = REQUESTS[2];
+    CHECK(mg_http_parse(request, strlen(request), &message) == static_cast<int>(strlen(request)) - 2);
+    struct mg_str* length = mg_http_get_header(&message, "content-length");
+    CHECK(length != NULL && mg_vcmp(length, "2") == 0);
+    CHECK(mg_vcmp(&message.body, "{}") == 0);
+
+    CHECK(mg_http_parse(REQUESTS[0], 20, &message) == 0);
+}
+
+static void TestDuplicatesAndLimit()
+{
+    // The first header of a name wins, as with the linear search
+    std::string request = "GET / HTTP/1.1\r\nX-Dup: first\r\nx-dup: second\r\nX-DUP: third\r\n";
+    for (int i = 3; i < MG_MAX_HTTP_HEADERS + 5; i++)
+    {
+        request += "Header-" + std::to_string(i) + ": " + std::to_string(i) + "\r\n";
+    }
+    request += "\r\n";
+
+    struct mg_http_message message;
+    CHECK(mg_http_parse(request.data(), request.size(), &message) == static_cast<int>(request.size()));
+    struct mg_str* dup = mg_http_get_header(&message, "X-Dup");
+    CHECK(dup != NULL && mg_vcmp(dup, "first") == 0);
+
+    // Headers past the limit are not kept
+    for (int i = 3; i < MG_MAX_HTTP_HEADERS + 5; i++)
+    {
+        std::string name = "header-" + std::to_string(i);
+        struct mg_str* value = mg_http_get_header(&message, name.c_str());
+        CHECK((i < MG_MAX_HTTP_HEADERS) == (value != NULL));
+        CHECK(value == LinearHeader(&message, name.c_str()));
+        if (value != NULL)
+        {
+            CHECK(mg_vcmp(value, std::to_string(i).c_str()) == 0);
+        }
+    }
+}
+
+static void TestHandBuilt()
+{
+    // A message filled in by hand is found with the linear search
+    struct mg_http_message message;
+    memset(&message, 0, sizeof(message));
+    message.headers[0].name = mg_str("Content-Type");
+    message.headers[0].value = mg_str("text/plain");
+    struct mg_str* type = mg_http_get_header(&message, "content-type");
+    CHECK(type != NULL && mg_vcmp(type, "text/plain") == 0);
+    CHECK(mg_http_get_header(&message, "Host") == NULL);
+}
+
+int main()
+{
+    TestRequestLength();
+    TestHeaders();
+    TestDuplicatesAndLimit();
+    TestHandBuilt();
+    return Essentials::Tests::Result();
+}
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_json_index.cpp
+//!
+//! @brief      Tests of the JSON tape parser and its lookups
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // strlen
+#include    <climits>                   // LONG_MIN, LONG_MAX
+#include    <string>                    // Documents
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/json_index.h"     // JSON Index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Parse a document held in a string literal.
+static int8_t Parse(JsonIndex& index, const char* json)
+{
+    return index.Parse(json, strlen(json));
+}
+
+static void TestValidity()
+{
+    JsonIndex index;
+    const char* valid[] = { "{}", "[]", "0", "-0", "1.5e-3", "\"\"", "true", "false", "null", " \t\r\n{ } \n",
+        "[1,[2,[3]],{\"a\":{}}]", "\"\\u00e9\\n\\\\\"", "-1E+2", "{\"a\":1,\"a\":2}" };
+    for (const char* json : valid)
+    {
+        CHECK(Parse(index, json) == 0);
+    }
+
+    const char* invalid[] = { "", " ", "{", "}", "[1,]", "{\"a\":1,}", "{\"a\" 1}", "{a:1}", "01", "1.", ".5",
+        "-", "1e", "+1", "tru", "nul", "\"open", "\"\\x\"", "\"\\u12\"", "\"a\nb\"", "[1] 2", "{} {}",
+        "'a'", "[1 2]", "NaN" };
+    for (const char* json : invalid)
+    {
+        CHECK(Parse(index, json) == -1);
+        CHECK(index.Root() == -1);
+    }
+
+    // Nesting stops at the depth limit
+    std::string deep(JSON_DEPTH_MAX, '[');
+    deep += std::string(JSON_DEPTH_MAX, ']');
+    CHECK(index.Parse(deep.data(), deep.size()) == 0);
+    deep = "[" + deep + "]";
+    CHECK(index.Parse(deep.data(), deep.size()) == -1);
+}
+
+static void TestLookups()
+{
+    JsonIndex index;
+    const char* json = "{\"type\":\"set\",\"items\":[{\"name\":\"a\",\"value\":1},{\"name\":\"b\",\"value\":[true,null]}],"
+        "\"t\\u0061g\":\"x\\\"y\",\"empty\":{}}";
+    CHECK(Parse(index, json) == 0);
+
+    int root = index.Root();
+    CHECK(root == 0);
+    CHECK(index.Is(root, Json::Kind::OBJECT));
+    CHECK(index.GetCount(root) == 4);
+    CHECK(index.Equals(index.Find(root, "type"), "set"));
+
+    // Keys are compared unescaped
+    int tag = index.Find(root, "tag");
+    std::string text;
+    CHECK(index.GetString(tag, text) && text == "x\"y");
+    CHECK(index.Equals(tag, "x\"y"));
+    CHECK(!index.Equals(tag, "x\\\"y"));
+    CHECK(index.Find(root, "t\\u0061g") == -1);
+
+    int items = index.Find(root, "items");
+    CHECK(index.Is(items, Json::Kind::ARRAY) && index.GetCount(items) == 2);
+    CHECK(index.Equals(index.Find(index.At(items, 1), "name"), "b"));
+    CHECK(index.At(items, 2) == -1);
+
+    // Absent values chain without checks in between
+    CHECK(index.Find(index.At(index.Find(root, "missing"), 0), "name") == -1);
+    CHECK(index.At(root, 0) == -1);
+    CHECK(index.Find(items, "name") == -1);
+    CHECK(index.GetCount(-1) == 0);
+    CHECK(index.GetText(-1).len == 0);
+
+    // Walking children skips whole values
+    int count = 0;
+    for (int item = index.First(items); item >= 0; item = index.Next(item, items))
+    {
+        CHECK(index.Is(item, Json::Kind::OBJECT));
+        count++;
+    }
+    CHECK(count == 2);
+    CHECK(index.First(index.Find(root, "empty")) == -1);
+
+    int value = index.Find(index.At(items, 1), "value");
+    mg_str raw = index.GetText(value);
+    CHECK(std::string(raw.ptr, raw.len) == "[true,null]");
+    CHECK(index.Is(index.At(value, 0), Json::Kind::BOOL));
+    CHECK(index.Is(index.At(value, 1), Json::Kind::NUL));
+
+    // A later parse replaces the document
+    CHECK(Parse(index, "[\"only\"]") == 0);
+    CHECK(index.Find(index.Root(), "type") == -1);
+    CHECK(index.Equals(index.At(index.Root(), 0), "only"));
+}
+
+static void TestStrings()
+{
+    std::string value;
+    CHECK(Json::Unescape("a\\u0041\\u00e9\\u20ac", 19, value) && value == "aA\xC3\xA9\xE2\x82\xAC");
+    CHECK(Json::Unescape("\\b\\f\\n\\r\\t\\/", 12, value) && value == "\b\f\n\r\t/");
+    CHECK(Json::Unescape("", 0, value) && value.empty());
+    CHECK(!Json::Unescape("\\", 1, value));
+    CHECK(!Json::Unescape("\\u004", 5, value));
+    CHECK(!Json::Unescape("\\u004g", 6, value));
+    CHECK(!Json::Unescape("\\udc00", 6, value));
+
+    JsonIndex index;
+    CHECK(Parse(index, "[\"plain\",1]") == 0);
+    CHECK(!index.GetString(index.At(index.Root(), 1), value));
+    CHECK(index.GetString(index.At(index.Root(), 0), value) && value == "plain");
+
+    // A lone surrogate is valid JSON, but has no UTF-8 form
+    CHECK(Parse(index, "\"\\ud800\"") == 0);
+    CHECK(!index.GetString(index.Root(), value));
+}
+
+/// @brief Get a document's root as a long.
+static bool RootLong(const char* json, long& value)
+{
+    JsonIndex index;
+    return Parse(index, json) == 0 && index.GetLong(index.Root(), value);
+}
+
+static void TestNumbers()
+{
+    long value = 0;
+    CHECK(RootLong("0", value) && value == 0);
+    CHECK(RootLong("-42", value) && value == -42);
+    CHECK(RootLong("2.0", value) && value == 2);
+    CHECK(RootLong("1e3", value) && value == 1000);
+    CHECK(RootLong("-1.5e1", value) && value == -15);
+    CHECK(!RootLong("1.5", value));
+    CHECK(!RootLong("1e-1", value));
+    CHECK(!RootLong("\"1\"", value));
+    CHECK(!RootLong("true", value));
+
+    // The limits of long, whatever its width
+    std::string max = std::to_string(LONG_MAX);
+    std::string min = std::to_string(LONG_MIN);
+    CHECK(RootLong(max.c_str(), value) && value == LONG_MAX);
+    CHECK(RootLong(min.c_str(), value) && value == LONG_MIN);
+    std::string over = std::to_string(static_cast<unsigned long>(LONG_MAX) + 1);
+    std::string under = "-" + std::to_string(static_cast<unsigned long>(LONG_MAX) + 2);
+    CHECK(!RootLong(over.c_str(), value));
+    CHECK(!RootLong(under.c_str(), value));
+    CHECK(!RootLong("1e300", value));
+    CHECK(!RootLong("-1e300", value));
+
+    JsonIndex index;
+    double number = 0.0;
+    CHECK(Parse(index, "[-0.5e-2,1E2,null]") == 0);
+    CHECK(index.GetNumber(index.At(index.Root(), 0), number) && number == -0.005);
+    CHECK(index.GetNumber(index.At(index.Root(), 1), number) && number == 100.0);
+    CHECK(!index.GetNumber(index.At(index.Root(), 2), number));
+    CHECK(!index.GetNumber(-1, number));
+}
+
+int main()
+{
+    TestValidity();
+    TestLookups();
+    TestStrings();
+    TestNumbers();
+    return Essentials::Tests::Result();
+}
@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_json_writer.cpp
+//!
+//! @brief      Tests of the JSON writer, read back through the JSON index
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <climits>                   // Integer limits
+#include    <cmath>                     // NaN and infinity
+#include    <string>                    // Documents
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/json_writer.h"    // JSON Writer
+#include    "../Source/CPP_Web_Server/json_index.h"     // JSON Index
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Write a string and read it back.
+static bool StringRoundTrip(const std::string& value)
+{
+    std::string json;
+    Json::AppendString(json, value);
+
+    JsonIndex index;
+    std::string parsed;
+    return index.Parse(json.data(), json.size()) == 0 && index.GetString(index.Root(), parsed) && parsed == value;
+}
+
+static void TestStrings()
+{
+    std::string json;
+    Json::AppendString(json, "a\"b\\c\n\x01");
+    CHECK(json == "\"a\\\"b\\\\c\\n\\u0001\"");
+
+    CHECK(StringRoundTrip(""));
+    CHECK(StringRoundTrip("plain"));
+    CHECK(StringRoundTrip("caf\xC3\xA9 \xE2\x82\xAC"));
+
+    std::string controls;
+    for (int c = 0; c < 0x20; c++)
+    {
+        controls += static_cast<char>(c);
+    }
+    CHECK(StringRoundTrip(controls));
+
+    // Each escape at every position of the 16 byte blocks, and just past them
+    const char escapes[] = { '"', '\\', '\0', '\x1F', '\t' };
+    for (char escape : escapes)
+    {
+        for (size_t position = 0; position < 48; position++)
+        {
+            std::string value(47, 'x');
+            value.insert(position, 1, escape);
+            CHECK(StringRoundTrip(value));
+        }
+    }
+
+    // Bytes above 0x7F are not mistaken for control characters
+    std::string high;
+    for (int c = 0x7F; c < 0x100; c++)
+    {
+        high += static_cast<char>(c);
+    }
+    json.clear();
+    Json::AppendString(json, high);
+    CHECK(json == "\"" + high + "\"");
+}
+
+/// @brief Write a double and read it back.
+static bool DoubleRoundTrip(double value)
+{
+    std::string json;
+    Json::AppendNumber(json, value);
+
+    JsonIndex index;
+    double parsed = 0.0;
+    return index.Parse(json.data(), json.size()) == 0 && index.GetNumber(index.Root(), parsed) && parsed == value;
+}
+
+static void TestNumbers()
+{
+    const double doubles[] = { 0.0, -1.5, 0.1, 1e300, -1e-300, 5e-324, 1.7976931348623157e308, 123456789.125 };
+    for (double value : doubles)
+    {
+        CHECK(DoubleRoundTrip(value));
+    }
+
+    std::string json;
+    Json::AppendNumber(json, std::nan(""));
+    Json::AppendNumber(json, HUGE_VAL);
+    Json::AppendNumber(json, -HUGE_VALF);
+    CHECK(json == "nullnullnull");
+
+    json.clear();
+    Json::AppendNumber(json, LLONG_MIN);
+    CHECK(json == std::to_string(LLONG_MIN));
+    json.clear();
+    Json::AppendNumber(json, ULLONG_MAX);
+    CHECK(json == std::to_string(ULLONG_MAX));
+
+    const int numbers[4] = { 1, -2, 3, 0 };
+    json.clear();
+    Json::AppendNumbers(json, numbers, 4);
+    CHECK(json == "1,-2,3,0");
+    json.clear();
+    Json::AppendNumbers(json, numbers, 0);
+    CHECK(json.empty());
+}
+
+static void TestValues()
+{
+    char c = -5;
+    unsigned char uc = 250;
+    short s = -300;
+    unsigned short us = 60000;
+    int i = INT_MIN;
+    unsigned int ui = UINT_MAX;
+    double d = 0.25;
+    float f = 1.5f;
+    bool b = true;
+    std::string text = "say \"hi\"";
+
+    JsonWriter writer;
+    writer.BeginArray();
+    writer.Value(Data::Type::CHAR, &c);
+    writer.Value(Data::Type::UCHAR, &uc);
+    writer.Value(Data::Type::SHORT, &s);
+    writer.Value(Data::Type::USHORT, &us);
+    writer.Value(Data::Type::INT, &i);
+    writer.Value(Data::Type::UINT, &ui);
+    writer.Value(Data::Type::DOUBLE, &d);
+    writer.Value(Data::Type::FLOAT, &f);
+    writer.Value(Data::Type::BOOL, &b);
+    writer.Value(Data::Type::STRING, &text);
+    writer.Value(Data::Type::NONE, &i);
+    writer.EndArray();
+    CHECK(writer.Text() == "[-5,250,-300,60000," + std::to_string(INT_MIN) + "," + std::to_string(UINT_MAX) +
+        ",0.25,1.5,true,\"say \\\"hi\\\"\",null]");
+}
+
+static void TestWriter()
+{
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Key("type");
+    writer.String("data");
+    writer.Key("items");
+    writer.BeginArray();
+    writer.BeginObject();
+    writer.EndObject();
+    writer.BeginArray();
+    writer.EndArray();
+    writer.Null();
+    writer.Bool(false);
+    writer.Raw("{\"raw\":1}");
+    writer.EndArray();
+    writer.Key("values");
+    const double values[3] = { 1.0, 2.5, -3.0 };
+    writer.Numbers(values, 3);
+    writer.Key("empty");
+    writer.Numbers(values, 0);
+    writer.Key("count");
+    writer.Number(3);
+    writer.EndObject();
+    CHECK(writer.Text() == "{\"type\":\"data\",\"items\":[{},[],null,false,{\"raw\":1}],"
+        "\"values\":[1,2.5,-3],\"empty\":[],\"count\":3}");
+
+    // A cleared writer starts a new document without a leading comma
+    writer.Clear();
+    writer.BeginArray();
+    writer.Number(1);
+    writer.EndArray();
+    CHECK(writer.Text() == "[1]");
+
+    // Separators stay right down to the deepest nesting tracked
+    writer.Clear();
+    for (size_t depth = 0; depth < JSON_WRITER_DEPTH_MAX; depth++)
+    {
+        writer.BeginArray();
+        writer.Number(depth);
+    }
+    for (size_t depth = 0; depth < JSON_WRITER_DEPTH_MAX; depth++)
+    {
+        writer.EndArray();
+    }
+    JsonIndex index;
+    CHECK(index.Parse(writer.Text().data(), writer.Text().size()) == 0);
+    int token = index.Root();
+    for (size_t depth = 1; depth < JSON_WRITER_DEPTH_MAX; depth++)
+    {
+        CHECK(index.GetCount(token) == 2);
+        token = index.At(token, 1);
+    }
+    CHECK(index.GetCount(token) == 1);
+}
+
+int main()
+{
+    TestStrings();
+    TestNumbers();
+    TestValues();
+    TestWriter();
+    return Essentials::Tests::Result();
+}
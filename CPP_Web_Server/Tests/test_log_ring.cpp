@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_log_ring.cpp
+//!
+//! @brief      Tests of the logger's ring of pending entries under each full
+//!             queue policy, checked against the log file it writes
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <stdio.h>                   // sscanf
+#include    <chrono>                    // Drain timeout
+#include    <filesystem>                // Log directory
+#include    <fstream>                   // Log file
+#include    <string>                    // Lines
+#include    <thread>                    // Logging threads
+#include    <vector>                    // Threads and counts
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Logger/cpp_logger.h"     // Log
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Utilities;
+
+const static int THREADS = 4;                   // Logging threads per phase
+const static int ENTRIES = 5000;                // Entries per thread per phase
+const static size_t QUEUE_SLOTS = 64;           // Small enough for the writer to fall behind
+
+/// @brief Entries one phase left in the file.
+struct Phase
+{
+    std::vector<int>    written;        // Entries in the file, per thread
+    bool                ordered;        // Each thread's entries are in the order logged
+    bool                marker;         // The phase's end marker is in the file
+};
+
+/// @brief Find the log file written into a directory.
+static std::string FindLogFile(const std::filesystem::path& directory)
+{
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+    {
+        return entry.path().string();
+    }
+    return "";
+}
+
+/// @brief Read the entries of every phase and the dropped counts noted in a log file.
+static std::vector<Phase> ReadLog(const std::string& file, int phases, uint64_t& notedDrops)
+{
+    std::vector<Phase> result(phases, Phase{ std::vector<int>(THREADS, 0), true, false });
+    std::vector<std::vector<int>> last(phases, std::vector<int>(THREADS, -1));
+    notedDrops = 0;
+
+    std::ifstream in(file);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        int phase = 0;
+        int thread = 0;
+        int sequence = 0;
+        unsigned long long dropped = 0;
+        size_t at = line.find("entry ");
+        if (at != std::string::npos && sscanf(line.c_str() + at, "entry %d %d %d", &phase, &thread, &sequence) == 3 &&
+            phase < phases && thread < THREADS)
+        {
+            result[phase].written[thread]++;
+            result[phase].ordered = result[phase].ordered && sequence > last[phase][thread];
+            last[phase][thread] = sequence;
+        }
+        else if ((at = line.find("marker ")) != std::string::npos && sscanf(line.c_str() + at, "marker %d", &phase) == 1 &&
+            phase < phases)
+        {
+            result[phase].marker = true;
+        }
+        else if ((at = line.find("Queue full, dropped ")) != std::string::npos &&
+            sscanf(line.c_str() + at, "Queue full, dropped %llu", &dropped) == 1)
+        {
+            notedDrops += dropped;
+        }
+    }
+    return result;
+}
+
+/// @brief Log from several threads at once, then wait for the writer to catch up.
+/// @return entries the logging threads were told were dropped.
+static int RunPhase(Log* log, const std::string& file, int phase, LOG_FULL_POLICY policy)
+{
+    log->SetQueueFullPolicy(policy);
+
+    std::vector<int> refused(THREADS, 0);
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < THREADS; thread++)
+    {
+        threads.emplace_back([=, &refused]()
+            {
+                for (int sequence = 0; sequence < ENTRIES; sequence++)
+                {
+                    if (!log->AddEntry(LOG_LEVEL::LOG_INFO, "Test", "entry %d %d %d", phase, thread, sequence))
+                    {
+                        refused[thread]++;
+                    }
+                }
+            });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // A marker logged with blocking is written once everything before it is
+    log->SetQueueFullPolicy(LOG_FULL_POLICY::LOG_BLOCK);
+    log->AddEntry(LOG_LEVEL::LOG_INFO, "Test", "marker %d", phase);
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    uint64_t notedDrops = 0;
+    while (!ReadLog(file, phase + 1, notedDrops)[phase].marker && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int total = 0;
+    for (int count : refused)
+    {
+        total += count;
+    }
+    return total;
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() /
+        ("cpp_log_ring_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::filesystem::create_directories(directory);
+
+    Log* log = Log::GetInstance();
+    CHECK(log->SetQueueSize(QUEUE_SLOTS - 1));
+    CHECK(log->Initialize(false, true, (directory / "ring").generic_string()) == 1);
+    CHECK(!log->SetQueueSize(1024));
+    std::string file = FindLogFile(directory);
+    CHECK(!file.empty());
+
+    // Blocking writes everything
+    uint64_t before = log->GetDroppedCount();
+    CHECK(RunPhase(log, file, 0, LOG_FULL_POLICY::LOG_BLOCK) == 0);
+    uint64_t blockDrops = log->GetDroppedCount() - before;
+
+    // Dropping the newest refuses the entries it drops
+    before = log->GetDroppedCount();
+    int refused = RunPhase(log, file, 1, LOG_FULL_POLICY::LOG_DROP_NEWEST);
+    uint64_t newestDrops = log->GetDroppedCount() - before;
+
+    // Dropping the oldest accepts every entry, but some never reach the file
+    before = log->GetDroppedCount();
+    CHECK(RunPhase(log, file, 2, LOG_FULL_POLICY::LOG_DROP_OLDEST) == 0);
+    uint64_t oldestDrops = log->GetDroppedCount() - before;
+
+    uint64_t totalDrops = log->GetDroppedCount();
+    Log::ReleaseInstance();
+
+    uint64_t notedDrops = 0;
+    std::vector<Phase> phases = ReadLog(file, 3, notedDrops);
+    int written[3] = { 0, 0, 0 };
+    for (int phase = 0; phase < 3; phase++)
+    {
+        CHECK(phases[phase].marker);
+        CHECK(phases[phase].ordered);
+        for (int count : phases[phase].written)
+        {
+            written[phase] += count;
+        }
+    }
+
+    CHECK(blockDrops == 0);
+    CHECK(written[0] == THREADS * ENTRIES);
+    for (int count : phases[0].written)
+    {
+        CHECK(count == ENTRIES);
+    }
+
+    CHECK(newestDrops > 0);
+    CHECK(static_cast<uint64_t>(refused) == newestDrops);
+    CHECK(written[1] + refused == THREADS * ENTRIES);
+
+    CHECK(written[2] + oldestDrops == static_cast<uint64_t>(THREADS * ENTRIES));
+
+    // The writer notes every drop in the file
+    CHECK(notedDrops == totalDrops);
+
+    std::filesystem::remove_all(directory);
+    return Essentials::Tests::Result();
+}
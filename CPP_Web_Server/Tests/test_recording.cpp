@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_recording.cpp
+//!
+//! @brief      Tests of recordings, written to disk and read back
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <stdio.h>                   // Files
+#include    <string.h>                  // memcpy
+#include    <chrono>                    // Sleep
+#include    <thread>                    // Sleep
+#include    <vector>                    // Samples
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/recording.h"      // Recording
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+static const char*  RECORDING_PATH = "test_recording.rec";     // Recording written
+static const char*  COPY_PATH = "test_recording_cut.rec";      // Truncated copies
+
+/// @brief Get the bits of a double, so NaN payloads and signed zeros compare exactly.
+static uint64_t Bits(double value)
+{
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/// @brief Small deterministic generator, the same on every platform.
+static uint64_t Random(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/// @brief Read a whole file.
+static std::vector<uint8_t> ReadFile(const char* path)
+{
+    std::vector<uint8_t> bytes;
+    FILE* file = fopen(path, "rb");
+    if (file != nullptr)
+    {
+        uint8_t buffer[4096];
+        size_t size = 0;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            bytes.insert(bytes.end(), buffer, buffer + size);
+        }
+        fclose(file);
+    }
+    return bytes;
+}
+
+/// @brief Write the first bytes of a file to the copy path.
+static void WriteCopy(const std::vector<uint8_t>& bytes, size_t size)
+{
+    FILE* file = fopen(COPY_PATH, "wb");
+    if (file != nullptr)
+    {
+        fwrite(bytes.data(), 1, size, file);
+        fclose(file);
+    }
+}
+
+static void TestRoundTrip()
+{
+    const std::vector<RecordingItem> items =
+    {
+        { 3, true, Data::Type::DOUBLE, Data::Access::EDIT, "pressure", "Tank pressure", "Pressures", Graph::Type::BAR, 500, 20 },
+        { 7, false, Data::Type::INT, Data::Access::VIEW, "count", "", "", Graph::Type::LINE, 0, 0 },
+    };
+
+    Recorder recorder;
+    CHECK(recorder.Start(RECORDING_PATH, {}) == -1);
+    CHECK(recorder.Start(RECORDING_PATH, items, 0) == -1);
+    CHECK(recorder.Start(RECORDING_PATH, items, 20) == 0);
+    CHECK(recorder.Start(RECORDING_PATH, items, 20) == -1);
+    CHECK(recorder.IsRecording());
+
+    // Batches apart in time land in separate chunks
+    const uint64_t base = 1700000000000ull;
+    uint64_t state = 99;
+    std::vector<uint64_t> times[2];
+    std::vector<double> values[2];
+    for (int batch = 0; batch < 5; batch++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            uint64_t time = base + (batch * 200 + i) * 10ull;
+            double pressure = static_cast<double>(Random(state) % 100000) / 7.0;
+            double count = static_cast<double>(batch * 200 + i);
+
+            recorder.Record(3, time, pressure);
+            recorder.Record(7, time + 5, count);
+            recorder.Record(5, time, 1.0);
+            recorder.Record(100, time, 1.0);
+            times[0].push_back(time);
+            values[0].push_back(pressure);
+            times[1].push_back(time + 5);
+            values[1].push_back(count);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    }
+    recorder.Stop();
+    recorder.Stop();
+    CHECK(!recorder.IsRecording());
+
+    std::vector<uint8_t> bytes = ReadFile(RECORDING_PATH);
+    CHECK(recorder.BytesWritten() == bytes.size());
+
+    RecordingReader reader;
+    CHECK(reader.Open(RECORDING_PATH) == 0);
+    CHECK(reader.Open(RECORDING_PATH) == -1);
+
+    // The item table comes back field for field
+    CHECK(reader.Items().size() == 2);
+    for (size_t i = 0; i < items.size() && i < reader.Items().size(); i++)
+    {
+        const RecordingItem& item = reader.Items()[i];
+        CHECK(item.id == items[i].id && item.graph == items[i].graph && item.type == items[i].type);
+        CHECK(item.access == items[i].access && item.graph_type == items[i].graph_type);
+        CHECK(item.graph_size == items[i].graph_size && item.sample_period == items[i].sample_period);
+        CHECK(item.unique_name == items[i].unique_name && item.description == items[i].description);
+        CHECK(item.graph_name == items[i].graph_name);
+    }
+
+    // Every sample of every chunk, interleaved in time order, and nothing else
+    const std::vector<RecordingChunk> chunks = reader.Chunks();
+    CHECK(chunks.size() >= 2);
+    std::vector<uint64_t> seenTimes[2];
+    std::vector<double> seenValues[2];
+    std::vector<RecordingSample> samples;
+    uint64_t previous = 0;
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        CHECK(c == 0 || chunks[c].first > chunks[c - 1].last);
+        CHECK(reader.ReadChunk(c, samples) == 0);
+        for (const RecordingSample& sample : samples)
+        {
+            CHECK(sample.timestamp >= previous && sample.timestamp >= chunks[c].first && sample.timestamp <= chunks[c].last);
+            previous = sample.timestamp;
+            if (sample.item < 2)
+            {
+                seenTimes[sample.item].push_back(sample.timestamp);
+                seenValues[sample.item].push_back(sample.value);
+            }
+        }
+    }
+    CHECK(reader.ReadChunk(chunks.size(), samples) == -1);
+    for (int item = 0; item < 2; item++)
+    {
+        CHECK(seenTimes[item] == times[item]);
+        bool same = seenValues[item].size() == values[item].size();
+        for (size_t i = 0; same && i < values[item].size(); i++)
+        {
+            same = Bits(seenValues[item][i]) == Bits(values[item][i]);
+        }
+        CHECK(same);
+    }
+
+    // Windows across chunk edges return exactly the samples inside them
+    const uint64_t windows[][2] = { { 0, UINT64_MAX }, { base + 1995, base + 2005 }, { base + 4000, base + 4000 },
+        { base + 3333, base + 7777 }, { base + 10000, UINT64_MAX } };
+    for (const auto& window : windows)
+    {
+        std::vector<uint64_t> windowTimes;
+        std::vector<double> windowValues;
+        CHECK(reader.ReadItem(0, window[0], window[1], windowTimes, windowValues) == 0);
+
+        std::vector<uint64_t> expected;
+        for (uint64_t time : times[0])
+        {
+            if (time > window[0] && time <= window[1])
+            {
+                expected.push_back(time);
+            }
+        }
+        CHECK(windowTimes == expected && windowValues.size() == expected.size());
+    }
+    std::vector<uint64_t> unusedTimes;
+    std::vector<double> unusedValues;
+    CHECK(reader.ReadItem(2, 0, UINT64_MAX, unusedTimes, unusedValues) == -1);
+    reader.Close();
+    CHECK(!reader.IsOpen());
+
+    // Cut short before the footer, the chunk headers are walked instead
+    size_t footer = 8 + chunks.size() * 24 + 16;
+    WriteCopy(bytes, bytes.size() - footer);
+    CHECK(reader.Open(COPY_PATH) == 0);
+    CHECK(reader.Chunks().size() == chunks.size());
+    for (size_t c = 0; c < chunks.size() && c < reader.Chunks().size(); c++)
+    {
+        CHECK(reader.Chunks()[c].first == chunks[c].first && reader.Chunks()[c].offset == chunks[c].offset);
+    }
+    reader.Close();
+
+    // A torn last chunk is dropped
+    WriteCopy(bytes, bytes.size() - footer - 1);
+    CHECK(reader.Open(COPY_PATH) == 0);
+    CHECK(reader.Chunks().size() == chunks.size() - 1);
+    reader.Close();
+
+    // Another file, or a torn header, is refused
+    WriteCopy(bytes, 12);
+    CHECK(reader.Open(COPY_PATH) == -1);
+    std::vector<uint8_t> wrong = bytes;
+    wrong[0] = 'X';
+    WriteCopy(wrong, wrong.size());
+    CHECK(reader.Open(COPY_PATH) == -1);
+    CHECK(reader.Open("missing.rec") == -1);
+
+    remove(RECORDING_PATH);
+    remove(COPY_PATH);
+}
+
+int main()
+{
+    TestRoundTrip();
+    return Essentials::Tests::Result();
+}
@@ -0,0 +1,136 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_sample_scheduler.cpp
+//!
+//! @brief      Tests of the sampling timing wheel, run against the clock
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <chrono>                    // Sweep times
+#include    <map>                       // Sweeps per period
+#include    <mutex>                     // Sweeps guard
+#include    <thread>                    // Sleep
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/sample_scheduler.h"   // Sample Scheduler
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Sweeps seen for one period.
+struct Sweeps
+{
+    int     count;          // Sweeps fired
+    double  firstMSec;      // Time of the first sweep after start
+    double  lastMSec;       // Time of the last sweep after start
+    size_t  targets;        // Targets in the group when last swept
+    uint64_t timestamp;     // Timestamp of the last sweep
+};
+
+static void TestRejected()
+{
+    int value = 0;
+    SampleScheduler scheduler;
+    CHECK(scheduler.AddTarget(0, { &value, Data::Type::INT, 1, nullptr }) == -1);
+    CHECK(scheduler.AddTarget(SAMPLE_PERIOD_MAX_MSEC + 1, { &value, Data::Type::INT, 1, nullptr }) == -1);
+    CHECK(scheduler.AddTarget(10, { nullptr, Data::Type::INT, 1, nullptr }) == -1);
+    CHECK(scheduler.GetNumberOfGroups() == 0);
+
+    CHECK(scheduler.AddTarget(SAMPLE_PERIOD_MAX_MSEC, { &value, Data::Type::INT, 1, nullptr }) == 0);
+    CHECK(scheduler.Start(nullptr) == -1);
+    CHECK(scheduler.Start([](const SampleGroup&, uint64_t) {}) == 0);
+    CHECK(scheduler.Start([](const SampleGroup&, uint64_t) {}) == -1);
+    scheduler.Stop();
+    scheduler.Stop();
+}
+
+static void TestPeriods()
+{
+    // Periods on each wheel level: 4100 ms only reaches level 0 through two cascades
+    const uint32_t periods[] = { 1, 3, 63, 64, 100, 1000, 4100 };
+    const double runMSec = 4500.0;
+
+    int values[2] = { 0, 0 };
+    std::mutex mutex;
+    uint64_t lastTimestamp = 0;
+    bool backwards = false;
+    std::map<uint32_t, Sweeps> sweeps;
+    std::chrono::steady_clock::time_point start;
+
+    SampleScheduler scheduler;
+    for (uint32_t period : periods)
+    {
+        CHECK(scheduler.AddTarget(period, { &values[0], Data::Type::INT, period, nullptr }) == 0);
+    }
+
+    // Items sharing a period share a group
+    CHECK(scheduler.AddTarget(100, { &values[1], Data::Type::INT, 2, nullptr }) == 0);
+    CHECK(scheduler.GetNumberOfGroups() == sizeof(periods) / sizeof(periods[0]));
+
+    start = std::chrono::steady_clock::now();
+    const uint64_t wallStart = GraphHistory::Now();
+    CHECK(scheduler.Start([&](const SampleGroup& group, uint64_t timestamp)
+        {
+            double at = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::lock_guard<std::mutex> lock(mutex);
+            backwards = backwards || timestamp < lastTimestamp;
+            lastTimestamp = timestamp;
+            Sweeps& seen = sweeps[group.period];
+            if (seen.count == 0)
+            {
+                seen.firstMSec = at;
+            }
+            seen.count++;
+            seen.lastMSec = at;
+            seen.targets = group.targets.size();
+            seen.timestamp = timestamp;
+        }) == 0);
+
+    // A group added while running joins the wheel at once
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    CHECK(scheduler.AddTarget(250, { &values[1], Data::Type::INT, 3, nullptr }) == 0);
+
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(static_cast<int>(runMSec)));
+    scheduler.Stop();
+    double stoppedMSec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint32_t period : periods)
+    {
+        const Sweeps& seen = sweeps[period];
+
+        // Never early, and on a busy machine late sweeps are skipped rather than bunched
+        double expected = runMSec / period;
+        CHECK(seen.count >= 1);
+        CHECK(seen.count <= static_cast<int>(stoppedMSec / period) + 1);
+        CHECK(seen.count >= static_cast<int>(expected / 2));
+        CHECK(seen.firstMSec >= period - 1.0);
+        CHECK(seen.firstMSec < period + 250.0);
+    }
+    CHECK(sweeps[100].targets == 2);
+
+    // Timestamps follow the steady clock from the wall clock at start
+    CHECK(!backwards);
+    CHECK(sweeps[1].timestamp >= wallStart + static_cast<uint64_t>(sweeps[1].lastMSec) - 5);
+    CHECK(sweeps[1].timestamp <= wallStart + static_cast<uint64_t>(sweeps[1].lastMSec) + 5);
+    CHECK(sweeps[250].count >= 1 && sweeps[250].firstMSec >= 749.0);
+
+    SampleSchedulerStatistics statistics = scheduler.GetStatistics();
+    CHECK(statistics.ticks >= static_cast<uint64_t>(runMSec) - 2);
+    CHECK(statistics.ticks <= static_cast<uint64_t>(stoppedMSec) + 1);
+    CHECK(statistics.sweeps > 0);
+}
+
+int main()
+{
+    TestRejected();
+    TestPeriods();
+    return Essentials::Tests::Result();
+}
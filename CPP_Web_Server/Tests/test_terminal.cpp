@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_terminal.cpp
+//!
+//! @brief      Tests of shell sessions and terminal jobs run through the
+//!             websocket of a running server
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <stdlib.h>                  // strtoull
+#include    <chrono>                    // Idle timing
+#include    <thread>                    // Sleep
+#include    "test_check.h"              // Checks
+#include    "test_client.h"             // Websocket client
+#include    "../Source/CPP_Web_Server/web_server.h"     // Web Server
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+using namespace Essentials::Tests;
+
+static const char*      TEST_URL = "ws://127.0.0.1:18182/ws";       // Server under test
+static const uint64_t   IDLE_MSEC = 1000;                           // Shortest idle timeout allowed
+static const size_t     JOBS_RUNNING = 2;                           // Jobs allowed to run at once
+static const size_t     JOB_OUTPUT = 4096;                          // Output kept per job
+
+static void TestShellSessions()
+{
+    WebsocketClient first;
+    WebsocketClient second;
+    CHECK(first.Connect(TEST_URL) && second.Connect(TEST_URL));
+
+    // Commands run one after another in the same shell, so the directory carries over
+    first.Send("{\"shell\":\"open\"}");
+    CHECK(!first.WaitFor("\"type\":\"shell\",\"status\":200,\"result\":{\"shell\":\"open\"}").empty());
+    first.Send("cd /tmp");
+    first.Send("echo \"in $(pwd)\"");
+    CHECK(!first.WaitFor("in /tmp").empty());
+
+    // One session is the limit, a second client is turned away
+    second.Send("{\"shell\":\"open\"}");
+    CHECK(!second.WaitFor("\"type\":\"shell\",\"status\":429,\"result\":{\"error\":\"too many shells\"}").empty());
+
+    // Left alone, the shell is closed for idling and the client told so
+    auto idleStart = std::chrono::steady_clock::now();
+    CHECK(!first.WaitFor("\"idle\":true}", 5000).empty());
+    auto idled = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - idleStart).count();
+    CHECK(idled >= static_cast<long long>(IDLE_MSEC) - 100);
+    first.Send("{\"shell\":\"close\"}");
+    CHECK(!first.WaitFor("\"status\":404,\"result\":{\"error\":\"no shell open\"}").empty());
+
+    // That frees the session for the other client
+    second.Send("{\"shell\":\"open\"}");
+    CHECK(!second.WaitFor("\"status\":200,\"result\":{\"shell\":\"open\"}").empty());
+    second.Send("echo $((6 * 7))");
+    CHECK(!second.WaitFor("42").empty());
+
+    // Everything written before the shell exits arrives ahead of the exit status
+    second.Send("for i in $(seq 1 2000); do echo line $i; done; exit 3");
+    CHECK(!second.WaitFor("line 2000\n").empty());
+    CHECK(!second.WaitFor("\"type\":\"shell\",\"status\":200,\"result\":{\"exit\":3}").empty());
+
+    // A background job still holding the terminal does not hold up the exit
+    second.Send("{\"shell\":\"open\"}");
+    CHECK(!second.WaitFor("\"status\":200,\"result\":{\"shell\":\"open\"}").empty());
+    second.Send("sleep 3 & exit 4");
+    CHECK(!second.WaitFor("\"result\":{\"exit\":4}", 2000).empty());
+
+    // A client leaving takes its shell with it
+    WebsocketClient third;
+    CHECK(third.Connect(TEST_URL));
+    third.Send("{\"shell\":\"open\"}");
+    CHECK(!third.WaitFor("\"result\":{\"shell\":\"open\"}").empty());
+    third.Close();
+
+    // Its shell is reaped on a later poll, until then the limit still holds
+    const std::string opened = "\"type\":\"shell\",\"status\":200,";
+    bool reopened = false;
+    for (int i = 0; i < 50 && !reopened; i++)
+    {
+        second.Send("{\"shell\":\"open\"}");
+        reopened = second.WaitFor("\"type\":\"shell\",\"status\":").compare(0, opened.size(), opened) == 0;
+    }
+    CHECK(reopened);
+}
+
+/// @brief Start a job and get its id, 0 if it was not started.
+static unsigned long long StartJob(WebsocketClient& client, const std::string& command)
+{
+    const std::string started = "\"type\":\"terminal\",\"status\":202,\"id\":";
+    client.Send(command);
+    std::string reply = client.WaitFor(started);
+    return reply.empty() ? 0 : strtoull(reply.c_str() + started.size(), nullptr, 10);
+}
+
+/// @brief Send a job command and wait for its reply, from the status on.
+static std::string ControlJob(WebsocketClient& client, const std::string& job)
+{
+    const std::string replied = "\"type\":\"job\",";
+    client.Send("{\"job\":" + job + "}");
+    std::string reply = client.WaitFor(replied);
+    return reply.empty() ? reply : reply.substr(replied.size());
+}
+
+static void TestJobs()
+{
+    WebsocketClient client;
+    CHECK(client.Connect(TEST_URL));
+
+    // Each command is a job with its own id, up to the running limit
+    unsigned long long first = StartJob(client, "sleep 30");
+    unsigned long long second = StartJob(client, "sleep 30");
+    CHECK(first > 0 && second > first);
+    client.Send("sleep 30");
+    CHECK(!client.WaitFor("\"type\":\"terminal\",\"status\":429,\"result\":{\"error\":\"too many terminal jobs\"}").empty());
+
+    std::string reply = ControlJob(client, "\"list\"");
+    CHECK(reply.find("{\"id\":" + std::to_string(first) + ",\"command\":\"sleep 30\",\"running\":true,\"exit\":null,") != std::string::npos);
+    CHECK(reply.find("\"attached\":true}") != std::string::npos);
+
+    // A kill is answered at once, the exit status follows when the job is reaped
+    const std::string id = std::to_string(first);
+    reply = ControlJob(client, "{\"action\":\"kill\",\"id\":" + id + "}");
+    CHECK(reply.find("\"status\":200,\"result\":{\"id\":" + id + ",\"killed\":true}") == 0);
+    CHECK(!client.WaitFor("\"type\":\"terminal\",\"status\":200,\"id\":" + id + ",\"result\":{\"exit\":137}").empty());
+    reply = ControlJob(client, "{\"action\":\"kill\",\"id\":" + id + "}");
+    CHECK(reply.find("\"status\":409,\"result\":{\"error\":\"job finished\"}") == 0);
+    reply = ControlJob(client, "{\"action\":\"kill\",\"id\":999}");
+    CHECK(reply.find("\"status\":404,\"result\":{\"error\":\"unknown job\"}") == 0);
+
+    // Output past the ring is dropped and counted, the tail stays readable by offset
+    unsigned long long flood = StartJob(client, "head -c 20000 /dev/zero | tr '\\0' x");
+    const std::string floodId = std::to_string(flood);
+    CHECK(!client.WaitFor("\"type\":\"terminal\",\"status\":200,\"id\":" + floodId + ",\"result\":{\"exit\":0}").empty());
+    const std::string dropped = std::to_string(20000 - JOB_OUTPUT);
+    reply = ControlJob(client, "{\"action\":\"tail\",\"id\":" + floodId + ",\"since\":0}");
+    CHECK(reply.find("{\"id\":" + floodId + ",\"offset\":" + dropped + ",\"next\":20000,\"dropped\":" + dropped +
+        ",\"running\":false,\"exit\":0,\"output\":\"") != std::string::npos);
+    size_t output = reply.find("\"output\":\"");
+    size_t end = reply.find("\"}}", output);
+    CHECK(output != std::string::npos && end != std::string::npos && end - output - 10 == JOB_OUTPUT);
+    reply = ControlJob(client, "{\"action\":\"tail\",\"id\":" + floodId + ",\"since\":19990}");
+    CHECK(reply.find("\"offset\":19990,\"next\":20000,") != std::string::npos);
+    CHECK(reply.find("\"output\":\"xxxxxxxxxx\"}") != std::string::npos);
+    reply = ControlJob(client, "\"list\"");
+    CHECK(reply.find("\"written\":20000,\"dropped\":" + dropped + ",") != std::string::npos);
+
+    reply = ControlJob(client, "{\"action\":\"kill\",\"id\":" + std::to_string(second) + "}");
+    CHECK(reply.find("\"status\":200,\"result\":{\"id\":" + std::to_string(second) + ",\"killed\":true}") == 0);
+    CHECK(!client.WaitFor("\"id\":" + std::to_string(second) + ",\"result\":{\"exit\":137}").empty());
+
+    // A job outlives the client that started it, its output kept for whoever asks. One
+    // running away with nobody reading still keeps only the ring.
+    unsigned long long detached = 0;
+    unsigned long long runaway = 0;
+    {
+        WebsocketClient leaving;
+        CHECK(leaving.Connect(TEST_URL));
+        detached = StartJob(leaving, "sleep 0.2; echo finished");
+        runaway = StartJob(leaving, "head -c 1000000 /dev/zero | tr '\\0' x");
+        leaving.Close();
+    }
+    CHECK(detached > 0 && runaway > detached);
+    bool finished = false;
+    for (int i = 0; i < 100 && !finished; i++)
+    {
+        reply = ControlJob(client, "{\"action\":\"tail\",\"id\":" + std::to_string(detached) + "}");
+        finished = reply.find("\"running\":false,\"exit\":0,\"output\":\"finished\\n\"}") != std::string::npos;
+        reply = ControlJob(client, "{\"action\":\"tail\",\"id\":" + std::to_string(runaway) + ",\"since\":999999}");
+        finished = finished && reply.find("\"offset\":999999,\"next\":1000000,\"dropped\":" +
+            std::to_string(1000000 - JOB_OUTPUT) + ",\"running\":false,\"exit\":0,\"output\":\"x\"}") != std::string::npos;
+        if (!finished)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    CHECK(finished);
+    reply = ControlJob(client, "\"list\"");
+    CHECK(reply.find("\"running\":false,\"exit\":0,\"written\":9,\"dropped\":0,\"attached\":false}") != std::string::npos);
+}
+
+int main()
+{
+    Web_Server* server = Web_Server::GetInstance();
+    server->Configure("http://127.0.0.1", 18182, ".");
+    CHECK(server->SetShellLimits(1, IDLE_MSEC - 1) == -1);
+    CHECK(server->SetShellLimits(1, IDLE_MSEC) == 0);
+    CHECK(server->SetTerminalJobLimits(JOBS_RUNNING, JOB_OUTPUT) == 0);
+    CHECK(server->Start() == 0);
+    CHECK(server->SetShellLimits(2, IDLE_MSEC) == -1);
+    CHECK(server->SetTerminalJobLimits(JOBS_RUNNING + 1, JOB_OUTPUT) == -1);
+
+    TestShellSessions();
+    TestJobs();
+
+    server->Stop();
+    Web_Server::ReleaseInstance();
+    return Essentials::Tests::Result();
+}
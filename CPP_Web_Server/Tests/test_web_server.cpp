@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_web_server.cpp
+//!
+//! @brief      Tests of registering published items with the web server and of
+//!             its HTTP endpoints, served from a replayed recording
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <stdio.h>                   // remove
+#include    <stdlib.h>                  // atoll
+#include    <chrono>                    // Replay wait
+#include    <thread>                    // Sleep
+#include    "test_check.h"              // Checks
+#include    "test_client.h"             // HTTP client
+#include    "../Source/CPP_Web_Server/web_server.h"     // Web Server
+#include    "../Source/CPP_Web_Server/recording.h"      // Recorder
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+using namespace Essentials::Tests;
+
+static void TestRegistration(Web_Server* server)
+{
+    int value = 0;
+
+    // A period the scheduler refuses leaves nothing registered, the name stays free
+    PublishedData data(&value, "data", "Sampled data", Data::Type::INT);
+    data.sample_period = SAMPLE_PERIOD_MAX_MSEC + 1;
+    CHECK(server->AddPublishedData(data) == -1);
+    PublishedData unsampled("unsampled");
+    unsampled.sample_period = 10;
+    CHECK(server->AddPublishedData(unsampled) == -1);
+    CHECK(server->GetNumberOfPublishedDatas() == 0);
+
+    data.sample_period = SAMPLE_PERIOD_MAX_MSEC;
+    CHECK(server->AddPublishedData(data) == 0);
+    CHECK(server->AddPublishedData(data) == -1);
+    CHECK(server->GetNumberOfPublishedDatas() == 1);
+
+    PublishedGraphData graph(&value, "graph", "Sampled graph", Data::Type::INT, "Graph", Graph::Type::LINE, 100);
+    graph.sample_period = SAMPLE_PERIOD_MAX_MSEC + 1;
+    CHECK(server->AddPublishedGraphData(graph) == -1);
+    CHECK(server->GetNumberOfPublishedGraphDatas() == 0);
+
+    graph.sample_period = 0;
+    CHECK(server->AddPublishedGraphData(graph) == 0);
+    CHECK(server->AddPublishedGraphData(graph) == -1);
+    CHECK(server->GetNumberOfPublishedGraphDatas() == 1);
+}
+
+static const char*      TEST_HOST = "http://127.0.0.1:18181";       // Server under test
+static const uint64_t   RECORDED_START = 1000000000000ull;          // Recording time, September 2001
+static const int        RECORDED_SAMPLES = 6000;                    // One minute at 10 ms
+
+/// @brief Record a minute of a graph item and a data item, long enough ago that the wall clock is far off.
+static bool WriteRecording(const std::string& path)
+{
+    RecordingItem wave = { 1, true, Data::Type::DOUBLE, Data::Access::VIEW, "wave", "Recorded wave", "Wave",
+        Graph::Type::LINE, RECORDED_SAMPLES, 10 };
+    RecordingItem count = { 2, false, Data::Type::INT, Data::Access::VIEW, "count", "Recorded count", "",
+        Graph::Type::LINE, 0, 10 };
+
+    Recorder recorder;
+    if (recorder.Start(path, { wave, count }) < 0)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < RECORDED_SAMPLES; i++)
+    {
+        recorder.Record(1, RECORDED_START + i * 10ull, i % 100);
+        recorder.Record(2, RECORDED_START + i * 10ull, i);
+    }
+    recorder.Stop();
+    return true;
+}
+
+/// @brief Get a number following a key in a JSON reply, -1 if missing.
+static long long JsonNumber(const std::string& body, const std::string& key)
+{
+    size_t at = body.find("\"" + key + "\":");
+    return at == std::string::npos ? -1 : atoll(body.c_str() + at + key.size() + 3);
+}
+
+static void TestReplayRequests(Web_Server* server)
+{
+    const std::string path = "test_web_server.rec";
+    CHECK(WriteRecording(path));
+
+    server->Configure("http://127.0.0.1", 18181, ".");
+    CHECK(server->SetGraphRollupTiers({ { 1000, 3600000 } }) == 0);
+    CHECK(server->StartReplay(path, 1000000.0) == 0);
+    CHECK(server->Start() == 0);
+
+    // Playback at this speed takes well under a second
+    const uint64_t last = RECORDED_START + (RECORDED_SAMPLES - 1) * 10ull;
+    double value = 0.0;
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 500 && (server->GetLatestSample("wave", value, timestamp) < 0 || timestamp != last); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(timestamp == last);
+
+    // The window ends at the newest sample, not today: 600 points over a minute are
+    // finer than the 1 s tier, so raw samples are reduced instead
+    HttpReply reply = HttpGet(TEST_HOST, "/api/graph/wave?points=600");
+    CHECK(reply.status == 200);
+    CHECK(JsonNumber(reply.body, "resolution") == 0);
+
+    reply = HttpGet(TEST_HOST, "/api/graph/wave?points=10");
+    CHECK(reply.status == 200);
+    CHECK(JsonNumber(reply.body, "resolution") == 1000);
+
+    reply = HttpGet(TEST_HOST, "/api/graph/wave?points=2");
+    CHECK(reply.status == 400 && reply.body.find("at least 3") != std::string::npos);
+
+    // Each bad name gets its own answer
+    reply = HttpGet(TEST_HOST, "/api/graph/");
+    CHECK(reply.status == 400 && reply.body.find("missing graph name") != std::string::npos);
+    reply = HttpGet(TEST_HOST, "/api/graph/wa%zzve");
+    CHECK(reply.status == 400 && reply.body.find("invalid graph name") != std::string::npos);
+    reply = HttpGet(TEST_HOST, "/api/graph/" + std::string(300, 'w'));
+    CHECK(reply.status == 414 && reply.body.find("too long") != std::string::npos);
+    reply = HttpGet(TEST_HOST, "/api/graph/" + std::string(255, 'w'));
+    CHECK(reply.status == 404);
+    reply = HttpGet(TEST_HOST, "/api/graph/w%61ve?points=3");
+    CHECK(reply.status == 200);
+
+    // An aligned query holds the last sample before t0 until the first one inside the window
+    const std::string t0 = std::to_string(RECORDED_START + 1235);
+    const std::string t1 = std::to_string(RECORDED_START + 1255);
+    reply = HttpGet(TEST_HOST, "/api/query?names=count,wave&t0=" + t0 + "&t1=" + t1 + "&step=10");
+    CHECK(reply.status == 200);
+    CHECK(reply.body.find("\"name\":\"count\",\"values\":[123,124,125]") != std::string::npos);
+    CHECK(reply.body.find("\"name\":\"wave\",\"values\":[23,24,25]") != std::string::npos);
+    reply = HttpGet(TEST_HOST, "/api/query?names=wave&t0=" + std::to_string(RECORDED_START - 10) +
+        "&t1=" + std::to_string(RECORDED_START) + "&step=10");
+    CHECK(reply.body.find("\"values\":[null,0]") != std::string::npos);
+
+    // Replayed data items are found by name like registered ones
+    reply = HttpPost(TEST_HOST, "/rpc", "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"data.get\",\"params\":{\"names\":[\"count\"]}}");
+    CHECK(reply.status == 200);
+    CHECK(reply.body.find("\"count\":5999") != std::string::npos && reply.body.find("error") == std::string::npos);
+
+    server->Stop();
+    remove(path.c_str());
+}
+
+int main()
+{
+    Web_Server* server = Web_Server::GetInstance();
+    TestRegistration(server);
+    Web_Server::ReleaseInstance();
+
+    // Replay only publishes into an empty server
+    server = Web_Server::GetInstance();
+    TestReplayRequests(server);
+    Web_Server::ReleaseInstance();
+    return Essentials::Tests::Result();
+}
@@ -0,0 +1,216 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_websocket_deflate.cpp
+//!
+//! @brief      Tests of permessage-deflate negotiation and message compression
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <string.h>                  // strlen
+#include    "test_check.h"              // Checks
+#include    "../Source/CPP_Web_Server/websocket_deflate.h"  // Websocket Deflate
+//
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace Essentials::Communications;
+
+/// @brief Negotiate a header value, returning the response or "-" when refused.
+static std::string Negotiate(const char* offers, DeflateParameters& parameters)
+{
+    std::string response;
+    if (!NegotiateDeflate(mg_str_n(offers, strlen(offers)), parameters, response))
+    {
+        return "-";
+    }
+    return response;
+}
+
+static void TestNegotiation()
+{
+    DeflateParameters parameters;
+
+    CHECK(Negotiate("permessage-deflate", parameters) == "permessage-deflate");
+    CHECK(!parameters.serverNoContextTakeover && !parameters.clientNoContextTakeover);
+    CHECK(parameters.serverMaxWindowBits == 15);
+
+    // Browsers offer client_max_window_bits without a value
+    CHECK(Negotiate("permessage-deflate; client_max_window_bits", parameters) == "permessage-deflate");
+
+    CHECK(Negotiate("permessage-deflate; server_no_context_takeover; client_no_context_takeover", parameters) ==
+        "permessage-deflate; server_no_context_takeover; client_no_context_takeover");
+    CHECK(parameters.serverNoContextTakeover && parameters.clientNoContextTakeover);
+
+    CHECK(Negotiate("permessage-deflate; server_max_window_bits=\"10\"", parameters) ==
+        "permessage-deflate; server_max_window_bits=10");
+    CHECK(parameters.serverMaxWindowBits == 10);
+
+    // The first acceptable offer wins
+    CHECK(Negotiate("x-webkit-deflate-frame, permessage-deflate; server_max_window_bits=8, permessage-deflate", parameters) ==
+        "permessage-deflate");
+
+    CHECK(Negotiate("", parameters) == "-");
+    CHECK(Negotiate("x-webkit-deflate-frame", parameters) == "-");
+    CHECK(Negotiate("permessage-deflate; server_max_window_bits=8", parameters) == "-");
+    CHECK(Negotiate("permessage-deflate; server_max_window_bits=16", parameters) == "-");
+    CHECK(Negotiate("permessage-deflate; server_max_window_bits=1x", parameters) == "-");
+    CHECK(Negotiate("permessage-deflate; server_max_window_bits", parameters) == "-");
+    CHECK(Negotiate("permessage-deflate; server_no_context_takeover=1", parameters) == "-");
+    CHECK(Negotiate("permessage-deflate; unknown", parameters) == "-");
+}
+
+#ifdef CPP_WEBSOCKET_DEFLATE
+/// @brief Compress with one context and inflate with another, as a peer would.
+static bool RoundTrip(WebsocketDeflate& sender, WebsocketDeflate& receiver, const std::string& message, size_t* compressed = nullptr)
+{
+    std::vector<uint8_t> packed;
+    std::vector<uint8_t> unpacked;
+    if (!sender.Compress(message.data(), message.size(), packed) ||
+        !receiver.Decompress(packed.data(), packed.size(), unpacked))
+    {
+        return false;
+    }
+    if (compressed != nullptr)
+    {
+        *compressed = packed.size();
+    }
+    return std::string(unpacked.begin(), unpacked.end()) == message;
+}
+
+static void TestRoundTrip()
+{
+    DeflateParameters parameters = { false, false, 15 };
+    WebsocketDeflate sender;
+    WebsocketDeflate receiver;
+    CHECK(sender.Start(parameters, 1) == 0);
+    CHECK(receiver.Start(parameters, 1) == 0);
+    CHECK(sender.Start(parameters, 1) == -1);
+
+    std::string message;
+    for (int i = 0; i < 200; i++)
+    {
+        message += "{\"name\":\"count\",\"value\":" + std::to_string(i) + "},";
+    }
+
+    // With context takeover a repeat of the last message is mostly back references
+    size_t first = 0;
+    size_t second = 0;
+    CHECK(RoundTrip(sender, receiver, message, &first));
+    CHECK(RoundTrip(sender, receiver, message, &second));
+    CHECK(second < first);
+
+    CHECK(RoundTrip(sender, receiver, ""));
+    CHECK(RoundTrip(sender, receiver, "x"));
+    CHECK(RoundTrip(sender, receiver, std::string(1, '\0')));
+
+    // Incompressible input grows, and must still come back whole
+    std::string noise;
+    uint32_t state = 12345;
+    for (int i = 0; i < 100000; i++)
+    {
+        state = state * 1103515245 + 12345;
+        noise.push_back(static_cast<char>(state >> 24));
+    }
+    CHECK(RoundTrip(sender, receiver, noise));
+    CHECK(RoundTrip(sender, receiver, message));
+}
+
+static void TestNoContextTakeover()
+{
+    DeflateParameters parameters = { true, true, 15 };
+    WebsocketDeflate sender;
+    WebsocketDeflate receiver;
+    CHECK(sender.Start(parameters, 6) == 0);
+    CHECK(receiver.Start(parameters, 6) == 0);
+
+    std::string message(1000, 'a');
+    size_t first = 0;
+    size_t second = 0;
+    CHECK(RoundTrip(sender, receiver, message, &first));
+    CHECK(RoundTrip(sender, receiver, message, &second));
+    CHECK(first == second);
+}
+
+static void TestSmallWindow()
+{
+    DeflateParameters parameters = { false, false, 9 };
+    WebsocketDeflate sender;
+    WebsocketDeflate receiver;
+    CHECK(sender.Start(parameters, 9) == 0);
+    CHECK(receiver.Start(parameters, 9) == 0);
+
+    std::string message;
+    for (int i = 0; i < 5000; i++)
+    {
+        message += std::to_string(i * 7919 % 1000);
+    }
+    CHECK(RoundTrip(sender, receiver, message));
+    CHECK(RoundTrip(sender, receiver, message));
+}
+
+static void TestInflateLimit()
+{
+    DeflateParameters parameters = { true, true, 15 };
+    WebsocketDeflate sender;
+    WebsocketDeflate receiver;
+    CHECK(sender.Start(parameters, 9) == 0);
+    CHECK(receiver.Start(parameters, 1) == 0);
+
+    // Zeros inflate a thousand fold, well past the first output buffer
+    CHECK(RoundTrip(sender, receiver, std::string(WEBSOCKET_INFLATE_MAX, '\0')));
+
+    std::vector<uint8_t> packed;
+    std::vector<uint8_t> unpacked;
+    std::string over(WEBSOCKET_INFLATE_MAX + 1, '\0');
+    CHECK(sender.Compress(over.data(), over.size(), packed));
+    CHECK(!receiver.Decompress(packed.data(), packed.size(), unpacked));
+
+    // The receiver is usable again after refusing a message
+    CHECK(RoundTrip(sender, receiver, "after"));
+}
+
+static void TestInvalidInput()
+{
+    DeflateParameters parameters = { false, false, 15 };
+    WebsocketDeflate idle;
+    std::vector<uint8_t> out;
+    CHECK(!idle.Compress("x", 1, out));
+    CHECK(!idle.Decompress("x", 1, out));
+    CHECK(idle.Start(parameters, 0) == -1);
+    CHECK(idle.Start(parameters, 10) == -1);
+
+    WebsocketDeflate receiver;
+    CHECK(receiver.Start(parameters, 1) == 0);
+
+    // Block type 3 is reserved
+    const uint8_t reserved[] = { 0x07, 0x00 };
+    CHECK(!receiver.Decompress(reserved, sizeof(reserved), out));
+
+    WebsocketDeflate sender;
+    CHECK(sender.Start(parameters, 1) == 0);
+    CHECK(RoundTrip(sender, receiver, "valid after an invalid message"));
+}
+#endif
+
+int main()
+{
+    TestNegotiation();
+#ifdef CPP_WEBSOCKET_DEFLATE
+    TestRoundTrip();
+    TestNoContextTakeover();
+    TestSmallWindow();
+    TestInflateLimit();
+    TestInvalidInput();
+#else
+    WebsocketDeflate deflate;
+    DeflateParameters parameters = { false, false, 15 };
+    CHECK(deflate.Start(parameters, 1) == -1);
+#endif
+    return Essentials::Tests::Result();
+}
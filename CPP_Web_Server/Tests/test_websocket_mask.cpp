@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! @file       test_websocket_mask.cpp
+//!
+//! @brief      Tests of the websocket masking kernels against a byte at a time
+//!             reference
+//!
+//! @author     Chip Brommer
+//!
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Includes:
+//          name                        reason included
+//          --------------------        ---------------------------------------
+#include    <algorithm>                 // std::equal
+#include    <vector>                    // Buffers
+#include    "test_check.h"              // Checks
+#include    "../Source/Mongoose/mongoose.h" // Mongoose
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/// @brief Mask a buffer at an offset from a 64 byte boundary and compare it with the reference.
+static bool MatchesReference(struct mg_mgr* mgr, size_t offset, size_t length, const uint8_t mask[4])
+{
+    const size_t guard = 64;
+    std::vector<uint8_t> buffer(offset + length + 2 * guard + 64);
+    uint8_t* base = buffer.data() + (64 - reinterpret_cast<uintptr_t>(buffer.data()) % 64) % 64;
+    for (size_t i = 0; i < offset + length + guard; i++)
+    {
+        base[i] = static_cast<uint8_t>(i * 37 + 11);
+    }
+
+    std::vector<uint8_t> expected(base, base + offset + length + guard);
+    for (size_t i = 0; i < length; i++)
+    {
+        expected[offset + i] ^= mask[i & 3];
+    }
+
+    mg_ws_mask_buf(mgr, base + offset, length, mask);
+    if (!std::equal(expected.begin(), expected.end(), base))
+    {
+        return false;
+    }
+
+    // Masking is its own inverse
+    mg_ws_mask_buf(mgr, base + offset, length, mask);
+    for (size_t i = 0; i < length; i++)
+    {
+        if (base[offset + i] != static_cast<uint8_t>((offset + i) * 37 + 11))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    struct mg_mgr mgr;
+    mg_mgr_init(&mgr);
+    CHECK(mgr.ws_mask != NULL);
+    CHECK(mgr.ws_mask == mg_ws_mask_select());
+
+    const uint8_t masks[3][4] = { { 0x12, 0x34, 0x56, 0x78 }, { 0xFF, 0x00, 0xFF, 0x00 }, { 0, 0, 0, 0 } };
+    for (const uint8_t* mask : masks)
+    {
+        // Every tail length of the vector loops, from every alignment
+        for (size_t offset = 0; offset < 33; offset++)
+        {
+            for (size_t length = 0; length < 200; length++)
+            {
+                CHECK(MatchesReference(&mgr, offset, length, mask));
+                CHECK(MatchesReference(NULL, offset, length, mask));
+            }
+        }
+        CHECK(MatchesReference(&mgr, 3, 1 << 20, mask));
+    }
+
+    mg_mgr_free(&mgr);
+    return Essentials::Tests::Result();
+}
@@ -31,6 +31,9 @@ int main()
     // Initialize webserver
     ws->Configure(address, port, root);
 
+    int count = 0;
+    ws->AddPublishedData(Essentials::Communications::PublishedData(&count, "count", "Main loop counter", Essentials::Communications::Data::Type::INT));
+
     if (ws->Start() < 0)
     {
         std::cout << ws->GetLastError();
@@ -46,11 +49,11 @@ int main()
 
     log->AddEntry(Essentials::Utilities::LOG_LEVEL::LOG_INFO, "Main", "Initialized!");
 
-    int count = 0;
     while (ws->IsRunning())
     {
         count++;
         ws->SendConsoleLog("Log: " + std::to_string(count));
+        ws->SendDataUpdate();
         timer->MSecSleep(5000);
     }
 